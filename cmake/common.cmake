@@ -6,6 +6,7 @@ set(CMAKE_MODULE_PATH "${CCF_DIR}/cmake;${CMAKE_MODULE_PATH}")
 set(CMAKE_EXPORT_COMPILE_COMMANDS ON)
 
 find_package(Threads REQUIRED)
+find_package(ZLIB REQUIRED)
 
 set(PYTHON unbuffer python3)
 
@@ -233,6 +234,7 @@ if("sgx" IN_LIST COMPILE_TARGETS)
   target_link_libraries(
     cchost
     PRIVATE uv
+            ZLIB::ZLIB
             ${CRYPTO_LIBRARY}
             ${CMAKE_DL_LIBS}
             ${CMAKE_THREAD_LIBS_INIT}
@@ -274,6 +276,7 @@ if("virtual" IN_LIST COMPILE_TARGETS)
   target_link_libraries(
     cchost.virtual
     PRIVATE uv
+            ZLIB::ZLIB
             ${SNMALLOC_LIB}
             ${CRYPTO_LIBRARY}
             ${CMAKE_DL_LIBS}
@@ -297,6 +300,27 @@ target_link_libraries(
 )
 install(TARGETS scenario_perf_client DESTINATION bin)
 
+# Ledger auditor executable
+add_executable(
+  ledger_auditor ${CCF_DIR}/src/enclave/thread_local.cpp
+                 ${CCF_DIR}/src/host/ledger_auditor.cpp
+)
+use_client_mbedtls(ledger_auditor)
+target_compile_options(ledger_auditor PRIVATE -stdlib=libc++)
+target_include_directories(ledger_auditor PRIVATE ${CCF_DIR}/src)
+add_warning_checks(ledger_auditor)
+target_link_libraries(
+  ledger_auditor
+  PRIVATE uv
+          ZLIB::ZLIB
+          ${CMAKE_THREAD_LIBS_INIT}
+          ${LINK_LIBCXX}
+          ccfcrypto.host
+          evercrypt.host
+          secp256k1.host
+)
+install(TARGETS ledger_auditor DESTINATION bin)
+
 # Lua for host and enclave
 add_enclave_library_c(lua.enclave "${LUA_SOURCES}")
 target_compile_options(lua.enclave PRIVATE -Wno-string-plus-int)
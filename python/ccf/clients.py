@@ -46,6 +46,7 @@ def truncate(string: str, max_len: int = 128):
 
 CCF_TX_SEQNO_HEADER = "x-ccf-tx-seqno"
 CCF_TX_VIEW_HEADER = "x-ccf-tx-view"
+CCF_MIN_SEQNO_HEADER = "x-ccf-min-seqno"
 # Deprecated, will be removed
 CCF_GLOBAL_COMMIT_HEADER = "x-ccf-global-commit"
 
@@ -528,6 +529,19 @@ class WSClient:
             1, 0, 0, 0, websocket.ABNF.OPCODE_BINARY, 0, header + payload
         )
         self.ws.send_frame(frame)
+        return self._recv_response(timeout)
+
+    def receive(self, timeout: int = DEFAULT_REQUEST_TIMEOUT_SEC):
+        """
+        Receives the next frame pushed by the node on this session, e.g. a
+        transaction status notification.
+        """
+        if self.ws is None:
+            raise ValueError("WebSocket session is not established")
+        return self._recv_response(timeout)
+
+    def _recv_response(self, timeout: int):
+        self.ws.settimeout(timeout)
         out = self.ws.recv_frame().data
         (status_code,) = struct.unpack("<h", out[:2])
         seqno = unpack_seqno_or_view(out[2:10])
@@ -742,6 +756,22 @@ class CCFClient:
         kwargs["http_verb"] = "HEAD"
         return self.call(*args, **kwargs)
 
+    def receive(self, timeout: int = DEFAULT_REQUEST_TIMEOUT_SEC) -> Response:
+        """
+        Receives the next response pushed by the node on a WebSocket session,
+        without sending a request, e.g. a notification sent after subscribing
+        to transaction statuses with ``tx/subscribe``.
+
+        :param int timeout: Maximum time to wait for a response before giving up.
+
+        :return: :py:class:`ccf.clients.Response`
+        """
+        if not isinstance(self.client_impl, WSClient):
+            raise ValueError("Pushed responses are only supported over WebSocket")
+        response = self.client_impl.receive(timeout)
+        LOG.info(response)
+        return response
+
     def wait_for_commit(
         self, response: Response, timeout: int = DEFAULT_COMMIT_TIMEOUT_SEC
     ):
@@ -6,6 +6,7 @@ import io
 import msgpack.fallback as msgpack  # type: ignore
 import struct
 import os
+import zlib
 
 from loguru import logger as LOG  # type: ignore
 
@@ -16,9 +17,20 @@ GCM_SIZE_IV = 12
 LEDGER_TRANSACTION_SIZE = 4
 LEDGER_DOMAIN_SIZE = 8
 LEDGER_HEADER_SIZE = 8
+LEDGER_COMPRESSED_INDEX_HEADER_SIZE = 16
+
+COMMITTED_SUFFIX = ".committed"
+COMPRESSED_SUFFIX = ".committed.compressed"
+PARTIAL_SUFFIX = ".partial"
 
 UNPACK_ARGS = {"raw": True, "strict_map_key": False}
 
+# Map start indicators. Sized maps record the size of their contents after
+# their name.
+KOT_MAP_START_INDICATOR = 1 << 1
+KOT_SIZED_MAP_START_INDICATOR = 1 << 8
+MAP_SIZE_SIZE = 8
+
 
 def to_uint_32(buffer):
     return struct.unpack("@I", buffer)[0]
@@ -88,10 +100,11 @@ class PublicDomain:
 
     def _read(self):
         while self._buffer_size > self._unpacker.tell():
-            # map_start_indicator
-            self._read_next()
+            map_start_indicator = self._read_next()
             map_name = self._read_next_string()
             LOG.debug(f"Reading map {map_name}")
+            if map_start_indicator == KOT_SIZED_MAP_START_INDICATOR:
+                self._unpacker.read_bytes(MAP_SIZE_SIZE)
             records = {}
             self._tables[map_name] = records
 
@@ -143,6 +156,30 @@ def _byte_read_safe(file, num_of_bytes):
     return ret
 
 
+def _decompress_chunk(file) -> BinaryIO:
+    """
+    Decompress a compressed ledger chunk, which contains the contents of the
+    committed chunk as independently compressed blocks, followed by an index of
+    these blocks.
+    """
+    index_offset = to_uint_64(_byte_read_safe(file, LEDGER_HEADER_SIZE))
+    file.seek(index_offset)
+    uncompressed_size, _, block_count = struct.unpack(
+        "@QII", _byte_read_safe(file, LEDGER_COMPRESSED_INDEX_HEADER_SIZE)
+    )
+    offsets = struct.unpack(
+        f"@{block_count + 1}Q", _byte_read_safe(file, 8 * (block_count + 1))
+    )
+
+    contents = io.BytesIO()
+    contents.write(struct.pack("@Q", uncompressed_size))
+    for start, end in zip(offsets, offsets[1:]):
+        file.seek(start)
+        contents.write(zlib.decompress(_byte_read_safe(file, end - start)))
+    contents.seek(0)
+    return contents
+
+
 class Transaction:
     """
     A transaction represents one entry in the CCF ledger.
@@ -162,6 +199,11 @@ class Transaction:
         if self._file is None:
             raise RuntimeError(f"Ledger file {filename} could not be opened")
 
+        if filename.endswith(COMPRESSED_SUFFIX):
+            compressed_file = self._file
+            self._file = _decompress_chunk(compressed_file)
+            compressed_file.close()
+
         self._file_size = int.from_bytes(
             _byte_read_safe(self._file, LEDGER_HEADER_SIZE), byteorder="little"
         )
@@ -274,19 +316,29 @@ class Ledger:
         self._filenames = []
         self._fileindex = -1
 
-        ledgers = os.listdir(directory)
+        ledgers = [
+            chunk
+            for chunk in os.listdir(directory)
+            if not chunk.endswith(PARTIAL_SUFFIX)
+        ]
         # Sorts the list based off the first number after ledger_ so that
         # the ledger is verified in sequence
         sorted_ledgers = sorted(
             ledgers,
             key=lambda x: int(
-                x.replace(".committed", "").replace("ledger_", "").split("-")[0]
+                x.replace(COMPRESSED_SUFFIX, "")
+                .replace(COMMITTED_SUFFIX, "")
+                .replace("ledger_", "")
+                .split("-")[0]
             ),
         )
 
         for chunk in sorted_ledgers:
             if os.path.isfile(os.path.join(directory, chunk)):
-                if not chunk.endswith(".committed"):
+                if not (
+                    chunk.endswith(COMMITTED_SUFFIX)
+                    or chunk.endswith(COMPRESSED_SUFFIX)
+                ):
                     LOG.warning(f"The file {chunk} has not been committed")
                 self._filenames.append(os.path.join(directory, chunk))
 
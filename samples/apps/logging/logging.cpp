@@ -24,6 +24,9 @@ namespace loggingapp
     Table records;
     Table public_records;
 
+    // Seqnos at which each private record was written
+    std::shared_ptr<ccf::indexing::TypedSeqNosByKey<Table>> record_seqnos;
+
     const nlohmann::json record_public_params_schema;
     const nlohmann::json record_public_result_schema;
 
@@ -41,8 +44,12 @@ namespace loggingapp
       record_public_params_schema(nlohmann::json::parse(j_record_public_in)),
       record_public_result_schema(nlohmann::json::parse(j_record_public_out)),
       get_public_params_schema(nlohmann::json::parse(j_get_public_in)),
-      get_public_result_schema(nlohmann::json::parse(j_get_public_out))
+      get_public_result_schema(nlohmann::json::parse(j_get_public_out)),
+      record_seqnos(
+        std::make_shared<ccf::indexing::TypedSeqNosByKey<Table>>())
     {
+      context.get_indexer().install_strategy(records.get_name(), record_seqnos);
+
       // SNIPPET_START: record
       auto record = [this](kv::Tx& tx, nlohmann::json&& params) {
         // SNIPPET_START: macro_validation_record
@@ -331,6 +338,92 @@ namespace loggingapp
         .set_forwarding_required(ccf::ForwardingRequired::Never)
         .install();
 
+      // Returns every version of a record in a range of seqnos. Only the
+      // transactions which wrote the record are fetched, using the index.
+      auto get_record_seqnos = [this, &indexer = context.get_indexer()](
+                                 ccf::EndpointContext& args,
+                                 ccf::historical::SeqNoCollection& seqnos,
+                                 std::string& error_reason) {
+        using Result = ccf::historical::GetSeqNosResult;
+
+        if (consensus == nullptr)
+        {
+          error_reason = "Node is not fully configured";
+          return Result::Invalid;
+        }
+
+        const auto [pack, params] =
+          ccf::jsonhandler::get_json_params(args.rpc_ctx);
+        const auto in = params.get<LoggingGetHistoricalRange::In>();
+
+        // Only committed transactions can be queried
+        const auto committed_seqno = consensus->get_committed_seqno();
+        const auto to_seqno =
+          std::min(in.to_seqno.value_or(committed_seqno), committed_seqno);
+        if (in.from_seqno > to_seqno)
+        {
+          error_reason = fmt::format(
+            "Invalid range: from_seqno {} is past to_seqno {} or the last "
+            "committed seqno {}",
+            in.from_seqno,
+            in.to_seqno.value_or(committed_seqno),
+            committed_seqno);
+          return Result::Invalid;
+        }
+
+        // Transactions are committed before they are indexed
+        const auto indexed_seqno = indexer.get_indexed_seqno();
+        if (to_seqno > indexed_seqno)
+        {
+          error_reason = fmt::format(
+            "Transactions up to seqno {} are not yet indexed, only up to {}",
+            to_seqno,
+            indexed_seqno);
+          return Result::Pending;
+        }
+
+        seqnos = record_seqnos->get_seqnos_for_key(
+          in.id,
+          in.from_seqno,
+          to_seqno,
+          ccf::historical::max_stores_per_range_query + 1);
+        return Result::Ok;
+      };
+
+      auto get_historical_range =
+        [this](
+          ccf::EndpointContext& args,
+          const ccf::historical::StoresBySeqNo& stores,
+          std::optional<kv::Consensus::SeqNo> next_seqno) {
+          const auto [pack, params] =
+            ccf::jsonhandler::get_json_params(args.rpc_ctx);
+          const auto in = params.get<LoggingGetHistoricalRange::In>();
+
+          LoggingGetHistoricalRange::Out out;
+          for (const auto& [seqno, historical_store] : stores)
+          {
+            auto historical_tx = historical_store->create_read_only_tx();
+            auto view = historical_tx.get_read_only_view(records);
+            out.entries.push_back({seqno, view->get(in.id)});
+          }
+          out.next_from_seqno = next_seqno;
+
+          nlohmann::json j = out;
+          ccf::jsonhandler::set_response(std::move(j), args.rpc_ctx, pack);
+        };
+      make_endpoint(
+        "log/private/historical/range",
+        HTTP_GET,
+        ccf::historical::range_adapter(
+          get_historical_range,
+          context.get_historical_state(),
+          get_record_seqnos))
+        .set_auto_schema<
+          LoggingGetHistoricalRange::In,
+          LoggingGetHistoricalRange::Out>()
+        .set_forwarding_required(ccf::ForwardingRequired::Never)
+        .install();
+
       auto record_admin_only =
         [this, &nwt](ccf::EndpointContext& ctx, nlohmann::json&& params) {
           {
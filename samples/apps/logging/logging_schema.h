@@ -48,6 +48,43 @@ namespace loggingapp
 
   using LoggingGetHistorical = LoggingGet;
 
+  struct LoggingGetHistoricalRange
+  {
+    struct In
+    {
+      size_t id;
+      int64_t from_seqno = 1;
+      // Defaults to the current commit seqno
+      std::optional<int64_t> to_seqno = std::nullopt;
+    };
+
+    struct Entry
+    {
+      int64_t seqno;
+      // Not set if the entry was removed at this seqno
+      std::optional<std::string> msg = std::nullopt;
+    };
+
+    struct Out
+    {
+      std::vector<Entry> entries;
+      // Set if there are further entries in the range, from this seqno
+      std::optional<int64_t> next_from_seqno = std::nullopt;
+    };
+  };
+
+  DECLARE_JSON_TYPE_WITH_OPTIONAL_FIELDS(LoggingGetHistoricalRange::In);
+  DECLARE_JSON_REQUIRED_FIELDS(LoggingGetHistoricalRange::In, id);
+  DECLARE_JSON_OPTIONAL_FIELDS(
+    LoggingGetHistoricalRange::In, from_seqno, to_seqno);
+  DECLARE_JSON_TYPE_WITH_OPTIONAL_FIELDS(LoggingGetHistoricalRange::Entry);
+  DECLARE_JSON_REQUIRED_FIELDS(LoggingGetHistoricalRange::Entry, seqno);
+  DECLARE_JSON_OPTIONAL_FIELDS(LoggingGetHistoricalRange::Entry, msg);
+  DECLARE_JSON_TYPE_WITH_OPTIONAL_FIELDS(LoggingGetHistoricalRange::Out);
+  DECLARE_JSON_REQUIRED_FIELDS(LoggingGetHistoricalRange::Out, entries);
+  DECLARE_JSON_OPTIONAL_FIELDS(
+    LoggingGetHistoricalRange::Out, next_from_seqno);
+
   // Public record/get
   // Manual schemas, verified then parsed in handler
   static const std::string j_record_public_in = R"!!!(
@@ -14,7 +14,10 @@
 // STL/3rdparty
 #include <CLI11/CLI11.hpp>
 #include <chrono>
+#include <deque>
+#include <exception>
 #include <fstream>
+#include <map>
 #include <nlohmann/json.hpp>
 #include <random>
 #include <thread>
@@ -59,6 +62,7 @@ namespace client
 
     size_t num_transactions = 10000;
     size_t thread_count = 1;
+    size_t connections_per_thread = 1;
     size_t session_count = 1;
     size_t max_writes_ahead = 0;
     size_t latency_rounds = 1;
@@ -73,6 +77,8 @@ namespace client
     bool check_responses = false;
     bool relax_commit_target = false;
     bool websockets = false;
+    bool commit_notifications = false;
+    bool open_loop = false;
     ///@}
 
     PerfOptions(
@@ -138,7 +144,19 @@ namespace client
           "The basic number of transactions to send (will actually send this "
           "many for each thread, in each session)")
         ->capture_default_str();
-      app.add_option("-t,--threads", thread_count)->capture_default_str();
+      app
+        .add_option(
+          "-t,--threads",
+          thread_count,
+          "Number of threads sending transactions, each pinned to a core. "
+          "Transactions are divided between every connection of every thread")
+        ->capture_default_str();
+      app
+        .add_option(
+          "--connections",
+          connections_per_thread,
+          "Number of connections on which each thread sends transactions")
+        ->capture_default_str();
       app.add_option("-s,--sessions", session_count)->capture_default_str();
       app
         .add_option(
@@ -187,6 +205,29 @@ namespace client
         .add_flag(
           "--use-websockets", websockets, "Use websockets to send transactions")
         ->capture_default_str();
+      app
+        .add_flag(
+          "--commit-notifications",
+          commit_notifications,
+          "Wait for global commit by subscribing to commit notifications over "
+          "a websocket, rather than polling transaction status")
+        ->capture_default_str();
+      app
+        .add_flag(
+          "--open-loop",
+          open_loop,
+          "Send transactions on a fixed schedule, at --transaction-rate, "
+          "regardless of when responses are received. Latencies are measured "
+          "from the scheduled send time, so that they include any delay in "
+          "sending")
+        ->capture_default_str();
+    }
+
+    // Whether transactions are sent by several threads or connections, or on
+    // a fixed schedule, rather than by the calling thread on one connection
+    bool use_load_generator() const
+    {
+      return thread_count > 1 || connections_per_thread > 1 || open_loop;
     }
   };
 
@@ -438,6 +479,313 @@ namespace client
       return timing_results;
     }
 
+    struct InFlightTx
+    {
+      timing::Clock::time_point send_time;
+      bool expects_commit;
+    };
+
+    struct LoadConnection
+    {
+      std::shared_ptr<RpcTlsClient> connection;
+      // Responses are received in the order requests were sent
+      std::deque<InFlightTx> in_flight;
+    };
+
+    struct LoadResults
+    {
+      size_t sends = 0;
+      size_t receives = 0;
+      timing::Clock::time_point last_receive_time = {};
+      timing::CommitPoint last_commit = {0, 0};
+      timing::Histogram response_latency;
+      timing::Histogram commit_latency;
+
+      // Send times of writes which were not globally committed when their
+      // response was received, by seqno
+      std::multimap<size_t, timing::Clock::time_point> pending_commits;
+
+      std::exception_ptr error = nullptr;
+
+      void complete_commits(size_t global, timing::Clock::time_point now)
+      {
+        const auto end = pending_commits.upper_bound(global);
+        for (auto it = pending_commits.begin(); it != end; ++it)
+        {
+          commit_latency.record(now - it->second);
+        }
+        pending_commits.erase(pending_commits.begin(), end);
+      }
+
+      void merge(LoadResults&& other)
+      {
+        sends += other.sends;
+        receives += other.receives;
+        last_receive_time =
+          std::max(last_receive_time, other.last_receive_time);
+        if (other.last_commit.seqno > last_commit.seqno)
+        {
+          last_commit = other.last_commit;
+        }
+        response_latency.merge(other.response_latency);
+        commit_latency.merge(other.commit_latency);
+        pending_commits.merge(other.pending_commits);
+      }
+    };
+
+    void process_load_reply(
+      LoadConnection& lc,
+      const RpcTlsClient::Response& reply,
+      LoadResults& results)
+    {
+      const auto now = timing::Clock::now();
+      const auto sent = lc.in_flight.front();
+      lc.in_flight.pop_front();
+
+      ++results.receives;
+      results.last_receive_time = now;
+
+      if (options.check_responses && !check_response(reply))
+      {
+        throw std::logic_error("Response failed check");
+      }
+
+      const auto latency = now - sent.send_time;
+      results.response_latency.record(latency);
+
+      if (reply.status != HTTP_STATUS_OK)
+      {
+        return;
+      }
+
+      const auto commits = timing::parse_commit_ids(reply);
+      if (sent.expects_commit)
+      {
+        if (commits.global >= commits.seqno)
+        {
+          results.commit_latency.record(latency);
+        }
+        else
+        {
+          results.pending_commits.emplace(commits.seqno, sent.send_time);
+        }
+      }
+
+      if (commits.seqno > results.last_commit.seqno)
+      {
+        results.last_commit = {commits.view, commits.seqno};
+      }
+      results.complete_commits(commits.global, now);
+    }
+
+    // Sends every thread_count-th transaction, starting at thread_idx, on each
+    // of the given connections in turn. In open-loop mode, transaction i is
+    // sent at start + i / transactions_per_s, whether or not earlier
+    // transactions have been answered.
+    void generate_load(
+      size_t thread_idx,
+      const PreparedTxs& txs,
+      timing::Clock::time_point start,
+      std::vector<LoadConnection>& connections,
+      LoadResults& results)
+    {
+      const auto target_core =
+        thread_idx % std::thread::hardware_concurrency();
+      if (!pin_to_core(target_core))
+      {
+        LOG_FAIL_FMT("Failed to pin to core: {}", target_core);
+      }
+
+      const std::chrono::duration<double> interval(
+        options.open_loop ? 1.0 / options.transactions_per_s : 0.0);
+
+      auto read_available = [&]() {
+        for (auto& lc : connections)
+        {
+          while (!lc.in_flight.empty())
+          {
+            const auto r = lc.connection->read_response_non_blocking();
+            if (!r.has_value())
+            {
+              break;
+            }
+            process_load_reply(lc, r.value(), results);
+          }
+        }
+      };
+
+      for (size_t i = thread_idx; i < txs.size(); i += options.thread_count)
+      {
+        auto& lc =
+          connections[(i / options.thread_count) % connections.size()];
+
+        timing::Clock::time_point send_time;
+        if (options.open_loop)
+        {
+          send_time = start +
+            std::chrono::duration_cast<timing::Clock::duration>(interval * i);
+          while (timing::Clock::now() < send_time)
+          {
+            read_available();
+          }
+        }
+        else
+        {
+          // 0 allows unlimited write-ahead
+          while (options.max_writes_ahead > 0 &&
+                 lc.in_flight.size() >= options.max_writes_ahead)
+          {
+            process_load_reply(lc, lc.connection->read_response(), results);
+          }
+          send_time = timing::Clock::now();
+        }
+
+        lc.connection->write(txs[i].rpc.encoded);
+        lc.in_flight.push_back({send_time, txs[i].expects_commit});
+        ++results.sends;
+
+        read_available();
+      }
+
+      for (auto& lc : connections)
+      {
+        while (!lc.in_flight.empty())
+        {
+          process_load_reply(lc, lc.connection->read_response(), results);
+        }
+      }
+    }
+
+    // Sends txs from thread_count threads, each with connections_per_thread
+    // connections, and records response and global commit latencies in
+    // histograms
+    timing::Results call_load_generator(const PreparedTxs& txs)
+    {
+      if (options.open_loop && options.transactions_per_s == 0)
+      {
+        throw std::logic_error("--open-loop requires a --transaction-rate");
+      }
+
+      if (options.session_count > 1)
+      {
+        throw std::logic_error(
+          "--sessions is not supported with several threads or connections, "
+          "or with --open-loop");
+      }
+
+      // Connections are all created on this thread, as they share a lazily
+      // created certificate
+      std::vector<std::vector<LoadConnection>> connections(
+        options.thread_count);
+      for (auto& thread_connections : connections)
+      {
+        for (size_t c = 0; c < options.connections_per_thread; ++c)
+        {
+          auto conn = create_connection(false, options.websockets);
+          if (options.transactions_per_s > 0)
+          {
+            conn->set_tcp_nodelay(true);
+          }
+          thread_connections.push_back({conn, {}});
+        }
+      }
+
+      LOG_INFO_FMT(
+        "Sending {} transactions from {} threads, each with {} connections, "
+        "{}",
+        txs.size(),
+        options.thread_count,
+        options.connections_per_thread,
+        options.open_loop ?
+          fmt::format("at {} tx/s", options.transactions_per_s) :
+          std::string("as fast as possible"));
+
+      std::vector<LoadResults> thread_results(options.thread_count);
+      const auto start = timing::Clock::now();
+
+      std::vector<std::thread> threads;
+      for (size_t t = 0; t < options.thread_count; ++t)
+      {
+        threads.emplace_back([&, t]() {
+          try
+          {
+            generate_load(t, txs, start, connections[t], thread_results[t]);
+          }
+          catch (...)
+          {
+            thread_results[t].error = std::current_exception();
+          }
+        });
+      }
+
+      LoadResults results;
+      for (size_t t = 0; t < options.thread_count; ++t)
+      {
+        threads[t].join();
+        if (thread_results[t].error != nullptr)
+        {
+          std::rethrow_exception(thread_results[t].error);
+        }
+        results.merge(std::move(thread_results[t]));
+      }
+      last_response_commit = results.last_commit;
+
+      auto end_time = results.last_receive_time;
+      if (!options.no_wait && results.last_commit.seqno > 0)
+      {
+        // Writes still pending are completed as each global commit is
+        // observed, rather than once the last one is
+        wait_for_global_commit(results.last_commit, [&](size_t global) {
+          results.complete_commits(global, timing::Clock::now());
+        });
+        end_time = timing::Clock::now();
+      }
+
+      if (!results.pending_commits.empty())
+      {
+        LOG_INFO_FMT(
+          "Global commit latency excludes {} writes which were not observed "
+          "to commit",
+          results.pending_commits.size());
+      }
+
+      for (const auto& [name, histogram] :
+           {std::make_pair("response", &results.response_latency),
+            std::make_pair("commit", &results.commit_latency)})
+      {
+        auto us = [h = histogram](double percentile) {
+          return std::chrono::duration_cast<std::chrono::microseconds>(
+                   h->value_at_percentile(percentile))
+            .count();
+        };
+        LOG_INFO_FMT(
+          "{} latency of {} transactions: p50 {}us, p90 {}us, p99 {}us, "
+          "p99.9 {}us, max {}us",
+          name,
+          histogram->count(),
+          us(50),
+          us(90),
+          us(99),
+          us(99.9),
+          us(100));
+
+        if (options.write_tx_times)
+        {
+          histogram->write_to_file(
+            fmt::format("{}_{}_latency.csv", options.label, name));
+        }
+      }
+
+      timing::Results timing_results;
+      timing_results.total_sends = results.sends;
+      timing_results.total_receives = results.receives;
+      timing_results.start_time = start;
+      timing_results.duration = end_time - start;
+      timing_results.total_local_commit = results.response_latency.measure();
+      timing_results.total_global_commit = results.commit_latency.measure();
+      return timing_results;
+    }
+
     void kick_off_timing()
     {
       LOG_INFO_FMT("About to begin timing");
@@ -607,7 +955,12 @@ namespace client
       // timing gets its own new connection for any requests it wants to send -
       // these are never signed
       response_times(create_connection(true, false))
-    {}
+    {
+      if (options.commit_notifications)
+      {
+        response_times.use_commit_notifications(create_connection(true, true));
+      }
+    }
 
     void init_connection()
     {
@@ -669,6 +1022,10 @@ namespace client
       try
       {
         // ...send any transactions which were previously prepared
+        if (options.use_load_generator())
+        {
+          return call_load_generator(prepared_txs);
+        }
         return call_raw_batch(rpc_connection, prepared_txs);
       }
       catch (std::exception& e)
@@ -679,9 +1036,11 @@ namespace client
     }
 
     timing::CommitPoint wait_for_global_commit(
-      const timing::CommitPoint& target)
+      const timing::CommitPoint& target,
+      const timing::GlobalCommitObserver& on_global_commit = nullptr)
     {
-      return response_times.wait_for_global_commit(target);
+      return response_times.wait_for_global_commit(
+        target, true, on_global_commit);
     }
 
     timing::CommitPoint wait_for_global_commit(
@@ -7,7 +7,10 @@
 
 // STL/3rdparty
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <thread>
 #include <vector>
@@ -86,6 +89,9 @@ namespace timing
     size_t seqno;
   };
 
+  // Called with each global commit seqno observed while waiting for commit
+  using GlobalCommitObserver = std::function<void(size_t)>;
+
   std::string timestamp()
   {
     std::stringstream ss;
@@ -141,6 +147,151 @@ namespace timing
     return stream;
   }
 
+  // Histogram of latencies in nanoseconds, in the style of HdrHistogram.
+  // Values below 2^sub_bucket_bits are counted exactly, and larger values in
+  // buckets whose width is less than 1/2^(sub_bucket_bits-1) of their value,
+  // so that percentiles are accurate to within 1%. The exact sum of values is
+  // kept, for the average and variance.
+  class Histogram
+  {
+    static constexpr size_t sub_bucket_bits = 8;
+    static constexpr uint64_t sub_bucket_count = 1ul << sub_bucket_bits;
+    static constexpr uint64_t half_sub_bucket_count = sub_bucket_count / 2;
+    static constexpr size_t bucket_count =
+      sub_bucket_count + (64 - sub_bucket_bits) * half_sub_bucket_count;
+
+    vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t max_value = 0;
+    double sum = 0.0;
+    double sum_of_squares = 0.0;
+
+    static size_t index_of(uint64_t value)
+    {
+      if (value < sub_bucket_count)
+      {
+        return value;
+      }
+
+      const size_t msb = 63 - __builtin_clzll(value);
+      const size_t shift = msb - sub_bucket_bits + 1;
+      return sub_bucket_count + (shift - 1) * half_sub_bucket_count +
+        ((value >> shift) - half_sub_bucket_count);
+    }
+
+    // Highest value counted in the bucket at index
+    static uint64_t highest_value_at(size_t index)
+    {
+      if (index < sub_bucket_count)
+      {
+        return index;
+      }
+
+      const size_t shift =
+        (index - sub_bucket_count) / half_sub_bucket_count + 1;
+      const uint64_t sub_bucket =
+        (index - sub_bucket_count) % half_sub_bucket_count +
+        half_sub_bucket_count;
+      return (sub_bucket << shift) + ((1ul << shift) - 1);
+    }
+
+  public:
+    Histogram() : counts(bucket_count, 0) {}
+
+    void record(nanoseconds latency)
+    {
+      const uint64_t value = std::max<int64_t>(latency.count(), 0);
+      ++counts[index_of(value)];
+      ++total;
+      max_value = std::max(max_value, value);
+      sum += value;
+      sum_of_squares += (double)value * value;
+    }
+
+    void merge(const Histogram& other)
+    {
+      for (size_t i = 0; i < bucket_count; ++i)
+      {
+        counts[i] += other.counts[i];
+      }
+      total += other.total;
+      max_value = std::max(max_value, other.max_value);
+      sum += other.sum;
+      sum_of_squares += other.sum_of_squares;
+    }
+
+    uint64_t count() const
+    {
+      return total;
+    }
+
+    nanoseconds max() const
+    {
+      return nanoseconds(max_value);
+    }
+
+    // Smallest latency which is greater than or equal to the given percentage
+    // of recorded latencies
+    nanoseconds value_at_percentile(double percentile) const
+    {
+      if (total == 0)
+      {
+        return nanoseconds::zero();
+      }
+
+      const auto target = std::max<uint64_t>(
+        1, std::ceil(percentile / 100.0 * total));
+      uint64_t seen = 0;
+      for (size_t i = 0; i < bucket_count; ++i)
+      {
+        seen += counts[i];
+        if (seen >= target)
+        {
+          return nanoseconds(std::min(highest_value_at(i), max_value));
+        }
+      }
+      return max();
+    }
+
+    // Average and variance, in seconds, as reported in Results
+    Measure measure() const
+    {
+      if (total == 0)
+      {
+        return {0, NAN, NAN};
+      }
+
+      const double average = sum / total;
+      const double variance = sum_of_squares / total - average * average;
+      return {total, average / 1e9, variance / 1e18};
+    }
+
+    // Writes the latency at each recorded percentile, as a CSV
+    void write_to_file(const string& path) const
+    {
+      ofstream csv(path, ofstream::out);
+      if (!csv.is_open())
+      {
+        return;
+      }
+
+      csv << "latency_ns,percentile,count" << endl;
+      uint64_t seen = 0;
+      for (size_t i = 0; i < bucket_count; ++i)
+      {
+        if (counts[i] == 0)
+        {
+          continue;
+        }
+
+        seen += counts[i];
+        csv << std::min(highest_value_at(i), max_value) << ","
+            << 100.0 * seen / total << "," << counts[i] << endl;
+      }
+      LOG_INFO_FMT("Wrote latency histogram to {}", path);
+    }
+  };
+
   struct Results
   {
     size_t total_sends;
@@ -196,6 +347,9 @@ namespace timing
   class ResponseTimes
   {
     const shared_ptr<RpcTlsClient> net_client;
+    // If set, a websocket connection on which commit notifications are
+    // received, instead of polling for transaction status
+    shared_ptr<RpcTlsClient> notification_client = nullptr;
     time_point<Clock> start_time;
 
     vector<SentRequest> sends;
@@ -244,13 +398,139 @@ namespace timing
       receives.push_back({Clock::now() - start_time, rpc_id, commit});
     }
 
+    void use_commit_notifications(const shared_ptr<RpcTlsClient>& ws_client)
+    {
+      notification_client = ws_client;
+    }
+
+    // Subscribes to the status of the target transaction, and of a sample of
+    // the previously received write transactions, so that intermediate commit
+    // points are observed as they are pushed by the node. Returns once the
+    // target is committed. Throws if the target is invalid. Each observed
+    // global commit seqno is passed to on_global_commit, if it is set.
+    CommitPoint wait_for_commit_notification(
+      const CommitPoint& target,
+      bool record = true,
+      const GlobalCommitObserver& on_global_commit = nullptr)
+    {
+      // Notifications are not responses to any request sent by the client
+      constexpr auto notification_id = std::numeric_limits<size_t>::max();
+      constexpr auto subscribe_tx_status = "tx/subscribe";
+      constexpr size_t max_samples = 1000;
+      constexpr size_t ack_interval = 16;
+
+      auto txs = nlohmann::json::array();
+      std::vector<const ReceivedReply*> writes;
+      for (const auto& receive : receives)
+      {
+        if (
+          receive.commit.has_value() &&
+          receive.commit->seqno < target.seqno &&
+          receive.commit->global < receive.commit->seqno)
+        {
+          writes.push_back(&receive);
+        }
+      }
+      const auto stride = std::max<size_t>(1, writes.size() / max_samples);
+      for (size_t i = 0; i < writes.size(); i += stride)
+      {
+        txs.push_back(
+          {{"view", writes[i]->commit->view},
+           {"seqno", writes[i]->commit->seqno}});
+      }
+      txs.push_back({{"view", target.view}, {"seqno", target.seqno}});
+
+      LOG_INFO_FMT(
+        "Subscribing to {} transactions, up to {}.{}",
+        txs.size(),
+        target.view,
+        target.seqno);
+
+      auto response = notification_client->call(
+        subscribe_tx_status, nlohmann::json{{"txs", txs}});
+      size_t received = 0;
+
+      while (true)
+      {
+        const auto body = notification_client->unpack_body(response);
+        if (response.status != HTTP_STATUS_OK)
+        {
+          throw runtime_error(fmt::format(
+            "{} failed with status {}: {}",
+            subscribe_tx_status,
+            http_status_str(response.status),
+            body.dump()));
+        }
+
+        const auto commit_ids = parse_commit_ids(response);
+        if (record)
+        {
+          record_receive(notification_id, commit_ids);
+        }
+
+        if (on_global_commit)
+        {
+          on_global_commit(commit_ids.global);
+          for (const auto& update : body["updates"])
+          {
+            if (update["status"] == "COMMITTED")
+            {
+              on_global_commit(update["seqno"].get<size_t>());
+            }
+          }
+        }
+
+        for (const auto& update : body["updates"])
+        {
+          if (
+            update["view"] == target.view && update["seqno"] == target.seqno)
+          {
+            const auto tx_status = update["status"];
+            if (tx_status == "COMMITTED")
+            {
+              LOG_INFO_FMT(
+                "Notified of global commit {}.{}", target.view, target.seqno);
+              return {commit_ids.view, commit_ids.seqno};
+            }
+            else
+            {
+              throw std::logic_error(fmt::format(
+                "Transaction {}.{} is now marked as {}",
+                target.view,
+                target.seqno,
+                tx_status));
+            }
+          }
+        }
+
+        // Return credit to the node regularly, so that notifications are not
+        // held back. The response to this is handled like any notification.
+        if (++received % ack_interval == 0)
+        {
+          const auto ack = notification_client->gen_request(
+            subscribe_tx_status, nlohmann::json{{"ack", ack_interval}});
+          notification_client->write(ack.encoded);
+        }
+
+        response = notification_client->read_response();
+      }
+    }
+
     // Repeatedly calls GET /tx RPC until the target seqno has been
     // committed (or will never be committed), returns first confirming
-    // response. Calls record_[send/response], if record is true.
-    // Throws on errors, or if target is rolled back
+    // response. Calls record_[send/response], if record is true, and passes
+    // the global commit seqno of each response to on_global_commit, if it is
+    // set. Throws on errors, or if target is rolled back
     CommitPoint wait_for_global_commit(
-      const CommitPoint& target, bool record = true)
+      const CommitPoint& target,
+      bool record = true,
+      const GlobalCommitObserver& on_global_commit = nullptr)
     {
+      if (notification_client != nullptr)
+      {
+        return wait_for_commit_notification(target, record, on_global_commit);
+      }
+
       auto params = nlohmann::json::object();
       params["view"] = target.view;
       params["seqno"] = target.seqno;
@@ -285,6 +565,11 @@ namespace timing
           record_receive(response.id, commit_ids);
         }
 
+        if (on_global_commit)
+        {
+          on_global_commit(commit_ids.global);
+        }
+
         // NB: Eventual header re-org should be exposing API types so
         // they can be consumed cleanly from C++ clients
         const auto tx_status = body["status"];
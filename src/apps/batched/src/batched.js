@@ -30,3 +30,17 @@ export function fetch_batch(request) {
     body: results,
   };
 }
+
+export function fetch_batch_str(request) {
+  const params = request.body.json();
+  var results = [];
+  let entries_map = ccf.kv["entries"];
+  for (var i = 0; i < params.length; ++i) {
+    const id = params[i];
+    const msg = entries_map.getStr(ccf.jsonCompatibleToBuf(id));
+    results.push({ id: id, msg: msg });
+  }
+  return {
+    body: results,
+  };
+}
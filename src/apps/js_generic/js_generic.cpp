@@ -301,6 +301,22 @@ namespace ccfapp
     return buf;
   }
 
+  static JSValue js_parse_json(JSContext* ctx, const uint8_t* buf, size_t size)
+  {
+    // QuickJS requires the input to be null-terminated, so it is copied to a
+    // buffer which is reused across calls
+    static thread_local std::string buf_null_terminated;
+    buf_null_terminated.assign((const char*)buf, size);
+
+    JSValue obj =
+      JS_ParseJSON(ctx, buf_null_terminated.c_str(), size, "<json>");
+
+    if (JS_IsException(obj))
+      js_dump_error(ctx);
+
+    return obj;
+  }
+
   static JSValue js_buf_to_json_compatible(
     JSContext* ctx, JSValueConst, int argc, JSValueConst* argv)
   {
@@ -314,17 +330,7 @@ namespace ccfapp
     if (!buf)
       return JS_ThrowTypeError(ctx, "Argument must be an ArrayBuffer");
 
-    std::vector<uint8_t> buf_null_terminated(buf_size + 1);
-    buf_null_terminated[buf_size] = 0;
-    buf_null_terminated.assign(buf, buf + buf_size);
-
-    JSValue obj =
-      JS_ParseJSON(ctx, (char*)buf_null_terminated.data(), buf_size, "<json>");
-
-    if (JS_IsException(obj))
-      js_dump_error(ctx);
-
-    return obj;
+    return js_parse_json(ctx, buf, buf_size);
   }
 
   static JSValue js_kv_map_has(
@@ -364,13 +370,12 @@ namespace ccfapp
     if (!key)
       return JS_ThrowTypeError(ctx, "Argument must be an ArrayBuffer");
 
-    auto val = map_view->get({key, key + key_size});
+    auto val = map_view->get_ref({key, key + key_size});
 
-    if (!val.has_value())
+    if (val == nullptr)
       return JS_UNDEFINED;
 
-    JSValue buf =
-      JS_NewArrayBufferCopy(ctx, val.value().data(), val.value().size());
+    JSValue buf = JS_NewArrayBufferCopy(ctx, val->data(), val->size());
 
     if (JS_IsException(buf))
       js_dump_error(ctx);
@@ -378,6 +383,66 @@ namespace ccfapp
     return buf;
   }
 
+  // Looks up the key passed as the only argument, setting value to the value
+  // at that key without copying it. If value is left null, the returned
+  // JSValue is the exception or undefined result for the caller to return.
+  static JSValue js_kv_map_get_ref(
+    JSContext* ctx,
+    JSValueConst this_val,
+    int argc,
+    JSValueConst* argv,
+    const KVMap::TxView::ValueType*& value)
+  {
+    auto map_view =
+      static_cast<KVMap::TxView*>(JS_GetOpaque(this_val, kv_map_view_class_id));
+
+    if (argc != 1)
+      return JS_ThrowTypeError(
+        ctx, "Passed %d arguments, but expected 1", argc);
+
+    size_t key_size;
+    uint8_t* key = JS_GetArrayBuffer(ctx, &key_size, argv[0]);
+
+    if (!key)
+      return JS_ThrowTypeError(ctx, "Argument must be an ArrayBuffer");
+
+    value = map_view->get_ref({key, key + key_size});
+    return JS_UNDEFINED;
+  }
+
+  // Equivalent to ccf.bufToStr(map.get(key)), without the intermediate
+  // ArrayBuffer
+  static JSValue js_kv_map_get_str(
+    JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv)
+  {
+    const KVMap::TxView::ValueType* val = nullptr;
+    auto ret = js_kv_map_get_ref(ctx, this_val, argc, argv, val);
+
+    if (val == nullptr)
+      return ret;
+
+    JSValue str = JS_NewStringLen(ctx, (const char*)val->data(), val->size());
+
+    if (JS_IsException(str))
+      js_dump_error(ctx);
+
+    return str;
+  }
+
+  // Equivalent to ccf.bufToJsonCompatible(map.get(key)), without the
+  // intermediate ArrayBuffer
+  static JSValue js_kv_map_get_json_compatible(
+    JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv)
+  {
+    const KVMap::TxView::ValueType* val = nullptr;
+    auto ret = js_kv_map_get_ref(ctx, this_val, argc, argv, val);
+
+    if (val == nullptr)
+      return ret;
+
+    return js_parse_json(ctx, val->data(), val->size());
+  }
+
   static JSValue js_kv_map_delete(
     JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv)
   {
@@ -554,6 +619,23 @@ namespace ccfapp
       "get",
       JS_NewCFunction(ctx, ccfapp::js_kv_map_get, "get", 1));
 
+    // Extensions to Map, which avoid copying values
+    JS_SetPropertyStr(
+      ctx,
+      view_val,
+      "getStr",
+      JS_NewCFunction(ctx, ccfapp::js_kv_map_get_str, "getStr", 1));
+
+    JS_SetPropertyStr(
+      ctx,
+      view_val,
+      "getJsonCompatible",
+      JS_NewCFunction(
+        ctx,
+        ccfapp::js_kv_map_get_json_compatible,
+        "getJsonCompatible",
+        1));
+
     auto setter = ccfapp::js_kv_map_set;
     auto deleter = ccfapp::js_kv_map_delete;
 
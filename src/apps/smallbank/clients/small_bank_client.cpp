@@ -3,17 +3,30 @@
 #include "../smallbank_serializer.h"
 #include "perf_client.h"
 
+#include <algorithm>
+#include <cmath>
+
 using namespace std;
 using namespace nlohmann;
 
 struct SmallBankClientOptions : public client::PerfOptions
 {
   size_t total_accounts = 10;
+  double zipf_exponent = 0.0;
 
   SmallBankClientOptions(CLI::App& app, const std::string& default_pid_file) :
     client::PerfOptions("Small_Bank_ClientCpp", default_pid_file, app)
   {
     app.add_option("--accounts", total_accounts)->capture_default_str();
+    app
+      .add_option(
+        "--zipf",
+        zipf_exponent,
+        "Exponent of the Zipfian distribution from which accounts are chosen, "
+        "so that a few hot accounts are involved in most transactions. 0 "
+        "chooses accounts uniformly")
+      ->capture_default_str()
+      ->check(CLI::NonNegativeNumber);
   }
 };
 
@@ -39,6 +52,40 @@ private:
                                  "SmallBank_deposit_checking",
                                  "SmallBank_balance"};
 
+  // Cumulative distribution of account choices, when these are Zipfian
+  std::vector<double> account_cdf;
+
+  void build_account_cdf()
+  {
+    account_cdf.resize(options.total_accounts);
+
+    double total = 0.0;
+    for (size_t i = 0; i < options.total_accounts; ++i)
+    {
+      total += 1.0 / std::pow(i + 1, options.zipf_exponent);
+      account_cdf[i] = total;
+    }
+
+    for (auto& p : account_cdf)
+    {
+      p /= total;
+    }
+  }
+
+  size_t choose_account()
+  {
+    if (account_cdf.empty())
+    {
+      return rand_range(options.total_accounts);
+    }
+
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    const auto it = std::lower_bound(
+      account_cdf.begin(), account_cdf.end(), dist(rand_generator));
+    return std::min<size_t>(
+      std::distance(account_cdf.begin(), it), options.total_accounts - 1);
+  }
+
   void print_accounts(const string& header = {})
   {
     if (!header.empty())
@@ -90,6 +137,11 @@ private:
     // Reserve space for transfer transactions
     prepared_txs.resize(options.num_transactions);
 
+    if (options.zipf_exponent > 0.0)
+    {
+      build_account_cdf();
+    }
+
     for (decltype(options.num_transactions) i = 0; i < options.num_transactions;
          i++)
     {
@@ -103,7 +155,7 @@ private:
         case TransactionTypes::TransactSavings:
         {
           smallbank::Transaction t;
-          t.name = to_string(rand_range(options.total_accounts));
+          t.name = to_string(choose_account());
           t.value = rand_range<int>(-50, 50);
           serialized_body = t.serialize();
         }
@@ -111,11 +163,22 @@ private:
 
         case TransactionTypes::Amalgamate:
         {
-          unsigned int src_account = rand_range(options.total_accounts);
-          unsigned int dest_account = rand_range(options.total_accounts - 1);
-          if (dest_account >= src_account)
+          size_t src_account = choose_account();
+          size_t dest_account;
+          if (account_cdf.empty())
+          {
+            dest_account = rand_range(options.total_accounts - 1);
+            if (dest_account >= src_account)
+            {
+              dest_account += 1;
+            }
+          }
+          else
           {
-            dest_account += 1;
+            do
+            {
+              dest_account = choose_account();
+            } while (dest_account == src_account);
           }
           smallbank::Amalgamate a;
           a.src = to_string(src_account);
@@ -127,7 +190,7 @@ private:
         case TransactionTypes::WriteCheck:
         {
           smallbank::Transaction t;
-          t.name = to_string(rand_range(options.total_accounts));
+          t.name = to_string(choose_account());
           t.value = rand_range<int>(50);
           serialized_body = t.serialize();
         }
@@ -136,7 +199,7 @@ private:
         case TransactionTypes::DepositChecking:
         {
           smallbank::Transaction t;
-          t.name = to_string(rand_range(options.total_accounts));
+          t.name = to_string(choose_account());
           t.value = rand_range<int>(50) + 1;
           serialized_body = t.serialize();
         }
@@ -145,7 +208,7 @@ private:
         case TransactionTypes::GetBalance:
         {
           smallbank::AccountName a;
-          a.name = to_string(rand_range(options.total_accounts));
+          a.name = to_string(choose_account());
           serialized_body = a.serialize();
         }
         break;
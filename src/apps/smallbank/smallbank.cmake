@@ -82,6 +82,27 @@ if(BUILD_TESTS)
       --use-websockets
   )
 
+  # Transactions are concentrated on a few hot accounts, so that many of them
+  # conflict
+  add_perf_test(
+    NAME small_bank_zipf_client_test_cft
+    PYTHON_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/tests/small_bank_client.py
+    CLIENT_BIN ./small_bank_client
+    LABEL SB_zipf
+    CONSENSUS cft
+    ADDITIONAL_ARGS
+      --transactions
+      ${SMALL_BANK_ITERATIONS}
+      --max-writes-ahead
+      250
+      --accounts
+      1000
+      --zipf
+      0.99
+      --metrics-file
+      small_bank_cft_zipf_metrics.json
+  )
+
   add_perf_test(
     NAME small_bank_sigs_client_test_cft
     PYTHON_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/tests/small_bank_client.py
@@ -3,6 +3,10 @@
 #define PICOBENCH_IMPLEMENT
 
 #include "consensus/aft/request.h"
+#include "ds/json.h"
+#include "kv/serialise_entry_json.h"
+#include "kv/serialise_entry_msgpack.h"
+#include "kv/serialise_entry_typed_binary.h"
 #include "node/encryptor.h"
 #include "node/history.h"
 #include "node/rpc/serdes.h"
@@ -18,11 +22,39 @@ extern "C"
 const std::string account_name = "10";
 const int transaction_value = 50;
 
+// Account, as stored in a KV table, with the field lists used by each value
+// serialiser
+struct AccountRecord
+{
+  std::string name;
+  int64_t checking_amt;
+  int64_t savings_amt;
+  std::vector<int64_t> recent_transactions;
+
+  MSGPACK_DEFINE(name, checking_amt, savings_amt, recent_transactions);
+};
+DECLARE_JSON_TYPE(AccountRecord);
+DECLARE_JSON_REQUIRED_FIELDS(
+  AccountRecord, name, checking_amt, savings_amt, recent_transactions);
+DECLARE_TYPED_BINARY_FIELDS(
+  AccountRecord, name, checking_amt, savings_amt, recent_transactions);
+
+using MsgPack = kv::serialisers::MsgPackSerialiser<AccountRecord>;
+using Json = kv::serialisers::JsonSerialiser<AccountRecord>;
+using TypedBinary = kv::serialisers::TypedBinarySerialiser<AccountRecord>;
+
 inline void clobber_memory()
 {
   asm volatile("" : : : "memory");
 }
 
+// Makes t visible outside of the benchmark, so that it is not optimised away
+template <typename T>
+inline void escape(const T& t)
+{
+  asm volatile("" : : "r"(&t) : "memory");
+}
+
 // Helper functions
 std::shared_ptr<ccf::LedgerSecrets> create_ledger_secrets()
 {
@@ -81,6 +113,10 @@ static std::vector<uint8_t> kv_serialized_data(std::vector<uint8_t>& data)
   auto pending_tx = tx.commit_reserved();
   return pending_tx.data;
 }
+static AccountRecord account_record()
+{
+  return {account_name, 1000, 2000, {50, -20, 10, 5, -100}};
+}
 // End Helper functions
 
 // Test functions
@@ -138,6 +174,57 @@ static void json_msgpack_des(picobench::state& s)
   s.stop_timer();
 }
 
+template <typename S>
+static void account_ser(picobench::state& s)
+{
+  const auto record = account_record();
+  s.start_timer();
+  for (int i = 0; i < s.iterations(); i++)
+  {
+    auto rep = S::to_serialised(record);
+    clobber_memory();
+  }
+  s.stop_timer();
+}
+
+template <typename S>
+static void account_des(picobench::state& s)
+{
+  const auto rep = S::to_serialised(account_record());
+  s.start_timer();
+  for (int i = 0; i < s.iterations(); i++)
+  {
+    auto record = S::from_serialised(rep);
+    clobber_memory();
+  }
+  s.stop_timer();
+}
+
+// Reads the checking balance only, as most SmallBank transactions do. The
+// typed binary serialiser reads the field in place, others deserialise the
+// whole account.
+template <typename S>
+static void account_read_balance(picobench::state& s)
+{
+  const auto rep = S::to_serialised(account_record());
+  escape(rep);
+  s.start_timer();
+  for (int i = 0; i < s.iterations(); i++)
+  {
+    int64_t balance;
+    if constexpr (std::is_same_v<S, TypedBinary>)
+    {
+      balance = S::template read_field<&AccountRecord::checking_amt>(rep);
+    }
+    else
+    {
+      balance = S::from_serialised(rep).checking_amt;
+    }
+    escape(balance);
+  }
+  s.stop_timer();
+}
+
 static void run_mt_benchmark(picobench::state& s, std::vector<uint8_t> data)
 {
   ccf::MerkleTreeHistory tree;
@@ -195,6 +282,24 @@ PICOBENCH_SUITE("smallbank payload deserialize");
 PICOBENCH(raw_des).iterations(iters).samples(10);
 PICOBENCH(json_msgpack_des).iterations(iters).samples(10);
 
+PICOBENCH_SUITE("smallbank account serialize");
+PICOBENCH(account_ser<MsgPack>).iterations(iters).samples(10).baseline();
+PICOBENCH(account_ser<Json>).iterations(iters).samples(10);
+PICOBENCH(account_ser<TypedBinary>).iterations(iters).samples(10);
+
+PICOBENCH_SUITE("smallbank account deserialize");
+PICOBENCH(account_des<MsgPack>).iterations(iters).samples(10).baseline();
+PICOBENCH(account_des<Json>).iterations(iters).samples(10);
+PICOBENCH(account_des<TypedBinary>).iterations(iters).samples(10);
+
+PICOBENCH_SUITE("smallbank account read balance");
+PICOBENCH(account_read_balance<MsgPack>)
+  .iterations(iters)
+  .samples(10)
+  .baseline();
+PICOBENCH(account_read_balance<Json>).iterations(iters).samples(10);
+PICOBENCH(account_read_balance<TypedBinary>).iterations(iters).samples(10);
+
 PICOBENCH_SUITE("smallbank payload merkle tree bench");
 PICOBENCH(raw_mt_append).iterations(iters).samples(10);
 PICOBENCH(json_msgpack_mt_append).iterations(iters).samples(10);
@@ -8,6 +8,7 @@
 #include "enclave/rpc_sessions.h"
 #include "http/http_rpc_context.h"
 #include "kv/tx.h"
+#include "node/caller_certs.h"
 #include "request_message.h"
 
 namespace aft
@@ -130,6 +131,21 @@ namespace aft
       "Deserialised request but it was not found in the requests map");
     Request request = req_v.value();
 
+    // The caller's certificate is recorded by digest, either by this
+    // transaction or by an earlier one
+    if (request.caller_cert.empty() && request.caller_cert_digest.has_value())
+    {
+      auto caller_cert =
+        ccf::resolve_caller_cert(tx, request.caller_cert_digest.value());
+      if (!caller_cert.has_value())
+      {
+        throw std::logic_error(fmt::format(
+          "Replayed request refers to unknown caller certificate {}",
+          request.caller_cert_digest.value()));
+      }
+      request.caller_cert = std::move(caller_cert.value());
+    }
+
     auto ctx = create_request_ctx(request);
 
     auto request_message = RequestMessage::deserialize(
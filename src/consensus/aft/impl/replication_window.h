@@ -0,0 +1,208 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include "consensus/aft/raft_types.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <optional>
+
+namespace aft
+{
+  // Flow control for the stream of AppendEntries sent by the primary to a
+  // single follower. Batches that have been sent but not yet acknowledged are
+  // in flight, and no new batch is sent once either the number of entries or
+  // the (estimated) number of bytes in flight reaches the window limit.
+  //
+  // Acknowledgements are used to measure the round-trip time to the follower
+  // and the rate at which it appends entries, from which the batch size for
+  // that follower is derived.
+  class ReplicationWindow
+  {
+  public:
+    static constexpr size_t max_entries_in_flight = 1 << 16;
+    static constexpr size_t max_bytes_in_flight = 1 << 20;
+
+    // Number of batches the window should hold per round-trip, so that the
+    // follower is kept busy while acknowledgements are in transit
+    static constexpr size_t pipeline_depth = 4;
+
+  private:
+    struct Batch
+    {
+      Index end_idx;
+      size_t entries;
+      size_t bytes;
+      std::chrono::milliseconds sent_at;
+    };
+
+    std::deque<Batch> in_flight;
+    size_t entries_in_flight = 0;
+    size_t bytes_in_flight = 0;
+
+    // Smoothed round-trip time, in milliseconds, as in RFC 6298
+    double rtt = 0.0;
+    bool has_rtt = false;
+
+    // Smoothed rate, in entries per millisecond, at which the follower
+    // acknowledges entries while the window is not empty
+    double ack_rate = 0.0;
+    std::chrono::milliseconds rate_period_start = std::chrono::milliseconds(0);
+    size_t acked_in_period = 0;
+
+  public:
+    bool is_open() const
+    {
+      return entries_in_flight < max_entries_in_flight &&
+        bytes_in_flight < max_bytes_in_flight;
+    }
+
+    bool is_empty() const
+    {
+      return in_flight.empty();
+    }
+
+    /** Records a batch of entries sent to the follower
+     *
+     * @param start_idx First index in the batch
+     * @param end_idx Last index in the batch
+     * @param bytes Estimated size of the batch
+     * @param now Current time
+     */
+    void on_send(
+      Index start_idx,
+      Index end_idx,
+      size_t bytes,
+      std::chrono::milliseconds now)
+    {
+      if (end_idx < start_idx)
+      {
+        // Heartbeats carry no entries and are not subject to flow control
+        return;
+      }
+
+      if (in_flight.empty())
+      {
+        rate_period_start = now;
+        acked_in_period = 0;
+      }
+
+      const size_t entries = end_idx - start_idx + 1;
+      in_flight.push_back({end_idx, entries, bytes, now});
+      entries_in_flight += entries;
+      bytes_in_flight += bytes;
+    }
+
+    /** Records that the follower has appended all entries up to last_idx
+     *
+     * @param last_idx Last index acknowledged by the follower
+     * @param now Current time
+     */
+    void on_ack(Index last_idx, std::chrono::milliseconds now)
+    {
+      std::optional<std::chrono::milliseconds> sent_at = std::nullopt;
+      while (!in_flight.empty() && in_flight.front().end_idx <= last_idx)
+      {
+        const auto& batch = in_flight.front();
+        sent_at = batch.sent_at;
+        entries_in_flight -= batch.entries;
+        bytes_in_flight -= batch.bytes;
+        acked_in_period += batch.entries;
+        in_flight.pop_front();
+      }
+
+      if (!sent_at.has_value())
+      {
+        return;
+      }
+
+      const double sample = (now - sent_at.value()).count();
+      if (!has_rtt)
+      {
+        rtt = sample;
+        has_rtt = true;
+      }
+      else
+      {
+        constexpr auto alpha = 0.125;
+        rtt = (1 - alpha) * rtt + alpha * sample;
+      }
+
+      if (now > rate_period_start)
+      {
+        const double rate_sample = static_cast<double>(acked_in_period) /
+          (now - rate_period_start).count();
+        constexpr auto alpha = 0.25;
+        ack_rate = ack_rate == 0.0 ?
+          rate_sample :
+          (1 - alpha) * ack_rate + alpha * rate_sample;
+        rate_period_start = now;
+        acked_in_period = 0;
+      }
+    }
+
+    /** Forgets all batches in flight, e.g. because the follower rejected an
+     * AppendEntries and the primary will resume from its last matching index,
+     * or because no acknowledgement was received for too long
+     */
+    void reset()
+    {
+      in_flight.clear();
+      entries_in_flight = 0;
+      bytes_in_flight = 0;
+      acked_in_period = 0;
+    }
+
+    /** Whether the oldest batch in flight was sent more than timeout ago
+     *
+     * @param now Current time
+     * @param timeout Time after which a batch is considered lost
+     */
+    bool is_stalled(
+      std::chrono::milliseconds now, std::chrono::milliseconds timeout) const
+    {
+      return !in_flight.empty() && now - in_flight.front().sent_at > timeout;
+    }
+
+    /** Number of entries to send in each batch to this follower
+     *
+     * @param max_batch_size Upper bound on the batch size, derived from the
+     *  AppendEntries size limit
+     */
+    Index batch_size(Index max_batch_size) const
+    {
+      if (!has_rtt || ack_rate == 0.0)
+      {
+        return max_batch_size;
+      }
+
+      // Round-trip times below the clock resolution are observed as 0
+      const auto rtt_ms = std::max(rtt, 1.0);
+      const auto target =
+        static_cast<Index>(ack_rate * rtt_ms / pipeline_depth);
+      return std::clamp<Index>(target, 1, std::max<Index>(max_batch_size, 1));
+    }
+
+    size_t get_entries_in_flight() const
+    {
+      return entries_in_flight;
+    }
+
+    size_t get_bytes_in_flight() const
+    {
+      return bytes_in_flight;
+    }
+
+    double get_rtt() const
+    {
+      return rtt;
+    }
+
+    double get_ack_rate() const
+    {
+      return ack_rate;
+    }
+  };
+}
@@ -5,7 +5,9 @@
 #include "ds/logger.h"
 #include "ds/serialized.h"
 #include "ds/spin_lock.h"
+#include "ds/tracing.h"
 #include "impl/execution.h"
+#include "impl/replication_window.h"
 #include "impl/request_message.h"
 #include "impl/state.h"
 #include "impl/view_change_tracker.h"
@@ -15,6 +17,8 @@
 #include "node/node_types.h"
 #include "node/progress_tracker.h"
 #include "node/request_tracker.h"
+#include "node/rpc/commit_notifier.h"
+#include "node/rpc/pending_reads.h"
 #include "node/rpc/tx_status.h"
 #include "node/signatures.h"
 #include "raft_types.h"
@@ -52,6 +56,9 @@ namespace aft
       // the highest matching index with the node that was confirmed
       Index match_idx;
 
+      // entries sent to the node but not yet acknowledged
+      ReplicationWindow window;
+
       NodeState() = default;
 
       NodeState(
@@ -76,6 +83,8 @@ namespace aft
 
     ReplicaState replica_state;
     std::chrono::milliseconds timeout_elapsed;
+    // Time elapsed since the node started, as reported by periodic()
+    std::chrono::milliseconds current_time;
     // Last (committable) index preceding the node's election, this is
     // used to decide when to start issuing signatures. While commit_idx
     // hasn't caught up with election_index, a newly elected leader is
@@ -102,6 +111,7 @@ namespace aft
 
     size_t entry_size_not_limited = 0;
     size_t entry_count = 0;
+    size_t avg_entry_size = 0;
     Index entries_batch_size = 1;
     static constexpr int batch_window_size = 100;
     int batch_window_sum = 0;
@@ -119,11 +129,16 @@ namespace aft
 
   public:
     static constexpr size_t append_entries_size_limit = 20000;
+    // Entries in flight to a follower are considered lost after this many
+    // request timeouts without an acknowledgement
+    static constexpr size_t append_entries_stall_factor = 10;
     std::unique_ptr<LedgerProxy> ledger;
     std::shared_ptr<ccf::NodeToNode> channels;
     std::shared_ptr<SnapshotterProxy> snapshotter;
     std::shared_ptr<enclave::RPCSessions> rpc_sessions;
     std::shared_ptr<enclave::RPCMap> rpc_map;
+    std::shared_ptr<ccf::CommitNotifier> commit_notifier;
+    std::shared_ptr<ccf::PendingReads> pending_reads;
     std::set<NodeId> backup_nodes;
 
   public:
@@ -151,6 +166,7 @@ namespace aft
 
       replica_state(Follower),
       timeout_elapsed(0),
+      current_time(0),
 
       state(state_),
       executor(executor_),
@@ -187,6 +203,16 @@ namespace aft
       }
     }
 
+    void set_commit_notifier(std::shared_ptr<ccf::CommitNotifier> n)
+    {
+      commit_notifier = n;
+    }
+
+    void set_pending_reads(std::shared_ptr<ccf::PendingReads> p)
+    {
+      pending_reads = p;
+    }
+
     NodeId leader()
     {
       return leader_id;
@@ -492,8 +518,17 @@ namespace aft
       switch (serialized::peek<RaftMsgType>(data, size))
       {
         case raft_append_entries:
-          recv_append_entries(data, size);
+        {
+          const auto last_idx = recv_append_entries(data, size);
+          // Pending reads are posted to the threads of their sessions, which
+          // execute them without the lock, as they may call back into
+          // consensus
+          if (pending_reads != nullptr)
+          {
+            pending_reads->on_applied(last_idx);
+          }
           break;
+        }
 
         case raft_append_entries_response:
           recv_append_entries_response(data, size);
@@ -605,6 +640,7 @@ namespace aft
       }
 
       timeout_elapsed += elapsed;
+      current_time += elapsed;
 
       if (replica_state == Leader)
       {
@@ -614,10 +650,33 @@ namespace aft
           timeout_elapsed = 0ms;
 
           update_batch_size();
-          // Send newly available entries to all nodes.
-          for (const auto& it : nodes)
+          // Send newly available entries to all nodes. Nodes whose window is
+          // full still receive a heartbeat.
+          for (auto& it : nodes)
           {
-            send_append_entries(it.first, it.second.sent_idx + 1);
+            auto& window = it.second.window;
+            if (window.is_stalled(
+                  current_time, request_timeout * append_entries_stall_factor))
+            {
+              // The batches in flight may have been lost, so send them again
+              LOG_DEBUG_FMT(
+                "No append entries response from {} since {}, resuming from {}",
+                it.first,
+                it.second.sent_idx,
+                it.second.match_idx + 1);
+              it.second.sent_idx = it.second.match_idx;
+              window.reset();
+            }
+
+            if (window.is_open())
+            {
+              send_append_entries(it.first, it.second.sent_idx + 1);
+            }
+            else
+            {
+              send_append_entries_range(
+                it.first, it.second.sent_idx + 1, it.second.sent_idx);
+            }
           }
         }
       }
@@ -734,13 +793,15 @@ namespace aft
   private:
     inline void update_batch_size()
     {
-      auto avg_entry_size = (entry_count == 0) ?
-        append_entries_size_limit :
-        entry_size_not_limited / entry_count;
+      if (entry_count != 0)
+      {
+        avg_entry_size = entry_size_not_limited / entry_count;
+      }
 
-      auto batch_size = (avg_entry_size == 0) ?
-        append_entries_size_limit / 2 :
-        append_entries_size_limit / avg_entry_size;
+      auto batch_size = (entry_count == 0) ?
+        1 :
+        ((avg_entry_size == 0) ? append_entries_size_limit / 2 :
+                                 append_entries_size_limit / avg_entry_size);
 
       auto batch_avg = batch_window_sum / batch_window_size;
       // balance out total batch size across batch window
@@ -824,23 +885,29 @@ namespace aft
 
     void send_append_entries(NodeId to, Index start_idx)
     {
-      Index end_idx = (state->last_idx == 0) ?
-        0 :
-        std::min(start_idx + entries_batch_size, state->last_idx);
-
-      for (Index i = end_idx; i < state->last_idx; i += entries_batch_size)
+      if (state->last_idx == 0 || start_idx > state->last_idx)
       {
-        send_append_entries_range(to, start_idx, i);
-        start_idx = std::min(i + 1, state->last_idx);
+        // Nothing new to send, but the node still expects a heartbeat
+        send_append_entries_range(to, start_idx, state->last_idx);
+        return;
       }
 
-      if (state->last_idx == 0 || end_idx <= state->last_idx)
+      // Send batches until all entries are sent, or the node's window is full.
+      // The remaining entries are sent as the node acknowledges earlier ones.
+      auto& window = nodes.at(to).window;
+      const auto batch_size = window.batch_size(entries_batch_size);
+
+      Index end_idx = std::min(start_idx + batch_size, state->last_idx);
+      while (window.is_open() &&
+             send_append_entries_range(to, start_idx, end_idx) &&
+             end_idx < state->last_idx)
       {
-        send_append_entries_range(to, start_idx, state->last_idx);
+        start_idx = end_idx + 1;
+        end_idx = std::min(end_idx + batch_size, state->last_idx);
       }
     }
 
-    void send_append_entries_range(NodeId to, Index start_idx, Index end_idx)
+    bool send_append_entries_range(NodeId to, Index start_idx, Index end_idx)
     {
       const auto prev_idx = start_idx - 1;
       const auto prev_term = get_term_internal(prev_idx);
@@ -871,16 +938,30 @@ namespace aft
       if (!channels->send_authenticated(
             ccf::NodeMsgType::consensus_msg, to, ae))
       {
-        return;
+        return false;
       }
 
       // Record the most recent index we have sent to this node.
       node.sent_idx = end_idx;
+      node.window.on_send(
+        start_idx,
+        end_idx,
+        (end_idx - start_idx + 1) * avg_entry_size,
+        current_time);
+      return true;
     }
 
-    void recv_append_entries(const uint8_t* data, size_t size)
+    // Returns the index of the last entry in the log once the entries have
+    // been processed, read under the same lock
+    Index recv_append_entries(const uint8_t* data, size_t size)
     {
       std::lock_guard<SpinLock> guard(state->lock);
+      process_append_entries(data, size);
+      return state->last_idx;
+    }
+
+    void process_append_entries(const uint8_t* data, size_t size)
+    {
       AppendEntries r;
 
       try
@@ -1559,6 +1640,12 @@ namespace aft
       // Update next and match for the responding node.
       node->second.match_idx = std::min(r.last_log_idx, state->last_idx);
 
+      if (tracing::config::enabled())
+      {
+        tracing::PendingTraces::instance().on_ack(
+          r.from_node, node->second.match_idx);
+      }
+
       if (r.success == AppendEntriesResponseType::REQUIRE_EVIDENCE)
       {
         // We need to provide evidence to the replica that we can send it append
@@ -1588,6 +1675,7 @@ namespace aft
           "Recv append entries response to {} from {}: failed",
           state->my_node_id,
           r.from_node);
+        node->second.window.reset();
         send_append_entries(r.from_node, node->second.match_idx + 1);
         return;
       }
@@ -1598,6 +1686,20 @@ namespace aft
         r.from_node,
         r.last_log_idx);
       update_commit();
+
+      // Acknowledged entries leave the node's window. If entries were held
+      // back by the window, send them now rather than on the next timeout.
+      auto acked_node = nodes.find(r.from_node);
+      if (replica_state == Leader && acked_node != nodes.end())
+      {
+        auto& window = acked_node->second.window;
+        window.on_ack(r.last_log_idx, current_time);
+        const auto sent_idx = acked_node->second.sent_idx;
+        if (sent_idx < state->last_idx && window.is_open())
+        {
+          send_append_entries(r.from_node, sent_idx + 1);
+        }
+      }
     }
 
     void send_request_vote(NodeId to)
@@ -1867,6 +1969,7 @@ namespace aft
       {
         it->second.match_idx = 0;
         it->second.sent_idx = next - 1;
+        it->second.window.reset();
 
         // Send an empty append_entries to all nodes.
         send_append_entries(it->first, next);
@@ -2025,6 +2128,11 @@ namespace aft
 
       state->commit_idx = idx;
 
+      if (tracing::config::enabled())
+      {
+        tracing::PendingTraces::instance().on_commit(idx);
+      }
+
       LOG_DEBUG_FMT("Compacting...");
       snapshotter->compact(idx);
       if (replica_state == Leader)
@@ -2034,6 +2142,12 @@ namespace aft
       store->compact(idx);
       ledger->commit(idx);
 
+      if (commit_notifier != nullptr)
+      {
+        commit_notifier->on_commit(
+          idx, [this](Index i) { return get_term_internal(i); });
+      }
+
       LOG_DEBUG_FMT("Commit on {}: {}", state->my_node_id, idx);
 
       // Examine all configurations that are followed by a globally committed
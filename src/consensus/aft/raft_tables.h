@@ -18,5 +18,6 @@ namespace aft
     ccf::Tables::SIGNATURES,
     ccf::Tables::BACKUP_SIGNATURES,
     ccf::Tables::NONCES,
+    ccf::Tables::CALLER_CERTS,
     ccf::Tables::NEW_VIEWS};
 }
\ No newline at end of file
@@ -2,15 +2,20 @@
 // Licensed under the Apache 2.0 License.
 #pragma once
 
+#include "crypto/hash.h"
 #include "ds/json.h"
 #include "kv/map.h"
+#include "node/caller_certs.h"
 #include "node/entities.h"
 
 #include <msgpack/msgpack.hpp>
+#include <optional>
 #include <vector>
 
 namespace aft
 {
+  using ccf::CallerCertFormat;
+
   struct Request
   {
     uint64_t caller_id;
@@ -19,17 +24,27 @@ namespace aft
     std::vector<uint8_t> raw;
     uint8_t frame_format = enclave::FrameFormat::http;
 
-    MSGPACK_DEFINE(caller_id, rid, caller_cert, raw, frame_format);
+    // Set instead of caller_cert once the certificate has been recorded in the
+    // caller certificates table
+    std::optional<crypto::Sha256Hash> caller_cert_digest = std::nullopt;
+
+    MSGPACK_DEFINE(
+      caller_id, rid, caller_cert, raw, frame_format, caller_cert_digest);
 
     std::vector<uint8_t> serialise()
     {
-      bool include_caller = false;
-      size_t size = sizeof(caller_id) + sizeof(rid) + sizeof(include_caller) +
+      auto caller_format = CallerCertFormat::None;
+      size_t size = sizeof(caller_id) + sizeof(rid) + sizeof(caller_format) +
         sizeof(size_t) + raw.size() + sizeof(enclave::FrameFormat);
       if (!caller_cert.empty())
       {
         size += sizeof(size_t) + caller_cert.size();
-        include_caller = true;
+        caller_format = CallerCertFormat::Cert;
+      }
+      else if (caller_cert_digest.has_value())
+      {
+        size += crypto::Sha256Hash::SIZE;
+        caller_format = CallerCertFormat::Digest;
       }
 
       std::vector<uint8_t> serialized_req(size);
@@ -37,12 +52,16 @@ namespace aft
       auto size_ = serialized_req.size();
       serialized::write(data_, size_, caller_id);
       serialized::write(data_, size_, rid);
-      serialized::write(data_, size_, include_caller);
-      if (include_caller)
+      serialized::write(data_, size_, caller_format);
+      if (caller_format == CallerCertFormat::Cert)
       {
         serialized::write(data_, size_, caller_cert.size());
         serialized::write(data_, size_, caller_cert.data(), caller_cert.size());
       }
+      else if (caller_format == CallerCertFormat::Digest)
+      {
+        serialized::write(data_, size_, caller_cert_digest->h);
+      }
       serialized::write(data_, size_, raw.size());
       serialized::write(data_, size_, raw.data(), raw.size());
 
@@ -54,12 +73,18 @@ namespace aft
     {
       caller_id = serialized::read<uint64_t>(data_, size_);
       rid = serialized::read<kv::TxHistory::RequestID>(data_, size_);
-      auto includes_caller = serialized::read<bool>(data_, size_);
-      if (includes_caller)
+      auto caller_format = serialized::read<CallerCertFormat>(data_, size_);
+      if (caller_format == CallerCertFormat::Cert)
       {
         auto caller_size = serialized::read<size_t>(data_, size_);
         caller_cert = serialized::read(data_, size_, caller_size);
       }
+      else if (caller_format == CallerCertFormat::Digest)
+      {
+        crypto::Sha256Hash digest;
+        digest.h = serialized::read<decltype(digest.h)>(data_, size_);
+        caller_cert_digest = digest;
+      }
       auto raw_size = serialized::read<size_t>(data_, size_);
       raw = serialized::read(data_, size_, raw_size);
 
@@ -67,9 +92,10 @@ namespace aft
     }
   };
 
-  DECLARE_JSON_TYPE(Request);
+  DECLARE_JSON_TYPE_WITH_OPTIONAL_FIELDS(Request);
   DECLARE_JSON_REQUIRED_FIELDS(
     Request, caller_id, rid, caller_cert, raw, frame_format);
+  DECLARE_JSON_OPTIONAL_FIELDS(Request, caller_cert_digest);
 
   // size_t is used as the key of the table. This key will always be 0 since we
   // don't want to store the requests in the kv over time, we just want to get
@@ -75,6 +75,14 @@ int main(int argc, char** argv)
           items[3].begin(), items[3].end());
         driver->replicate(stoi(items[1]), stoi(items[2]), data);
         break;
+      case shash("latency"):
+        assert(items.size() == 3);
+        driver->set_latency(stoi(items[1]), ms(stoi(items[2])));
+        break;
+      case shash("run"):
+        assert(items.size() == 4);
+        driver->run(ms(stoi(items[1])), stoi(items[2]), stoi(items[3]));
+        break;
       case shash("disconnect"):
         assert(items.size() == 3);
         driver->disconnect(stoi(items[1]), stoi(items[2]));
@@ -6,6 +6,8 @@
 #include "ds/logger.h"
 
 #include <chrono>
+#include <map>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <string>
@@ -35,6 +37,84 @@ private:
   std::unordered_map<aft::NodeId, NodeDriver> _nodes;
   std::set<std::pair<aft::NodeId, aft::NodeId>> _connections;
 
+  // Simulated network, used by run(). A message between two nodes is
+  // delivered after the sum of their latencies.
+  struct InTransit
+  {
+    aft::NodeId from;
+    aft::NodeId to;
+    std::vector<uint8_t> contents;
+  };
+  std::unordered_map<aft::NodeId, ms> _latencies;
+  std::multimap<ms, InTransit> _in_transit;
+  ms _now = ms(0);
+
+  ms latency(aft::NodeId node_id)
+  {
+    auto it = _latencies.find(node_id);
+    return it == _latencies.end() ? ms(0) : it->second;
+  }
+
+  template <class Messages>
+  void send_one_queue(aft::NodeId node_id, Messages& messages)
+  {
+    while (messages.size())
+    {
+      auto [tgt_node_id, contents] = messages.front();
+      messages.pop_front();
+
+      if (
+        _connections.find(std::make_pair(node_id, tgt_node_id)) !=
+        _connections.end())
+      {
+        const auto data = reinterpret_cast<const uint8_t*>(&contents);
+        _in_transit.emplace(
+          _now + latency(node_id) + latency(tgt_node_id),
+          InTransit{
+            node_id, tgt_node_id, {data, data + sizeof(contents)}});
+      }
+    }
+  }
+
+  void send_all()
+  {
+    for (auto& node : _nodes)
+    {
+      auto channels = (aft::ChannelStubProxy*)node.second.raft->channels.get();
+      send_one_queue(node.first, channels->sent_request_vote);
+      send_one_queue(node.first, channels->sent_request_vote_response);
+      send_one_queue(node.first, channels->sent_append_entries);
+      send_one_queue(node.first, channels->sent_append_entries_response);
+    }
+  }
+
+  // Delivers all messages due by now, including responses to them if the
+  // nodes involved have no latency
+  void deliver_all()
+  {
+    send_all();
+    while (!_in_transit.empty() && _in_transit.begin()->first <= _now)
+    {
+      auto message = std::move(_in_transit.begin()->second);
+      _in_transit.erase(_in_transit.begin());
+      _nodes.at(message.to)
+        .raft->recv_message(message.contents.data(), message.contents.size());
+      send_all();
+    }
+  }
+
+  std::optional<aft::NodeId> find_primary()
+  {
+    for (auto& node : _nodes)
+    {
+      if (node.second.raft->is_primary())
+      {
+        return node.first;
+      }
+    }
+    return std::nullopt;
+  }
+
 public:
   RaftDriver(size_t number_of_nodes)
   {
@@ -249,6 +329,72 @@ public:
     _nodes.at(node_id).raft->replicate(kv::BatchVector{{idx, data, true}}, 1);
   }
 
+  void set_latency(aft::NodeId node_id, ms latency_)
+  {
+    std::cout << "  Note right of Node" << node_id
+              << ": latency " << latency_.count() << " ms" << std::endl;
+    _latencies[node_id] = latency_;
+  }
+
+  // Advances time by duration in 1ms steps, delivering messages according to
+  // node latencies. Every ms, the primary replicates entries_per_ms entries
+  // of entry_size bytes. Individual messages are not logged, but the
+  // replication throughput of each node over the run is reported.
+  void run(ms duration, size_t entries_per_ms, size_t entry_size)
+  {
+    std::cout << "  Note over Node0: run for " << duration.count()
+              << " ms, replicating " << entries_per_ms << " entries of "
+              << entry_size << " bytes per ms" << std::endl;
+
+    std::unordered_map<aft::NodeId, size_t> initial_ledger_size;
+    for (auto& node : _nodes)
+    {
+      initial_ledger_size[node.first] =
+        node.second.raft->ledger->ledger.size();
+    }
+
+    // Silence per-message and per-entry output for the duration of the run
+    auto cout_buf = std::cout.rdbuf(nullptr);
+
+    auto data = std::make_shared<std::vector<uint8_t>>(entry_size, 1);
+    for (auto end = _now + duration; _now < end;)
+    {
+      _now += ms(1);
+
+      auto primary = find_primary();
+      if (primary.has_value() && entries_per_ms > 0)
+      {
+        auto raft = _nodes.at(primary.value()).raft;
+        kv::BatchVector entries;
+        for (size_t i = 1; i <= entries_per_ms; ++i)
+        {
+          entries.emplace_back(raft->get_last_idx() + i, data, true);
+        }
+        raft->replicate(entries, raft->get_term());
+      }
+
+      for (auto& node : _nodes)
+      {
+        node.second.raft->periodic(ms(1));
+      }
+
+      deliver_all();
+    }
+
+    std::cout.rdbuf(cout_buf);
+
+    for (auto& node : _nodes)
+    {
+      const auto replicated =
+        node.second.raft->ledger->ledger.size() - initial_ledger_size[node.first];
+      std::cout << "  Note right of Node" << node.first << ": latency "
+                << latency(node.first).count() << " ms, replicated "
+                << replicated << " entries, "
+                << (double)replicated / duration.count() << " entries/ms, ci: "
+                << node.second.raft->get_commit_idx() << std::endl;
+    }
+  }
+
   void disconnect(aft::NodeId left, aft::NodeId right)
   {
     bool noop = true;
@@ -1073,15 +1073,159 @@ DOCTEST_TEST_CASE("Exceed append entries limit")
     ->sent_append_entries_response.pop_front();
   r0.recv_message(reinterpret_cast<uint8_t*>(&aer), sizeof(aer));
 
-  DOCTEST_REQUIRE(
-    (((aft::ChannelStubProxy*)r0.channels.get())->sent_append_entries.size() >
-       num_small_entries_sent &&
-     ((aft::ChannelStubProxy*)r0.channels.get())->sent_append_entries.size() <=
-       num_small_entries_sent + num_big_entries));
-  auto sent_entries = dispatch_all(
-    nodes, ((aft::ChannelStubProxy*)r0.channels.get())->sent_append_entries);
+  DOCTEST_INFO("Node 0 only sends what fits in Node 2's window");
+  auto first_window =
+    ((aft::ChannelStubProxy*)r0.channels.get())->sent_append_entries.size();
+  DOCTEST_REQUIRE(first_window > 0);
+  DOCTEST_REQUIRE(first_window < num_small_entries_sent);
+
+  DOCTEST_INFO("Node 0 sends the rest as Node 2 acknowledges entries");
+  size_t sent_entries = 0;
+  while (((aft::ChannelStubProxy*)r0.channels.get())->sent_msg_count() > 0)
+  {
+    sent_entries += dispatch_all(
+      nodes, ((aft::ChannelStubProxy*)r0.channels.get())->sent_append_entries);
+    dispatch_all(
+      nodes,
+      ((aft::ChannelStubProxy*)r2.channels.get())
+        ->sent_append_entries_response);
+  }
   DOCTEST_REQUIRE(
     (sent_entries > num_small_entries_sent &&
      sent_entries <= num_small_entries_sent + num_big_entries));
   DOCTEST_REQUIRE(r2.ledger->ledger.size() == individual_entries);
-}
\ No newline at end of file
+}
+
+DOCTEST_TEST_CASE("Replication window")
+{
+  aft::ReplicationWindow window;
+  const aft::Index max_batch_size = 100;
+
+  DOCTEST_INFO("Without measurements, batches are as large as allowed");
+  DOCTEST_REQUIRE(window.is_open());
+  DOCTEST_REQUIRE(window.batch_size(max_batch_size) == max_batch_size);
+
+  DOCTEST_INFO("Heartbeats are not in flight");
+  window.on_send(11, 10, 0, ms(0));
+  DOCTEST_REQUIRE(window.is_empty());
+
+  DOCTEST_INFO("The window closes when too many bytes are in flight");
+  const size_t batch_bytes = aft::ReplicationWindow::max_bytes_in_flight / 4;
+  aft::Index idx = 1;
+  for (size_t i = 0; i < 4; ++i)
+  {
+    DOCTEST_REQUIRE(window.is_open());
+    window.on_send(idx, idx + 9, batch_bytes, ms(0));
+    idx += 10;
+  }
+  DOCTEST_REQUIRE(!window.is_open());
+  DOCTEST_REQUIRE(window.get_entries_in_flight() == 40);
+
+  DOCTEST_INFO("Acknowledgements open the window and measure round-trips");
+  window.on_ack(20, ms(10));
+  DOCTEST_REQUIRE(window.is_open());
+  DOCTEST_REQUIRE(window.get_entries_in_flight() == 20);
+  DOCTEST_REQUIRE(window.get_rtt() == 10.0);
+  // 20 entries acknowledged in 10ms
+  DOCTEST_REQUIRE(window.get_ack_rate() == 2.0);
+  // 2 entries/ms * 10ms / 4 batches per round-trip
+  DOCTEST_REQUIRE(window.batch_size(max_batch_size) == 5);
+  DOCTEST_REQUIRE(window.batch_size(2) == 2);
+
+  DOCTEST_INFO("Stale batches are detected, and can be forgotten");
+  DOCTEST_REQUIRE(!window.is_stalled(ms(50), ms(100)));
+  DOCTEST_REQUIRE(window.is_stalled(ms(101), ms(100)));
+  window.reset();
+  DOCTEST_REQUIRE(window.is_empty());
+  DOCTEST_REQUIRE(window.get_bytes_in_flight() == 0);
+}
+
+DOCTEST_TEST_CASE("Replication resumes from the match index after a stall")
+{
+  auto kv_store0 = std::make_shared<Store>(0);
+  auto kv_store1 = std::make_shared<Store>(1);
+
+  aft::NodeId node_id0(0);
+  aft::NodeId node_id1(1);
+
+  ms request_timeout(10);
+
+  TRaft r0(
+    ConsensusType::CFT,
+    std::make_unique<Adaptor>(kv_store0),
+    std::make_unique<aft::LedgerStubProxy>(node_id0),
+    std::make_shared<aft::ChannelStubProxy>(),
+    std::make_shared<aft::StubSnapshotter>(),
+    nullptr,
+    nullptr,
+    cert,
+    std::make_shared<aft::State>(node_id0),
+    nullptr,
+    nullptr,
+    nullptr,
+    request_timeout,
+    ms(20),
+    ms(1000));
+  TRaft r1(
+    ConsensusType::CFT,
+    std::make_unique<Adaptor>(kv_store1),
+    std::make_unique<aft::LedgerStubProxy>(node_id1),
+    std::make_shared<aft::ChannelStubProxy>(),
+    std::make_shared<aft::StubSnapshotter>(),
+    nullptr,
+    nullptr,
+    cert,
+    std::make_shared<aft::State>(node_id1),
+    nullptr,
+    nullptr,
+    nullptr,
+    request_timeout,
+    ms(100),
+    ms(1000));
+
+  aft::Configuration::Nodes config;
+  config[node_id0] = {};
+  config[node_id1] = {};
+  r0.add_configuration(0, config);
+  r1.add_configuration(0, config);
+
+  map<aft::NodeId, TRaft*> nodes;
+  nodes[node_id0] = &r0;
+  nodes[node_id1] = &r1;
+
+  auto r0c = (aft::ChannelStubProxy*)r0.channels.get();
+  auto r1c = (aft::ChannelStubProxy*)r1.channels.get();
+
+  r0.periodic(ms(200));
+  DOCTEST_REQUIRE(1 == dispatch_all(nodes, r0c->sent_request_vote));
+  DOCTEST_REQUIRE(1 == dispatch_all(nodes, r1c->sent_request_vote_response));
+  DOCTEST_REQUIRE(1 == dispatch_all(nodes, r0c->sent_append_entries));
+  DOCTEST_REQUIRE(1 == dispatch_all(nodes, r1c->sent_append_entries_response));
+
+  auto data = std::make_shared<std::vector<uint8_t>>(10, 1);
+
+  DOCTEST_INFO("Node 1 acknowledges the first entry");
+  DOCTEST_REQUIRE(r0.replicate(kv::BatchVector{{1, data, true}}, 1));
+  r0.periodic(request_timeout);
+  DOCTEST_REQUIRE(1 == dispatch_all(nodes, r0c->sent_append_entries));
+  DOCTEST_REQUIRE(1 == dispatch_all(nodes, r1c->sent_append_entries_response));
+
+  DOCTEST_INFO("Acknowledgements of the next entries are lost");
+  DOCTEST_REQUIRE(r0.replicate(kv::BatchVector{{2, data, true}}, 1));
+  DOCTEST_REQUIRE(r0.replicate(kv::BatchVector{{3, data, true}}, 1));
+  r0.periodic(request_timeout);
+  DOCTEST_REQUIRE(1 == dispatch_all(nodes, r0c->sent_append_entries));
+  r1c->sent_append_entries_response.clear();
+
+  DOCTEST_INFO("Once stalled, Node 0 sends them again");
+  r0.periodic(request_timeout * r0.append_entries_stall_factor + ms(1));
+  DOCTEST_REQUIRE(
+    1 ==
+    dispatch_all_and_DOCTEST_CHECK(
+      nodes, r0c->sent_append_entries, [](const auto& msg) {
+        DOCTEST_REQUIRE(msg.prev_idx == 1);
+        DOCTEST_REQUIRE(msg.idx == 3);
+      }));
+  DOCTEST_REQUIRE(1 == dispatch_all(nodes, r1c->sent_append_entries_response));
+  DOCTEST_REQUIRE(r1.ledger->ledger.size() == 3);
+}
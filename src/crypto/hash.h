@@ -62,6 +62,11 @@ namespace crypto
     return !(lhs == rhs);
   }
 
+  inline bool operator<(const Sha256Hash& lhs, const Sha256Hash& rhs)
+  {
+    return lhs.h < rhs.h;
+  }
+
   class CSha256HashImpl;
   class CSha256Hash
   {
@@ -5,6 +5,7 @@
 #include "ds/buffer.h"
 #include "ds/ccf_assert.h"
 #include "ds/champ_map_serializers.h"
+#include "ds/parallel_for.h"
 
 #include <algorithm>
 #include <array>
@@ -410,9 +411,26 @@ namespace champ
   public:
     Map() : root(std::make_shared<SubNodes<K, V, H>>()) {}
 
-    static Map<K, V, H> deserialize_map(CBuffer serialized_state)
-    {
-      Map<K, V, H> map;
+    /** Deserialise a map serialised by Snapshot::serialize.
+     *
+     * Entries are parsed sequentially, and grouped by the child of the root
+     * in which they belong. The subtrees of the root are then built
+     * independently, concurrently if parallel_for is set, before the root is
+     * assembled from them.
+     */
+    static Map<K, V, H> deserialize_map(
+      CBuffer serialized_state,
+      const threading::ParallelFor& parallel_for = nullptr)
+    {
+      struct ParsedEntry
+      {
+        Hash hash;
+        K key;
+        V value;
+      };
+      constexpr size_t root_children = index_mask + 1;
+      std::array<std::vector<ParsedEntry>, root_children> children;
+
       const uint8_t* data = serialized_state.p;
       size_t size = serialized_state.rawSize();
 
@@ -429,9 +447,72 @@ namespace champ
         V value = champ::deserialize<V>(data, size);
         value_size -= size;
         serialized::skip(data, size, get_padding(value_size));
-        map = map.put(key, value);
+
+        const auto hash = static_cast<Hash>(H()(key));
+        children[mask(hash, 0)].push_back(
+          {hash, std::move(key), std::move(value)});
       }
-      return map;
+
+      std::array<Node<K, V, H>, root_children> nodes;
+      std::array<size_t, root_children> sizes = {};
+      std::array<size_t, root_children> serialized_sizes = {};
+
+      threading::for_indices(parallel_for, root_children, [&](size_t i) {
+        const auto& entries = children[i];
+        if (entries.size() == 1)
+        {
+          const auto& e = entries.front();
+          nodes[i] = std::make_shared<Entry<K, V>>(e.key, e.value);
+          sizes[i] = 1;
+          serialized_sizes[i] = get_size_with_padding<K, V>(e.key, e.value);
+        }
+        else if (entries.size() > 1)
+        {
+          SubNodes<K, V, H> sub_nodes;
+          for (const auto& e : entries)
+          {
+            const auto r = sub_nodes.put_mut(1, e.hash, e.key, e.value);
+            if (r == 0)
+            {
+              sizes[i]++;
+            }
+            serialized_sizes[i] +=
+              get_size_with_padding<K, V>(e.key, e.value) - r;
+          }
+          nodes[i] = std::make_shared<SubNodes<K, V, H>>(std::move(sub_nodes));
+        }
+      });
+
+      // Entries are stored before sub-nodes in the root, each in index order
+      std::vector<Node<K, V, H>> root_nodes;
+      Bitmap node_map;
+      Bitmap data_map;
+      size_t map_size = 0;
+      size_t serialized_size = 0;
+      for (SmallIndex i = 0; i < root_children; ++i)
+      {
+        if (children[i].size() == 1)
+        {
+          data_map = data_map.set(i);
+          root_nodes.push_back(nodes[i]);
+        }
+        map_size += sizes[i];
+        serialized_size += serialized_sizes[i];
+      }
+      for (SmallIndex i = 0; i < root_children; ++i)
+      {
+        if (children[i].size() > 1)
+        {
+          node_map = node_map.set(i);
+          root_nodes.push_back(nodes[i]);
+        }
+      }
+
+      return Map(
+        std::make_shared<SubNodes<K, V, H>>(
+          std::move(root_nodes), node_map, data_map),
+        map_size,
+        serialized_size);
     }
 
     size_t size() const
@@ -505,10 +586,22 @@ namespace champ
       Hash h_k;
       V* v;
 
+      KVTuple() : k(nullptr), h_k(0), v(nullptr) {}
+
       KVTuple(K* k_, Hash h_k_, V* v_) : k(k_), h_k(h_k_), v(v_) {}
     };
     const uintptr_t padding = 0;
 
+    // Entries are partitioned by the top bits of their hash, so that each
+    // partition covers a contiguous range of the serialised snapshot
+    static constexpr size_t partition_bits = 6;
+    static constexpr size_t partitions = 1 << partition_bits;
+
+    static size_t partition(Hash h)
+    {
+      return h >> (hash_bits - partition_bits);
+    }
+
     uint32_t add_padding(uint32_t data_size, uint8_t*& data, size_t& size) const
     {
       uint32_t padding_size = get_padding(data_size);
@@ -536,56 +629,95 @@ namespace champ
       return serialized_buffer;
     }
 
-    void serialize(uint8_t* data)
+    /** Serialise the map to data, which must be get_serialized_size() bytes.
+     *
+     * Entries are written in order of their hash, so that the same state is
+     * always serialised to the same bytes. Each partition of the hash space is
+     * sorted and written independently, concurrently if parallel_for is set.
+     * The output does not depend on parallel_for.
+     */
+    void serialize(
+      uint8_t* data, const threading::ParallelFor& parallel_for = nullptr)
     {
-      std::vector<KVTuple> ordered_state;
-      ordered_state.reserve(map.size());
-      size_t size = 0;
+      std::vector<KVTuple> entries;
+      entries.reserve(map.size());
+      std::array<size_t, partitions + 1> starts = {};
 
       map.foreach([&](auto& key, auto& value) {
-        K* k = &key;
-        V* v = &value;
-        uint32_t ks = champ::get_size(key);
-        uint32_t vs = champ::get_size(value);
-        uint32_t key_size = ks + get_padding(ks);
-        uint32_t value_size = vs + get_padding(vs);
+        const auto h = static_cast<Hash>(H()(key));
+        entries.emplace_back(&key, h, &value);
+        starts[partition(h) + 1]++;
+        return true;
+      });
+
+      for (size_t i = 0; i < partitions; ++i)
+      {
+        starts[i + 1] += starts[i];
+      }
 
-        size += (key_size + value_size);
+      // Counting sort into partitions
+      std::vector<KVTuple> ordered_state(entries.size());
+      {
+        auto next = starts;
+        for (const auto& e : entries)
+        {
+          ordered_state[next[partition(e.h_k)]++] = e;
+        }
+      }
 
-        ordered_state.emplace_back(k, static_cast<Hash>(H()(key)), v);
+      // Sort each partition, and size it
+      std::array<size_t, partitions + 1> offsets = {};
+      threading::for_indices(parallel_for, partitions, [&](size_t i) {
+        const auto begin = ordered_state.begin() + starts[i];
+        const auto end = ordered_state.begin() + starts[i + 1];
+        std::sort(begin, end, [](const KVTuple& a, const KVTuple& b) {
+          return a.h_k < b.h_k;
+        });
 
-        return true;
+        size_t partition_size = 0;
+        for (auto it = begin; it != end; ++it)
+        {
+          uint32_t ks = champ::get_size(*it->k);
+          uint32_t vs = champ::get_size(*it->v);
+          partition_size += ks + get_padding(ks) + vs + get_padding(vs);
+        }
+        offsets[i + 1] = partition_size;
       });
 
-      // Sort keys to be able to generate byte-for-byte serialised snapshot from
-      // the same state
-      std::sort(
-        ordered_state.begin(), ordered_state.end(), [](KVTuple& i, KVTuple& j) {
-          return i.h_k < j.h_k;
-        });
+      for (size_t i = 0; i < partitions; ++i)
+      {
+        offsets[i + 1] += offsets[i];
+      }
 
       CCF_ASSERT_FMT(
-        size == map.get_serialized_size(),
+        offsets[partitions] == map.get_serialized_size(),
         "size:{}, map->size:{} ==> count:{}, vect:{}",
-        size,
+        offsets[partitions],
         map.get_serialized_size(),
         map.size(),
         ordered_state.size());
 
       serialized_buffer = CBuffer(data, map.get_serialized_size());
 
-      for (const auto& p : ordered_state)
-      {
-        // Serialize the key
-        uint32_t key_size = champ::serialize(*p.k, data, size);
-        add_padding(key_size, data, size);
+      threading::for_indices(parallel_for, partitions, [&](size_t i) {
+        uint8_t* partition_data = data + offsets[i];
+        size_t size = offsets[i + 1] - offsets[i];
 
-        // Serialize the value
-        uint32_t value_size = champ::serialize(*p.v, data, size);
-        add_padding(value_size, data, size);
-      }
+        for (size_t j = starts[i]; j < starts[i + 1]; ++j)
+        {
+          const auto& p = ordered_state[j];
+
+          // Serialize the key
+          uint32_t key_size = champ::serialize(*p.k, partition_data, size);
+          add_padding(key_size, partition_data, size);
 
-      CCF_ASSERT_FMT(size == 0, "buffer not filled, remaining:{}", size);
+          // Serialize the value
+          uint32_t value_size = champ::serialize(*p.v, partition_data, size);
+          add_padding(value_size, partition_data, size);
+        }
+
+        CCF_ASSERT_FMT(size == 0, "buffer not filled, remaining:{}", size);
+      });
     }
   };
 }
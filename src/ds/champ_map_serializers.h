@@ -5,6 +5,7 @@
 #include "ccf_assert.h"
 #include "serialized.h"
 
+#include <memory>
 #include <msgpack/msgpack.hpp>
 #include <nlohmann/json.hpp>
 #include <small_vector/SmallVector.h>
@@ -28,6 +29,43 @@ namespace champ
     using SerialisedEntry = llvm_vecsmall::SmallVector<uint8_t, 8>;
   }
 
+  /// A serialised value which is held outside the map, for instance sealed in
+  /// host memory, and loaded on demand
+  class ColdValue
+  {
+  public:
+    virtual ~ColdValue() = default;
+
+    virtual size_t size() const = 0;
+    virtual std::shared_ptr<const serialisers::SerialisedEntry> load()
+      const = 0;
+  };
+
+  /// Serialised values may be cold, in which case value is empty and the
+  /// value of the entry is loaded from cold
+  template <>
+  struct VersionV<serialisers::SerialisedEntry>
+  {
+    Version version;
+    serialisers::SerialisedEntry value;
+    std::shared_ptr<const ColdValue> cold = nullptr;
+
+    VersionV() = default;
+    VersionV(
+      Version ver,
+      serialisers::SerialisedEntry val,
+      std::shared_ptr<const ColdValue> cold_ = nullptr) :
+      version(ver),
+      value(val),
+      cold(cold_)
+    {}
+
+    size_t value_size() const
+    {
+      return cold != nullptr ? cold->size() : value.size();
+    }
+  };
+
   namespace untyped
   {
     using SerialisedEntry = champ::serialisers::SerialisedEntry;
@@ -51,7 +89,7 @@ namespace champ
   inline size_t get_size<champ::untyped::VersionV>(
     const champ::untyped::VersionV& data)
   {
-    return sizeof(uint64_t) + sizeof(data.version) + data.value.size();
+    return sizeof(uint64_t) + sizeof(data.version) + data.value_size();
   }
 
   template <class T>
@@ -87,7 +125,15 @@ namespace champ
   inline size_t serialize<champ::untyped::VersionV>(
     const champ::untyped::VersionV& t, uint8_t*& data, size_t& size)
   {
-    uint64_t data_size = sizeof(t.version) + t.value.size();
+    // Cold values are loaded for as long as they are serialised
+    std::shared_ptr<const champ::untyped::SerialisedEntry> loaded = nullptr;
+    if (t.cold != nullptr)
+    {
+      loaded = t.cold->load();
+    }
+    const auto& value = loaded != nullptr ? *loaded : t.value;
+
+    uint64_t data_size = sizeof(t.version) + value.size();
     serialized::write(
       data,
       size,
@@ -99,11 +145,8 @@ namespace champ
       reinterpret_cast<const uint8_t*>(&t.version),
       sizeof(t.version));
     serialized::write(
-      data,
-      size,
-      reinterpret_cast<const uint8_t*>(t.value.data()),
-      t.value.size());
-    return sizeof(uint64_t) + sizeof(t.version) + t.value.size();
+      data, size, reinterpret_cast<const uint8_t*>(value.data()), value.size());
+    return sizeof(uint64_t) + sizeof(t.version) + value.size();
   }
 
   template <class T>
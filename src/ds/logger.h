@@ -2,10 +2,12 @@
 // Licensed under the Apache 2.0 License.
 #pragma once
 
+#include "logger_binary.h"
 #include "logger_formatters.h"
 #include "ring_buffer.h"
 #include "thread_ids.h"
 
+#include <atomic>
 #include <chrono>
 #include <cstring>
 #include <ctime>
@@ -16,11 +18,13 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <optional>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <unordered_map>
 
 namespace logger
 {
@@ -36,6 +40,41 @@ namespace logger
 
   static constexpr long int ns_per_s = 1'000'000'000;
 
+  // A log statement whose message is formatted lazily, from a binary record
+  // of its arguments. Each call site is registered once, with the sink of
+  // binary records, the first time it is logged.
+  struct LogSite
+  {
+    const Level level;
+    const char* const file_name;
+    const size_t line_number;
+    const char* format = nullptr;
+    std::atomic<uint32_t> id = 0;
+
+    // Records admitted since the start of the current rate-limiting window,
+    // and records dropped since the last record was written
+    std::atomic<uint64_t> window_start_ms = 0;
+    std::atomic<uint32_t> window_count = 0;
+    std::atomic<uint32_t> dropped = 0;
+
+    LogSite(Level level, const char* file_name, size_t line_number) :
+      level(level),
+      file_name(file_name),
+      line_number(line_number)
+    {}
+  };
+
+  class AbstractDeferredSink
+  {
+  public:
+    virtual ~AbstractDeferredSink() = default;
+
+    virtual void register_site(uint32_t id, const LogSite& site) = 0;
+
+    virtual void write_records(
+      uint16_t thread_id, const uint8_t* data, size_t size) = 0;
+  };
+
   class AbstractLogger
   {
   protected:
@@ -309,6 +348,35 @@ namespace logger
       return l >= level();
     }
 
+    // Destination of binary log records. If unset, deferred log statements
+    // are formatted immediately
+    static inline std::unique_ptr<AbstractDeferredSink>& deferred_sink()
+    {
+      static std::unique_ptr<AbstractDeferredSink> the_sink;
+      return the_sink;
+    }
+
+    static constexpr uint32_t default_site_rate_limit = 10000;
+
+    // Maximum number of records written per second by each call site, below
+    // the FAIL level. 0 disables rate limiting
+    static inline uint32_t& site_rate_limit()
+    {
+      static uint32_t the_limit = default_site_rate_limit;
+      return the_limit;
+    }
+
+    static uint64_t now_ms()
+    {
+#ifdef INSIDE_ENCLAVE
+      return elapsed_ms().count();
+#else
+      return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+    }
+
   private:
     static inline void try_initialize()
     {
@@ -369,12 +437,126 @@ namespace logger
     }
   };
 
+  // Binary log records written by the current thread, which are passed to the
+  // deferred sink in batches
+  class DeferredLogBuffer
+  {
+  private:
+    std::vector<uint8_t> records;
+    uint64_t first_record_ms = 0;
+
+  public:
+    // Records are flushed once they take this many bytes, or once the oldest
+    // of them was written this long ago
+    static constexpr size_t flush_size = 4096;
+    static constexpr uint64_t flush_interval_ms = 10;
+
+    static DeferredLogBuffer& current()
+    {
+      static thread_local DeferredLogBuffer buffer;
+      return buffer;
+    }
+
+    template <typename... Ts>
+    void append(
+      const LogSite& site, uint32_t dropped, uint64_t now, Ts&&... args)
+    {
+      if (records.empty())
+      {
+        first_record_ms = now;
+      }
+
+      const auto header_offset = records.size();
+      records.resize(header_offset + sizeof(binary::RecordHeader));
+      binary::pack_args(records, std::forward<Ts>(args)...);
+
+      const binary::RecordHeader header{
+        site.id.load(),
+        dropped,
+        now,
+        static_cast<uint32_t>(
+          records.size() - header_offset - sizeof(binary::RecordHeader))};
+      std::memcpy(records.data() + header_offset, &header, sizeof(header));
+
+      if (
+        site.level >= FAIL || records.size() >= flush_size ||
+        now - first_record_ms >= flush_interval_ms)
+      {
+        flush();
+      }
+    }
+
+    void flush()
+    {
+      if (records.empty())
+      {
+        return;
+      }
+
+      auto& sink = config::deferred_sink();
+      if (sink != nullptr)
+      {
+#ifdef INSIDE_ENCLAVE
+        const auto thread_id = threading::get_current_thread_id();
+#else
+        const uint16_t thread_id = 100;
+#endif
+        sink->write_records(thread_id, records.data(), records.size());
+      }
+      records.clear();
+    }
+  };
+
+  static inline void flush_deferred()
+  {
+    DeferredLogBuffer::current().flush();
+  }
+
 #ifdef INSIDE_ENCLAVE
+  // Writes binary log records to the host
+  class RingbufferDeferredSink : public AbstractDeferredSink
+  {
+  private:
+    ringbuffer::WriterPtr writer;
+    ringbuffer::Message site_msg;
+    ringbuffer::Message records_msg;
+
+  public:
+    RingbufferDeferredSink(
+      const ringbuffer::WriterPtr& writer,
+      ringbuffer::Message site_msg,
+      ringbuffer::Message records_msg) :
+      writer(writer),
+      site_msg(site_msg),
+      records_msg(records_msg)
+    {}
+
+    void register_site(uint32_t id, const LogSite& site) override
+    {
+      writer->write(
+        site_msg,
+        id,
+        std::string(site.file_name),
+        site.line_number,
+        site.level,
+        std::string(site.format));
+    }
+
+    void write_records(
+      uint16_t thread_id, const uint8_t* data, size_t size) override
+    {
+      writer->write(
+        records_msg, thread_id, serializer::ByteRange{data, size});
+    }
+  };
+
   struct Out
   {
     bool operator==(LogLine& line)
     {
       line.finalize();
+      // Preserve the order of this thread's messages
+      flush_deferred();
       config::writer()->write(
         config::msg(),
         config::elapsed_ms(),
@@ -498,8 +680,215 @@ namespace logger
             enclave_ts));
     }
   };
+
+  // Formats binary log records, from the enclave or from local deferred log
+  // statements
+  class DeferredLogReader
+  {
+  private:
+    struct Site
+    {
+      std::string file_name;
+      size_t line_number;
+      Level level;
+      std::string format;
+    };
+
+    std::unordered_map<uint32_t, Site> sites;
+
+  public:
+    void register_site(
+      uint32_t id,
+      const std::string& file_name,
+      size_t line_number,
+      Level level,
+      const std::string& format)
+    {
+      sites[id] = {file_name, line_number, level, format};
+    }
+
+    void read_records(
+      uint16_t thread_id,
+      const uint8_t* data,
+      size_t size,
+      bool from_enclave = true)
+    {
+      while (size > 0)
+      {
+        const auto header = binary::read<binary::RecordHeader>(data, size);
+        if (size < header.args_size)
+        {
+          throw std::logic_error("Truncated binary log record");
+        }
+
+        const auto args = data;
+        data += header.args_size;
+        size -= header.args_size;
+
+        const auto it = sites.find(header.site_id);
+        if (it == sites.end())
+        {
+          Out::write(
+            __FILE__,
+            __LINE__,
+            FAIL,
+            thread_id,
+            fmt::format(
+              "Binary log record from unknown call site {}\n",
+              header.site_id));
+          continue;
+        }
+
+        const auto& site = it->second;
+        auto msg = binary::format_args(site.format, args, header.args_size);
+        if (header.dropped > 0)
+        {
+          msg += fmt::format(
+            " ({} earlier messages from here were dropped)", header.dropped);
+        }
+        msg += "\n";
+
+        if (from_enclave)
+        {
+          Out::write(
+            site.file_name,
+            site.line_number,
+            site.level,
+            thread_id,
+            msg,
+            header.elapsed_ms);
+        }
+        else
+        {
+          Out::write(
+            site.file_name, site.line_number, site.level, thread_id, msg);
+        }
+      }
+    }
+  };
+
+  // Formats binary log records as soon as they are flushed, in the same
+  // process. Only useful to measure the cost of host-side formatting.
+  class LocalDeferredSink : public AbstractDeferredSink
+  {
+  private:
+    DeferredLogReader reader;
+
+  public:
+    void register_site(uint32_t id, const LogSite& site) override
+    {
+      reader.register_site(
+        id, site.file_name, site.line_number, site.level, site.format);
+    }
+
+    void write_records(
+      uint16_t thread_id, const uint8_t* data, size_t size) override
+    {
+      reader.read_records(thread_id, data, size, false);
+    }
+  };
 #endif
 
+  template <typename S, typename... Ts>
+  static inline bool log_immediate(
+    const LogSite& site, const S& format, Ts&&... args)
+  {
+    LogLine line(site.level, site.file_name, site.line_number);
+    return Out() ==
+      (line << fmt::format(format, std::forward<Ts>(args)...) << std::endl);
+  }
+
+  static inline bool admit(LogSite& site, uint64_t now)
+  {
+    const auto limit = config::site_rate_limit();
+    if (limit == 0 || site.level >= FAIL)
+    {
+      return true;
+    }
+
+    auto start = site.window_start_ms.load(std::memory_order_relaxed);
+    if (
+      now - start >= 1000 &&
+      site.window_start_ms.compare_exchange_strong(start, now))
+    {
+      site.window_count.store(0, std::memory_order_relaxed);
+    }
+
+    if (site.window_count.fetch_add(1, std::memory_order_relaxed) >= limit)
+    {
+      site.dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    return true;
+  }
+
+  static inline void register_site(LogSite& site, const char* format)
+  {
+    if (site.id.load(std::memory_order_acquire) != 0)
+    {
+      return;
+    }
+
+    // The site is registered before its id is published, so that the sink
+    // receives the registration before any record from the site
+    static std::mutex registration_lock;
+    static uint32_t next_id = 0;
+
+    std::lock_guard<std::mutex> guard(registration_lock);
+    if (site.id.load() == 0)
+    {
+      site.format = format;
+      config::deferred_sink()->register_site(++next_id, site);
+      site.id.store(next_id, std::memory_order_release);
+    }
+  }
+
+  /** Log a message whose format string is a literal by writing a binary
+   * record of its arguments, to be formatted by the sink. Messages from a
+   * single call site, below the FAIL level, are dropped beyond
+   * config::site_rate_limit() per second. Messages with format specs for
+   * arguments which cannot be packed as they are are formatted immediately.
+   */
+  template <size_t N, typename... Ts>
+  static inline bool log_deferred(
+    LogSite& site, const char (&format)[N], Ts&&... args)
+  {
+    if (config::deferred_sink() == nullptr)
+    {
+      return log_immediate(site, format, std::forward<Ts>(args)...);
+    }
+
+    if constexpr (!(binary::is_packed_v<std::decay_t<Ts>> && ...))
+    {
+      static constexpr std::array<bool, sizeof...(Ts)> packed = {
+        binary::is_packed_v<std::decay_t<Ts>>...};
+      if (!binary::can_pack_args(format, packed))
+      {
+        return log_immediate(site, format, std::forward<Ts>(args)...);
+      }
+    }
+
+    const auto now = config::now_ms();
+    if (!admit(site, now))
+    {
+      return true;
+    }
+
+    register_site(site, format);
+    DeferredLogBuffer::current().append(
+      site, site.dropped.exchange(0), now, std::forward<Ts>(args)...);
+    return true;
+  }
+
+  // Format strings which are not literals may change between calls from the
+  // same site, so these messages are always formatted immediately
+  template <typename S, typename... Ts>
+  static inline bool log_deferred(LogSite& site, const S& format, Ts&&... args)
+  {
+    return log_immediate(site, format, std::forward<Ts>(args)...);
+  }
+
   // The == operator is being used to:
   // 1. Be a lower precedence than <<, such that using << on the LogLine will
   // happen before the LogLine is "equalitied" with the Out.
@@ -508,28 +897,39 @@ namespace logger
   // This allows:
   // LOG_DEBUG << "info" << std::endl;
 
+// Each use of the _FMT macros declares a LogSite, so that messages may be
+// formatted lazily, by the host, from binary records of their arguments
+#define CCF_LOG_DEFERRED(LEVEL, ...) \
+  logger::config::ok(LEVEL) && \
+    logger::log_deferred( \
+      []() -> logger::LogSite& { \
+        static logger::LogSite site(LEVEL, __FILE__, __LINE__); \
+        return site; \
+      }(), \
+      __VA_ARGS__)
+
 #define LOG_TRACE \
   logger::config::ok(logger::TRACE) && \
     logger::Out() == logger::LogLine(logger::TRACE, __FILE__, __LINE__)
-#define LOG_TRACE_FMT(...) LOG_TRACE << fmt::format(__VA_ARGS__) << std::endl
+#define LOG_TRACE_FMT(...) CCF_LOG_DEFERRED(logger::TRACE, __VA_ARGS__)
 
 #define LOG_DEBUG \
   logger::config::ok(logger::DEBUG) && \
     logger::Out() == logger::LogLine(logger::DEBUG, __FILE__, __LINE__)
-#define LOG_DEBUG_FMT(...) LOG_DEBUG << fmt::format(__VA_ARGS__) << std::endl
+#define LOG_DEBUG_FMT(...) CCF_LOG_DEFERRED(logger::DEBUG, __VA_ARGS__)
 
 #define LOG_INFO \
   logger::config::ok(logger::INFO) && \
     logger::Out() == logger::LogLine(logger::INFO, __FILE__, __LINE__)
-#define LOG_INFO_FMT(...) LOG_INFO << fmt::format(__VA_ARGS__) << std::endl
+#define LOG_INFO_FMT(...) CCF_LOG_DEFERRED(logger::INFO, __VA_ARGS__)
 
 #define LOG_FAIL \
   logger::config::ok(logger::FAIL) && \
     logger::Out() == logger::LogLine(logger::FAIL, __FILE__, __LINE__)
-#define LOG_FAIL_FMT(...) LOG_FAIL << fmt::format(__VA_ARGS__) << std::endl
+#define LOG_FAIL_FMT(...) CCF_LOG_DEFERRED(logger::FAIL, __VA_ARGS__)
 
 #define LOG_FATAL \
   logger::config::ok(logger::FATAL) && \
     logger::Out() == logger::LogLine(logger::FATAL, __FILE__, __LINE__)
-#define LOG_FATAL_FMT(...) LOG_FATAL << fmt::format(__VA_ARGS__) << std::endl
+#define LOG_FATAL_FMT(...) CCF_LOG_DEFERRED(logger::FATAL, __VA_ARGS__)
 }
\ No newline at end of file
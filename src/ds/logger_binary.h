@@ -0,0 +1,261 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace logger::binary
+{
+  // Binary log records are written by the enclave in place of formatted log
+  // lines, and formatted by the host. Each record refers to the call site
+  // which produced it by id, and contains the arguments of the log statement
+  // packed as tagged values. Arguments of types other than the primitive ones
+  // below are formatted to strings when they are packed, unless their
+  // replacement fields have format specs.
+  enum class ArgType : uint8_t
+  {
+    Bool = 0,
+    Char,
+    Int,
+    UInt,
+    Float,
+    Double,
+    String
+  };
+
+  struct RecordHeader
+  {
+    uint32_t site_id;
+    // Number of records from this call site which were dropped by the rate
+    // limiter since the previous record from it was written
+    uint32_t dropped;
+    uint64_t elapsed_ms;
+    uint32_t args_size;
+  };
+
+  // Whether values of T are packed as they are, rather than formatted when
+  // they are packed
+  template <typename T>
+  inline constexpr bool is_packed_v =
+    (std::is_arithmetic_v<T> && !std::is_same_v<T, long double>) ||
+    std::is_same_v<T, const char*> || std::is_same_v<T, char*> ||
+    std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+
+  /** Whether the arguments which are formatted when they are packed, rather
+   * than packed as they are, have replacement fields without a format spec.
+   * Those arguments become strings, to which the spec of their field may not
+   * apply, for instance "{:02x}" with fmt::join.
+   *
+   * @param format Format string
+   * @param packed Whether each argument is packed as it is
+   *
+   * @return false if the arguments should be formatted immediately instead
+   */
+  template <size_t N>
+  inline bool can_pack_args(
+    std::string_view format, const std::array<bool, N>& packed)
+  {
+    size_t next_arg = 0;
+    for (size_t i = 0; i < format.size(); ++i)
+    {
+      if (format[i] != '{')
+      {
+        continue;
+      }
+
+      if (++i < format.size() && format[i] == '{')
+      {
+        continue;
+      }
+
+      size_t arg = 0;
+      const auto index_start = i;
+      while (i < format.size() && format[i] >= '0' && format[i] <= '9')
+      {
+        arg = arg * 10 + (format[i++] - '0');
+      }
+      if (i == index_start)
+      {
+        arg = next_arg++;
+      }
+
+      if (i >= format.size() || format[i] == '}')
+      {
+        continue;
+      }
+
+      // A field with a spec, or a name, which may not apply to a string
+      if (arg >= N || !packed[arg])
+      {
+        return false;
+      }
+
+      while (i < format.size() && format[i] != '}')
+      {
+        // Nested fields, for dynamic widths, also take arguments
+        if (format[i++] == '{')
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  template <typename T>
+  inline void append(std::vector<uint8_t>& buf, const T& t)
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const auto offset = buf.size();
+    buf.resize(offset + sizeof(T));
+    std::memcpy(buf.data() + offset, &t, sizeof(T));
+  }
+
+  inline void append_string(std::vector<uint8_t>& buf, std::string_view s)
+  {
+    append(buf, ArgType::String);
+    append(buf, static_cast<uint32_t>(s.size()));
+    buf.insert(buf.end(), s.begin(), s.end());
+  }
+
+  template <typename T>
+  inline void pack_arg(std::vector<uint8_t>& buf, T&& t)
+  {
+    using D = std::decay_t<T>;
+    if constexpr (std::is_same_v<D, bool>)
+    {
+      append(buf, ArgType::Bool);
+      append(buf, t);
+    }
+    else if constexpr (std::is_same_v<D, char>)
+    {
+      append(buf, ArgType::Char);
+      append(buf, t);
+    }
+    else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>)
+    {
+      append(buf, ArgType::Int);
+      append(buf, static_cast<int64_t>(t));
+    }
+    else if constexpr (std::is_integral_v<D>)
+    {
+      append(buf, ArgType::UInt);
+      append(buf, static_cast<uint64_t>(t));
+    }
+    else if constexpr (std::is_same_v<D, float>)
+    {
+      append(buf, ArgType::Float);
+      append(buf, t);
+    }
+    else if constexpr (std::is_same_v<D, double>)
+    {
+      append(buf, ArgType::Double);
+      append(buf, t);
+    }
+    else if constexpr (
+      std::is_same_v<D, const char*> || std::is_same_v<D, char*> ||
+      std::is_same_v<D, std::string> || std::is_same_v<D, std::string_view>)
+    {
+      append_string(buf, std::string_view(t));
+    }
+    else
+    {
+      append_string(buf, fmt::format("{}", std::forward<T>(t)));
+    }
+  }
+
+  template <typename... Ts>
+  inline void pack_args(std::vector<uint8_t>& buf, Ts&&... args)
+  {
+    (pack_arg(buf, std::forward<Ts>(args)), ...);
+  }
+
+  template <typename T>
+  inline T read(const uint8_t*& data, size_t& size)
+  {
+    if (size < sizeof(T))
+    {
+      throw std::logic_error("Truncated binary log record");
+    }
+    T t;
+    std::memcpy(&t, data, sizeof(T));
+    data += sizeof(T);
+    size -= sizeof(T);
+    return t;
+  }
+
+  /** Format the packed arguments of a record, according to the format string
+   * of its call site
+   *
+   * @param format Format string of the call site
+   * @param data Packed arguments
+   * @param size Size of packed arguments
+   *
+   * @return Formatted message, or the format string followed by a description
+   * of the error if the arguments could not be formatted
+   */
+  inline std::string format_args(
+    const std::string& format, const uint8_t* data, size_t size)
+  {
+    fmt::dynamic_format_arg_store<fmt::format_context> store;
+
+    try
+    {
+      while (size > 0)
+      {
+        switch (read<ArgType>(data, size))
+        {
+          case ArgType::Bool:
+            store.push_back(read<bool>(data, size));
+            break;
+          case ArgType::Char:
+            store.push_back(read<char>(data, size));
+            break;
+          case ArgType::Int:
+            store.push_back(read<int64_t>(data, size));
+            break;
+          case ArgType::UInt:
+            store.push_back(read<uint64_t>(data, size));
+            break;
+          case ArgType::Float:
+            store.push_back(read<float>(data, size));
+            break;
+          case ArgType::Double:
+            store.push_back(read<double>(data, size));
+            break;
+          case ArgType::String:
+          {
+            const auto len = read<uint32_t>(data, size);
+            if (size < len)
+            {
+              throw std::logic_error("Truncated binary log record");
+            }
+            store.push_back(std::string((const char*)data, len));
+            data += len;
+            size -= len;
+            break;
+          }
+          default:
+            throw std::logic_error(
+              "Unknown argument type in binary log record");
+        }
+      }
+
+      return fmt::vformat(format, store);
+    }
+    catch (const std::exception& e)
+    {
+      return fmt::format("{} (could not be formatted: {})", format, e.what());
+    }
+  }
+}
@@ -95,6 +95,24 @@ namespace ringbuffer
       underlying_writer->finish(marker);
     }
 
+    virtual void abandon(const WriteMarker& marker) override
+    {
+      if (marker.has_value())
+      {
+        for (auto it = pending.begin(); it != pending.end(); ++it)
+        {
+          if ((size_t)it->buffer.data() == marker.value())
+          {
+            // This is a pending write which has not been flushed - drop it
+            pending.erase(it);
+            return;
+          }
+        }
+      }
+
+      underlying_writer->abandon(marker);
+    }
+
     virtual WriteMarker write_bytes(
       const WriteMarker& marker, const uint8_t* bytes, size_t size) override
     {
@@ -141,6 +159,32 @@ namespace ringbuffer
       return underlying_writer->write_bytes(marker, bytes, size);
     }
 
+    virtual WriteRegion next_region(
+      WriteMarker& marker, size_t max_size) override
+    {
+      if (marker.has_value())
+      {
+        for (auto& it : pending)
+        {
+          const auto buffer_end = it.buffer.data() + it.buffer.size();
+          if (
+            it.marker == marker.value() &&
+            marker.value() != reinterpret_cast<uint64_t>(buffer_end))
+          {
+            // This is a pending write - hand out the remainder of the pending
+            // buffer, which is copied to the underlying writer when flushed
+            auto dest = (uint8_t*)marker.value();
+            const auto size = std::min(max_size, (size_t)(buffer_end - dest));
+            it.marker = (size_t)(dest + size);
+            marker = it.marker;
+            return {dest, size};
+          }
+        }
+      }
+
+      return underlying_writer->next_region(marker, max_size);
+    }
+
     // Returns true if flush completed and there are no more pending messages.
     // False means 0 or more pending messages were written, but some remain
     bool try_flush_pending()
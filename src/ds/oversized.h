@@ -16,6 +16,10 @@ namespace oversized
   {
     /// Part of a larger message. Can be sent both ways
     DEFINE_RINGBUFFER_MSG_TYPE(fragment),
+
+    /// The larger message will not be completed. Any fragments of it which
+    /// have already been received should be discarded
+    DEFINE_RINGBUFFER_MSG_TYPE(fragments_abandoned),
   };
 
   class FragmentReconstructor
@@ -92,11 +96,27 @@ namespace oversized
             partial_messages.erase(message_id);
           }
         });
+
+      DISPATCHER_SET_MESSAGE_HANDLER(
+        d,
+        OversizedMessage::fragments_abandoned,
+        [this](const uint8_t* data, size_t size) {
+          auto message_id = serialized::read<size_t>(data, size);
+
+          // May not have received any fragments of this message
+          auto it = partial_messages.find(message_id);
+          if (it != partial_messages.end())
+          {
+            delete[] it->second.data;
+            partial_messages.erase(it);
+          }
+        });
     }
 
     ~FragmentReconstructor()
     {
       dispatcher.remove_message_handler(OversizedMessage::fragment);
+      dispatcher.remove_message_handler(OversizedMessage::fragments_abandoned);
 
       for (const auto& [_, partial] : partial_messages)
       {
@@ -127,6 +147,7 @@ namespace oversized
       WriteMarker marker; // Track this so a later call can finish this fragment
       size_t identifier; // Identifier for all fragments of oversized message
       size_t remainder; // Remaining space in currently prepared fragment buffer
+      size_t message_remaining; // Remaining payload of oversized message
     };
 
     // None iff the message is small enough to fit in a single fragment, or
@@ -209,7 +230,7 @@ namespace oversized
 
       // Track progress in current oversized message
       fragment_progress = {
-        marker, outer_id, max_fragment_size - sizeof(header)};
+        marker, outer_id, max_fragment_size - sizeof(header), total_size};
 
       if (identifier != nullptr)
         *identifier = outer_id;
@@ -245,6 +266,24 @@ namespace oversized
       }
     }
 
+    virtual void abandon(const WriteMarker& marker) override
+    {
+      if (fragment_progress.has_value())
+      {
+        // Abandon the current fragment. Earlier fragments may already have
+        // been finished, so tell the reader to discard them
+        underlying_writer->abandon(fragment_progress->marker);
+        const auto id = fragment_progress->identifier;
+        fragment_progress = {};
+
+        underlying_writer->write(OversizedMessage::fragments_abandoned, id);
+      }
+      else
+      {
+        underlying_writer->abandon(marker);
+      }
+    }
+
     virtual WriteMarker write_bytes(
       const WriteMarker& marker, const uint8_t* bytes, size_t size) override
     {
@@ -265,53 +304,92 @@ namespace oversized
       bytes += write_size;
       size -= write_size;
       fragment_progress->remainder -= write_size;
+      fragment_progress->message_remaining -= write_size;
 
       // While there is more to write...
       while (size > 0)
       {
-        // Prepare a new fragment
-        const auto id = fragment_progress->identifier;
-        const auto frag_size = std::min(size + sizeof(id), max_fragment_size);
-        next = underlying_writer->prepare(
-          OversizedMessage::fragment, frag_size, true);
-
-        if (!next.has_value())
-        {
-          // Intermediate fragment failed - this is unexpected
-          throw std::logic_error(
-            "Failed to create fragment for oversized message");
-
-          // If this path is hit it is likely because we have allowed oversized
-          // writes to write without waiting. Some initial fragments were
-          // written, but there is insufficient space to write this fragment.
-          // In this case we can either cancel the entire oversized message, or
-          // retry. In either case we should send a message to inform the
-          // reader.
-          fragment_progress->remainder = 0;
-          break;
-        }
-
-        // Finish the previous fragment
-        underlying_writer->finish(fragment_progress->marker);
-
-        // Update progress tracking to reference the new fragment
-        write_size = frag_size - sizeof(id);
-        fragment_progress->marker = next;
-        fragment_progress->remainder = write_size;
-
-        // Write the id of the oversized message
-        next =
-          underlying_writer->write_bytes(next, (const uint8_t*)&id, sizeof(id));
+        next = start_next_fragment(size);
 
         // Write some fragment payload
+        write_size = fragment_progress->remainder;
         next = underlying_writer->write_bytes(next, bytes, write_size);
         bytes += write_size;
         size -= write_size;
         fragment_progress->remainder -= write_size;
+        fragment_progress->message_remaining -= write_size;
       }
 
       return next;
     }
+
+    virtual ringbuffer::WriteRegion next_region(
+      WriteMarker& marker, size_t max_size) override
+    {
+      if (!marker.has_value())
+      {
+        return {};
+      }
+
+      if (!fragment_progress.has_value())
+      {
+        // Writing a small message - nothing to do here
+        return underlying_writer->next_region(marker, max_size);
+      }
+
+      if (max_size == 0 || fragment_progress->message_remaining == 0)
+      {
+        return {};
+      }
+
+      if (fragment_progress->remainder == 0)
+      {
+        // Size the next fragment for the rest of the message, rather than for
+        // this region, so that callers writing in small regions do not produce
+        // many small fragments
+        marker = start_next_fragment(fragment_progress->message_remaining);
+      }
+
+      const auto region = underlying_writer->next_region(
+        marker, std::min(max_size, fragment_progress->remainder));
+      fragment_progress->remainder -= region.size;
+      fragment_progress->message_remaining -= region.size;
+      return region;
+    }
+
+  private:
+    // Finish the current fragment and prepare the next, with space for up to
+    // size bytes of payload. Returns a marker after the fragment's id.
+    WriteMarker start_next_fragment(size_t size)
+    {
+      const auto id = fragment_progress->identifier;
+      const auto frag_size = std::min(size + sizeof(id), max_fragment_size);
+      auto next =
+        underlying_writer->prepare(OversizedMessage::fragment, frag_size, true);
+
+      if (!next.has_value())
+      {
+        // Intermediate fragment failed - this is unexpected. If this path is
+        // hit it is likely because we have allowed oversized writes to write
+        // without waiting. Some initial fragments were written, but there is
+        // insufficient space to write this fragment. In this case we can
+        // either cancel the entire oversized message, or retry. In either case
+        // we should send a message to inform the reader.
+        throw std::logic_error(
+          "Failed to create fragment for oversized message");
+      }
+
+      // Finish the previous fragment
+      underlying_writer->finish(fragment_progress->marker);
+
+      // Update progress tracking to reference the new fragment
+      fragment_progress->marker = next;
+      fragment_progress->remainder = frag_size - sizeof(id);
+
+      // Write the id of the oversized message
+      return underlying_writer->write_bytes(
+        next, (const uint8_t*)&id, sizeof(id));
+    }
   };
 
   struct WriterConfig
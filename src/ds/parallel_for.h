@@ -0,0 +1,35 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace threading
+{
+  /** Runs fn(0) to fn(n - 1), possibly concurrently, and returns once all of
+   * them have run. An exception thrown by fn is rethrown to the caller, once
+   * all calls have returned.
+   */
+  using ParallelFor =
+    std::function<void(size_t n, const std::function<void(size_t)>& fn)>;
+
+  // Runs fn(0) to fn(n - 1) with parallel_for if it is set, or sequentially on
+  // the calling thread otherwise
+  static inline void for_indices(
+    const ParallelFor& parallel_for,
+    size_t n,
+    const std::function<void(size_t)>& fn)
+  {
+    if (parallel_for)
+    {
+      parallel_for(n, fn);
+      return;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+      fn(i);
+    }
+  }
+}
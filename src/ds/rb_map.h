@@ -98,6 +98,31 @@ public:
     }
   }
 
+  // Visits, in key order, the entries with from <= key, and key < to if to is
+  // set, until f returns false. Returns false if f stopped the iteration.
+  template <class F>
+  bool foreach_range(const K& from, const std::optional<K>& to, F&& f) const
+  {
+    if (empty())
+      return true;
+
+    auto& y = rootKey();
+
+    if (y < from)
+      return right().foreach_range(from, to, std::forward<F>(f));
+
+    if (to.has_value() && !(y < to.value()))
+      return left().foreach_range(from, to, std::forward<F>(f));
+
+    if (!left().foreach_range(from, to, std::forward<F>(f)))
+      return false;
+
+    if (!f(y, rootValue()))
+      return false;
+
+    return right().foreach_range(from, to, std::forward<F>(f));
+  }
+
 private:
   std::shared_ptr<const Node> _root;
 
@@ -273,6 +273,18 @@ namespace ringbuffer
       }
     }
 
+    virtual void abandon(const WriteMarker& marker) override
+    {
+      if (marker.has_value())
+      {
+        // Turn the reservation into padding, which the reader skips over
+        const auto index = marker.value() - Const::header_size();
+        auto size = read32(index) & length_mask;
+        write64(
+          index, make_header(Const::msg_pad, Const::entry_size(size), false));
+      }
+    }
+
   protected:
     virtual WriteMarker write_bytes(
       const WriteMarker& marker, const uint8_t* bytes, size_t size) override
@@ -293,6 +305,25 @@ namespace ringbuffer
       return {index + size};
     }
 
+  public:
+    virtual WriteRegion next_region(
+      WriteMarker& marker, size_t max_size) override
+    {
+      if (!marker.has_value())
+      {
+        return {};
+      }
+
+      const auto index = marker.value();
+
+      checkAccess(index, max_size);
+
+      // The caller is bounded by the size passed to prepare, and a single
+      // reservation is always contiguous
+      marker = index + max_size;
+      return {bd.data + index, max_size};
+    }
+
   private:
     uint32_t read32(size_t index)
     {
@@ -6,7 +6,10 @@
 #include "hash.h"
 #include "serializer.h"
 
+#include <algorithm>
 #include <atomic>
+#include <cstring>
+#include <limits>
 #include <optional>
 #include <string>
 #include <vector>
@@ -37,6 +40,16 @@ namespace ringbuffer
     {}
   };
 
+  /// A region of a writer's own buffer, which a message may be written to in
+  /// place. Empty if the writer does not support in-place writes.
+  struct WriteRegion
+  {
+    uint8_t* data = nullptr;
+    size_t size = 0;
+  };
+
+  class MessageReservation;
+
   class AbstractWriter
   {
   public:
@@ -77,14 +90,16 @@ namespace ringbuffer
     // to track progress between writes in the same message.
     using WriteMarker = std::optional<size_t>;
 
-    /// Implementation requires 3 methods - prepare, finish, and write_bytes.
-    /// For each message, prepare will be called with the total message size. It
-    /// should return a WriteMarker for this reservation. That WriteMarker will
-    /// be passed to write_bytes, which may be called repeatedly for each part
-    /// of the message. write_bytes returns an opaque WriteMarker which will be
-    /// passed to the next invocation of write_bytes, to track progress.
-    /// Finally, finish will be called with the WriteMarker initially returned
-    /// from prepare.
+    /// Implementation requires 4 methods - prepare, finish, write_bytes and
+    /// abandon. For each message, prepare will be called with the total message
+    /// size. It should return a WriteMarker for this reservation. That
+    /// WriteMarker will be passed to write_bytes, which may be called
+    /// repeatedly for each part of the message. write_bytes returns an opaque
+    /// WriteMarker which will be passed to the next invocation of write_bytes,
+    /// to track progress. Finally, finish will be called with the WriteMarker
+    /// initially returned from prepare. If the message cannot be completed,
+    /// abandon is called with that WriteMarker instead of finish, and must
+    /// release the reservation without the reader ever seeing the message.
     ///@{
     virtual WriteMarker prepare(
       Message m,
@@ -96,8 +111,27 @@ namespace ringbuffer
 
     virtual WriteMarker write_bytes(
       const WriteMarker& marker, const uint8_t* bytes, size_t size) = 0;
+
+    virtual void abandon(const WriteMarker& marker) = 0;
     ///@}
 
+    /// Implementations may additionally hand out regions of their own buffer,
+    /// which the caller fills in place of a call to write_bytes. Returns a
+    /// region of at most max_size bytes at the given marker, and advances the
+    /// marker past it. The returned region may be smaller than requested, for
+    /// instance at the end of a fragment. An empty region means the caller
+    /// must use write_bytes instead.
+    virtual WriteRegion next_region(WriteMarker&, size_t)
+    {
+      return {};
+    }
+
+    /// Reserve space for a message of the given size, to be written in place
+    /// by the caller and then committed. Returns nothing if wait is false and
+    /// there is not currently sufficient space.
+    std::optional<MessageReservation> reserve_message(
+      Message m, size_t size, bool wait = true);
+
   private:
     template <typename Serializer, typename... Ts>
     bool write_multiple(Message m, bool wait, Ts&&... ts)
@@ -125,6 +159,166 @@ namespace ringbuffer
     }
   };
 
+  /// A message which has been prepared on a writer, but not yet written.
+  /// Producers which would otherwise build a large payload in a temporary
+  /// buffer, only for it to be copied into the ringbuffer, can instead write
+  /// it directly to the regions returned by next(). Where the writer does not
+  /// support in-place writes, regions are staged in a local buffer and copied
+  /// on the following call.
+  ///
+  /// Readers cannot progress past a reserved message until it is committed,
+  /// so every reservation must be committed once its entire payload has been
+  /// written. A reservation which is destroyed without being committed, for
+  /// instance because producing its payload threw, is abandoned: the writer
+  /// releases its space without the message ever being delivered, so that
+  /// readers are neither blocked forever nor handed a partial payload.
+  class MessageReservation
+  {
+    AbstractWriter* writer;
+    AbstractWriter::WriteMarker initial_marker;
+    AbstractWriter::WriteMarker next_marker;
+    size_t remaining_size;
+
+    std::vector<uint8_t> staging;
+
+    void flush_staging()
+    {
+      if (!staging.empty())
+      {
+        next_marker =
+          writer->write_bytes(next_marker, staging.data(), staging.size());
+        staging.clear();
+      }
+    }
+
+  public:
+    MessageReservation(
+      AbstractWriter& writer_,
+      const AbstractWriter::WriteMarker& marker,
+      size_t size) :
+      writer(&writer_),
+      initial_marker(marker),
+      next_marker(marker),
+      remaining_size(size)
+    {}
+
+    MessageReservation(MessageReservation&& that) :
+      writer(that.writer),
+      initial_marker(that.initial_marker),
+      next_marker(that.next_marker),
+      remaining_size(that.remaining_size),
+      staging(std::move(that.staging))
+    {
+      that.writer = nullptr;
+    }
+
+    MessageReservation(const MessageReservation&) = delete;
+    MessageReservation& operator=(const MessageReservation&) = delete;
+    MessageReservation& operator=(MessageReservation&&) = delete;
+
+    ~MessageReservation()
+    {
+      if (writer != nullptr)
+      {
+        abandon();
+      }
+    }
+
+    /// Number of bytes of the message which have not yet been handed out
+    size_t remaining() const
+    {
+      return remaining_size;
+    }
+
+    /// Returns the next region of the message, of at most max_size bytes.
+    /// Successive regions are consecutive in the message, but not necessarily
+    /// in memory. The returned region is only valid until the next call to
+    /// next(), write() or commit().
+    WriteRegion next(size_t max_size = std::numeric_limits<size_t>::max())
+    {
+      flush_staging();
+
+      const auto size = std::min(max_size, remaining_size);
+      if (size == 0)
+      {
+        return {};
+      }
+
+      auto region = writer->next_region(next_marker, size);
+      if (region.data == nullptr)
+      {
+        staging.resize(size);
+        region = {staging.data(), size};
+      }
+
+      remaining_size -= region.size;
+      return region;
+    }
+
+    /// Copies size bytes into the next region(s) of the message
+    void write(const uint8_t* data, size_t size)
+    {
+      if (size > remaining_size)
+      {
+        throw std::logic_error(
+          "Cannot write " + std::to_string(size) +
+          " bytes to reservation with " + std::to_string(remaining_size) +
+          " bytes remaining");
+      }
+
+      while (size > 0)
+      {
+        const auto region = next(size);
+        ::memcpy(region.data, data, region.size);
+        data += region.size;
+        size -= region.size;
+      }
+    }
+
+    template <typename T>
+    void write(const T& t)
+    {
+      static_assert(std::is_trivially_copyable_v<T>);
+      write(reinterpret_cast<const uint8_t*>(&t), sizeof(T));
+    }
+
+    /// Makes the message visible to the reader. The entire message must have
+    /// been written.
+    void commit()
+    {
+      if (remaining_size != 0)
+      {
+        throw std::logic_error(
+          "Cannot commit reservation with " + std::to_string(remaining_size) +
+          " bytes remaining");
+      }
+
+      flush_staging();
+      writer->finish(initial_marker);
+      writer = nullptr;
+    }
+
+    /// Discards the message. Nothing is delivered to the reader
+    void abandon()
+    {
+      staging.clear();
+      writer->abandon(initial_marker);
+      writer = nullptr;
+    }
+  };
+
+  inline std::optional<MessageReservation> AbstractWriter::reserve_message(
+    Message m, size_t size, bool wait)
+  {
+    const auto marker = prepare(m, size, wait);
+    if (!marker.has_value())
+    {
+      return std::nullopt;
+    }
+
+    return MessageReservation(*this, marker, size);
+  }
+
   using WriterPtr = std::shared_ptr<AbstractWriter>;
 
   class AbstractWriterFactory
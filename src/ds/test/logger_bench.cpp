@@ -5,6 +5,8 @@
 
 #include <picobench/picobench.hpp>
 
+::timespec logger::config::start{0, 0};
+
 enum LoggerKind
 {
   None = 0x0,
@@ -124,6 +126,74 @@ static void log_rejected_fmt(picobench::state& s)
   reset_loggers();
 }
 
+// Discards binary log records, to measure the cost of writing them alone
+class DiscardingSink : public logger::AbstractDeferredSink
+{
+public:
+  size_t bytes = 0;
+
+  void register_site(uint32_t, const logger::LogSite&) override {}
+
+  void write_records(uint16_t, const uint8_t*, size_t size) override
+  {
+    bytes += size;
+  }
+};
+
+enum class Deferral
+{
+  // Formatted in place, as when there is no deferred sink
+  None,
+  // Binary records are written, but not formatted
+  RecordOnly,
+  // Binary records are written then formatted, as the host would
+  RecordAndFormat
+};
+
+template <Deferral D, LoggerKind LK = LoggerKind::Console>
+static void log_with_args(picobench::state& s)
+{
+  prepare_loggers<LK>();
+
+  // Call sites are only registered with the first sink they log to, so the
+  // same sink is used by every sample
+  static std::unique_ptr<logger::AbstractDeferredSink> sink = nullptr;
+  if constexpr (D == Deferral::RecordOnly)
+  {
+    if (sink == nullptr)
+    {
+      sink = std::make_unique<DiscardingSink>();
+    }
+  }
+  else if constexpr (D == Deferral::RecordAndFormat)
+  {
+    if (sink == nullptr)
+    {
+      sink = std::make_unique<logger::LocalDeferredSink>();
+    }
+  }
+  std::swap(logger::config::deferred_sink(), sink);
+
+  const std::string name = "node_0";
+  logger::config::level() = logger::DEBUG;
+  const auto default_limit = logger::config::site_rate_limit();
+  logger::config::site_rate_limit() = 0;
+  {
+    picobench::scope scope(s);
+
+    for (size_t i = 0; i < s.iterations(); ++i)
+    {
+      LOG_DEBUG_FMT(
+        "Replicating {} entries to {} at term {} ({:.2f}ms)", i, name, 3, 0.5);
+    }
+    logger::flush_deferred();
+  }
+
+  std::swap(logger::config::deferred_sink(), sink);
+  logger::config::site_rate_limit() = default_limit;
+  reset_loggers();
+}
+
 const std::vector<int> sizes = {1000};
 
 PICOBENCH_SUITE("logger");
@@ -154,3 +224,16 @@ PICOBENCH(json_reject_fmt).iterations(sizes).samples(10);
 // PICOBENCH(json_loud).iterations(sizes).samples(10);
 // auto all_loud = log_accepted<LoggerKind::All, false>;
 // PICOBENCH(all_loud).iterations(sizes).samples(10);
+
+PICOBENCH_SUITE("deferred");
+auto immediate = log_with_args<Deferral::None>;
+PICOBENCH(immediate).iterations(sizes).samples(10).baseline();
+auto deferred_record = log_with_args<Deferral::RecordOnly>;
+PICOBENCH(deferred_record).iterations(sizes).samples(10);
+auto deferred_format = log_with_args<Deferral::RecordAndFormat>;
+PICOBENCH(deferred_format).iterations(sizes).samples(10);
+auto json_immediate = log_with_args<Deferral::None, LoggerKind::JSON>;
+PICOBENCH(json_immediate).iterations(sizes).samples(10);
+auto json_deferred_format =
+  log_with_args<Deferral::RecordAndFormat, LoggerKind::JSON>;
+PICOBENCH(json_deferred_format).iterations(sizes).samples(10);
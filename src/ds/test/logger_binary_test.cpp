@@ -0,0 +1,200 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#include "../logger.h"
+
+// doctest defines INFO and FAIL macros, so these levels are logged from here
+static void log_failure(size_t i)
+{
+  LOG_FAIL_FMT("failure {}", i);
+}
+
+static void log_info(const std::string& format, size_t i)
+{
+  LOG_INFO_FMT(format, i);
+}
+
+static void log_mismatched_argument()
+{
+  LOG_INFO_FMT("{:d}", "not a number");
+}
+
+static void log_joined(const std::vector<uint8_t>& v)
+{
+  LOG_INFO_FMT("{:02x} {}", fmt::join(v, ""), v.size());
+}
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+::timespec logger::config::start{0, 0};
+
+// Records the messages of each log line, rather than printing them
+class RecordingLogger : public logger::AbstractLogger
+{
+public:
+  std::vector<std::string>& lines;
+
+  RecordingLogger(std::vector<std::string>& lines) : lines(lines) {}
+
+  std::string format(
+    const std::string&,
+    size_t,
+    const std::string&,
+    const std::string& msg,
+    const std::tm&,
+    const ::timespec&,
+    uint16_t,
+    const std::optional<::timespec>& = std::nullopt) override
+  {
+    return msg;
+  }
+
+  void write(const std::string& log_line) override
+  {
+    lines.push_back(log_line);
+  }
+};
+
+// Counts sites and records, then formats them locally
+class CountingSink : public logger::LocalDeferredSink
+{
+public:
+  size_t sites = 0;
+  size_t batches = 0;
+
+  void register_site(uint32_t id, const logger::LogSite& site) override
+  {
+    ++sites;
+    LocalDeferredSink::register_site(id, site);
+  }
+
+  void write_records(
+    uint16_t thread_id, const uint8_t* data, size_t size) override
+  {
+    ++batches;
+    LocalDeferredSink::write_records(thread_id, data, size);
+  }
+};
+
+struct LoggerFixture
+{
+  std::vector<std::string> lines;
+  CountingSink* sink;
+
+  LoggerFixture()
+  {
+    auto& loggers = logger::config::loggers();
+    loggers.clear();
+    loggers.emplace_back(std::make_unique<RecordingLogger>(lines));
+    logger::config::level() = logger::TRACE;
+
+    auto s = std::make_unique<CountingSink>();
+    sink = s.get();
+    logger::config::deferred_sink() = std::move(s);
+  }
+
+  ~LoggerFixture()
+  {
+    logger::config::deferred_sink() = nullptr;
+    logger::config::loggers().clear();
+  }
+};
+
+TEST_CASE_FIXTURE(LoggerFixture, "Deferred messages are formatted by the sink")
+{
+  const std::string s = "string";
+  const auto ms = std::chrono::milliseconds(42);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    LOG_DEBUG_FMT(
+      "{} {} {} {:x} {} {:.2f} {} {} {} {}",
+      i,
+      -2,
+      true,
+      255u,
+      'c',
+      1.5,
+      0.25f,
+      s,
+      "literal",
+      ms);
+  }
+  REQUIRE(lines.empty());
+
+  logger::flush_deferred();
+  REQUIRE(sink->sites == 1);
+  REQUIRE(sink->batches == 1);
+  REQUIRE(lines.size() == 3);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    REQUIRE(
+      lines[i] ==
+      fmt::format(
+        "{} {} {} {:x} {} {:.2f} {} {} {} {}\n",
+        i,
+        -2,
+        true,
+        255u,
+        'c',
+        1.5,
+        0.25f,
+        s,
+        "literal",
+        ms));
+  }
+
+  INFO("Failures are written immediately");
+  log_failure(1);
+  REQUIRE(lines.size() == 4);
+  REQUIRE(lines.back() == "failure 1\n");
+  REQUIRE(sink->sites == 2);
+
+  INFO("Format strings which are not literals are formatted immediately");
+  log_info("not a literal {}", 2);
+  REQUIRE(lines.size() == 5);
+  REQUIRE(lines.back() == "not a literal 2\n");
+  REQUIRE(sink->sites == 2);
+
+  INFO("Arguments which do not match the format string are reported");
+  log_mismatched_argument();
+  logger::flush_deferred();
+  REQUIRE(lines.size() == 6);
+  REQUIRE(lines.back().find("could not be formatted") != std::string::npos);
+
+  INFO("Arguments which are not packed are formatted with their format spec");
+  const std::vector<uint8_t> v = {1, 0xab, 0x10};
+  log_joined(v);
+  logger::flush_deferred();
+  REQUIRE(lines.size() == 7);
+  REQUIRE(lines.back() == "01ab10 3\n");
+}
+
+TEST_CASE_FIXTURE(LoggerFixture, "Deferred messages are rate limited per site")
+{
+  constexpr auto limit = 5;
+  const auto default_limit = logger::config::site_rate_limit();
+  logger::config::site_rate_limit() = limit;
+
+  auto log_from_one_site = [](size_t i) { LOG_TRACE_FMT("one {}", i); };
+  auto log_from_other_site = [](size_t i) { LOG_TRACE_FMT("other {}", i); };
+
+  for (size_t i = 0; i < 2 * limit; ++i)
+  {
+    log_from_one_site(i);
+    log_from_other_site(i);
+  }
+  logger::flush_deferred();
+  REQUIRE(lines.size() == 2 * limit);
+
+  INFO("The next message reports how many were dropped");
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  log_from_one_site(0);
+  logger::flush_deferred();
+  REQUIRE(lines.size() == 2 * limit + 1);
+  REQUIRE(
+    lines.back() ==
+    fmt::format("one 0 ({} earlier messages from here were dropped)\n", limit));
+
+  logger::config::site_rate_limit() = default_limit;
+}
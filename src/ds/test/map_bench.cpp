@@ -117,6 +117,69 @@ static void benchmark_foreach(picobench::state& s)
   s.stop_timer();
 }
 
+// Visits the entries in a range of RANGE consecutive keys of a map of 1M
+// entries, through the ordered iteration of an RBMap, or by filtering every
+// entry of a CHAMP
+static constexpr size_t range_map_size = 1 << 20;
+
+template <class M>
+static const M& get_range_map()
+{
+  static const M map = [] {
+    M m;
+    for (uint64_t i = 0; i < range_map_size; ++i)
+    {
+      m = m.put(i, {i});
+    }
+    return m;
+  }();
+  return map;
+}
+
+template <size_t RANGE>
+static void benchmark_rb_map_range(picobench::state& s)
+{
+  auto& map = get_range_map<RBMap<K, V>>();
+  size_t count = 0;
+  K from = 0;
+  s.start_timer();
+  for (auto _ : s)
+  {
+    (void)_;
+    from = (from + 7919) % (range_map_size - RANGE);
+    map.foreach_range(
+      from, from + RANGE, [&count](const auto& key, const auto& value) {
+        count++;
+        return true;
+      });
+    clobber_memory();
+  }
+  s.stop_timer();
+}
+
+template <size_t RANGE>
+static void benchmark_champ_map_range(picobench::state& s)
+{
+  auto& map = get_range_map<champ::Map<K, V>>();
+  size_t count = 0;
+  K from = 0;
+  s.start_timer();
+  for (auto _ : s)
+  {
+    (void)_;
+    from = (from + 7919) % (range_map_size - RANGE);
+    map.foreach([&count, from](const auto& key, const auto& value) {
+      if (key >= from && key < from + RANGE)
+      {
+        count++;
+      }
+      return true;
+    });
+    clobber_memory();
+  }
+  s.stop_timer();
+}
+
 const std::vector<int> sizes = {32, 32 << 2, 32 << 4, 32 << 6, 32 << 8};
 
 PICOBENCH_SUITE("put");
@@ -142,3 +205,16 @@ auto bench_rb_map_foreach = benchmark_foreach<RBMap<K, V>>;
 PICOBENCH(bench_rb_map_foreach).iterations(for_sizes).samples(10).baseline();
 auto bench_champ_map_foreach = benchmark_foreach<champ::Map<K, V>>;
 PICOBENCH(bench_champ_map_foreach).iterations(for_sizes).samples(10);
+
+const std::vector<int> range_sizes = {10, 100};
+
+PICOBENCH_SUITE("range");
+auto bench_champ_map_range_100 = benchmark_champ_map_range<100>;
+PICOBENCH(bench_champ_map_range_100)
+  .iterations(range_sizes)
+  .samples(10)
+  .baseline();
+auto bench_rb_map_range_100 = benchmark_rb_map_range<100>;
+PICOBENCH(bench_rb_map_range_100).iterations(range_sizes).samples(10);
+auto bench_rb_map_range_10k = benchmark_rb_map_range<10000>;
+PICOBENCH(bench_rb_map_range_10k).iterations(range_sizes).samples(10);
@@ -2,9 +2,11 @@
 // Licensed under the Apache 2.0 License.
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "../champ_map.h"
+#include "../rb_map.h"
 
 #include <doctest/doctest.h>
 #include <random>
+#include <thread>
 #include <unordered_map>
 
 using namespace std;
@@ -305,3 +307,115 @@ TEST_CASE("serialize map")
     snapshot.serialize(s.data());
   }
 }
+
+// Runs each index on its own thread
+static void thread_per_index(size_t n, const std::function<void(size_t)>& fn)
+{
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < n; ++i)
+  {
+    threads.emplace_back(fn, i);
+  }
+  for (auto& t : threads)
+  {
+    t.join();
+  }
+}
+
+template <class Hash>
+static void check_parallel_serialization(size_t num_elements)
+{
+  champ::Map<K, V, Hash> map;
+  for (size_t i = 0; i < num_elements; ++i)
+  {
+    map = map.put(i, i * 2);
+  }
+
+  champ::Snapshot<K, V, Hash> snapshot(map);
+  std::vector<uint8_t> s(map.get_serialized_size());
+  snapshot.serialize(s.data());
+
+  INFO("Serialized state does not depend on parallelism");
+  champ::Snapshot<K, V, Hash> parallel_snapshot(map);
+  std::vector<uint8_t> parallel_s(map.get_serialized_size());
+  parallel_snapshot.serialize(parallel_s.data(), thread_per_index);
+  REQUIRE_EQ(s, parallel_s);
+
+  INFO("Map deserialized in parallel has the same contents");
+  auto new_map =
+    champ::Map<K, V, Hash>::deserialize_map(parallel_s, thread_per_index);
+  REQUIRE_EQ(new_map.size(), map.size());
+  REQUIRE_EQ(new_map.get_serialized_size(), map.get_serialized_size());
+  for (size_t i = 0; i < num_elements; ++i)
+  {
+    REQUIRE_EQ(new_map.get(i), i * 2);
+  }
+
+  INFO("Map deserialized in parallel behaves as if deserialized sequentially");
+  auto sequential_map = champ::Map<K, V, Hash>::deserialize_map(s);
+  new_map = new_map.put(num_elements, 0).remove(0);
+  sequential_map = sequential_map.put(num_elements, 0).remove(0);
+  champ::Snapshot<K, V, Hash> snapshot_1(sequential_map);
+  std::vector<uint8_t> s_1(sequential_map.get_serialized_size());
+  snapshot_1.serialize(s_1.data());
+  champ::Snapshot<K, V, Hash> snapshot_2(new_map);
+  std::vector<uint8_t> s_2(new_map.get_serialized_size());
+  snapshot_2.serialize(s_2.data(), thread_per_index);
+  REQUIRE_EQ(s_1, s_2);
+}
+
+TEST_CASE("parallel serialize map")
+{
+  for (auto n : {0, 1, 2, 10, 10000})
+  {
+    check_parallel_serialization<std::hash<K>>(n);
+    check_parallel_serialization<H>(n);
+  }
+}
+
+TEST_CASE("ordered map range iteration")
+{
+  std::mt19937 gen(42);
+  std::map<K, V> model;
+  RBMap<K, V> rb;
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    const auto k = gen() % 2000;
+    model[k] = i;
+    rb = rb.put(k, i);
+  }
+
+  for (size_t i = 0; i < 100; ++i)
+  {
+    const K from = gen() % 2100;
+    const std::optional<K> to =
+      i % 10 == 0 ? std::nullopt : std::make_optional<K>(from + gen() % 200);
+
+    std::vector<std::pair<K, V>> expected;
+    for (auto it = model.lower_bound(from);
+         it != model.end() && (!to.has_value() || it->first < *to);
+         ++it)
+    {
+      expected.emplace_back(*it);
+    }
+
+    std::vector<std::pair<K, V>> actual;
+    REQUIRE(rb.foreach_range(from, to, [&](const K& k, const V& v) {
+      actual.emplace_back(k, v);
+      return true;
+    }));
+    REQUIRE(actual == expected);
+
+    INFO("Iteration stops when requested");
+    if (expected.size() > 2)
+    {
+      actual.clear();
+      REQUIRE_FALSE(rb.foreach_range(from, to, [&](const K& k, const V& v) {
+        actual.emplace_back(k, v);
+        return actual.size() < 2;
+      }));
+      REQUIRE(actual.size() == 2);
+      REQUIRE(actual[1] == expected[1]);
+    }
+  }
+}
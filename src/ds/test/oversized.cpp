@@ -536,4 +536,185 @@ TEST_CASE("Non-blocking" * doctest::test_suite("oversized"))
       break;
     }
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("In-place reservations" * doctest::test_suite("oversized"))
+{
+  using namespace ringbuffer;
+
+  constexpr auto circuit_size = 1 << 10;
+
+  auto in_buffer = std::make_unique<ringbuffer::TestBuffer>(circuit_size);
+  auto out_buffer = std::make_unique<ringbuffer::TestBuffer>(circuit_size);
+
+  ringbuffer::Circuit circuit(in_buffer->bd, out_buffer->bd);
+
+  constexpr auto max_fragment_size = circuit_size / 8;
+  constexpr auto max_total_size = circuit_size * 4;
+  oversized::WriterConfig writer_config{max_fragment_size, max_total_size};
+
+  ringbuffer::WriterFactory basic_factory(circuit);
+  ringbuffer::NonBlockingWriterFactory non_blocking_factory(basic_factory);
+  oversized::WriterFactory oversized_factory(
+    non_blocking_factory, writer_config);
+
+  auto writer = oversized_factory.create_writer_to_inside();
+
+  std::vector<std::vector<uint8_t>> messages;
+  for (auto size : {max_fragment_size / 2, max_total_size})
+  {
+    auto& message = messages.emplace_back(size);
+    for (auto& n : message)
+    {
+      n = rand();
+    }
+  }
+
+  decltype(messages) received;
+  messaging::BufferProcessor processor_inside;
+  DISPATCHER_SET_MESSAGE_HANDLER(
+    processor_inside, random_contents, [&](const uint8_t* data, size_t size) {
+      received.emplace_back(data, data + size);
+    });
+
+  oversized::FragmentReconstructor reconstructor(
+    processor_inside.get_dispatcher());
+
+  auto read_all = [&]() {
+    while (received.size() < messages.size())
+    {
+      non_blocking_factory.flush_all_inbound();
+      processor_inside.read_n(-1, circuit.read_from_outside());
+    }
+  };
+
+  SUBCASE("Regions are returned within fragments")
+  {
+    for (const auto& message : messages)
+    {
+      auto reservation =
+        writer->reserve_message(random_contents, message.size());
+      REQUIRE(reservation.has_value());
+
+      // Regions never span fragments, whether they are in the ringbuffer or
+      // pending in the non-blocking writer
+      auto it = message.begin();
+      while (reservation->remaining() > 0)
+      {
+        const auto region = reservation->next(max_fragment_size / 3);
+        REQUIRE(region.data != nullptr);
+        REQUIRE(region.size > 0);
+        REQUIRE(region.size <= max_fragment_size);
+        std::copy(it, it + region.size, region.data);
+        it += region.size;
+      }
+      REQUIRE(it == message.end());
+      reservation->commit();
+    }
+
+    read_all();
+    REQUIRE(received == messages);
+  }
+
+  SUBCASE("Regions can be mixed with copies")
+  {
+    for (const auto& message : messages)
+    {
+      auto reservation =
+        writer->reserve_message(random_contents, message.size());
+      REQUIRE(reservation.has_value());
+
+      const auto half = message.size() / 2;
+      reservation->write(message.data(), half);
+      auto it = message.begin() + half;
+      while (reservation->remaining() > 0)
+      {
+        const auto region = reservation->next();
+        std::copy(it, it + region.size, region.data);
+        it += region.size;
+      }
+      reservation->commit();
+    }
+
+    read_all();
+    REQUIRE(received == messages);
+  }
+
+  SUBCASE("Abandoned reservations are never delivered")
+  {
+    for (const auto& message : messages)
+    {
+      // Abandon part way through the message, after some fragments of an
+      // oversized message have been finished
+      auto reservation =
+        writer->reserve_message(random_contents, message.size());
+      REQUIRE(reservation.has_value());
+      reservation->write(message.data(), message.size() / 2);
+    }
+
+    for (const auto& message : messages)
+    {
+      auto reservation =
+        writer->reserve_message(random_contents, message.size());
+      REQUIRE(reservation.has_value());
+      reservation->write(message.data(), message.size());
+      reservation->commit();
+    }
+
+    read_all();
+    REQUIRE(received == messages);
+  }
+
+  SUBCASE("Writers without in-place support are staged")
+  {
+    class CopyingWriter : public AbstractWriter
+    {
+      WriterPtr underlying;
+
+    public:
+      CopyingWriter(const WriterPtr& w) : underlying(w) {}
+
+      WriteMarker prepare(
+        Message m, size_t size, bool wait, size_t* identifier) override
+      {
+        return underlying->prepare(m, size, wait, identifier);
+      }
+
+      void finish(const WriteMarker& marker) override
+      {
+        underlying->finish(marker);
+      }
+
+      WriteMarker write_bytes(
+        const WriteMarker& marker, const uint8_t* bytes, size_t size) override
+      {
+        return underlying->write_bytes(marker, bytes, size);
+      }
+
+      void abandon(const WriteMarker& marker) override
+      {
+        underlying->abandon(marker);
+      }
+    };
+
+    CopyingWriter copying_writer(writer);
+    for (const auto& message : messages)
+    {
+      auto reservation =
+        copying_writer.reserve_message(random_contents, message.size());
+      REQUIRE(reservation.has_value());
+
+      auto it = message.begin();
+      while (reservation->remaining() > 0)
+      {
+        const auto region = reservation->next(max_fragment_size / 3);
+        std::copy(it, it + region.size, region.data);
+        it += region.size;
+      }
+      reservation->commit();
+    }
+
+    read_all();
+    REQUIRE(received == messages);
+  }
+}
@@ -5,7 +5,9 @@
 #include "../serialized.h"
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <algorithm>
 #include <doctest/doctest.h>
+#include <numeric>
 #include <thread>
 #include <vector>
 
@@ -343,6 +345,85 @@ TEST_CASE(
   }
 }
 
+TEST_CASE("In-place reservations" * doctest::test_suite("ringbuffer"))
+{
+  auto buffer = std::make_unique<ringbuffer::TestBuffer>(4096);
+  Reader r(buffer->bd);
+  Writer w(r);
+
+  std::vector<uint8_t> expected(big_size);
+  std::iota(expected.begin(), expected.end(), 0);
+
+  SUBCASE("Regions are written in place")
+  {
+    auto reservation = w.reserve_message(big_message, big_size);
+    REQUIRE(reservation.has_value());
+    REQUIRE(reservation->remaining() == big_size);
+
+    // Unread until committed
+    const auto first = reservation->next(100);
+    REQUIRE(first.size == 100);
+    std::copy(expected.begin(), expected.begin() + 100, first.data);
+    REQUIRE(r.read(-1, handle_message) == 0);
+
+    // The remainder is contiguous, and bounded by the reservation size
+    const auto rest = reservation->next();
+    REQUIRE(rest.data == first.data + first.size);
+    REQUIRE(rest.size == big_size - 100);
+    std::copy(expected.begin() + 100, expected.end(), rest.data);
+    REQUIRE(reservation->remaining() == 0);
+    REQUIRE(reservation->next().size == 0);
+
+    reservation->commit();
+    REQUIRE(r.read(-1, handle_message) == 1);
+    REQUIRE(last_message_body == expected);
+  }
+
+  SUBCASE("Reservations must be fully written before commit")
+  {
+    auto reservation = w.reserve_message(big_message, big_size);
+    REQUIRE(reservation.has_value());
+    reservation->write(expected.data(), big_size - 1);
+    REQUIRE_THROWS_AS(reservation->commit(), std::logic_error);
+    REQUIRE_THROWS_AS(reservation->write(expected.data(), 2), std::logic_error);
+    reservation->write(expected.back());
+    reservation->commit();
+    REQUIRE(r.read(-1, handle_message) == 1);
+    REQUIRE(last_message_body == expected);
+  }
+
+  SUBCASE("Abandoned reservations are skipped by the reader")
+  {
+    {
+      auto reservation = w.reserve_message(big_message, big_size);
+      REQUIRE(reservation.has_value());
+      reservation->write(expected.data(), 100);
+      REQUIRE(r.read(-1, handle_message) == 0);
+    }
+    REQUIRE(r.read(-1, handle_message) == 0);
+
+    // Later messages are not blocked behind it
+    auto reservation = w.reserve_message(big_message, big_size);
+    REQUIRE(reservation.has_value());
+    reservation->write(expected.data(), big_size);
+    reservation->commit();
+    REQUIRE(r.read(-1, handle_message) == 1);
+    REQUIRE(last_message_body == expected);
+  }
+
+  SUBCASE("Reservations fail without waiting when the buffer is full")
+  {
+    auto first = w.reserve_message(big_message, big_size, false);
+    REQUIRE(first.has_value());
+    size_t reserved = 1;
+    while (w.reserve_message(small_message, big_size, false).has_value())
+    {
+      ++reserved;
+    }
+    REQUIRE(reserved < 4096 / big_size);
+  }
+}
+
 TEST_CASE("Ring buffer with mixed messages" * doctest::test_suite("ringbuffer"))
 {
   constexpr size_t size = 2 << 10;
@@ -4,6 +4,7 @@
 #define PICOBENCH_DONT_BIND_TO_ONE_CORE
 #include "../ring_buffer.h"
 
+#include <numeric>
 #include <picobench/picobench.hpp>
 #include <thread>
 
@@ -89,6 +90,62 @@ static void write_impl(
   }
 }
 
+// Stands in for a producer such as a serialiser or an encryption routine,
+// which generates the message payload
+static void produce(uint8_t* dest, size_t size, uint8_t seed)
+{
+  ::memset(dest, seed, size);
+}
+
+// A single writer produces large messages, which are either built in a
+// separate buffer and copied into the ringbuffer, or produced directly into
+// a reservation in the ringbuffer
+template <size_t MessageSize, bool InPlace>
+static void write_large(picobench::state& s)
+{
+  // Large enough that the largest message is a single reservation
+  constexpr size_t buf_size = 1 << 22;
+  auto buffer = std::make_unique<ringbuffer::TestBuffer>(buf_size);
+  Reader r(buffer->bd);
+
+  const size_t total_messages = s.iterations();
+  size_t reads = 0;
+
+  s.start_timer();
+
+  std::thread writer_thread([total_messages, &r]() {
+    Writer w(r);
+    std::vector<uint8_t> payload;
+
+    for (size_t m = 0u; m < total_messages; ++m)
+    {
+      if constexpr (InPlace)
+      {
+        auto reservation = w.reserve_message(msg_type, MessageSize);
+        const auto region = reservation->next();
+        produce(region.data, region.size, m);
+        reservation->commit();
+      }
+      else
+      {
+        payload.resize(MessageSize);
+        produce(payload.data(), payload.size(), m);
+        w.write(msg_type, payload);
+      }
+    }
+  });
+
+  while (reads < total_messages)
+  {
+    reads += r.read(-1, nop_handler);
+    CCF_PAUSE();
+  }
+
+  s.stop_timer();
+
+  writer_thread.join();
+}
+
 //
 // Defaults
 //
@@ -182,3 +239,26 @@ auto spin_200 = specialize<32, 1, 4, spin_pause_handler<200>>;
 FIXED_PICO(spin_200);
 auto spin_400 = specialize<32, 1, 4, spin_pause_handler<400>>;
 FIXED_PICO(spin_400);
+
+const std::vector<int> large_msg_counts = {100, 1000};
+
+#define LARGE_PICO(NAME) \
+  PICOBENCH(NAME).iterations(large_msg_counts).samples(10)
+
+PICOBENCH_SUITE("large messages, copied vs in-place (4M buffer)");
+auto copy_1k = write_large<1 << 10, false>;
+LARGE_PICO(copy_1k).baseline();
+auto in_place_1k = write_large<1 << 10, true>;
+LARGE_PICO(in_place_1k);
+auto copy_16k = write_large<1 << 14, false>;
+LARGE_PICO(copy_16k);
+auto in_place_16k = write_large<1 << 14, true>;
+LARGE_PICO(in_place_16k);
+auto copy_256k = write_large<1 << 18, false>;
+LARGE_PICO(copy_256k);
+auto in_place_256k = write_large<1 << 18, true>;
+LARGE_PICO(in_place_256k);
+auto copy_1m = write_large<1 << 20, false>;
+LARGE_PICO(copy_1m);
+auto in_place_1m = write_large<1 << 20, true>;
+LARGE_PICO(in_place_1m);
@@ -60,6 +60,14 @@ struct VectorWriter : public AbstractWriter
     return {index + size};
   }
 
+  virtual void abandon(const WriteMarker& marker) override
+  {
+    REQUIRE(marker.has_value());
+    REQUIRE(marker.value() == 0);
+    REQUIRE(!done);
+    payload.clear();
+  }
+
   template <typename FnCheckPayload>
   void require_done(ringbuffer::Message m, FnCheckPayload f)
   {
@@ -3,6 +3,8 @@
 #include "../thread_messaging.h"
 
 #include <doctest/doctest.h>
+#include <set>
+#include <thread>
 
 struct Foo
 {
@@ -59,4 +61,163 @@ TEST_CASE("Unpopped messages are freed")
   CHECK(Foo::count == 0);
 
   CHECK(happened);
-}
\ No newline at end of file
+}
+
+static std::atomic<bool> woken = false;
+
+static void wake(std::unique_ptr<threading::Tmsg<Foo>> msg)
+{
+  woken = true;
+}
+
+struct TimeOffset
+{
+  threading::ThreadMessaging& tm;
+  std::atomic<int64_t>& offset_ms;
+
+  TimeOffset(threading::ThreadMessaging& tm_, std::atomic<int64_t>& offset_) :
+    tm(tm_),
+    offset_ms(offset_)
+  {}
+};
+
+static void read_time_offset(std::unique_ptr<threading::Tmsg<TimeOffset>> msg)
+{
+  msg->data.offset_ms = msg->data.tm.get_current_time_offset().count();
+}
+
+TEST_CASE("Idle worker parks and is woken by new tasks")
+{
+  constexpr uint16_t worker_tid = 1;
+  threading::ThreadMessaging tm(2);
+  const auto prev_thread_count =
+    threading::ThreadMessaging::thread_count.load();
+  threading::ThreadMessaging::thread_count = 2;
+  tm.set_spin_before_park(100);
+
+  std::thread worker([&tm]() {
+    threading::thread_id = worker_tid;
+    tm.run();
+  });
+
+  using namespace std::chrono_literals;
+  const auto deadline = std::chrono::steady_clock::now() + 10s;
+
+  threading::ThreadStats total;
+  while (total.parks == 0 && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(1ms);
+    total.parks += tm.retrieve_thread_stats()[worker_tid].parks;
+  }
+  REQUIRE(total.parks > 0);
+
+  INFO("Ticks do not wake a parked worker which has no timer tasks");
+  for (size_t i = 0; i < 5; ++i)
+  {
+    tm.tick(10ms);
+  }
+  std::this_thread::sleep_for(50ms);
+  CHECK(tm.retrieve_thread_stats()[worker_tid].tasks == 0);
+
+  INFO("The time of those ticks is applied once the worker runs again");
+  std::atomic<int64_t> offset_ms = -1;
+  tm.add_task<TimeOffset>(
+    worker_tid,
+    std::make_unique<threading::Tmsg<TimeOffset>>(
+      &read_time_offset, tm, offset_ms));
+  while (offset_ms == -1 && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(1ms);
+  }
+  CHECK(offset_ms == 50);
+
+  total.parks = 0;
+  while (total.parks == 0 && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(1ms);
+    total.parks += tm.retrieve_thread_stats()[worker_tid].parks;
+  }
+  REQUIRE(total.parks > 0);
+
+  tm.add_task<Foo>(worker_tid, std::make_unique<threading::Tmsg<Foo>>(&wake));
+  while (!woken && std::chrono::steady_clock::now() < deadline)
+  {
+    std::this_thread::sleep_for(1ms);
+  }
+  CHECK(woken);
+
+  // A parked worker is also woken when the thread messaging is finished
+  tm.set_finished();
+  worker.join();
+
+  const auto stats = tm.retrieve_thread_stats()[worker_tid];
+  CHECK(stats.tasks == 1);
+  CHECK(Foo::count == 0);
+
+  threading::ThreadMessaging::thread_count = prev_thread_count;
+}
+
+TEST_CASE("parallel_for runs every index once, on the workers too")
+{
+  constexpr uint16_t num_threads = 4;
+  threading::ThreadMessaging tm(num_threads);
+  const auto prev_thread_count =
+    threading::ThreadMessaging::thread_count.load();
+  threading::ThreadMessaging::thread_count = num_threads;
+
+  std::vector<std::thread> workers;
+  for (uint16_t tid = 1; tid < num_threads; ++tid)
+  {
+    workers.emplace_back([&tm, tid]() {
+      threading::thread_id = tid;
+      tm.run();
+    });
+  }
+
+  constexpr size_t n = 1000;
+  std::vector<std::atomic<size_t>> runs(n);
+  std::vector<std::atomic<uint16_t>> run_by(n);
+  tm.parallel_for(n, [&](size_t i) {
+    runs[i]++;
+    run_by[i] = threading::get_current_thread_id();
+    std::this_thread::sleep_for(std::chrono::microseconds(10));
+  });
+
+  std::set<uint16_t> threads;
+  for (size_t i = 0; i < n; ++i)
+  {
+    REQUIRE(runs[i] == 1);
+    threads.insert(run_by[i]);
+  }
+  CHECK(threads.size() > 1);
+
+  INFO("Empty and single index loops run on the calling thread");
+  tm.parallel_for(0, [](size_t) { CHECK(false); });
+  size_t single = 0;
+  tm.parallel_for(1, [&](size_t i) { single += i + 1; });
+  CHECK(single == 1);
+
+  INFO("The first exception is rethrown once all indices have run");
+  std::atomic<size_t> done = 0;
+  REQUIRE_THROWS_AS(
+    tm.parallel_for(
+      100,
+      [&](size_t i) {
+        done++;
+        if (i % 10 == 0)
+        {
+          throw std::logic_error("Failed");
+        }
+      }),
+    std::logic_error);
+  CHECK(done == 100);
+
+  tm.set_finished();
+  for (auto& w : workers)
+  {
+    w.join();
+  }
+  tm.drop_tasks();
+
+  threading::ThreadMessaging::thread_count = prev_thread_count;
+}
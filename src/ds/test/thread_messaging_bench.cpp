@@ -0,0 +1,143 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#define PICOBENCH_IMPLEMENT
+#define PICOBENCH_DONT_BIND_TO_ONE_CORE
+#include "../thread_messaging.h"
+
+#include <iostream>
+#include <picobench/picobench.hpp>
+#include <pthread.h>
+#include <thread>
+#include <time.h>
+
+::timespec logger::config::start{0, 0};
+std::atomic<uint16_t> threading::ThreadMessaging::thread_count = 0;
+
+constexpr uint16_t worker_tid = 1;
+
+struct Ping
+{
+  std::atomic<bool>& done;
+
+  Ping(std::atomic<bool>& done_) : done(done_) {}
+};
+
+static void ping_cb(std::unique_ptr<threading::Tmsg<Ping>> msg)
+{
+  msg->data.done.store(true);
+}
+
+// Runs a single worker thread, with the given idle policy, for the lifetime of
+// this object
+class Worker
+{
+public:
+  threading::ThreadMessaging tm;
+  std::thread thread;
+
+  Worker(size_t spin_before_park) : tm(2)
+  {
+    threading::ThreadMessaging::thread_count = 2;
+    tm.set_spin_before_park(spin_before_park);
+    thread = std::thread([this]() {
+      threading::thread_id = worker_tid;
+      tm.run();
+    });
+  }
+
+  ~Worker()
+  {
+    tm.set_finished();
+    thread.join();
+    tm.drop_tasks();
+  }
+
+  uint64_t parks()
+  {
+    return tm.retrieve_thread_stats()[worker_tid].parks;
+  }
+};
+
+// Time from a task being added for an idle worker thread until it has run.
+// When Park is true, the worker is parked each time. Otherwise it spins.
+template <bool Park>
+static void wakeup_latency(picobench::state& s)
+{
+  Worker w(Park ? 1 : 0);
+
+  for (auto _ : s)
+  {
+    (void)_;
+    if constexpr (Park)
+    {
+      // Wait for the worker to park after the previous task
+      while (w.parks() == 0)
+      {
+        std::this_thread::yield();
+      }
+    }
+
+    std::atomic<bool> done = false;
+    const auto start = picobench::high_res_clock::now();
+    w.tm.add_task<Ping>(
+      worker_tid, std::make_unique<threading::Tmsg<Ping>>(&ping_cb, done));
+    while (!done.load())
+    {
+      CCF_PAUSE();
+    }
+    s.add_custom_duration(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        picobench::high_res_clock::now() - start)
+        .count());
+  }
+}
+
+const std::vector<int> wakeup_counts = {100, 1000};
+
+PICOBENCH_SUITE("wakeup");
+PICOBENCH(wakeup_latency<false>).iterations(wakeup_counts).baseline();
+PICOBENCH(wakeup_latency<true>).iterations(wakeup_counts);
+
+// CPU time used by an idle worker thread over a fixed period, during which
+// all threads are ticked every 10ms, as they are in the enclave
+static std::chrono::microseconds idle_cpu_time(size_t spin_before_park)
+{
+  Worker w(spin_before_park);
+
+  clockid_t clock;
+  pthread_getcpuclockid(w.thread.native_handle(), &clock);
+
+  auto cpu_now = [clock]() {
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return std::chrono::seconds(ts.tv_sec) +
+      std::chrono::nanoseconds(ts.tv_nsec);
+  };
+
+  const auto start = cpu_now();
+  for (size_t i = 0; i < 50; ++i)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    w.tm.tick(std::chrono::milliseconds(10));
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    cpu_now() - start);
+}
+
+int main(int argc, char* argv[])
+{
+  picobench::runner runner;
+  runner.parse_cmd_line(argc, argv);
+  const auto ret = runner.run();
+
+  std::cout << "Idle worker CPU time over 500ms, spinning: "
+            << idle_cpu_time(0).count() << "us, parking after "
+            << threading::ThreadMessaging::default_spin_before_park
+            << " polls: "
+            << idle_cpu_time(
+                 threading::ThreadMessaging::default_spin_before_park)
+                 .count()
+            << "us" << std::endl;
+
+  return ret;
+}
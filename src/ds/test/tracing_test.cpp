@@ -0,0 +1,150 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#include "../tracing.h"
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+class RecordingSink : public tracing::AbstractSpanSink
+{
+public:
+  std::vector<tracing::Span>& spans;
+
+  RecordingSink(std::vector<tracing::Span>& spans) : spans(spans) {}
+
+  void write_spans(const tracing::Span* s, size_t count) override
+  {
+    spans.insert(spans.end(), s, s + count);
+  }
+};
+
+static uint64_t fake_time_us = 0;
+
+struct TracingFixture
+{
+  std::vector<tracing::Span> spans;
+
+  TracingFixture()
+  {
+    tracing::config::sink() = std::make_unique<RecordingSink>(spans);
+    tracing::config::clock() = []() {
+      return std::chrono::microseconds(fake_time_us++);
+    };
+  }
+
+  ~TracingFixture()
+  {
+    tracing::set_sample_rate(0);
+    tracing::PendingTraces::instance().clear();
+    tracing::config::sink() = nullptr;
+  }
+};
+
+TEST_CASE_FIXTURE(TracingFixture, "Requests are sampled")
+{
+  for (size_t i = 0; i < 10; ++i)
+  {
+    REQUIRE(tracing::start_trace() == 0);
+  }
+
+  constexpr auto rate = 4;
+  tracing::set_sample_rate(rate);
+
+  std::set<uint64_t> traces;
+  for (size_t i = 0; i < 10 * rate; ++i)
+  {
+    const auto trace_id = tracing::start_trace();
+    if (trace_id != 0)
+    {
+      traces.insert(trace_id);
+    }
+  }
+  REQUIRE(traces.size() == 10);
+}
+
+TEST_CASE_FIXTURE(TracingFixture, "Spans are only recorded for traced requests")
+{
+  {
+    tracing::ScopedSpan span(tracing::SpanKind::HttpRequest);
+  }
+  tracing::flush();
+  REQUIRE(spans.empty());
+
+  {
+    tracing::TraceScope trace(42);
+    tracing::ScopedSpan outer(tracing::SpanKind::HttpRequest);
+    {
+      tracing::ScopedSpan inner(tracing::SpanKind::TxCommit);
+      inner.set_seqno(7);
+    }
+  }
+  REQUIRE(tracing::current_trace == 0);
+
+  INFO("Spans are buffered until flushed");
+  REQUIRE(spans.empty());
+  tracing::flush();
+  REQUIRE(spans.size() == 2);
+
+  const auto& inner = spans[0];
+  REQUIRE(inner.trace_id == 42);
+  REQUIRE(inner.kind == tracing::SpanKind::TxCommit);
+  REQUIRE(inner.seqno == 7);
+
+  const auto& outer = spans[1];
+  REQUIRE(outer.trace_id == 42);
+  REQUIRE(outer.kind == tracing::SpanKind::HttpRequest);
+  REQUIRE(outer.seqno == 0);
+  REQUIRE(outer.start_us < inner.start_us);
+  REQUIRE(inner.end_us < outer.end_us);
+
+  INFO("Full buffers are flushed");
+  spans.clear();
+  for (size_t i = 0; i < tracing::SpanBuffer::flush_count; ++i)
+  {
+    tracing::TraceScope trace(i + 1);
+    tracing::ScopedSpan span(tracing::SpanKind::FindEndpoint);
+  }
+  REQUIRE(spans.size() == tracing::SpanBuffer::flush_count);
+}
+
+TEST_CASE_FIXTURE(TracingFixture, "Replication and commit of traced transactions")
+{
+  auto& pending = tracing::PendingTraces::instance();
+  pending.add(10, 1, 0);
+  pending.add(11, 2, 0);
+  pending.add(12, 3, 0);
+
+  auto count = [this](tracing::SpanKind kind) {
+    return std::count_if(spans.begin(), spans.end(), [kind](const auto& s) {
+      return s.kind == kind;
+    });
+  };
+
+  pending.on_ack(1, 11);
+  pending.on_ack(2, 10);
+  tracing::flush();
+  REQUIRE(count(tracing::SpanKind::ReplicationAck) == 3);
+
+  INFO("Each node's acknowledgement is only reported once");
+  pending.on_ack(1, 12);
+  tracing::flush();
+  REQUIRE(count(tracing::SpanKind::ReplicationAck) == 4);
+  REQUIRE(spans.back().peer == 1);
+  REQUIRE(spans.back().seqno == 12);
+  REQUIRE(spans.back().trace_id == 3);
+
+  pending.on_commit(11);
+  tracing::flush();
+  REQUIRE(count(tracing::SpanKind::GlobalCommit) == 2);
+
+  INFO("Committed transactions are no longer pending");
+  pending.on_commit(11);
+  pending.on_ack(3, 11);
+  tracing::flush();
+  REQUIRE(count(tracing::SpanKind::GlobalCommit) == 2);
+  REQUIRE(count(tracing::SpanKind::ReplicationAck) == 4);
+
+  pending.on_commit(12);
+  tracing::flush();
+  REQUIRE(count(tracing::SpanKind::GlobalCommit) == 3);
+}
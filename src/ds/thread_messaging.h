@@ -4,11 +4,18 @@
 
 #include "ds/ccf_assert.h"
 #include "ds/logger.h"
+#include "ds/parallel_for.h"
+#include "ds/ring_buffer.h"
 #include "ds/thread_ids.h"
+#include "ds/tracing.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <exception>
+#include <mutex>
 
 namespace threading
 {
@@ -38,11 +45,50 @@ namespace threading
 
   class ThreadMessaging;
 
+  // Thread activity is timed with the tracing clock, which in the enclave is
+  // the time last reported by the host rather than an ocall. It only advances
+  // every millisecond, so short stretches of activity are counted in whole
+  // ticks, or not at all, but the totals over many stretches are accurate.
+  static inline uint64_t stats_now_us()
+  {
+    return tracing::config::now_us();
+  }
+
+  // Activity of a thread since these were last retrieved. Times are in
+  // microseconds.
+  struct ThreadStats
+  {
+    uint64_t busy_us = 0;
+    uint64_t idle_us = 0;
+    uint64_t parked_us = 0;
+    uint64_t tasks = 0;
+    uint64_t parks = 0;
+  };
+
   class Task
   {
     std::atomic<ThreadMsg*> item_head = nullptr;
     ThreadMsg* local_msg = nullptr;
 
+    // Set by the owning thread while it is, or is about to be, blocked on
+    // wakeup, so that producers only pay for a notification when it is needed
+    std::atomic<bool> parked = false;
+    std::mutex park_lock;
+    std::condition_variable wakeup;
+
+    std::atomic<uint64_t> busy_us = 0;
+    std::atomic<uint64_t> idle_us = 0;
+    std::atomic<uint64_t> parked_us = 0;
+    std::atomic<uint64_t> tasks_run = 0;
+    std::atomic<uint64_t> parks = 0;
+
+    // Ticks are not delivered to a parked thread which has no timer tasks, as
+    // they would only wake it up. Instead, their time is accumulated here and
+    // applied when the thread next looks at its time offset.
+    std::atomic<uint64_t> deferred_elapsed_ms = 0;
+    // Size of timer_map, which is only accessed by the owning thread
+    std::atomic<size_t> timer_count = 0;
+
   public:
     Task() = default;
 
@@ -74,6 +120,43 @@ namespace threading
         tmp_head = item_head.load();
         item->next = tmp_head;
       } while (!item_head.compare_exchange_strong(tmp_head, item));
+
+      if (parked.load())
+      {
+        notify();
+      }
+    }
+
+    // Block the calling thread, which must own this task, until a task is
+    // added or should_stop returns true
+    template <typename Pred>
+    void park(Pred should_stop)
+    {
+      std::unique_lock<std::mutex> guard(park_lock);
+      parked.store(true);
+      // Re-check after publishing the parked flag, as a producer which added
+      // a task before seeing the flag will not notify
+      wakeup.wait(guard, [this, &should_stop]() {
+        return item_head.load() != nullptr || should_stop();
+      });
+      parked.store(false);
+    }
+
+    void notify()
+    {
+      std::lock_guard<std::mutex> guard(park_lock);
+      wakeup.notify_one();
+    }
+
+    ThreadStats retrieve_stats()
+    {
+      ThreadStats stats;
+      stats.busy_us = busy_us.exchange(0);
+      stats.idle_us = idle_us.exchange(0);
+      stats.parked_us = parked_us.exchange(0);
+      stats.tasks = tasks_run.exchange(0);
+      stats.parks = parks.exchange(0);
+      return stats;
     }
 
     struct TimerEntry
@@ -104,6 +187,8 @@ namespace threading
     TimerEntry add_task_after(
       std::unique_ptr<ThreadMsg> item, std::chrono::milliseconds ms)
     {
+      apply_deferred_elapsed();
+
       TimerEntry entry = {time_offset + ms, time_entry_counter++};
       if (timer_map.empty() || entry.time_offset <= next_time_offset)
       {
@@ -111,6 +196,7 @@ namespace threading
       }
 
       timer_map.emplace(entry, std::move(item));
+      timer_count.store(timer_map.size());
       return entry;
     }
 
@@ -118,6 +204,7 @@ namespace threading
     {
       auto num_erased = timer_map.erase(timer_entry);
       CCF_ASSERT(num_erased <= 1, "Too many items erased");
+      timer_count.store(timer_map.size());
       if (!timer_map.empty() && timer_entry.time_offset <= next_time_offset)
       {
         next_time_offset = timer_map.begin()->first.time_offset;
@@ -127,6 +214,7 @@ namespace threading
 
     void tick(std::chrono::milliseconds elapsed)
     {
+      apply_deferred_elapsed();
       time_offset += elapsed;
 
       bool updated = false;
@@ -147,13 +235,27 @@ namespace threading
       {
         next_time_offset = timer_map.begin()->first.time_offset;
       }
+      timer_count.store(timer_map.size());
     }
 
     std::chrono::milliseconds get_current_time_offset()
     {
+      apply_deferred_elapsed();
       return time_offset;
     }
 
+    // Called by the ticking thread, rather than the owning thread
+    bool defer_tick_if_parked(std::chrono::milliseconds elapsed)
+    {
+      if (!parked.load() || timer_count.load() != 0)
+      {
+        return false;
+      }
+
+      deferred_elapsed_ms.fetch_add(elapsed.count());
+      return true;
+    }
+
   private:
     std::chrono::milliseconds time_offset = std::chrono::milliseconds(0);
     uint64_t time_entry_counter = 0;
@@ -161,6 +263,11 @@ namespace threading
       timer_map;
     std::chrono::milliseconds next_time_offset;
 
+    void apply_deferred_elapsed()
+    {
+      time_offset += std::chrono::milliseconds(deferred_elapsed_ms.exchange(0));
+    }
+
     void reverse_local_messages()
     {
       if (local_msg == nullptr)
@@ -208,6 +315,63 @@ namespace threading
     std::atomic<bool> finished;
     std::vector<Task> tasks;
 
+    // Shared by the threads running a parallel_for. Each thread claims the
+    // next index until all have been claimed.
+    struct ParallelForState
+    {
+      const size_t n;
+      const std::function<void(size_t)> fn;
+      std::atomic<size_t> next = 0;
+      std::atomic<size_t> done = 0;
+
+      std::mutex error_lock;
+      std::exception_ptr error = nullptr;
+
+      ParallelForState(size_t n_, const std::function<void(size_t)>& fn_) :
+        n(n_),
+        fn(fn_)
+      {}
+
+      void run()
+      {
+        for (size_t i = next++; i < n; i = next++)
+        {
+          try
+          {
+            fn(i);
+          }
+          catch (...)
+          {
+            std::lock_guard<std::mutex> guard(error_lock);
+            if (error == nullptr)
+            {
+              error = std::current_exception();
+            }
+          }
+          done++;
+        }
+      }
+    };
+
+    struct ParallelForMsg
+    {
+      std::shared_ptr<ParallelForState> state;
+
+      ParallelForMsg(const std::shared_ptr<ParallelForState>& state_) :
+        state(state_)
+      {}
+    };
+
+    static void parallel_for_cb(std::unique_ptr<Tmsg<ParallelForMsg>> msg)
+    {
+      msg->data.state->run();
+    }
+
+    // Number of consecutive empty polls after which an idle worker thread
+    // stops spinning and parks until a task is added for it. 0 disables
+    // parking.
+    std::atomic<size_t> spin_before_park;
+
   public:
     static ThreadMessaging thread_messaging;
     static std::atomic<uint16_t> thread_count;
@@ -215,9 +379,12 @@ namespace threading
 
     static const uint16_t max_num_threads = 24;
 
+    static constexpr size_t default_spin_before_park = 10000;
+
     ThreadMessaging(uint16_t num_threads = max_num_threads) :
       finished(false),
-      tasks(num_threads)
+      tasks(num_threads),
+      spin_before_park(default_spin_before_park)
     {}
 
     // Drop all pending tasks, this is only ever to be used
@@ -234,18 +401,93 @@ namespace threading
     void set_finished(bool v = true)
     {
       finished.store(v);
+
+      if (v)
+      {
+        for (auto& t : tasks)
+        {
+          t.notify();
+        }
+      }
+    }
+
+    void set_spin_before_park(size_t n)
+    {
+      spin_before_park.store(n);
     }
 
+    // Run tasks for the current thread until finished. When there is nothing
+    // to do, the thread spins for a while, in case more work arrives shortly,
+    // then parks until a task is added for it.
     void run()
     {
       Task& task = get_task(get_current_thread_id());
 
+      size_t consecutive_idles = 0;
+      auto stretch_start = stats_now_us();
+
       while (!is_finished())
       {
-        task.run_next_task();
+        if (task.run_next_task())
+        {
+          task.tasks_run.fetch_add(1, std::memory_order_relaxed);
+          if (consecutive_idles != 0)
+          {
+            const auto now = stats_now_us();
+            task.idle_us.fetch_add(now - stretch_start);
+            stretch_start = now;
+            consecutive_idles = 0;
+          }
+          continue;
+        }
+
+        if (consecutive_idles++ == 0)
+        {
+          const auto now = stats_now_us();
+          task.busy_us.fetch_add(now - stretch_start);
+          stretch_start = now;
+
+          // Idle, so pass any log records and spans written by this thread to
+          // the host
+          logger::flush_deferred();
+          tracing::flush();
+        }
+
+        const auto spin_limit = spin_before_park.load();
+        if (spin_limit == 0 || consecutive_idles < spin_limit)
+        {
+          CCF_PAUSE();
+          continue;
+        }
+
+        // Records may have been written by the last task run
+        logger::flush_deferred();
+        tracing::flush();
+
+        const auto park_start = stats_now_us();
+        task.idle_us.fetch_add(park_start - stretch_start);
+        task.parks.fetch_add(1);
+        task.park([this]() { return is_finished(); });
+        stretch_start = stats_now_us();
+        task.parked_us.fetch_add(stretch_start - park_start);
+
+        // Resume spinning, rather than parking straight away
+        consecutive_idles = 1;
       }
     }
 
+    // Activity of each thread since the last call, indexed by thread id
+    std::vector<ThreadStats> retrieve_thread_stats()
+    {
+      std::vector<ThreadStats> stats;
+      const size_t n = std::min<size_t>(thread_count, tasks.size());
+      for (size_t i = 0; i < n; ++i)
+      {
+        stats.push_back(tasks[i].retrieve_stats());
+      }
+      return stats;
+    }
+
     inline Task& get_task(uint16_t tid)
     {
       CCF_ASSERT_FMT(
@@ -304,6 +546,11 @@ namespace threading
     static void tick_cb(std::unique_ptr<Tmsg<TickMsg>> msg)
     {
       msg->data.task.tick(msg->data.elapsed);
+
+      // A thread which is never idle would otherwise hold on to the records
+      // it writes until it writes more
+      logger::flush_deferred();
+      tracing::flush();
     }
 
     void tick(std::chrono::milliseconds elapsed)
@@ -311,11 +558,53 @@ namespace threading
       for (auto i = 0; i < thread_count; ++i)
       {
         auto& task = get_task(i);
+        if (task.defer_tick_if_parked(elapsed))
+        {
+          continue;
+        }
+
         auto msg = std::make_unique<Tmsg<TickMsg>>(&tick_cb, elapsed, task);
         task.add_task(msg.release());
       }
     }
 
+    /** Runs fn(0) to fn(n - 1) on the calling thread and on the worker
+     * threads, and returns once all of them have run.
+     *
+     * The calling thread claims indices alongside the workers, so it runs any
+     * that the workers have not started, and only waits for calls already in
+     * progress on other threads. It therefore never waits for workers which
+     * are busy with other tasks, or are themselves in a parallel_for.
+     */
+    void parallel_for(size_t n, const std::function<void(size_t)>& fn)
+    {
+      auto state = std::make_shared<ParallelForState>(n, fn);
+
+      const auto current = get_current_thread_id();
+      size_t helpers = 0;
+      for (uint16_t tid = 1; tid < thread_count && helpers + 1 < n; ++tid)
+      {
+        if (tid != current)
+        {
+          add_task(
+            tid,
+            std::make_unique<Tmsg<ParallelForMsg>>(&parallel_for_cb, state));
+          ++helpers;
+        }
+      }
+
+      state->run();
+      while (state->done.load() < n)
+      {
+        CCF_PAUSE();
+      }
+
+      if (state->error != nullptr)
+      {
+        std::rethrow_exception(state->error);
+      }
+    }
+
     static uint16_t get_execution_thread(uint32_t i)
     {
       uint16_t tid = MAIN_THREAD_ID;
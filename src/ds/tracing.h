@@ -0,0 +1,393 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include "ds/ring_buffer.h"
+#include "ds/thread_ids.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace tracing
+{
+  // Stages of the processing of a request, from its arrival on a node to its
+  // global commit
+  enum class SpanKind : uint8_t
+  {
+    TlsDecrypt = 0,
+    HttpRequest,
+    FindEndpoint,
+    ExecuteEndpoint,
+    TxCommit,
+    StoreCommit,
+    Replicate,
+    LedgerWrite,
+    ReplicationAck,
+    GlobalCommit,
+
+    MaxSpanKind
+  };
+
+  static constexpr const char* span_names[] = {"tls_decrypt",
+                                               "http_request",
+                                               "find_endpoint",
+                                               "execute_endpoint",
+                                               "tx_commit",
+                                               "store_commit",
+                                               "replicate",
+                                               "ledger_write",
+                                               "replication_ack",
+                                               "global_commit"};
+
+  static inline const char* to_string(SpanKind kind)
+  {
+    return span_names[static_cast<size_t>(kind)];
+  }
+
+  // Spans are shipped from the enclave to the host as they are laid out in
+  // memory
+  struct Span
+  {
+    // Id of the sampled request. 0 for spans recorded by the host, which are
+    // matched to requests by seqno
+    uint64_t trace_id;
+    // Seqno of the transaction, once it is known
+    uint64_t seqno;
+    // For replication acks, the node which acknowledged the transaction
+    uint64_t peer;
+    // Microseconds since the host started
+    uint64_t start_us;
+    uint64_t end_us;
+    uint16_t thread_id;
+    SpanKind kind;
+  };
+
+  class AbstractSpanSink
+  {
+  public:
+    virtual ~AbstractSpanSink() = default;
+
+    virtual void write_spans(const Span* spans, size_t count) = 0;
+
+    // Called when tracing is enabled or disabled, so that the sink can notify
+    // other processes which record spans
+    virtual void set_sample_rate(uint32_t) {}
+  };
+
+  // Writes spans to the host, where they are written to a trace file
+  class RingbufferSpanSink : public AbstractSpanSink
+  {
+  private:
+    ringbuffer::WriterPtr writer;
+    ringbuffer::Message spans_msg;
+    ringbuffer::Message config_msg;
+
+  public:
+    RingbufferSpanSink(
+      const ringbuffer::WriterPtr& writer,
+      ringbuffer::Message spans_msg,
+      ringbuffer::Message config_msg) :
+      writer(writer),
+      spans_msg(spans_msg),
+      config_msg(config_msg)
+    {}
+
+    void write_spans(const Span* spans, size_t count) override
+    {
+      writer->write(
+        spans_msg,
+        serializer::ByteRange{reinterpret_cast<const uint8_t*>(spans),
+                              count * sizeof(Span)});
+    }
+
+    void set_sample_rate(uint32_t rate) override
+    {
+      writer->write(config_msg, rate);
+    }
+  };
+
+  using Clock = std::chrono::microseconds (*)();
+
+  class config
+  {
+  public:
+    // 1 in sample_rate requests is traced. 0 disables tracing
+    static inline std::atomic<uint32_t>& sample_rate()
+    {
+      static std::atomic<uint32_t> the_rate = 0;
+      return the_rate;
+    }
+
+    static inline bool enabled()
+    {
+      return sample_rate().load(std::memory_order_relaxed) != 0;
+    }
+
+    static inline std::unique_ptr<AbstractSpanSink>& sink()
+    {
+      static std::unique_ptr<AbstractSpanSink> the_sink;
+      return the_sink;
+    }
+
+    // Start of the host's monotonic clock, shared with the enclave
+    static inline std::chrono::steady_clock::time_point& epoch()
+    {
+      static std::chrono::steady_clock::time_point the_epoch =
+        std::chrono::steady_clock::now();
+      return the_epoch;
+    }
+
+    static inline Clock& clock()
+    {
+      static Clock the_clock = []() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - epoch());
+      };
+      return the_clock;
+    }
+
+    static inline uint64_t now_us()
+    {
+      return clock()().count();
+    }
+  };
+
+  static inline void set_sample_rate(uint32_t rate)
+  {
+    config::sample_rate() = rate;
+
+    auto& sink = config::sink();
+    if (sink != nullptr)
+    {
+      sink->set_sample_rate(rate);
+    }
+  }
+
+  // Trace of the request being processed by the current thread, or 0 if it
+  // is not sampled
+  static inline thread_local uint64_t current_trace = 0;
+
+  /** Decide whether to trace a new request
+   *
+   * @return Id of the new trace if the request is sampled, 0 otherwise
+   */
+  static inline uint64_t start_trace()
+  {
+    const auto rate = config::sample_rate().load(std::memory_order_relaxed);
+    if (rate == 0)
+    {
+      return 0;
+    }
+
+    static std::atomic<uint64_t> requests = 0;
+    static std::atomic<uint64_t> next_trace_id = 0;
+    if (requests.fetch_add(1, std::memory_order_relaxed) % rate != 0)
+    {
+      return 0;
+    }
+
+    return ++next_trace_id;
+  }
+
+  // Sets the trace of the current thread, for the lifetime of this object
+  class TraceScope
+  {
+  private:
+    const uint64_t previous;
+
+  public:
+    TraceScope(uint64_t trace_id) : previous(current_trace)
+    {
+      current_trace = trace_id;
+    }
+
+    ~TraceScope()
+    {
+      current_trace = previous;
+    }
+  };
+
+  static inline uint16_t thread_id()
+  {
+#ifdef INSIDE_ENCLAVE
+    return threading::get_current_thread_id();
+#else
+    return 100;
+#endif
+  }
+
+  // Spans recorded by the current thread, which are passed to the sink in
+  // batches. Only touched by its own thread, so needs no synchronisation.
+  class SpanBuffer
+  {
+  private:
+    std::vector<Span> spans;
+
+  public:
+    static constexpr size_t flush_count = 256;
+
+    static SpanBuffer& current()
+    {
+      static thread_local SpanBuffer buffer;
+      return buffer;
+    }
+
+    void add(const Span& span)
+    {
+      spans.push_back(span);
+      if (spans.size() >= flush_count)
+      {
+        flush();
+      }
+    }
+
+    void flush()
+    {
+      if (spans.empty())
+      {
+        return;
+      }
+
+      auto& sink = config::sink();
+      if (sink != nullptr)
+      {
+        sink->write_spans(spans.data(), spans.size());
+      }
+      spans.clear();
+    }
+  };
+
+  static inline void record(const Span& span)
+  {
+    SpanBuffer::current().add(span);
+  }
+
+  static inline void flush()
+  {
+    SpanBuffer::current().flush();
+  }
+
+  // Records a span covering its lifetime, if the current request is traced
+  class ScopedSpan
+  {
+  private:
+    const SpanKind kind;
+    const uint64_t trace_id;
+    uint64_t start_us = 0;
+    uint64_t seqno = 0;
+
+  public:
+    ScopedSpan(SpanKind kind) : kind(kind), trace_id(current_trace)
+    {
+      if (trace_id != 0)
+      {
+        start_us = config::now_us();
+      }
+    }
+
+    ~ScopedSpan()
+    {
+      if (trace_id != 0)
+      {
+        record(
+          {trace_id, seqno, 0, start_us, config::now_us(), thread_id(), kind});
+      }
+    }
+
+    void set_seqno(uint64_t s)
+    {
+      seqno = s;
+    }
+  };
+
+  // Traced transactions which have been replicated but are not yet globally
+  // committed. Each of them is reported once per node which acknowledges it,
+  // and once when it is globally committed.
+  class PendingTraces
+  {
+  private:
+    struct Pending
+    {
+      uint64_t trace_id;
+      uint64_t start_us;
+      std::set<uint64_t> acked_by;
+    };
+
+    std::mutex lock;
+    std::map<uint64_t, Pending> pending;
+
+  public:
+    static PendingTraces& instance()
+    {
+      static PendingTraces the_pending;
+      return the_pending;
+    }
+
+    void add(uint64_t seqno, uint64_t trace_id, uint64_t start_us)
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      pending[seqno] = {trace_id, start_us, {}};
+    }
+
+    void on_ack(uint64_t peer, uint64_t match_idx)
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      if (pending.empty())
+      {
+        return;
+      }
+
+      const auto now = config::now_us();
+      for (auto it = pending.begin();
+           it != pending.end() && it->first <= match_idx;
+           ++it)
+      {
+        auto& p = it->second;
+        if (p.acked_by.insert(peer).second)
+        {
+          record({p.trace_id,
+                  it->first,
+                  peer,
+                  p.start_us,
+                  now,
+                  thread_id(),
+                  SpanKind::ReplicationAck});
+        }
+      }
+    }
+
+    void on_commit(uint64_t commit_idx)
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      if (pending.empty())
+      {
+        return;
+      }
+
+      const auto now = config::now_us();
+      auto it = pending.begin();
+      for (; it != pending.end() && it->first <= commit_idx; ++it)
+      {
+        record({it->second.trace_id,
+                it->first,
+                0,
+                it->second.start_us,
+                now,
+                thread_id(),
+                SpanKind::GlobalCommit});
+      }
+      pending.erase(pending.begin(), it);
+    }
+
+    void clear()
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      pending.clear();
+    }
+  };
+}
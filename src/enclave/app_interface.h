@@ -3,6 +3,7 @@
 #pragma once
 
 #include "node/historical_queries_interface.h"
+#include "node/indexing.h"
 #include "node/rpc/user_frontend.h"
 
 namespace ccfapp
@@ -12,6 +13,8 @@ namespace ccfapp
     virtual ~AbstractNodeContext() = default;
 
     virtual ccf::historical::AbstractStateCache& get_historical_state() = 0;
+
+    virtual ccf::indexing::Indexer& get_indexer() = 0;
   };
 
   // SNIPPET_START: rpc_handler
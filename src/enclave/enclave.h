@@ -5,6 +5,7 @@
 #include "crypto/hash.h"
 #include "ds/logger.h"
 #include "ds/oversized.h"
+#include "ds/tracing.h"
 #include "enclave_time.h"
 #include "interface.h"
 #include "node/entities.h"
@@ -32,6 +33,8 @@ namespace enclave
     std::shared_ptr<RPCSessions> rpcsessions;
     std::unique_ptr<ccf::NodeState> node;
     std::shared_ptr<ccf::Forwarder<ccf::NodeToNode>> cmd_forwarder;
+    std::shared_ptr<ccf::CommitNotifier> commit_notifier;
+    std::shared_ptr<ccf::PendingReads> pending_reads;
     ringbuffer::WriterPtr to_host = nullptr;
 
     CCFConfig ccf_config;
@@ -40,15 +43,22 @@ namespace enclave
     struct NodeContext : public ccfapp::AbstractNodeContext
     {
       ccf::historical::StateCache historical_state_cache;
+      ccf::indexing::Indexer indexer;
 
-      NodeContext(ccf::historical::StateCache&& hsc) :
-        historical_state_cache(std::move(hsc))
+      NodeContext(ccf::historical::StateCache&& hsc, kv::Store& store) :
+        historical_state_cache(std::move(hsc)),
+        indexer(store)
       {}
 
       ccf::historical::AbstractStateCache& get_historical_state() override
       {
         return historical_state_cache;
       }
+
+      ccf::indexing::Indexer& get_indexer() override
+      {
+        return indexer;
+      }
     } context;
 
   public:
@@ -73,11 +83,25 @@ namespace enclave
       rpcsessions(std::make_shared<RPCSessions>(writer_factory, rpc_map)),
       cmd_forwarder(std::make_shared<ccf::Forwarder<ccf::NodeToNode>>(
         rpcsessions, n2n_channels, rpc_map, consensus_type_)),
-      context(ccf::historical::StateCache(
-        *network.tables, writer_factory.create_writer_to_outside()))
+      commit_notifier(std::make_shared<ccf::CommitNotifier>(rpcsessions)),
+      pending_reads(std::make_shared<ccf::PendingReads>(rpcsessions)),
+      context(
+        ccf::historical::StateCache(
+          *network.tables, writer_factory.create_writer_to_outside()),
+        *network.tables)
     {
       logger::config::msg() = AdminMessage::log_msg;
       logger::config::writer() = writer_factory.create_writer_to_outside();
+      logger::config::deferred_sink() =
+        std::make_unique<logger::RingbufferDeferredSink>(
+          logger::config::writer(),
+          AdminMessage::log_site,
+          AdminMessage::log_records);
+      tracing::config::clock() = &enclave::get_enclave_time;
+      tracing::config::sink() = std::make_unique<tracing::RingbufferSpanSink>(
+        logger::config::writer(),
+        AdminMessage::trace_spans,
+        AdminMessage::trace_config);
 
       to_host = writer_factory.create_writer_to_outside();
 
@@ -100,15 +124,25 @@ namespace enclave
           signature_intervals.sig_tx_interval,
           signature_intervals.sig_ms_interval);
         fe->set_cmd_forwarder(cmd_forwarder);
+        fe->set_commit_notifier(commit_notifier);
+        fe->set_pending_reads(pending_reads);
+        fe->set_historical_state(&context.historical_state_cache);
+        fe->set_responder(rpcsessions);
       }
 
+      rpcsessions->set_close_callback(
+        [this](size_t id) { commit_notifier->unsubscribe(id); });
+
       node->initialize(
         consensus_config,
         n2n_channels,
         rpc_map,
         cmd_forwarder,
+        commit_notifier,
+        pending_reads,
         signature_intervals.sig_tx_interval,
-        signature_intervals.sig_ms_interval);
+        signature_intervals.sig_ms_interval,
+        signature_intervals.sig_latency_target_ms);
     }
 
     bool create_new_node(
@@ -128,6 +162,8 @@ namespace enclave
       start_type = start_type_;
       ccf_config = ccf_config_;
 
+      logger::config::site_rate_limit() = ccf_config.log_site_rate_limit;
+
       auto r = node->create({start_type, ccf_config});
       if (!r.second)
         return false;
@@ -195,14 +231,33 @@ namespace enclave
             {
               const auto message_counts =
                 bp.get_dispatcher().retrieve_message_counts();
-              const auto j =
+              auto j = nlohmann::json::object();
+              j["ringbuffer_messages"] =
                 bp.get_dispatcher().convert_message_counts(message_counts);
+
+              const auto thread_stats = threading::ThreadMessaging::
+                thread_messaging.retrieve_thread_stats();
+              auto& threads_j = j["threads"] = nlohmann::json::object();
+              // The main thread is driven by the ringbuffer, so only worker
+              // threads are reported
+              for (size_t tid = 1; tid < thread_stats.size(); ++tid)
+              {
+                const auto& ts = thread_stats[tid];
+                threads_j[std::to_string(tid)] = {{"busy_us", ts.busy_us},
+                                                  {"idle_us", ts.idle_us},
+                                                  {"parked_us", ts.parked_us},
+                                                  {"tasks", ts.tasks},
+                                                  {"parks", ts.parks}};
+              }
+
               RINGBUFFER_WRITE_MESSAGE(
                 AdminMessage::work_stats, to_host, j.dump());
 
               std::chrono::milliseconds elapsed_ms(ms_count);
               logger::config::tick(elapsed_ms);
+              logger::flush_deferred();
               node->tick(elapsed_ms);
+              pending_reads->tick(elapsed_ms);
               threading::ThreadMessaging::thread_messaging.tick(elapsed_ms);
               // When recovering, no signature should be emitted while the
               // public ledger is being read
@@ -307,6 +362,9 @@ namespace enclave
           static std::chrono::microseconds idling_start_time;
           const auto time_now = enclave::get_enclave_time();
 
+          logger::flush_deferred();
+          tracing::flush();
+
           if (num_consecutive_idles == 0)
           {
             idling_start_time = time_now;
@@ -337,6 +395,8 @@ namespace enclave
         });
 
         LOG_INFO_FMT("Enclave stopped successfully. Stopping host...");
+        logger::flush_deferred();
+        tracing::flush();
         RINGBUFFER_WRITE_MESSAGE(AdminMessage::stopped, to_host);
 
         return true;
@@ -25,7 +25,8 @@ namespace enclave
       ccf::NodeId to,
       std::set<ccf::NodeId> nodes,
       ccf::CallerId caller_id,
-      const std::vector<uint8_t>& caller_cert) = 0;
+      const std::vector<uint8_t>& caller_cert,
+      const std::optional<crypto::Sha256Hash>& caller_cert_digest) = 0;
 
     virtual void send_request_hash_to_nodes(
       std::shared_ptr<enclave::RpcContext> rpc_ctx,
@@ -54,7 +54,8 @@ struct CCFConfig
   {
     size_t sig_tx_interval;
     size_t sig_ms_interval;
-    MSGPACK_DEFINE(sig_tx_interval, sig_ms_interval);
+    size_t sig_latency_target_ms;
+    MSGPACK_DEFINE(sig_tx_interval, sig_ms_interval, sig_latency_target_ms);
   };
   SignatureIntervals signature_intervals = {};
 
@@ -82,6 +83,19 @@ struct CCFConfig
 
   size_t jwt_key_refresh_interval_s;
 
+  // Committed KV values of at least kv_spill_threshold bytes are sealed and
+  // moved to host memory, if the threshold is not 0
+  size_t kv_spill_threshold;
+  size_t kv_spill_cache_size;
+
+  // Serialised transactions and snapshots record the size of each map. Only
+  // nodes from this version onwards can read them.
+  bool kv_record_map_sizes;
+
+  // Maximum number of deferred log messages written per second by each call
+  // site, below the fail level. 0 disables rate limiting
+  uint32_t log_site_rate_limit;
+
   MSGPACK_DEFINE(
     consensus_config,
     node_info_network,
@@ -93,7 +107,11 @@ struct CCFConfig
     joining,
     subject_name,
     subject_alternative_names,
-    jwt_key_refresh_interval_s);
+    jwt_key_refresh_interval_s,
+    kv_spill_threshold,
+    kv_spill_cache_size,
+    kv_record_map_sizes,
+    log_site_rate_limit);
 };
 
 /// General administrative messages
@@ -115,7 +133,19 @@ enum AdminMessage : ringbuffer::Message
   DEFINE_RINGBUFFER_MSG_TYPE(tick),
 
   /// Notify the host of work done since last message. Enclave -> Host
-  DEFINE_RINGBUFFER_MSG_TYPE(work_stats)
+  DEFINE_RINGBUFFER_MSG_TYPE(work_stats),
+
+  /// Call site of deferred log messages. Enclave -> Host
+  DEFINE_RINGBUFFER_MSG_TYPE(log_site),
+
+  /// Batch of binary records of deferred log messages. Enclave -> Host
+  DEFINE_RINGBUFFER_MSG_TYPE(log_records),
+
+  /// Batch of spans of traced requests. Enclave -> Host
+  DEFINE_RINGBUFFER_MSG_TYPE(trace_spans),
+
+  /// Sample rate of traced requests, 0 if tracing is disabled. Enclave -> Host
+  DEFINE_RINGBUFFER_MSG_TYPE(trace_config)
 };
 
 DECLARE_RINGBUFFER_MESSAGE_PAYLOAD(
@@ -131,3 +161,15 @@ DECLARE_RINGBUFFER_MESSAGE_NO_PAYLOAD(AdminMessage::stop);
 DECLARE_RINGBUFFER_MESSAGE_NO_PAYLOAD(AdminMessage::stopped);
 DECLARE_RINGBUFFER_MESSAGE_PAYLOAD(AdminMessage::tick, size_t);
 DECLARE_RINGBUFFER_MESSAGE_PAYLOAD(AdminMessage::work_stats, std::string);
+DECLARE_RINGBUFFER_MESSAGE_PAYLOAD(
+  AdminMessage::log_site,
+  uint32_t,
+  std::string,
+  size_t,
+  logger::Level,
+  std::string);
+DECLARE_RINGBUFFER_MESSAGE_PAYLOAD(
+  AdminMessage::log_records, uint16_t, std::vector<uint8_t>);
+DECLARE_RINGBUFFER_MESSAGE_PAYLOAD(
+  AdminMessage::trace_spans, std::vector<uint8_t>);
+DECLARE_RINGBUFFER_MESSAGE_PAYLOAD(AdminMessage::trace_config, uint32_t);
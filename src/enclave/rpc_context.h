@@ -2,12 +2,15 @@
 // Licensed under the Apache 2.0 License.
 #pragma once
 
+#include "crypto/hash.h"
 #include "http/http_builder.h"
 #include "http/http_consts.h"
 #include "http/ws_consts.h"
 #include "node/client_signatures.h"
 #include "node/entities.h"
 
+#include <deque>
+#include <functional>
 #include <llhttp/llhttp.h>
 #include <variant>
 #include <vector>
@@ -116,8 +119,19 @@ namespace enclave
     size_t client_session_id = InvalidSessionId;
     // Usually a DER certificate, may be a PEM on forwardee
     std::vector<uint8_t> caller_cert = {};
+    // Set instead of caller_cert on forwardee when the forwarder found the
+    // certificate in the caller certificates table
+    std::optional<crypto::Sha256Hash> caller_cert_digest = std::nullopt;
     bool is_forwarding = false;
 
+    // Set while a request of this session is answered asynchronously by this
+    // node, such as a queued re-execution or a read held until a seqno has
+    // been applied. Requests received meanwhile are held, and processed once
+    // it has been answered, so that responses are sent in the order of the
+    // requests. Both are only accessed from the session's thread.
+    bool awaiting_response = false;
+    std::deque<std::function<void()>> held_requests = {};
+
     //
     // Only set in the case of a forwarded RPC
     //
@@ -14,6 +14,17 @@ namespace kv
   class Tx;
 }
 
+namespace ccf
+{
+  class CommitNotifier;
+  class PendingReads;
+}
+
+namespace ccf::historical
+{
+  class AbstractStateCache;
+}
+
 namespace enclave
 {
   class RpcHandler
@@ -26,6 +37,15 @@ namespace enclave
       size_t sig_tx_interval, size_t sig_ms_interval) = 0;
     virtual void set_cmd_forwarder(
       std::shared_ptr<AbstractForwarder> cmd_forwarder_) = 0;
+    virtual void set_commit_notifier(
+      std::shared_ptr<ccf::CommitNotifier> commit_notifier_) = 0;
+    virtual void set_pending_reads(
+      std::shared_ptr<ccf::PendingReads> pending_reads_) = 0;
+    virtual void set_historical_state(
+      ccf::historical::AbstractStateCache* historical_state_) = 0;
+    // Sends responses which are produced after process() returns
+    virtual void set_responder(
+      std::shared_ptr<AbstractRPCResponder> responder_) = 0;
     virtual void tick(std::chrono::milliseconds) {}
     virtual void open() = 0;
     virtual bool is_open() = 0;
@@ -12,6 +12,7 @@
 #include "tls/context.h"
 #include "tls/server.h"
 
+#include <functional>
 #include <limits>
 #include <unordered_map>
 
@@ -33,6 +34,10 @@ namespace enclave
     SpinLock lock;
     std::unordered_map<size_t, std::shared_ptr<Endpoint>> sessions;
 
+    // Called when a session is closed, to release state held for that session
+    // outside of its endpoint
+    std::function<void(size_t)> close_callback = nullptr;
+
     // Upper half of sessions range is reserved for those originating from
     // the enclave via create_client().
     std::atomic<size_t> next_client_session_id =
@@ -92,26 +97,47 @@ namespace enclave
 
     bool reply_async(size_t id, std::vector<uint8_t>&& data) override
     {
-      std::lock_guard<SpinLock> guard(lock);
-
-      auto search = sessions.find(id);
-      if (search == sessions.end())
+      std::shared_ptr<Endpoint> session = nullptr;
       {
-        LOG_FAIL_FMT("Replying to unknown session {}", id);
-        return false;
+        std::lock_guard<SpinLock> guard(lock);
+
+        auto search = sessions.find(id);
+        if (search == sessions.end())
+        {
+          LOG_FAIL_FMT("Replying to unknown session {}", id);
+          return false;
+        }
+        session = search->second;
       }
 
       LOG_DEBUG_FMT("Replying to session {}", id);
 
-      search->second->send(std::move(data));
+      // The session may write the response immediately, so this is done
+      // without holding the sessions lock
+      session->send(std::move(data));
       return true;
     }
 
-    void remove_session(size_t id)
+    void set_close_callback(std::function<void(size_t)> cb)
     {
       std::lock_guard<SpinLock> guard(lock);
-      LOG_DEBUG_FMT("Closing a session inside the enclave: {}", id);
-      sessions.erase(id);
+      close_callback = cb;
+    }
+
+    void remove_session(size_t id)
+    {
+      std::function<void(size_t)> cb = nullptr;
+      {
+        std::lock_guard<SpinLock> guard(lock);
+        LOG_DEBUG_FMT("Closing a session inside the enclave: {}", id);
+        sessions.erase(id);
+        cb = close_callback;
+      }
+
+      if (cb != nullptr)
+      {
+        cb(id);
+      }
     }
 
     std::shared_ptr<ClientEndpoint> create_client(
@@ -28,6 +28,9 @@ namespace asynchost
     ringbuffer::Reader& r;
     ringbuffer::NonBlockingWriterFactory& nbwf;
 
+    // Formats the deferred log messages of the enclave
+    logger::DeferredLogReader log_reader;
+
   public:
     HandleRingbufferImpl(
       messaging::BufferProcessor& bp,
@@ -47,6 +50,23 @@ namespace asynchost
             file_name, line_number, log_level, thread_id, msg, elapsed.count());
         });
 
+      DISPATCHER_SET_MESSAGE_HANDLER(
+        bp, AdminMessage::log_site, [this](const uint8_t* data, size_t size) {
+          auto [id, file_name, line_number, log_level, format] =
+            ringbuffer::read_message<AdminMessage::log_site>(data, size);
+
+          log_reader.register_site(
+            id, file_name, line_number, log_level, format);
+        });
+
+      DISPATCHER_SET_MESSAGE_HANDLER(
+        bp,
+        AdminMessage::log_records,
+        [this](const uint8_t* data, size_t size) {
+          auto thread_id = serialized::read<uint16_t>(data, size);
+          log_reader.read_records(thread_id, data, size);
+        });
+
       DISPATCHER_SET_MESSAGE_HANDLER(
         bp,
         AdminMessage::fatal_error_msg,
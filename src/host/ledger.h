@@ -5,6 +5,7 @@
 #include "consensus/ledger_enclave_types.h"
 #include "ds/logger.h"
 #include "ds/messaging.h"
+#include "ds/tracing.h"
 
 #include <cstdint>
 #include <cstdio>
@@ -16,7 +17,9 @@
 #include <string>
 #include <sys/types.h>
 #include <unistd.h>
+#include <uv.h>
 #include <vector>
+#include <zlib.h>
 
 namespace fs = std::filesystem;
 
@@ -25,17 +28,48 @@ namespace asynchost
   static constexpr size_t ledger_max_read_cache_files_default = 5;
 
   static constexpr auto ledger_committed_suffix = "committed";
+  static constexpr auto ledger_compressed_suffix = "committed.compressed";
+  static constexpr auto ledger_partial_suffix = "partial";
   static constexpr auto ledger_start_idx_delimiter = "_";
   static constexpr auto ledger_last_idx_delimiter = "-";
 
-  static inline bool is_ledger_file_committed(const std::string& file_name)
+  // Committed ledger files may be compressed, in blocks of this many bytes of
+  // their uncompressed contents
+  static constexpr size_t ledger_compression_block_size = 64 * 1024;
+
+  static inline std::string get_suffix_from_file_name(
+    const std::string& file_name)
   {
     auto pos = file_name.find(".");
     if (pos == std::string::npos)
     {
-      return false;
+      return "";
     }
-    return file_name.substr(pos + 1) == ledger_committed_suffix;
+    return file_name.substr(pos + 1);
+  }
+
+  static inline bool is_ledger_file_committed(const std::string& file_name)
+  {
+    const auto suffix = get_suffix_from_file_name(file_name);
+    return suffix == ledger_committed_suffix ||
+      suffix == ledger_compressed_suffix;
+  }
+
+  static inline bool is_ledger_file_compressed(const std::string& file_name)
+  {
+    return get_suffix_from_file_name(file_name) == ledger_compressed_suffix;
+  }
+
+  // Compressed files are written to a partial file first, which is renamed
+  // once complete. Partial files left behind are ignored.
+  static inline bool is_ledger_file_partial(const std::string& file_name)
+  {
+    const auto suffix = get_suffix_from_file_name(file_name);
+    return suffix.size() >= strlen(ledger_partial_suffix) &&
+      suffix.compare(
+        suffix.size() - strlen(ledger_partial_suffix),
+        std::string::npos,
+        ledger_partial_suffix) == 0;
   }
 
   static inline size_t get_start_idx_from_file_name(
@@ -73,6 +107,11 @@ namespace asynchost
       // If any file, based on its name, contains idx. Only committed files
       // (i.e. those with a last idx) are considered here.
       auto f_name = f.path().filename();
+      if (is_ledger_file_partial(f_name))
+      {
+        continue;
+      }
+
       auto start_idx = get_start_idx_from_file_name(f_name);
       auto last_idx = get_last_idx_from_file_name(f_name);
       if (idx >= start_idx && last_idx.has_value() && idx <= last_idx.value())
@@ -105,6 +144,131 @@ namespace asynchost
     bool completed = false;
     bool committed = false;
 
+    // Compressed files hold the contents of a committed file, between the
+    // positions offset header and the positions table, as a sequence of
+    // independently compressed blocks. The offset header points to an index of
+    // these blocks, followed by the positions table of the uncompressed file.
+    struct CompressedIndexHeader
+    {
+      uint64_t uncompressed_size;
+      uint32_t block_size;
+      uint32_t block_count;
+    };
+
+    bool compressed = false;
+    size_t block_size = 0;
+    // Offset of each block in the file, followed by the offset of the index
+    std::vector<uint64_t> block_offsets;
+
+    // Last block read from a compressed file, as entries are usually read in
+    // order
+    mutable std::optional<size_t> cached_block = std::nullopt;
+    mutable std::vector<uint8_t> cached_block_data;
+
+    void read_compressed_index(size_t index_offset, size_t total_file_size)
+    {
+      fseeko(file, index_offset, SEEK_SET);
+      CompressedIndexHeader header;
+      if (fread(&header, sizeof(header), 1, file) != 1)
+      {
+        throw std::logic_error("Failed to read compressed ledger file index");
+      }
+
+      block_size = header.block_size;
+      block_offsets.resize(header.block_count + 1);
+      if (
+        fread(
+          block_offsets.data(),
+          sizeof(block_offsets.at(0)),
+          block_offsets.size(),
+          file) != block_offsets.size())
+      {
+        throw std::logic_error("Failed to read compressed ledger file index");
+      }
+
+      const size_t table_offset = ftello(file);
+      positions.resize(
+        (total_file_size - table_offset) / sizeof(positions.at(0)));
+      if (
+        fread(
+          positions.data(), sizeof(positions.at(0)), positions.size(), file) !=
+        positions.size())
+      {
+        throw std::logic_error(
+          "Failed to read positions table from compressed ledger file");
+      }
+
+      total_len = header.uncompressed_size;
+      compressed = true;
+      completed = true;
+    }
+
+    const std::vector<uint8_t>& read_block(size_t block) const
+    {
+      if (cached_block == block)
+      {
+        return cached_block_data;
+      }
+
+      const auto compressed_size =
+        block_offsets.at(block + 1) - block_offsets.at(block);
+      std::vector<uint8_t> compressed_data(compressed_size);
+      fseeko(file, block_offsets.at(block), SEEK_SET);
+      if (fread(compressed_data.data(), compressed_size, 1, file) != 1)
+      {
+        throw std::logic_error(
+          fmt::format("Failed to read compressed ledger block {}", block));
+      }
+
+      const auto block_start =
+        sizeof(positions_offset_header_t) + block * block_size;
+      uLongf size = std::min(block_size, total_len - block_start);
+      cached_block = std::nullopt;
+      cached_block_data.resize(size);
+      if (
+        uncompress(
+          cached_block_data.data(),
+          &size,
+          compressed_data.data(),
+          compressed_size) != Z_OK ||
+        size != cached_block_data.size())
+      {
+        throw std::logic_error(
+          fmt::format("Failed to decompress ledger block {}", block));
+      }
+
+      cached_block = block;
+      return cached_block_data;
+    }
+
+    // Read size bytes at offset pos of the uncompressed file
+    void read_contents(size_t pos, uint8_t* data, size_t size) const
+    {
+      if (!compressed)
+      {
+        fseeko(file, pos, SEEK_SET);
+        if (fread(data, size, 1, file) != 1)
+        {
+          throw std::logic_error(fmt::format(
+            "Failed to read {} bytes at {} from ledger file", size, pos));
+        }
+        return;
+      }
+
+      const auto contents_start = sizeof(positions_offset_header_t);
+      while (size > 0)
+      {
+        const auto block = (pos - contents_start) / block_size;
+        const auto offset = (pos - contents_start) % block_size;
+        const auto& block_data = read_block(block);
+        const auto n = std::min(size, block_data.size() - offset);
+        std::memcpy(data, block_data.data() + offset, n);
+        data += n;
+        pos += n;
+        size -= n;
+      }
+    }
+
   public:
     LedgerFile(const std::string& dir, size_t start_idx) :
       dir(dir),
@@ -125,13 +289,17 @@ namespace asynchost
       total_len = sizeof(positions_offset_header_t);
     }
 
-    // Used when recovering an existing ledger file
-    LedgerFile(const std::string& dir, const std::string& file_name) :
+    // Used when recovering an existing ledger file, or reading one from a
+    // read-only ledger directory
+    LedgerFile(
+      const std::string& dir,
+      const std::string& file_name,
+      bool read_only = false) :
       dir(dir),
       file(nullptr)
     {
       auto full_path = (fs::path(dir) / fs::path(file_name));
-      file = fopen(full_path.c_str(), "r+b");
+      file = fopen(full_path.c_str(), read_only ? "rb" : "r+b");
       if (!file)
       {
         throw std::logic_error(fmt::format(
@@ -154,7 +322,11 @@ namespace asynchost
           "Failed to read positions offset from ledger file {}", full_path));
       }
 
-      if (table_offset != 0)
+      if (is_ledger_file_compressed(file_name))
+      {
+        read_compressed_index(table_offset, total_file_size);
+      }
+      else if (table_offset != 0)
       {
         // If the chunk was completed, read positions table from file directly
         total_len = table_offset;
@@ -258,6 +430,142 @@ namespace asynchost
       return completed;
     }
 
+    bool is_compressed() const
+    {
+      return compressed;
+    }
+
+    /** Write a compressed copy of a committed ledger file. The committed file
+     * is never modified, so this may run on any thread.
+     *
+     * @param from Path of committed ledger file
+     * @param to Path of compressed ledger file
+     * @param level zlib compression level
+     * @param block_size Size of uncompressed blocks
+     *
+     * @return Size of compressed ledger file
+     */
+    static size_t compress(
+      const fs::path& from,
+      const fs::path& to,
+      int level = Z_DEFAULT_COMPRESSION,
+      size_t block_size = ledger_compression_block_size)
+    {
+      using FilePtr = std::unique_ptr<FILE, decltype(&fclose)>;
+
+      FilePtr in(fopen(from.c_str(), "rb"), &fclose);
+      if (!in)
+      {
+        throw std::logic_error(fmt::format(
+          "Unable to open ledger file {}: {}", from, strerror(errno)));
+      }
+
+      fseeko(in.get(), 0, SEEK_END);
+      const size_t total_file_size = ftello(in.get());
+      fseeko(in.get(), 0, SEEK_SET);
+
+      positions_offset_header_t table_offset = 0;
+      if (
+        fread(&table_offset, sizeof(table_offset), 1, in.get()) != 1 ||
+        table_offset == 0 || table_offset > total_file_size)
+      {
+        throw std::logic_error(
+          fmt::format("Cannot compress incomplete ledger file {}", from));
+      }
+
+      FilePtr out(fopen(to.c_str(), "wb"), &fclose);
+      if (!out)
+      {
+        throw std::logic_error(fmt::format(
+          "Unable to open ledger file {}: {}", to, strerror(errno)));
+      }
+
+      // Header reserved for the offset to the block index
+      size_t index_offset = 0;
+      if (fwrite(&index_offset, sizeof(index_offset), 1, out.get()) != 1)
+      {
+        throw std::logic_error("Failed to write compressed ledger file");
+      }
+
+      std::vector<uint64_t> block_offsets;
+      std::vector<uint8_t> block(block_size);
+      std::vector<uint8_t> compressed_block(compressBound(block_size));
+      for (size_t pos = sizeof(table_offset); pos < table_offset;)
+      {
+        const auto size = std::min(block_size, table_offset - pos);
+        if (fread(block.data(), size, 1, in.get()) != 1)
+        {
+          throw std::logic_error(
+            fmt::format("Failed to read ledger file {}", from));
+        }
+
+        uLongf compressed_size = compressed_block.size();
+        if (
+          compress2(
+            compressed_block.data(),
+            &compressed_size,
+            block.data(),
+            size,
+            level) != Z_OK)
+        {
+          throw std::logic_error(
+            fmt::format("Failed to compress ledger file {}", from));
+        }
+
+        block_offsets.push_back(ftello(out.get()));
+        if (
+          fwrite(compressed_block.data(), compressed_size, 1, out.get()) != 1)
+        {
+          throw std::logic_error("Failed to write compressed ledger file");
+        }
+        pos += size;
+      }
+
+      index_offset = ftello(out.get());
+      block_offsets.push_back(index_offset);
+
+      CompressedIndexHeader header{table_offset,
+                                   static_cast<uint32_t>(block_size),
+                                   static_cast<uint32_t>(
+                                     block_offsets.size() - 1)};
+      std::vector<uint8_t> positions_table(total_file_size - table_offset);
+      if (
+        !positions_table.empty() &&
+        fread(positions_table.data(), positions_table.size(), 1, in.get()) !=
+          1)
+      {
+        throw std::logic_error(
+          fmt::format("Failed to read positions table from {}", from));
+      }
+
+      if (
+        fwrite(&header, sizeof(header), 1, out.get()) != 1 ||
+        fwrite(
+          block_offsets.data(),
+          sizeof(block_offsets.at(0)),
+          block_offsets.size(),
+          out.get()) != block_offsets.size() ||
+        (!positions_table.empty() &&
+         fwrite(
+           positions_table.data(), positions_table.size(), 1, out.get()) !=
+           1))
+      {
+        throw std::logic_error("Failed to write compressed ledger file index");
+      }
+
+      const size_t compressed_file_size = ftello(out.get());
+
+      fseeko(out.get(), 0, SEEK_SET);
+      if (
+        fwrite(&index_offset, sizeof(index_offset), 1, out.get()) != 1 ||
+        fflush(out.get()) != 0)
+      {
+        throw std::logic_error("Failed to write compressed ledger file");
+      }
+
+      return compressed_file_size;
+    }
+
     size_t write_entry(const uint8_t* data, size_t size, bool committable)
     {
       fseeko(file, total_len, SEEK_SET);
@@ -320,15 +628,23 @@ namespace asynchost
 
       auto len = entry_size(idx);
       std::vector<uint8_t> entry(len);
-      fseeko(file, positions.at(idx - start_idx) + frame_header_size, SEEK_SET);
+      read_contents(
+        positions.at(idx - start_idx) + frame_header_size, entry.data(), len);
 
-      if (fread(entry.data(), len, 1, file) != 1)
+      return entry;
+    }
+
+    // Reads an entry directly into a ringbuffer reservation, which must have
+    // exactly entry_size(idx) bytes remaining
+    void read_entry(size_t idx, ringbuffer::MessageReservation& r) const
+    {
+      auto pos = positions.at(idx - start_idx) + frame_header_size;
+      while (r.remaining() > 0)
       {
-        throw std::logic_error(
-          fmt::format("Failed to read entry {} from file", idx));
+        const auto region = r.next();
+        read_contents(pos, region.data, region.size);
+        pos += region.size;
       }
-
-      return entry;
     }
 
     std::optional<std::vector<uint8_t>> read_framed_entries(
@@ -342,13 +658,8 @@ namespace asynchost
 
       auto framed_size = framed_entries_size(from, to);
       std::vector<uint8_t> framed_entries(framed_size);
-      fseeko(file, positions.at(from - start_idx), SEEK_SET);
-
-      if (fread(framed_entries.data(), framed_size, 1, file) != 1)
-      {
-        throw std::logic_error(fmt::format(
-          "Failed to read entry range {} - {} from file", from, to));
-      }
+      read_contents(
+        positions.at(from - start_idx), framed_entries.data(), framed_size);
 
       return framed_entries;
     }
@@ -498,6 +809,112 @@ namespace asynchost
     // True if a new file should be created when writing an entry
     bool require_new_file;
 
+    // If set, committed files are compressed in the background with this zlib
+    // compression level
+    std::optional<int> compression_level = std::nullopt;
+    size_t compressions_in_progress = 0;
+
+    struct CompressionJob
+    {
+      uv_work_t req;
+      Ledger* ledger;
+      std::string file_name;
+      int level;
+      std::optional<std::string> error = std::nullopt;
+    };
+
+    static std::string get_compressed_file_name(const std::string& file_name)
+    {
+      return fmt::format(
+        "{}.{}",
+        file_name.substr(0, file_name.find(".")),
+        ledger_compressed_suffix);
+    }
+
+    static void on_compress(uv_work_t* req)
+    {
+      auto job = static_cast<CompressionJob*>(req->data);
+      const auto compressed_file_name =
+        get_compressed_file_name(job->file_name);
+      const auto& dir = job->ledger->ledger_dir;
+      try
+      {
+        LedgerFile::compress(
+          fs::path(dir) / fs::path(job->file_name),
+          fs::path(dir) /
+            fs::path(fmt::format(
+              "{}.{}", compressed_file_name, ledger_partial_suffix)),
+          job->level);
+      }
+      catch (const std::exception& e)
+      {
+        job->error = e.what();
+      }
+    }
+
+    static void on_compressed(uv_work_t* req, int status)
+    {
+      std::unique_ptr<CompressionJob> job(
+        static_cast<CompressionJob*>(req->data));
+      if (status != 0)
+      {
+        job->error = uv_strerror(status);
+      }
+      job->ledger->complete_compression(job->file_name, job->error);
+    }
+
+    void compress_in_background(const std::string& file_name)
+    {
+      auto job = std::make_unique<CompressionJob>();
+      job->req.data = job.get();
+      job->ledger = this;
+      job->file_name = file_name;
+      job->level = compression_level.value();
+
+      const auto rc = uv_queue_work(
+        uv_default_loop(), &job->req, &on_compress, &on_compressed);
+      if (rc < 0)
+      {
+        LOG_FAIL_FMT(
+          "Unable to compress ledger file {}: {}", file_name, uv_strerror(rc));
+        return;
+      }
+
+      job.release();
+      compressions_in_progress++;
+    }
+
+    void complete_compression(
+      const std::string& file_name, const std::optional<std::string>& error)
+    {
+      compressions_in_progress--;
+
+      const auto compressed_file_name = get_compressed_file_name(file_name);
+      const auto partial_path = fs::path(ledger_dir) /
+        fs::path(fmt::format(
+          "{}.{}", compressed_file_name, ledger_partial_suffix));
+
+      if (error.has_value())
+      {
+        LOG_FAIL_FMT(
+          "Failed to compress ledger file {}: {}", file_name, error.value());
+        fs::remove(partial_path);
+        return;
+      }
+
+      fs::rename(partial_path, fs::path(ledger_dir) / compressed_file_name);
+      fs::remove(fs::path(ledger_dir) / fs::path(file_name));
+
+      // Cached files keep reading the uncompressed file until evicted, so
+      // evict them now to release it
+      const auto start_idx = get_start_idx_from_file_name(file_name);
+      files_read_cache.remove_if([start_idx](const auto& f) {
+        return !f->is_compressed() && f->get_start_idx() == start_idx;
+      });
+
+      LOG_DEBUG_FMT("Compressed ledger file {}", file_name);
+    }
+
     auto get_it_contains_idx(size_t idx) const
     {
       if (idx == 0)
@@ -535,6 +952,7 @@ namespace asynchost
       // If the file is not in the cache, find the file from the ledger
       // directories, inspecting the main ledger directory first
       std::string ledger_dir_;
+      bool read_only = false;
       auto match = get_file_name_with_idx(ledger_dir, idx);
       if (match.has_value())
       {
@@ -548,6 +966,7 @@ namespace asynchost
           if (match.has_value())
           {
             ledger_dir_ = dir;
+            read_only = true;
             break;
           }
         }
@@ -561,7 +980,7 @@ namespace asynchost
       // Emplace file in the max-sized read cache, replacing the oldest entry if
       // the read cache is full
       auto match_file =
-        std::make_shared<LedgerFile>(ledger_dir_, match.value());
+        std::make_shared<LedgerFile>(ledger_dir_, match.value(), read_only);
       if (files_read_cache.size() >= max_read_cache_files)
       {
         files_read_cache.erase(files_read_cache.begin());
@@ -596,6 +1015,30 @@ namespace asynchost
       return get_file_from_cache(idx);
     }
 
+    // Entries are read from the ledger file straight into the ringbuffer, with
+    // the same layout as a consensus::ledger_entry message, rather than into
+    // an intermediate buffer. If the read throws, the reservation is abandoned
+    // as it unwinds, so nothing is sent to the enclave and the exception is
+    // propagated to the caller.
+    bool write_entry_to_enclave(
+      consensus::Index idx, consensus::LedgerRequestPurpose purpose)
+    {
+      auto f = get_file_from_idx(idx);
+      if (f == nullptr || idx > f->get_last_idx())
+      {
+        return false;
+      }
+
+      const auto size = f->entry_size(idx);
+      auto reservation = to_enclave->reserve_message(
+        consensus::ledger_entry, sizeof(idx) + sizeof(purpose) + size);
+      reservation->write(idx);
+      reservation->write(purpose);
+      f->read_entry(idx, reservation.value());
+      reservation->commit();
+      return true;
+    }
+
     std::shared_ptr<LedgerFile> get_latest_file() const
     {
       if (files.empty())
@@ -630,6 +1073,13 @@ namespace asynchost
         // If the ledger directory exists, recover ledger files from it
         for (auto const& f : fs::directory_iterator(ledger_dir))
         {
+          if (is_ledger_file_partial(f.path().filename()))
+          {
+            // Compression was interrupted, but the committed file remains
+            fs::remove(f.path());
+            continue;
+          }
+
           files.push_back(
             std::make_shared<LedgerFile>(ledger_dir, f.path().filename()));
         }
@@ -690,6 +1140,54 @@ namespace asynchost
 
     Ledger(const Ledger& that) = delete;
 
+    /** Compress committed files in the background, on the libuv thread pool.
+     * Compressed files are decompressed transparently when read. Committed
+     * files which have not yet been compressed are compressed straight away.
+     *
+     * @param level zlib compression level
+     */
+    void enable_compression(int level = Z_DEFAULT_COMPRESSION)
+    {
+      compression_level = level;
+
+      std::vector<std::string> uncompressed;
+      std::vector<fs::path> already_compressed;
+      for (auto const& f : fs::directory_iterator(ledger_dir))
+      {
+        const std::string file_name = f.path().filename();
+        if (get_suffix_from_file_name(file_name) != ledger_committed_suffix)
+        {
+          continue;
+        }
+
+        if (fs::exists(
+              fs::path(ledger_dir) / get_compressed_file_name(file_name)))
+        {
+          // Compressed before the node stopped, but not yet removed
+          already_compressed.push_back(f.path());
+        }
+        else
+        {
+          uncompressed.push_back(file_name);
+        }
+      }
+
+      for (const auto& path : already_compressed)
+      {
+        fs::remove(path);
+      }
+
+      for (const auto& file_name : uncompressed)
+      {
+        compress_in_background(file_name);
+      }
+    }
+
+    size_t get_compressions_in_progress() const
+    {
+      return compressions_in_progress;
+    }
+
     void init_idx(size_t idx)
     {
       last_idx = idx;
@@ -828,6 +1326,11 @@ namespace asynchost
           (*it)->commit(commit_idx) &&
           (it != f_to || (idx == (*it)->get_last_idx())))
         {
+          if (compression_level.has_value())
+          {
+            compress_in_background((*it)->get_file_name());
+          }
+
           auto it_ = it;
           it++;
           files.erase(it_);
@@ -856,7 +1359,23 @@ namespace asynchost
         [this](const uint8_t* data, size_t size) {
           auto committable = serialized::read<bool>(data, size);
           auto force_chunk = serialized::read<bool>(data, size);
-          write_entry(data, size, committable, force_chunk);
+
+          if (tracing::config::enabled())
+          {
+            const auto start = tracing::config::now_us();
+            const auto idx = write_entry(data, size, committable, force_chunk);
+            tracing::record({0,
+                             idx,
+                             0,
+                             start,
+                             tracing::config::now_us(),
+                             tracing::thread_id(),
+                             tracing::SpanKind::LedgerWrite});
+          }
+          else
+          {
+            write_entry(data, size, committable, force_chunk);
+          }
         });
 
       DISPATCHER_SET_MESSAGE_HANDLER(
@@ -880,14 +1399,7 @@ namespace asynchost
           auto [idx, purpose] =
             ringbuffer::read_message<consensus::ledger_get>(data, size);
 
-          auto entry = read_entry(idx);
-
-          if (entry.has_value())
-          {
-            RINGBUFFER_WRITE_MESSAGE(
-              consensus::ledger_entry, to_enclave, idx, purpose, entry.value());
-          }
-          else
+          if (!write_entry_to_enclave(idx, purpose))
           {
             RINGBUFFER_WRITE_MESSAGE(
               consensus::ledger_no_entry, to_enclave, idx, purpose);
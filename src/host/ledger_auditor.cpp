@@ -0,0 +1,92 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#include "ledger_auditor.h"
+
+#include "ds/logger.h"
+
+#include <CLI11/CLI11.hpp>
+#include <iostream>
+#include <string>
+#include <thread>
+
+extern "C"
+{
+#include <evercrypt/EverCrypt_AutoConfig2.h>
+}
+
+::timespec logger::config::start{0, 0};
+
+int main(int argc, char** argv)
+{
+  CLI::App app{"Audit the committed chunks of a CCF ledger"};
+
+  std::string ledger_dir("ledger");
+  app.add_option("--ledger-dir", ledger_dir, "Ledger directory")
+    ->capture_default_str();
+
+  std::vector<std::string> read_only_ledger_dirs;
+  app
+    .add_option(
+      "--read-only-ledger-dir",
+      read_only_ledger_dirs,
+      "Additional read-only ledger directory (optional)")
+    ->type_size(-1);
+
+  size_t threads = std::thread::hardware_concurrency();
+  app
+    .add_option(
+      "--threads",
+      threads,
+      "Number of threads on which to read chunks and verify signatures")
+    ->capture_default_str();
+
+  size_t max_errors = 10;
+  app.add_option("--max-errors", max_errors, "Number of errors to report")
+    ->capture_default_str();
+
+  CLI11_PARSE(app, argc, argv);
+
+  ::EverCrypt_AutoConfig2_init();
+  logger::config::level() = logger::FAIL;
+
+  std::vector<std::string> ledger_dirs = {ledger_dir};
+  ledger_dirs.insert(
+    ledger_dirs.end(),
+    read_only_ledger_dirs.begin(),
+    read_only_ledger_dirs.end());
+
+  asynchost::LedgerAuditor auditor(ledger_dirs, threads);
+  const auto report = auditor.audit();
+
+  const auto seconds = report.elapsed.count();
+  std::cout << fmt::format(
+                 "Audited {} entries ({} signatures) in {} chunks, {:.1f} MB, "
+                 "in {:.2f}s: {:.0f} tx/s, {:.1f} MB/s",
+                 report.entries,
+                 report.signatures,
+                 report.chunks,
+                 report.bytes / 1e6,
+                 seconds,
+                 report.entries / seconds,
+                 report.bytes / 1e6 / seconds)
+            << std::endl;
+
+  if (!report.ok())
+  {
+    for (size_t i = 0; i < std::min(max_errors, report.errors.size()); ++i)
+    {
+      std::cout << "Error: " << report.errors[i] << std::endl;
+    }
+    if (report.errors.size() > max_errors)
+    {
+      std::cout << fmt::format(
+                     "... and {} more errors",
+                     report.errors.size() - max_errors)
+                << std::endl;
+    }
+    return 1;
+  }
+
+  std::cout << "Ledger is valid" << std::endl;
+  return 0;
+}
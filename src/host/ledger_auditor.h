@@ -0,0 +1,422 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include "crypto/hash.h"
+#include "crypto/symmetric_key.h"
+#include "ds/logger.h"
+#include "ds/serialized.h"
+#include "host/ledger.h"
+#include "kv/kv_serialiser.h"
+#include "node/entities.h"
+#include "node/history.h"
+#include "node/nodes.h"
+#include "node/signatures.h"
+#include "tls/verifier.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace asynchost
+{
+  // Ledger entries are read without the ledger secret. This only locates the
+  // public domain of each entry, and cannot decrypt the private domain.
+  class PublicDomainReader : public kv::AbstractTxEncryptor
+  {
+    size_t header_length;
+
+  public:
+    PublicDomainReader(
+      size_t header_length =
+        crypto::GcmHeader<crypto::GCM_SIZE_IV>::RAW_DATA_SIZE) :
+      header_length(header_length)
+    {}
+
+    void encrypt(
+      const std::vector<uint8_t>&,
+      const std::vector<uint8_t>&,
+      std::vector<uint8_t>&,
+      std::vector<uint8_t>&,
+      kv::Version,
+      bool = false) override
+    {
+      throw std::logic_error(
+        "Ledger entries cannot be written while auditing");
+    }
+
+    bool decrypt(
+      const std::vector<uint8_t>&,
+      const std::vector<uint8_t>&,
+      const std::vector<uint8_t>&,
+      std::vector<uint8_t>&,
+      kv::Version) override
+    {
+      return false;
+    }
+
+    void set_iv_id(size_t) override {}
+
+    size_t get_header_length() override
+    {
+      return header_length;
+    }
+
+    void update_encryption_key(
+      kv::Version, const std::vector<uint8_t>&) override
+    {}
+
+    void rollback(kv::Version) override {}
+    void compact(kv::Version) override {}
+  };
+
+  struct LedgerAuditReport
+  {
+    size_t chunks = 0;
+    size_t entries = 0;
+    size_t signatures = 0;
+    size_t bytes = 0;
+    std::chrono::duration<double> elapsed = {};
+
+    // Empty if the ledger was audited successfully
+    std::vector<std::string> errors;
+
+    bool ok() const
+    {
+      return errors.empty();
+    }
+  };
+
+  /** Audits the committed chunks of a ledger, without the ledger secret.
+   *
+   * The hash of every entry is recomputed, and the Merkle root at each
+   * signature transaction is checked against the signed root. Each signature
+   * is verified with the certificate of the signing node, which must have been
+   * recorded in the nodes table by an earlier transaction.
+   *
+   * Chunks are read and hashed, and signatures verified, on several threads.
+   * Only the Merkle tree is built on a single thread, in ledger order.
+   */
+  class LedgerAuditor
+  {
+    struct ChunkFile
+    {
+      std::string dir;
+      std::string file_name;
+    };
+
+    struct NodeCert
+    {
+      consensus::Index written_at;
+      tls::Pem cert;
+    };
+
+    struct ChunkResult
+    {
+      consensus::Index start_idx = 0;
+      size_t bytes = 0;
+      std::vector<crypto::Sha256Hash> leaves;
+      std::map<consensus::Index, ccf::PrimarySignature> signatures;
+      std::vector<std::tuple<consensus::Index, ccf::NodeId, tls::Pem>> nodes;
+      std::optional<std::string> error = std::nullopt;
+    };
+
+    struct PendingSignature
+    {
+      consensus::Index idx;
+      ccf::PrimarySignature sig;
+      crypto::Sha256Hash root;
+    };
+
+    std::vector<std::string> ledger_dirs;
+    size_t num_threads;
+    kv::EncryptorPtr encryptor;
+
+    template <typename F>
+    void for_each_parallel(size_t n, F&& f)
+    {
+      std::atomic<size_t> next = 0;
+      auto work = [&]() {
+        for (auto i = next++; i < n; i = next++)
+        {
+          f(i);
+        }
+      };
+
+      std::vector<std::thread> threads;
+      for (size_t t = 1; t < std::min(num_threads, n); ++t)
+      {
+        threads.emplace_back(work);
+      }
+      work();
+      for (auto& t : threads)
+      {
+        t.join();
+      }
+    }
+
+    std::vector<ChunkFile> find_committed_chunks() const
+    {
+      // Chunks in the main ledger directory take precedence over copies of
+      // the same chunks in read-only directories
+      std::map<size_t, ChunkFile> chunks;
+      for (const auto& dir : ledger_dirs)
+      {
+        for (auto const& f : fs::directory_iterator(dir))
+        {
+          const auto file_name = f.path().filename();
+          if (
+            is_ledger_file_partial(file_name) ||
+            !is_ledger_file_committed(file_name))
+          {
+            continue;
+          }
+
+          chunks.emplace(
+            get_start_idx_from_file_name(file_name),
+            ChunkFile{dir, file_name});
+        }
+      }
+
+      std::vector<ChunkFile> ordered;
+      for (auto& [_, chunk] : chunks)
+      {
+        ordered.push_back(std::move(chunk));
+      }
+      return ordered;
+    }
+
+    void read_public_domain(
+      consensus::Index idx,
+      const uint8_t* data,
+      size_t size,
+      ChunkResult& result) const
+    {
+      kv::KvStoreDeserialiser d(encryptor, kv::SecurityDomain::PUBLIC);
+      const auto version = d.init(data, size);
+      if (!version.has_value() || version.value() != idx)
+      {
+        throw std::logic_error(
+          fmt::format("Entry {} has an invalid header", idx));
+      }
+
+      for (auto map = d.start_map(); map.has_value(); map = d.start_map())
+      {
+        const auto& map_name = map.value();
+        if (
+          map_name != ccf::Tables::SIGNATURES && map_name != ccf::Tables::NODES)
+        {
+          d.skip_map();
+          continue;
+        }
+
+        d.deserialise_entry_version();
+        for (auto reads = d.deserialise_read_header(); reads > 0; --reads)
+        {
+          d.deserialise_read();
+        }
+
+        for (auto writes = d.deserialise_write_header(); writes > 0; --writes)
+        {
+          const auto [k, v] = d.deserialise_write();
+          if (map_name == ccf::Tables::SIGNATURES)
+          {
+            result.signatures.emplace(
+              idx, ccf::Signatures::ValueSerialiser::from_serialised(v));
+          }
+          else if (map_name == ccf::Tables::NODES)
+          {
+            result.nodes.emplace_back(
+              idx,
+              ccf::Nodes::KeySerialiser::from_serialised(k),
+              ccf::Nodes::ValueSerialiser::from_serialised(v).cert);
+          }
+        }
+
+        for (auto removes = d.deserialise_remove_header(); removes > 0;
+             --removes)
+        {
+          d.deserialise_remove();
+        }
+      }
+    }
+
+    ChunkResult read_chunk(const ChunkFile& chunk) const
+    {
+      ChunkResult result;
+      try
+      {
+        LedgerFile file(chunk.dir, chunk.file_name, true);
+        result.start_idx = file.get_start_idx();
+        const auto last_idx = file.get_last_idx();
+
+        const auto framed_entries =
+          file.read_framed_entries(result.start_idx, last_idx);
+        if (!framed_entries.has_value())
+        {
+          throw std::logic_error("Could not read entries");
+        }
+
+        const uint8_t* data = framed_entries->data();
+        size_t size = framed_entries->size();
+        result.bytes = size;
+        result.leaves.reserve(last_idx - result.start_idx + 1);
+
+        for (auto idx = result.start_idx; idx <= last_idx; ++idx)
+        {
+          const auto entry_size = serialized::read<uint32_t>(data, size);
+          if (entry_size > size)
+          {
+            throw std::logic_error(fmt::format("Entry {} is truncated", idx));
+          }
+
+          result.leaves.emplace_back(CBuffer{data, entry_size});
+          read_public_domain(idx, data, entry_size, result);
+          serialized::skip(data, size, entry_size);
+        }
+      }
+      catch (const std::exception& e)
+      {
+        result.error = fmt::format("{}: {}", chunk.file_name, e.what());
+      }
+      return result;
+    }
+
+  public:
+    /**
+     * @param ledger_dirs Ledger directories, searched in order. These are
+     * only read from.
+     * @param num_threads Number of threads on which to read chunks and
+     * verify signatures
+     * @param encryptor Used to locate the public domain of ledger entries
+     */
+    LedgerAuditor(
+      const std::vector<std::string>& ledger_dirs,
+      size_t num_threads = std::thread::hardware_concurrency(),
+      kv::EncryptorPtr encryptor = std::make_shared<PublicDomainReader>()) :
+      ledger_dirs(ledger_dirs),
+      num_threads(std::max<size_t>(num_threads, 1)),
+      encryptor(encryptor)
+    {}
+
+    LedgerAuditReport audit()
+    {
+      LedgerAuditReport report;
+      const auto start_time = std::chrono::steady_clock::now();
+
+      const auto chunks = find_committed_chunks();
+      if (chunks.empty())
+      {
+        report.errors.push_back("No committed ledger chunks found");
+      }
+
+      // Leaf 0 of the tree is a placeholder, as the ledger starts at 1
+      ccf::MerkleTreeHistory tree;
+      consensus::Index next_idx = 1;
+      std::map<ccf::NodeId, NodeCert> nodes;
+
+      // Chunks are read a batch at a time, to bound the number of leaves held
+      // before they are added to the tree
+      const size_t batch_size = num_threads * 2;
+      for (size_t begin = 0; begin < chunks.size() && report.ok();
+           begin += batch_size)
+      {
+        const auto end = std::min(begin + batch_size, chunks.size());
+
+        std::vector<ChunkResult> results(end - begin);
+        for_each_parallel(results.size(), [&](size_t i) {
+          results[i] = read_chunk(chunks[begin + i]);
+        });
+
+        std::vector<PendingSignature> pending;
+        for (auto& result : results)
+        {
+          if (result.error.has_value())
+          {
+            report.errors.push_back(result.error.value());
+            break;
+          }
+
+          if (result.start_idx != next_idx)
+          {
+            report.errors.push_back(fmt::format(
+              "Expected chunk starting at {}, but next chunk starts at {}",
+              next_idx,
+              result.start_idx));
+            break;
+          }
+
+          for (const auto& [idx, node_id, cert] : result.nodes)
+          {
+            nodes.emplace(node_id, NodeCert{idx, cert});
+          }
+
+          for (auto& leaf : result.leaves)
+          {
+            const auto sig_it = result.signatures.find(next_idx);
+            if (sig_it != result.signatures.end())
+            {
+              // Signatures sign the root of the tree before their own entry
+              const auto root = tree.get_root();
+              if (root != sig_it->second.root)
+              {
+                report.errors.push_back(fmt::format(
+                  "Signature at {} does not match the root of the ledger",
+                  next_idx));
+              }
+              pending.push_back({next_idx, std::move(sig_it->second), root});
+            }
+
+            tree.append(leaf);
+            ++next_idx;
+          }
+
+          // Only the most recent leaf is needed to extend the tree
+          if (next_idx > 2)
+          {
+            tree.flush(next_idx - 2);
+          }
+
+          report.chunks++;
+          report.entries += result.leaves.size();
+          report.bytes += result.bytes;
+        }
+
+        std::vector<std::optional<std::string>> sig_errors(pending.size());
+        for_each_parallel(pending.size(), [&](size_t i) {
+          const auto& [idx, sig, root] = pending[i];
+          const auto node_it = nodes.find(sig.node);
+          if (node_it == nodes.end() || node_it->second.written_at >= idx)
+          {
+            sig_errors[i] = fmt::format(
+              "Signature at {} was produced by unknown node {}", idx, sig.node);
+            return;
+          }
+
+          auto verifier = tls::make_verifier(node_it->second.cert);
+          if (!verifier->verify_hash(
+                root.h.data(), root.h.size(), sig.sig.data(), sig.sig.size()))
+          {
+            sig_errors[i] = fmt::format("Signature at {} is invalid", idx);
+          }
+        });
+
+        report.signatures += pending.size();
+        for (auto& error : sig_errors)
+        {
+          if (error.has_value())
+          {
+            report.errors.push_back(std::move(error.value()));
+          }
+        }
+      }
+
+      report.elapsed = std::chrono::steady_clock::now() - start_time;
+      return report;
+    }
+  };
+}
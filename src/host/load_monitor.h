@@ -18,6 +18,30 @@ namespace asynchost
 
     std::fstream enclave_output_file;
     nlohmann::json enclave_counts;
+    nlohmann::json enclave_thread_stats;
+
+    // Sums the counters in update, a two-level object of counters as sent in
+    // work_stats messages, into total
+    static void accumulate(nlohmann::json& total, const nlohmann::json& update)
+    {
+      for (const auto& [outer_key, outer_value] : update.items())
+      {
+        for (const auto& [inner_key, inner_value] : outer_value.items())
+        {
+          auto& outer_obj = total[outer_key];
+          auto it = outer_obj.find(inner_key);
+          if (it == outer_obj.end())
+          {
+            outer_obj[inner_key] = inner_value;
+          }
+          else
+          {
+            const auto prev = it.value().get<size_t>();
+            outer_obj[inner_key] = prev + inner_value.get<size_t>();
+          }
+        }
+      }
+    }
 
   public:
     LoadMonitorImpl(messaging::BufferProcessor& bp) :
@@ -31,6 +55,7 @@ namespace asynchost
 
       enclave_output_file.open("enclave_load.log", std::fstream::out);
       enclave_counts = nlohmann::json::object();
+      enclave_thread_stats = nlohmann::json::object();
 
       // Register message handler for work_stats message from enclave
       DISPATCHER_SET_MESSAGE_HANDLER(
@@ -49,23 +74,8 @@ namespace asynchost
             return;
           }
 
-          for (const auto& [outer_key, outer_value] : j.items())
-          {
-            for (const auto& [inner_key, inner_value] : outer_value.items())
-            {
-              auto& outer_obj = enclave_counts[outer_key];
-              auto it = outer_obj.find(inner_key);
-              if (it == outer_obj.end())
-              {
-                outer_obj[inner_key] = inner_value;
-              }
-              else
-              {
-                const auto prev = it.value().get<size_t>();
-                outer_obj[inner_key] = prev + inner_value.get<size_t>();
-              }
-            }
-          }
+          accumulate(enclave_counts, j["ringbuffer_messages"]);
+          accumulate(enclave_thread_stats, j["threads"]);
         });
     }
 
@@ -95,6 +105,8 @@ namespace asynchost
         {
           j["ringbuffer_messages"] = enclave_counts;
           enclave_counts = nlohmann::json::object();
+          j["threads"] = enclave_thread_stats;
+          enclave_thread_stats = nlohmann::json::object();
 
           const auto line = j.dump();
           enclave_output_file.write(line.data(), line.size());
@@ -16,6 +16,7 @@
 #include "snapshot.h"
 #include "ticker.h"
 #include "time_updater.h"
+#include "trace_writer.h"
 #include "version.h"
 
 #include <CLI11/CLI11.hpp>
@@ -160,6 +161,16 @@ int main(int argc, char** argv)
     ->capture_default_str()
     ->transform(CLI::AsSizeValue(true)); // 1000 is kb
 
+  int ledger_compression_level = 0;
+  app
+    .add_option(
+      "--ledger-compression-level",
+      ledger_compression_level,
+      "zlib compression level (1-9) at which committed ledger chunks are "
+      "compressed in the background. Defaults to no compression.")
+    ->capture_default_str()
+    ->check(CLI::Range(0, 9));
+
   size_t snapshot_tx_interval = std::numeric_limits<std::size_t>::max();
   app
     .add_option(
@@ -188,6 +199,16 @@ int main(int argc, char** argv)
   app.add_flag(
     "--log-format-json", log_format_json, "Set node stdout log format to JSON");
 
+  uint32_t log_site_rate_limit = logger::config::default_site_rate_limit;
+  app
+    .add_option(
+      "--log-site-rate-limit",
+      log_site_rate_limit,
+      "Maximum number of enclave log messages below the fail level written per "
+      "second by each logging statement. Further messages are dropped, and "
+      "counted. 0 disables rate limiting.")
+    ->capture_default_str();
+
   std::string node_cert_file("nodecert.pem");
   app
     .add_option(
@@ -218,6 +239,17 @@ int main(int argc, char** argv)
       "--sig-ms-interval", sig_ms_interval, "Milliseconds between signatures")
     ->capture_default_str();
 
+  size_t sig_latency_target_ms = 0;
+  app
+    .add_option(
+      "--sig-latency-target-ms",
+      sig_latency_target_ms,
+      "Target commit latency, in milliseconds. If non-zero, signatures are "
+      "emitted adaptively (when idle, or according to the observed "
+      "transaction rate) to meet this target, within the bounds set by "
+      "--sig-tx-interval and --sig-ms-interval")
+    ->capture_default_str();
+
   size_t circuit_size_shift = 22;
   app
     .add_option(
@@ -326,6 +358,32 @@ int main(int argc, char** argv)
       "Interval in seconds for JWT public signing key refresh.")
     ->capture_default_str();
 
+  size_t kv_spill_threshold = 0;
+  app
+    .add_option(
+      "--kv-spill-threshold",
+      kv_spill_threshold,
+      "Size in bytes from which committed KV values are sealed and moved out "
+      "of the enclave, to host memory. 0 keeps all values in the enclave.")
+    ->capture_default_str();
+
+  size_t kv_spill_cache_size = 64 * 1024 * 1024;
+  app
+    .add_option(
+      "--kv-spill-cache-size",
+      kv_spill_cache_size,
+      "Total size in bytes of the values moved to host memory which are kept "
+      "in an in-enclave cache once read")
+    ->capture_default_str();
+
+  bool kv_record_map_sizes = false;
+  app.add_flag(
+    "--kv-record-map-sizes",
+    kv_record_map_sizes,
+    "Record the size of each map in serialised transactions and snapshots, so "
+    "that readers can skip maps. Only set once every node of the service "
+    "supports it, since earlier nodes cannot read such transactions.");
+
   size_t memory_reserve_startup = 0;
   app
     .add_option(
@@ -578,9 +636,16 @@ int main(int argc, char** argv)
     // regularly update the time given to the enclave
     asynchost::TimeUpdater time_updater(1ms);
 
+    // spans of traced requests are timestamped relative to the time given to
+    // the enclave
+    tracing::config::epoch() = time_updater->behaviour.get_creation_time();
+
     // regularly record some load statistics
     asynchost::LoadMonitor load_monitor(500ms, bp);
 
+    // write spans of traced requests
+    asynchost::TraceWriter trace_writer(100ms, bp);
+
     // handle outbound messages from the enclave
     asynchost::HandleRingbuffer handle_ringbuffer(
       1ms, bp, circuit.read_from_inside(), non_blocking_factory);
@@ -595,6 +660,10 @@ int main(int argc, char** argv)
       asynchost::ledger_max_read_cache_files_default,
       read_only_ledger_dirs);
     ledger.register_message_handlers(bp.get_dispatcher());
+    if (ledger_compression_level > 0)
+    {
+      ledger.enable_compression(ledger_compression_level);
+    }
 
     asynchost::SnapshotManager snapshots(snapshot_dir);
     snapshots.register_message_handlers(bp.get_dispatcher());
@@ -652,7 +721,8 @@ int main(int argc, char** argv)
                                    raft_election_timeout,
                                    bft_view_change_timeout,
                                    bft_status_interval};
-    ccf_config.signature_intervals = {sig_tx_interval, sig_ms_interval};
+    ccf_config.signature_intervals = {
+      sig_tx_interval, sig_ms_interval, sig_latency_target_ms};
     ccf_config.node_info_network = {rpc_address.hostname,
                                     public_rpc_address.hostname,
                                     node_address.hostname,
@@ -666,6 +736,11 @@ int main(int argc, char** argv)
 
     ccf_config.jwt_key_refresh_interval_s = jwt_key_refresh_interval_s;
 
+    ccf_config.kv_spill_threshold = kv_spill_threshold;
+    ccf_config.kv_spill_cache_size = kv_spill_cache_size;
+    ccf_config.kv_record_map_sizes = kv_record_map_sizes;
+    ccf_config.log_site_rate_limit = log_site_rate_limit;
+
     if (*start)
     {
       start_type = StartType::New;
@@ -818,4 +818,260 @@ TEST_CASE("Multiple ledger paths")
     // cannot be read
     REQUIRE_FALSE(ledger.read_entry(last_idx).has_value());
   }
-}
\ No newline at end of file
+}
+size_t number_of_compressed_files_in_ledger_dir()
+{
+  size_t compressed_file_count = 0;
+  for (auto const& f : fs::directory_iterator(ledger_dir))
+  {
+    if (is_ledger_file_compressed(f.path().filename()))
+    {
+      compressed_file_count++;
+    }
+  }
+
+  return compressed_file_count;
+}
+
+void wait_for_compression(Ledger& ledger)
+{
+  while (ledger.get_compressions_in_progress() > 0)
+  {
+    uv_run(uv_default_loop(), UV_RUN_ONCE);
+  }
+}
+
+TEST_CASE("Compression")
+{
+  fs::remove_all(ledger_dir);
+
+  size_t chunk_threshold = 30;
+  size_t chunk_count = 4;
+  size_t end_of_first_chunk_idx = 0;
+  size_t last_idx = 0;
+
+  INFO("Committed chunks are compressed once compression is enabled");
+  {
+    Ledger ledger(ledger_dir, wf, chunk_threshold);
+    TestEntrySubmitter entry_submitter(ledger);
+
+    end_of_first_chunk_idx =
+      initialise_ledger(entry_submitter, chunk_threshold, chunk_count);
+    entry_submitter.write(true);
+    last_idx = entry_submitter.get_last_idx();
+
+    ledger.commit(2 * end_of_first_chunk_idx);
+    REQUIRE(number_of_committed_files_in_ledger_dir() == 2);
+
+    // Read committed chunks before they are compressed, so that they are
+    // cached
+    read_entries_range_from_ledger(ledger, 1, last_idx);
+
+    ledger.enable_compression();
+    wait_for_compression(ledger);
+    REQUIRE(number_of_compressed_files_in_ledger_dir() == 2);
+    REQUIRE(number_of_committed_files_in_ledger_dir() == 2);
+    REQUIRE(number_of_files_in_ledger_dir() == chunk_count + 1);
+
+    for (size_t i = 1; i <= last_idx; i++)
+    {
+      read_entry_from_ledger(ledger, i);
+    }
+    read_entries_range_from_ledger(ledger, 1, last_idx);
+
+    INFO("Chunks are compressed as they are committed");
+    ledger.commit(3 * end_of_first_chunk_idx);
+    wait_for_compression(ledger);
+    REQUIRE(number_of_compressed_files_in_ledger_dir() == 3);
+    read_entries_range_from_ledger(ledger, 1, last_idx);
+
+    INFO("Ledger cannot be truncated earlier than compressed chunks");
+    ledger.truncate(end_of_first_chunk_idx);
+    read_entries_range_from_ledger(ledger, 1, last_idx);
+  }
+
+  INFO("Compressed chunks are restored");
+  {
+    Ledger ledger(ledger_dir, wf, chunk_threshold);
+    TestEntrySubmitter entry_submitter(ledger, last_idx);
+
+    read_entries_range_from_ledger(ledger, 1, last_idx);
+
+    entry_submitter.write(true);
+    last_idx = entry_submitter.get_last_idx();
+    read_entries_range_from_ledger(ledger, 1, last_idx);
+  }
+
+  INFO("Entries and ranges of entries can span compressed blocks");
+  {
+    static constexpr auto blocks_ledger_dir = "ledger_dir_blocks";
+    fs::remove_all(blocks_ledger_dir);
+
+    size_t end_of_chunk_idx = 0;
+    {
+      Ledger ledger(blocks_ledger_dir, wf, chunk_threshold);
+      TestEntrySubmitter entry_submitter(ledger);
+      for (size_t i = 0; i < end_of_first_chunk_idx; i++)
+      {
+        entry_submitter.write(true);
+      }
+      end_of_chunk_idx = entry_submitter.get_last_idx();
+      ledger.commit(end_of_chunk_idx);
+    }
+
+    const auto file_name =
+      fmt::format("ledger_1-{}.committed", end_of_chunk_idx);
+    const auto compressed_file_name =
+      fmt::format("ledger_1-{}.committed.compressed", end_of_chunk_idx);
+
+    // Smaller than an entry, and not a multiple of the size of entries
+    const size_t block_size = 3;
+    LedgerFile::compress(
+      fs::path(blocks_ledger_dir) / fs::path(file_name),
+      fs::path(blocks_ledger_dir) / fs::path(compressed_file_name),
+      Z_BEST_COMPRESSION,
+      block_size);
+    fs::remove(fs::path(blocks_ledger_dir) / fs::path(file_name));
+
+    LedgerFile f(blocks_ledger_dir, compressed_file_name);
+    REQUIRE(f.is_compressed());
+    REQUIRE(f.get_last_idx() == end_of_chunk_idx);
+    for (size_t i = 1; i <= end_of_chunk_idx; i++)
+    {
+      REQUIRE(TestLedgerEntry(f.read_entry(i).value()).value() == i);
+    }
+    verify_framed_entries_range(
+      f.read_framed_entries(1, end_of_chunk_idx).value(), 1, end_of_chunk_idx);
+    verify_framed_entries_range(
+      f.read_framed_entries(2, end_of_chunk_idx).value(), 2, end_of_chunk_idx);
+  }
+}
+
+TEST_CASE("Entries are written to the enclave in place")
+{
+  fs::remove_all(ledger_dir);
+
+  size_t chunk_threshold = 30;
+  Ledger ledger(ledger_dir, wf, chunk_threshold);
+  TestEntrySubmitter entry_submitter(ledger);
+  const auto entries_per_chunk =
+    initialise_ledger(entry_submitter, chunk_threshold, 2);
+  const auto last_idx = entry_submitter.get_last_idx();
+  ledger.commit(entries_per_chunk);
+
+  messaging::BufferProcessor host_bp("host");
+  ledger.register_message_handlers(host_bp.get_dispatcher());
+
+  std::vector<std::tuple<consensus::Index, std::vector<uint8_t>>> received;
+  std::vector<consensus::Index> missing;
+  messaging::BufferProcessor enclave_bp("enclave");
+  DISPATCHER_SET_MESSAGE_HANDLER(
+    enclave_bp,
+    consensus::ledger_entry,
+    [&](const uint8_t* data, size_t size) {
+      auto [idx, purpose, entry] =
+        ringbuffer::read_message<consensus::ledger_entry>(data, size);
+      REQUIRE(purpose == consensus::LedgerRequestPurpose::HistoricalQuery);
+      received.emplace_back(idx, entry);
+    });
+  DISPATCHER_SET_MESSAGE_HANDLER(
+    enclave_bp,
+    consensus::ledger_no_entry,
+    [&](const uint8_t* data, size_t size) {
+      auto [idx, _] =
+        ringbuffer::read_message<consensus::ledger_no_entry>(data, size);
+      missing.push_back(idx);
+    });
+
+  auto to_host = wf.create_writer_to_outside();
+  for (size_t idx = 0; idx <= last_idx + 1; ++idx)
+  {
+    RINGBUFFER_WRITE_MESSAGE(
+      consensus::ledger_get,
+      to_host,
+      idx,
+      consensus::LedgerRequestPurpose::HistoricalQuery);
+
+    // Padding at the end of the ringbuffer may end a read early, so read
+    // twice
+    for (size_t i = 0; i < 2; ++i)
+    {
+      host_bp.read_n(-1, eio.read_from_inside());
+      enclave_bp.read_n(-1, eio.read_from_outside());
+    }
+  }
+
+  REQUIRE(missing == std::vector<consensus::Index>{0, last_idx + 1});
+  REQUIRE(received.size() == last_idx);
+  for (const auto& [idx, entry] : received)
+  {
+    REQUIRE(TestLedgerEntry(entry).value() == idx);
+  }
+}
+
+TEST_CASE("Entries which cannot be read are not written to the enclave")
+{
+  fs::remove_all(ledger_dir);
+
+  // Fresh buffers, so that no read is ended early by padding
+  auto in = std::make_unique<ringbuffer::TestBuffer>(buffer_size);
+  auto out = std::make_unique<ringbuffer::TestBuffer>(buffer_size);
+  ringbuffer::Circuit circuit(in->bd, out->bd);
+  auto factory = ringbuffer::WriterFactory(circuit);
+
+  size_t chunk_threshold = 100;
+  Ledger ledger(ledger_dir, factory, chunk_threshold);
+  TestEntrySubmitter entry_submitter(ledger);
+  for (size_t i = 0; i < 3; ++i)
+  {
+    entry_submitter.write(true);
+  }
+  const auto last_idx = entry_submitter.get_last_idx();
+
+  // Truncate the last entry behind the ledger's back, so that reading it fails
+  const auto file_path = fs::path(ledger_dir) / fs::path("ledger_1");
+  fs::resize_file(file_path, fs::file_size(file_path) - 1);
+
+  messaging::BufferProcessor host_bp("host");
+  ledger.register_message_handlers(host_bp.get_dispatcher());
+
+  std::vector<consensus::Index> received;
+  messaging::BufferProcessor enclave_bp("enclave");
+  DISPATCHER_SET_MESSAGE_HANDLER(
+    enclave_bp,
+    consensus::ledger_entry,
+    [&](const uint8_t* data, size_t size) {
+      auto [idx, purpose, entry] =
+        ringbuffer::read_message<consensus::ledger_entry>(data, size);
+      REQUIRE(TestLedgerEntry(entry).value() == idx);
+      received.push_back(idx);
+    });
+
+  auto to_host = factory.create_writer_to_outside();
+  RINGBUFFER_WRITE_MESSAGE(
+    consensus::ledger_get,
+    to_host,
+    last_idx,
+    consensus::LedgerRequestPurpose::Recovery);
+
+  // The failure is reported to the host, and nothing reaches the enclave which
+  // could be mistaken for the end of the ledger
+  REQUIRE_THROWS_AS(
+    host_bp.read_n(-1, circuit.read_from_inside()), std::logic_error);
+  REQUIRE(enclave_bp.read_n(-1, circuit.read_from_outside()) == 0);
+
+  // Drop the failed request, after which entries can be read as usual
+  messaging::BufferProcessor drain_bp("drain");
+  DISPATCHER_SET_MESSAGE_HANDLER(
+    drain_bp, consensus::ledger_get, [](const uint8_t*, size_t) {});
+  drain_bp.read_n(-1, circuit.read_from_inside());
+
+  RINGBUFFER_WRITE_MESSAGE(
+    consensus::ledger_get,
+    to_host,
+    last_idx - 1,
+    consensus::LedgerRequestPurpose::Recovery);
+  host_bp.read_n(-1, circuit.read_from_inside());
+  enclave_bp.read_n(-1, circuit.read_from_outside());
+  REQUIRE(received == std::vector<consensus::Index>{last_idx - 1});
+}
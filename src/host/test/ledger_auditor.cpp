@@ -0,0 +1,179 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "host/ledger_auditor.h"
+
+#include "kv/test/null_encryptor.h"
+#include "kv/test/stub_consensus.h"
+#include "node/history.h"
+
+#include <doctest/doctest.h>
+#include <string>
+
+using namespace asynchost;
+
+::timespec logger::config::start{0, 0};
+threading::ThreadMessaging threading::ThreadMessaging::thread_messaging;
+std::atomic<uint16_t> threading::ThreadMessaging::thread_count = 0;
+
+static constexpr auto ledger_dir = "auditor_ledger_dir";
+static constexpr auto read_only_ledger_dir = "auditor_read_only_ledger_dir";
+
+using Entries = std::map<consensus::Index, std::vector<uint8_t>>;
+using NumToString = kv::Map<size_t, std::string>;
+
+constexpr size_t signature_interval = 10;
+
+// Records the trusted signing node, followed by transactions with a signature
+// every signature_interval entries
+Entries make_entries(size_t n)
+{
+  auto consensus = std::make_shared<kv::StubConsensus>();
+  kv::Store store(consensus);
+  store.set_encryptor(std::make_shared<kv::NullTxEncryptor>());
+
+  const auto node_id = 0;
+  auto kp = tls::make_key_pair();
+  auto history = std::make_shared<ccf::MerkleTxHistory>(store, node_id, *kp);
+  store.set_history(history);
+
+  {
+    auto tx = store.create_tx();
+    auto view = tx.get_view<ccf::Nodes>(ccf::Tables::NODES);
+    ccf::NodeInfo ni;
+    ni.cert = kp->self_sign("CN=Test node");
+    ni.status = ccf::NodeStatus::TRUSTED;
+    view->put(node_id, ni);
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+  }
+
+  while (store.current_version() < n)
+  {
+    if ((store.current_version() + 1) % signature_interval == 0)
+    {
+      history->emit_signature();
+      store.compact(store.current_version());
+    }
+    else
+    {
+      auto tx = store.create_tx();
+      auto [public_view, private_view] =
+        tx.get_view<NumToString, NumToString>("public:data", "data");
+      const auto i = store.current_version();
+      public_view->put(i, std::to_string(i));
+      private_view->put(i, std::to_string(i));
+      REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+    }
+  }
+
+  Entries entries;
+  for (auto e = consensus->pop_oldest_entry(); e.has_value();
+       e = consensus->pop_oldest_entry())
+  {
+    entries.emplace(std::get<0>(e.value()), *std::get<1>(e.value()));
+  }
+  REQUIRE(entries.size() == n);
+  return entries;
+}
+
+void write_committed_chunk(
+  const std::string& dir,
+  const Entries& entries,
+  consensus::Index from,
+  consensus::Index to)
+{
+  LedgerFile file(dir, from);
+  for (auto idx = from; idx <= to; ++idx)
+  {
+    const auto& entry = entries.at(idx);
+    file.write_entry(entry.data(), entry.size(), false);
+  }
+  file.complete();
+  REQUIRE(file.commit(to));
+}
+
+struct LedgerDirs
+{
+  LedgerDirs()
+  {
+    fs::remove_all(ledger_dir);
+    fs::remove_all(read_only_ledger_dir);
+    fs::create_directory(ledger_dir);
+    fs::create_directory(read_only_ledger_dir);
+  }
+
+  ~LedgerDirs()
+  {
+    fs::remove_all(ledger_dir);
+    fs::remove_all(read_only_ledger_dir);
+  }
+};
+
+TEST_CASE("Audit valid ledger")
+{
+  LedgerDirs dirs;
+  constexpr size_t n = 55;
+  const auto entries = make_entries(n);
+
+  // Older chunks have been moved to a read-only directory
+  write_committed_chunk(read_only_ledger_dir, entries, 1, 12);
+  write_committed_chunk(read_only_ledger_dir, entries, 13, 30);
+  write_committed_chunk(ledger_dir, entries, 31, 44);
+  write_committed_chunk(ledger_dir, entries, 45, n);
+
+  for (size_t threads : {1, 4})
+  {
+    INFO("Threads: " << threads);
+    LedgerAuditor auditor(
+      {ledger_dir, read_only_ledger_dir},
+      threads,
+      std::make_shared<PublicDomainReader>(0));
+    const auto report = auditor.audit();
+    CHECK(report.ok());
+    CHECK(report.chunks == 4);
+    CHECK(report.entries == n);
+    CHECK(report.signatures == n / signature_interval);
+  }
+}
+
+TEST_CASE("Audit tampered ledger")
+{
+  LedgerDirs dirs;
+  constexpr size_t n = 30;
+  auto entries = make_entries(n);
+
+  INFO("Modify the end of the private domain of an entry");
+  constexpr consensus::Index tampered_idx = 12;
+  entries.at(tampered_idx).back() ^= 1;
+
+  write_committed_chunk(ledger_dir, entries, 1, 15);
+  write_committed_chunk(ledger_dir, entries, 16, n);
+
+  LedgerAuditor auditor(
+    {ledger_dir}, 2, std::make_shared<PublicDomainReader>(0));
+  const auto report = auditor.audit();
+  REQUIRE_FALSE(report.ok());
+  // The first signature covering the tampered entry is the first to fail
+  CHECK(
+    report.errors.front() ==
+    fmt::format(
+      "Signature at {} does not match the root of the ledger",
+      2 * signature_interval));
+}
+
+TEST_CASE("Audit ledger with missing chunk")
+{
+  LedgerDirs dirs;
+  constexpr size_t n = 30;
+  const auto entries = make_entries(n);
+
+  write_committed_chunk(ledger_dir, entries, 1, 10);
+  write_committed_chunk(ledger_dir, entries, 21, n);
+
+  LedgerAuditor auditor(
+    {ledger_dir}, 2, std::make_shared<PublicDomainReader>(0));
+  const auto report = auditor.audit();
+  REQUIRE_FALSE(report.ok());
+  CHECK(report.chunks == 1);
+  CHECK(report.entries == 10);
+}
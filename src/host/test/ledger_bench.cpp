@@ -0,0 +1,201 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#include "../ledger.h"
+
+#include <cstdlib>
+#include <iostream>
+#define PICOBENCH_IMPLEMENT_WITH_MAIN
+#include <picobench/picobench.hpp>
+
+::timespec logger::config::start{0, 0};
+
+using namespace asynchost;
+
+static constexpr auto bench_ledger_dir = "ledger_bench_dir";
+
+static void append_random(std::vector<uint8_t>& entry, size_t size)
+{
+  for (size_t i = 0; i < size; ++i)
+  {
+    entry.push_back(::rand() % 256);
+  }
+}
+
+static std::string random_hex(size_t size)
+{
+  std::string s;
+  for (size_t i = 0; i < size; ++i)
+  {
+    s += fmt::format("{:02x}", ::rand() % 256);
+  }
+  return s;
+}
+
+// Entries are shaped like those of a service under load: mostly application
+// transactions, whose private domain is encrypted and so incompressible, with
+// regular signatures and occasional governance transactions, whose public
+// domain holds JSON values
+static std::vector<uint8_t> make_entry(size_t idx)
+{
+  std::vector<uint8_t> entry;
+
+  // GCM tag and IV
+  append_random(entry, 28);
+
+  std::string public_domain;
+  size_t private_size = 0;
+  if (idx % 100 == 0)
+  {
+    public_domain = fmt::format(
+      "{{\"node\":0,\"seqno\":{},\"view\":2,\"commit_seqno\":{},"
+      "\"commit_view\":2,\"root\":\"{}\",\"sig\":\"{}\"}}",
+      idx,
+      idx - 1,
+      random_hex(32),
+      random_hex(72));
+  }
+  else if (idx % 20 == 0)
+  {
+    public_domain = fmt::format(
+      "{{\"proposal\":{{\"script\":{{\"text\":\"tables, calls = ...; return "
+      "Calls:call(\\\"set_user_data\\\", {{user_id={}, "
+      "user_data={{role=\\\"auditor\\\"}}}})\"}},\"parameter\":null}},"
+      "\"proposer\":{},\"state\":\"OPEN\",\"votes\":[[0,{{\"text\":\"return "
+      "true\"}}],[1,{{\"text\":\"return true\"}}]]}}",
+      idx % 7,
+      idx % 3);
+  }
+  else
+  {
+    if (idx % 4 == 0)
+    {
+      public_domain = fmt::format(
+        "{{\"id\":{},\"msg\":\"Public message at index {}\"}}", idx, idx);
+    }
+    private_size = 64 + ::rand() % 192;
+  }
+
+  const uint64_t public_size = public_domain.size();
+  entry.insert(
+    entry.end(),
+    reinterpret_cast<const uint8_t*>(&public_size),
+    reinterpret_cast<const uint8_t*>(&public_size) + sizeof(public_size));
+  entry.insert(entry.end(), public_domain.begin(), public_domain.end());
+  append_random(entry, private_size);
+
+  return entry;
+}
+
+// Writes a committed chunk of size entries, compressed if required, once for
+// all samples
+static std::string get_chunk(size_t size, bool compressed)
+{
+  static std::map<size_t, std::pair<std::string, std::string>> chunks;
+
+  auto it = chunks.find(size);
+  if (it == chunks.end())
+  {
+    const auto dir = fmt::format("{}/{}", bench_ledger_dir, size);
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    ::srand(42);
+    {
+      LedgerFile f(dir, 1);
+      for (size_t i = 1; i <= size; ++i)
+      {
+        const auto entry = make_entry(i);
+        f.write_entry(entry.data(), entry.size(), true);
+      }
+      f.complete();
+      f.commit(size);
+    }
+
+    const auto file_name = fmt::format("ledger_1-{}.committed", size);
+    const auto compressed_file_name =
+      fmt::format("ledger_1-{}.committed.compressed", size);
+    const auto raw_size = fs::file_size(fs::path(dir) / file_name);
+    const auto compressed_size = LedgerFile::compress(
+      fs::path(dir) / file_name, fs::path(dir) / compressed_file_name);
+
+    std::cout << fmt::format(
+                   "Chunk of {} entries: {} bytes, {} bytes compressed ({:.2f} "
+                   "compression ratio)",
+                   size,
+                   raw_size,
+                   compressed_size,
+                   (double)raw_size / compressed_size)
+              << std::endl;
+
+    it = chunks.emplace(size, std::make_pair(file_name, compressed_file_name))
+           .first;
+  }
+
+  return compressed ? it->second.second : it->second.first;
+}
+
+template <class A>
+inline void do_not_optimize(A const& value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <int Level>
+static void compress(picobench::state& s)
+{
+  const auto dir = fmt::format("{}/{}", bench_ledger_dir, s.iterations());
+  const auto file_name = get_chunk(s.iterations(), false);
+
+  s.start_timer();
+  LedgerFile::compress(
+    fs::path(dir) / file_name, fs::path(dir) / "ledger_bench.partial", Level);
+  s.stop_timer();
+}
+
+template <bool Compressed>
+static void read_entries(picobench::state& s)
+{
+  const auto dir = fmt::format("{}/{}", bench_ledger_dir, s.iterations());
+  const auto file_name = get_chunk(s.iterations(), Compressed);
+  LedgerFile f(dir, file_name);
+
+  s.start_timer();
+  for (size_t i = 1; i <= s.iterations(); ++i)
+  {
+    do_not_optimize(f.read_entry(i));
+  }
+  s.stop_timer();
+}
+
+// Ranges of entries, as read by backups catching up
+template <bool Compressed>
+static void read_ranges(picobench::state& s)
+{
+  constexpr size_t range_size = 100;
+  const auto dir = fmt::format("{}/{}", bench_ledger_dir, s.iterations());
+  const auto file_name = get_chunk(s.iterations(), Compressed);
+  LedgerFile f(dir, file_name);
+
+  s.start_timer();
+  for (size_t i = 1; i <= s.iterations(); i += range_size)
+  {
+    const auto to = std::min(i + range_size - 1, (size_t)s.iterations());
+    do_not_optimize(f.read_framed_entries(i, to));
+  }
+  s.stop_timer();
+}
+
+const std::vector<int> sizes = {1000, 10000};
+
+PICOBENCH_SUITE("compress");
+PICOBENCH(compress<Z_BEST_SPEED>).iterations(sizes).samples(10).baseline();
+PICOBENCH(compress<Z_DEFAULT_COMPRESSION>).iterations(sizes).samples(10);
+PICOBENCH(compress<Z_BEST_COMPRESSION>).iterations(sizes).samples(10);
+
+PICOBENCH_SUITE("read_entries");
+PICOBENCH(read_entries<false>).iterations(sizes).samples(10).baseline();
+PICOBENCH(read_entries<true>).iterations(sizes).samples(10);
+
+PICOBENCH_SUITE("read_ranges");
+PICOBENCH(read_ranges<false>).iterations(sizes).samples(10).baseline();
+PICOBENCH(read_ranges<true>).iterations(sizes).samples(10);
@@ -19,6 +19,11 @@ namespace asynchost
   public:
     TimeUpdaterImpl() : creation_time(TClock::now()) {}
 
+    TClock::time_point get_creation_time() const
+    {
+      return creation_time;
+    }
+
     std::atomic<std::chrono::microseconds>* get_value()
     {
       return &us_since_creation;
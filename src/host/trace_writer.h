@@ -0,0 +1,209 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include "ds/messaging.h"
+#include "ds/tracing.h"
+#include "enclave/interface.h"
+#include "timer.h"
+
+#include <fstream>
+#include <map>
+#include <nlohmann/json.hpp>
+
+namespace asynchost
+{
+  // Writes the spans of traced requests to a file in the Chrome trace event
+  // format, which can be loaded in chrome://tracing or Perfetto. Spans
+  // recorded by the enclave are attributed to process 0, and spans recorded by
+  // the host to process 1. The host does not know which requests are traced,
+  // so it times every ledger write while tracing is enabled, and these are
+  // matched by seqno to the transactions committed by traced requests.
+  class TraceFile : public tracing::AbstractSpanSink
+  {
+  public:
+    static constexpr auto enclave_pid = 0;
+    static constexpr auto host_pid = 1;
+
+    // Number of host spans, and of seqnos of traced transactions, which are
+    // kept while waiting for their counterpart
+    static constexpr size_t max_unmatched = 4096;
+
+  private:
+    const std::string file_name;
+    std::ofstream file;
+    bool first_event = true;
+
+    // Host spans of recent ledger writes, by seqno
+    std::map<uint64_t, tracing::Span> recent_writes;
+
+    // Trace id of traced transactions whose ledger write has not been seen,
+    // by seqno
+    std::map<uint64_t, uint64_t> wanted_writes;
+
+    template <typename M>
+    static void bound(M& m)
+    {
+      while (m.size() > max_unmatched)
+      {
+        m.erase(m.begin());
+      }
+    }
+
+    void write_event(const tracing::Span& span, int pid)
+    {
+      if (!file.is_open())
+      {
+        file.open(file_name, std::ofstream::out | std::ofstream::trunc);
+        file << "[" << std::endl;
+      }
+
+      auto args = nlohmann::json::object();
+      args["trace_id"] = span.trace_id;
+      if (span.seqno != 0)
+      {
+        args["seqno"] = span.seqno;
+      }
+      if (span.kind == tracing::SpanKind::ReplicationAck)
+      {
+        args["peer"] = span.peer;
+      }
+
+      auto event = nlohmann::json::object();
+      event["name"] = tracing::to_string(span.kind);
+      event["cat"] = "ccf";
+      event["ph"] = "X";
+      event["ts"] = span.start_us;
+      event["dur"] =
+        span.end_us > span.start_us ? span.end_us - span.start_us : 0;
+      event["pid"] = pid;
+      event["tid"] = span.thread_id;
+      event["args"] = args;
+
+      if (!first_event)
+      {
+        file << "," << std::endl;
+      }
+      file << event.dump();
+      first_event = false;
+    }
+
+  public:
+    TraceFile(const std::string& file_name = "trace.json") :
+      file_name(file_name)
+    {}
+
+    ~TraceFile()
+    {
+      if (file.is_open())
+      {
+        file << std::endl << "]" << std::endl;
+      }
+    }
+
+    // Spans recorded by the host
+    void write_spans(const tracing::Span* spans, size_t count) override
+    {
+      for (size_t i = 0; i < count; ++i)
+      {
+        auto span = spans[i];
+        if (span.kind != tracing::SpanKind::LedgerWrite)
+        {
+          write_event(span, host_pid);
+          continue;
+        }
+
+        auto it = wanted_writes.find(span.seqno);
+        if (it != wanted_writes.end())
+        {
+          span.trace_id = it->second;
+          write_event(span, host_pid);
+          wanted_writes.erase(it);
+        }
+        else
+        {
+          recent_writes[span.seqno] = span;
+          bound(recent_writes);
+        }
+      }
+    }
+
+    void write_enclave_spans(const uint8_t* data, size_t size)
+    {
+      if (size % sizeof(tracing::Span) != 0)
+      {
+        LOG_FAIL_FMT("Received truncated trace spans from enclave");
+        return;
+      }
+
+      for (size_t i = 0; i < size / sizeof(tracing::Span); ++i)
+      {
+        tracing::Span span;
+        std::memcpy(&span, data + i * sizeof(span), sizeof(span));
+        write_event(span, enclave_pid);
+
+        if (span.kind == tracing::SpanKind::StoreCommit && span.seqno != 0)
+        {
+          auto it = recent_writes.find(span.seqno);
+          if (it != recent_writes.end())
+          {
+            it->second.trace_id = span.trace_id;
+            write_event(it->second, host_pid);
+            recent_writes.erase(it);
+          }
+          else
+          {
+            wanted_writes[span.seqno] = span.trace_id;
+            bound(wanted_writes);
+          }
+        }
+      }
+    }
+
+    void flush()
+    {
+      if (file.is_open())
+      {
+        file.flush();
+      }
+    }
+  };
+
+  class TraceWriterImpl
+  {
+    TraceFile* trace_file;
+
+  public:
+    TraceWriterImpl(messaging::BufferProcessor& bp)
+    {
+      auto f = std::make_unique<TraceFile>();
+      trace_file = f.get();
+      tracing::config::sink() = std::move(f);
+
+      DISPATCHER_SET_MESSAGE_HANDLER(
+        bp,
+        AdminMessage::trace_spans,
+        [this](const uint8_t* data, size_t size) {
+          trace_file->write_enclave_spans(data, size);
+        });
+
+      DISPATCHER_SET_MESSAGE_HANDLER(
+        bp,
+        AdminMessage::trace_config,
+        [](const uint8_t* data, size_t size) {
+          auto [sample_rate] =
+            ringbuffer::read_message<AdminMessage::trace_config>(data, size);
+          tracing::config::sample_rate() = sample_rate;
+          LOG_INFO_FMT("Tracing 1 in {} requests", sample_rate);
+        });
+    }
+
+    void on_timer()
+    {
+      tracing::flush();
+      trace_file->flush();
+    }
+  };
+
+  using TraceWriter = proxy_ptr<Timer<TraceWriterImpl>>;
+}
@@ -20,6 +20,7 @@ namespace http
 
     static constexpr auto CCF_TX_SEQNO = "x-ccf-tx-seqno";
     static constexpr auto CCF_TX_VIEW = "x-ccf-tx-view";
+    static constexpr auto CCF_MIN_SEQNO = "x-ccf-min-seqno";
 
     // Deprecated, will be removed in a later release
     static constexpr auto CCF_GLOBAL_COMMIT = "x-ccf-global-commit";
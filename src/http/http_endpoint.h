@@ -3,6 +3,7 @@
 #pragma once
 
 #include "ds/logger.h"
+#include "ds/tracing.h"
 #include "enclave/client_endpoint.h"
 #include "enclave/rpc_map.h"
 #include "http_parser.h"
@@ -49,6 +50,12 @@ namespace http
         execution_thread, std::move(msg));
     }
 
+    size_t traced_read(uint8_t* data, size_t size)
+    {
+      tracing::ScopedSpan span(tracing::SpanKind::TlsDecrypt);
+      return read(data, size, false);
+    }
+
     void recv_(const uint8_t* data_, size_t size_)
     {
       recv_buffered(data_, size_);
@@ -83,10 +90,13 @@ namespace http
       }
       else
       {
+        // Requests parsed from this data are traced if it is sampled
+        tracing::TraceScope trace(tracing::start_trace());
+
         constexpr auto read_block_size = 4096;
         std::vector<uint8_t> buf(read_block_size);
         auto data = buf.data();
-        auto n_read = read(data, buf.size(), false);
+        auto n_read = traced_read(data, buf.size());
 
         while (true)
         {
@@ -99,10 +109,13 @@ namespace http
 
           try
           {
-            p.execute(data, n_read);
+            {
+              tracing::ScopedSpan span(tracing::SpanKind::HttpRequest);
+              p.execute(data, n_read);
+            }
 
             // Used all provided bytes - check if more are available
-            n_read = read(buf.data(), buf.size(), false);
+            n_read = traced_read(buf.data(), buf.size());
           }
           catch (const std::exception& e)
           {
@@ -148,6 +161,16 @@ namespace http
 
     void send(std::vector<uint8_t>&& data) override
     {
+      // Asynchronous responses produced on this session's thread are written
+      // immediately, so that they are not overtaken by the responses to
+      // requests which are already queued on that thread
+      if (threading::get_current_thread_id() == execution_thread)
+      {
+        send_buffered(data);
+        flush();
+        return;
+      }
+
       send_raw(std::move(data));
     }
 
@@ -3,9 +3,13 @@
 #pragma once
 #include "ds/champ_map.h"
 #include "ds/hash.h"
+#include "ds/rb_map.h"
 #include "kv/kv_types.h"
 
+#include <functional>
 #include <map>
+#include <memory>
+#include <vector>
 
 namespace kv
 {
@@ -16,13 +20,34 @@ namespace kv
   template <typename K, typename V, typename H>
   using Snapshot = champ::Snapshot<K, VersionV<V>, H>;
 
+  // Index of the keys of an ordered map's state, in serialised key order.
+  // Removed keys remain in the state with a deleted version, so the index is
+  // only ever added to.
+  template <typename K>
+  using OrderedKeys = RBMap<K, bool>;
+
   template <typename K>
   using Read = std::map<K, Version>;
 
+  // Key ranges [from, to) read by iterating over an ordered map, where a to of
+  // nullopt is unbounded
+  template <typename K>
+  using Ranges = std::vector<std::pair<K, std::optional<K>>>;
+
   // nullopt values represent deletions
   template <typename K, typename V>
   using Write = std::map<K, std::optional<V>>;
 
+  // A merge computes the new value of a key from its value when the
+  // transaction is committed, nullopt if the key does not exist
+  template <typename V>
+  using Merge = std::function<V(const std::optional<V>&)>;
+
+  // Merges which have not been resolved against the current value of their
+  // key, in the order they were made by the transaction
+  template <typename K, typename V>
+  using Merges = std::map<K, std::vector<Merge<V>>>;
+
   // This is a container for a write-set + dependencies. It can be applied to a
   // given state, or used to track a set of operations on a state
   template <typename K, typename V, typename H>
@@ -36,27 +61,40 @@ namespace kv
     const State<K, V, H> state = {};
     const State<K, V, H> committed = {};
     const Version start_version = {};
+    const std::optional<OrderedKeys<K>> ordered = {};
 
     Version read_version = NoVersion;
     Read<K> reads = {};
+    Ranges<K> ranges = {};
     Write<K, V> writes = {};
+    Merges<K, V> merges = {};
+
+    // Set when this change set conflicts because of the version of a single
+    // key, to the first such key found
+    std::optional<K> conflicting_key = std::nullopt;
+
+    // Cold values which have been read, kept loaded for the lifetime of the
+    // change set so that references to them remain valid
+    std::vector<std::shared_ptr<const V>> loaded_values = {};
 
     ChangeSet(
       size_t rollbacks,
       State<K, V, H>& current_state,
       State<K, V, H>& committed_state,
-      Version current_version) :
+      Version current_version,
+      const std::optional<OrderedKeys<K>>& current_ordered = std::nullopt) :
       rollback_counter(rollbacks),
       state(current_state),
       committed(committed_state),
-      start_version(current_version)
+      start_version(current_version),
+      ordered(current_ordered)
     {}
 
     ChangeSet(ChangeSet&) = delete;
 
     bool has_writes() const override
     {
-      return !writes.empty();
+      return !writes.empty() || !merges.empty();
     }
   };
 
@@ -24,6 +24,11 @@ namespace kv
     KOT_WRITE = (1 << 5),
     KOT_REMOVE_VERSION = (1 << 6),
     KOT_REMOVE = (1 << 7),
+    // Starts a map whose name is followed by the size of its remaining
+    // contents, so that readers can skip it. Only written when the store
+    // records map sizes, since earlier readers accept only
+    // KOT_MAP_START_INDICATOR.
+    KOT_SIZED_MAP_START_INDICATOR = (1 << 8),
   };
 
   typedef std::underlying_type<KvOperationType>::type KotBase;
@@ -51,12 +56,18 @@ namespace kv
     W* current_writer;
     Version version;
     bool is_snapshot;
+    bool record_map_sizes;
 
     std::shared_ptr<AbstractTxEncryptor> crypto_util;
 
     // must only be set by set_current_domain, since it affects current_writer
     SecurityDomain current_domain;
 
+    // Writer and position of the size of the current map, which is written
+    // once the map is complete
+    W* current_map_writer = nullptr;
+    size_t current_map_size_offset = 0;
+
     template <typename T>
     void serialise_internal(T&& t)
     {
@@ -69,6 +80,15 @@ namespace kv
       current_writer->template append_pre_serialised<T>(raw);
     }
 
+    void end_current_map()
+    {
+      if (current_map_writer != nullptr)
+      {
+        current_map_writer->write_reserved_size(current_map_size_offset);
+        current_map_writer = nullptr;
+      }
+    }
+
     void set_current_domain(SecurityDomain domain)
     {
       switch (domain)
@@ -90,9 +110,11 @@ namespace kv
     GenericSerialiseWrapper(
       std::shared_ptr<AbstractTxEncryptor> e,
       const Version& version_,
-      bool is_snapshot_ = false) :
+      bool is_snapshot_ = false,
+      bool record_map_sizes_ = false) :
       version(version_),
       is_snapshot(is_snapshot_),
+      record_map_sizes(record_map_sizes_),
       crypto_util(e)
     {
       set_current_domain(SecurityDomain::PUBLIC);
@@ -108,11 +130,23 @@ namespace kv
           "Private map {} cannot be serialised without an encryptor", name));
       }
 
+      end_current_map();
+
       if (domain != current_domain)
         set_current_domain(domain);
 
-      serialise_internal(KvOperationType::KOT_MAP_START_INDICATOR);
+      if (!record_map_sizes)
+      {
+        serialise_internal(KvOperationType::KOT_MAP_START_INDICATOR);
+        serialise_internal(name);
+        return;
+      }
+
+      serialise_internal(KvOperationType::KOT_SIZED_MAP_START_INDICATOR);
       serialise_internal(name);
+
+      current_map_writer = current_writer;
+      current_map_size_offset = current_writer->reserve_size();
     }
 
     void serialise_raw(const std::vector<uint8_t>& raw)
@@ -175,6 +209,8 @@ namespace kv
       std::unique_ptr<decltype(private_writer), decltype(writer_guard_func)>
         writer_guard(&private_writer, writer_guard_func);
 
+      end_current_map();
+
       auto serialised_public_domain = public_writer.get_raw_data();
 
       // If no crypto util is set, all maps have been serialised by the public
@@ -244,6 +280,8 @@ namespace kv
     R public_reader;
     R private_reader;
     R* current_reader;
+    // Size of the remaining contents of the current map, if it was recorded
+    std::optional<uint64_t> current_map_size = std::nullopt;
     std::vector<uint8_t> decrypted_buffer;
     KvOperationType unhandled_op;
     bool is_snapshot;
@@ -369,13 +407,54 @@ namespace kv
           return {};
       }
 
-      if (!try_read_op(KvOperationType::KOT_MAP_START_INDICATOR))
+      const auto op = try_read_op_flag(
+        KvOperationType::KOT_MAP_START_INDICATOR |
+        KvOperationType::KOT_SIZED_MAP_START_INDICATOR);
+      if (
+        op != KvOperationType::KOT_MAP_START_INDICATOR &&
+        op != KvOperationType::KOT_SIZED_MAP_START_INDICATOR)
       {
         return {};
       }
 
-      return std::optional<std::string>{
-        current_reader->template read_next<std::string>()};
+      auto name = current_reader->template read_next<std::string>();
+
+      current_map_size = std::nullopt;
+      if (op == KvOperationType::KOT_SIZED_MAP_START_INDICATOR)
+      {
+        current_map_size = current_reader->read_size();
+      }
+
+      return name;
+    }
+
+    /** Skip the contents of the map started by the last call to start_map().
+     *
+     * Maps written before their size was recorded are parsed until their end,
+     * as they would be if they were deserialised.
+     */
+    void skip_map()
+    {
+      if (current_map_size.has_value())
+      {
+        current_reader->skip(current_map_size.value());
+        current_map_size = std::nullopt;
+        return;
+      }
+
+      deserialise_entry_version();
+      for (auto n = deserialise_read_header(); n > 0; --n)
+      {
+        deserialise_read();
+      }
+      for (auto n = deserialise_write_header(); n > 0; --n)
+      {
+        deserialise_write();
+      }
+      for (auto n = deserialise_remove_header(); n > 0; --n)
+      {
+        deserialise_remove();
+      }
     }
 
     Version deserialise_entry_version()
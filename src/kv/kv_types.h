@@ -4,6 +4,7 @@
 
 #include "crypto/hash.h"
 #include "ds/nonstd.h"
+#include "ds/parallel_for.h"
 #include "enclave/consensus_type.h"
 #include "serialiser_declare.h"
 #include "tls/pem.h"
@@ -215,6 +216,12 @@ namespace kv
     virtual crypto::Sha256Hash get_replicated_state_root() = 0;
     virtual std::vector<uint8_t> get_receipt(Version v) = 0;
     virtual bool verify_receipt(const std::vector<uint8_t>& receipt) = 0;
+    virtual std::vector<uint8_t> get_batch_receipt(
+      const std::vector<Version>& vs) = 0;
+    virtual bool verify_batch_receipt(const std::vector<uint8_t>& receipt) = 0;
+    // Versions before this have been flushed, and can no longer be given
+    // receipts by the history
+    virtual Version get_first_receipt_version() = 0;
     virtual bool init_from_snapshot(
       const std::vector<uint8_t>& hash_at_snapshot) = 0;
     virtual std::vector<uint8_t> get_raw_leaf(uint64_t index) = 0;
@@ -246,6 +253,23 @@ namespace kv
     virtual void register_on_response(ResponseCallbackHandler func) = 0;
     virtual void clear_on_result() = 0;
     virtual void clear_on_response() = 0;
+
+    struct SignatureStatistics
+    {
+      bool adaptive = false;
+      size_t tx_interval = 0;
+      size_t ms_interval = 0;
+      size_t latency_target_ms = 0;
+      size_t commit_latency_samples = 0;
+      uint32_t commit_latency_p50_ms = 0;
+      uint32_t commit_latency_p90_ms = 0;
+      uint32_t commit_latency_p99_ms = 0;
+      uint32_t commit_latency_max_ms = 0;
+    };
+    virtual SignatureStatistics get_signature_statistics()
+    {
+      return SignatureStatistics();
+    }
   };
 
   class Consensus
@@ -434,6 +458,9 @@ namespace kv
 
   using EncryptorPtr = std::shared_ptr<AbstractTxEncryptor>;
 
+  class ValueSpill;
+  using ValueSpillPtr = std::shared_ptr<ValueSpill>;
+
   class AbstractChangeSet
   {
   public:
@@ -457,6 +484,9 @@ namespace kv
   {
   public:
     virtual ~AbstractTxView() = default;
+
+    // Whether obtaining this view enables ordered iteration over its map
+    static constexpr bool is_ordered = false;
   };
 
   struct NamedMap
@@ -483,6 +513,11 @@ namespace kv
     {
     public:
       virtual ~Snapshot() = default;
+      // Serialises the state of the map, which is most of the work of
+      // serialise. This can run concurrently for different maps.
+      virtual void serialise_state(
+        const threading::ParallelFor& parallel_for) = 0;
+      virtual size_t get_serialised_size() = 0;
       virtual void serialise(KvStoreSerialiser& s) = 0;
       virtual SecurityDomain get_security_domain() = 0;
     };
@@ -523,7 +558,9 @@ namespace kv
       virtual ~AbstractSnapshot() = default;
       virtual Version get_version() const = 0;
       virtual std::vector<uint8_t> serialise(
-        std::shared_ptr<AbstractTxEncryptor> encryptor) = 0;
+        std::shared_ptr<AbstractTxEncryptor> encryptor,
+        const threading::ParallelFor& parallel_for,
+        bool record_map_sizes = false) = 0;
     };
 
     virtual ~AbstractStore() {}
@@ -543,11 +580,14 @@ namespace kv
       kv::Version v, const std::string& map_name) = 0;
     virtual void add_dynamic_map(
       kv::Version v, const std::shared_ptr<AbstractMap>& map) = 0;
+    virtual void mark_map_dirty(const std::string& map_name) = 0;
     virtual bool is_map_replicated(const std::string& map_name) = 0;
 
     virtual std::shared_ptr<Consensus> get_consensus() = 0;
     virtual std::shared_ptr<TxHistory> get_history() = 0;
     virtual EncryptorPtr get_encryptor() = 0;
+    virtual ValueSpillPtr get_value_spill() = 0;
+    virtual bool get_record_map_sizes() = 0;
     virtual DeserialiseSuccess deserialise(
       const std::vector<uint8_t>& data,
       bool public_only = false,
@@ -6,6 +6,8 @@
 #include "serialise_entry_blit.h"
 #include "serialise_entry_json.h"
 #include "serialise_entry_msgpack.h"
+#include "serialise_entry_ordered.h"
+#include "serialise_entry_typed_binary.h"
 #include "tx_view.h"
 
 namespace kv
@@ -56,6 +58,19 @@ namespace kv
     }
   };
 
+  /** Map which can also be iterated in key order, over ranges of keys, with
+   * foreach_range and foreach_prefix on its views. Keys are compared by their
+   * serialised representation, so KSerialiser must preserve their order.
+   */
+  template <typename K, typename V, typename KSerialiser, typename VSerialiser>
+  class TypedOrderedMap : public TypedMap<K, V, KSerialiser, VSerialiser>
+  {
+  public:
+    using TxView = kv::OrderedTxView<K, V, KSerialiser, VSerialiser>;
+
+    using TypedMap<K, V, KSerialiser, VSerialiser>::TypedMap;
+  };
+
   template <
     typename K,
     typename V,
@@ -79,9 +94,27 @@ namespace kv
   using MsgPackSerialisedMap =
     MapSerialisedWith<K, V, kv::serialisers::MsgPackSerialiser>;
 
+  /** Map with fixed-layout serialisation of keys and values, declared with
+   * DECLARE_TYPED_BINARY_FIELDS. Single fields of values can be read with
+   * get_field on its views, without deserialising the rest of the value.
+   */
+  template <typename K, typename V>
+  using TypedBinarySerialisedMap =
+    MapSerialisedWith<K, V, kv::serialisers::TypedBinarySerialiser>;
+
   /** Short name for default-serialised maps, using msgpack serialisers. Support
    * for custom types can be added through the MSGPACK_DEFINE macro
    */
   template <typename K, typename V>
   using Map = MsgPackSerialisedMap<K, V>;
+
+  /** Short name for ordered maps, with order-preserving serialisation of
+   * integer, string and byte keys, and msgpack serialisation of values
+   */
+  template <typename K, typename V>
+  using OrderedMap = TypedOrderedMap<
+    K,
+    V,
+    kv::serialisers::OrderedSerialiser<K>,
+    kv::serialisers::MsgPackSerialiser<V>>;
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "generic_serialise_wrapper.h"
 #include "serialised_entry.h"
 
+#include <cstring>
 #include <iterator>
 #include <msgpack/msgpack.hpp>
 #include <nlohmann/json.hpp>
@@ -47,6 +48,23 @@ namespace kv
       }
     }
 
+    // Reserves space for a size, to be written by write_reserved_size()
+    size_t reserve_size()
+    {
+      const auto offset = sb.size();
+      const uint64_t size = 0;
+      sb.write(reinterpret_cast<char const*>(&size), sizeof(size));
+      return offset;
+    }
+
+    // Writes the number of bytes written since the size at offset was
+    // reserved
+    void write_reserved_size(size_t offset)
+    {
+      const uint64_t size = sb.size() - offset - sizeof(uint64_t);
+      std::memcpy(sb.data() + offset, &size, sizeof(size));
+    }
+
     void clear()
     {
       sb.clear();
@@ -116,6 +134,27 @@ namespace kv
       return {data_ptr + before_offset, data_ptr + data_offset};
     }
 
+    uint64_t read_size()
+    {
+      auto remainder = data_size - data_offset;
+      auto data = reinterpret_cast<const uint8_t*>(data_ptr + data_offset);
+      const auto size = serialized::read<uint64_t>(data, remainder);
+      data_offset += sizeof(uint64_t);
+      return size;
+    }
+
+    void skip(size_t size)
+    {
+      if (data_size - data_offset < size)
+      {
+        throw std::runtime_error(fmt::format(
+          "Cannot skip {} bytes, found only {}",
+          size,
+          data_size - data_offset));
+      }
+      data_offset += size;
+    }
+
     bool is_eos()
     {
       return data_offset >= data_size;
@@ -26,6 +26,20 @@ namespace kv
       arr.push_back(obj);
     }
 
+    // Reserves space for a size, to be written by write_reserved_size()
+    size_t reserve_size()
+    {
+      arr.push_back(0);
+      return arr.size() - 1;
+    }
+
+    // Writes the number of elements appended since the size at offset was
+    // reserved
+    void write_reserved_size(size_t offset)
+    {
+      arr[offset] = arr.size() - offset - 1;
+    }
+
     void clear()
     {
       arr.clear();
@@ -82,6 +96,23 @@ namespace kv
       return ret;
     }
 
+    uint64_t read_size()
+    {
+      return read_next<uint64_t>();
+    }
+
+    void skip(size_t size)
+    {
+      if (arr.size() - data_offset < size)
+      {
+        throw std::runtime_error(fmt::format(
+          "Cannot skip {} elements, found only {}",
+          size,
+          arr.size() - data_offset));
+      }
+      data_offset += size;
+    }
+
     bool is_eos()
     {
       return data_offset >= arr.size();
@@ -0,0 +1,85 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include "ds/nonstd.h"
+#include "serialised_entry.h"
+
+namespace kv::serialisers
+{
+  // Serialises keys such that the byte-wise order of their serialised
+  // representations is the order of the keys, as required by ordered maps.
+  // Integers are written big-endian, with the sign bit of signed integers
+  // flipped. Strings and byte containers are copied as they are.
+  template <typename T>
+  struct OrderedSerialiser
+  {
+    static SerialisedEntry to_serialised(const T& t)
+    {
+      if constexpr (std::is_integral_v<T>)
+      {
+        using U = std::make_unsigned_t<T>;
+        auto u = static_cast<U>(t);
+        if constexpr (std::is_signed_v<T>)
+        {
+          u ^= U(1) << (sizeof(U) * 8 - 1);
+        }
+
+        SerialisedEntry s(sizeof(U));
+        for (size_t i = 0; i < sizeof(U); ++i)
+        {
+          s[sizeof(U) - 1 - i] = static_cast<uint8_t>(u >> (i * 8));
+        }
+        return s;
+      }
+      else if constexpr (
+        std::is_same_v<T, std::string> ||
+        std::is_same_v<T, std::vector<uint8_t>> ||
+        nonstd::is_std_array<T>::value)
+      {
+        return SerialisedEntry(t.begin(), t.end());
+      }
+      else
+      {
+        static_assert(
+          nonstd::dependent_false<T>::value, "Can't serialise this type");
+      }
+    }
+
+    static T from_serialised(const SerialisedEntry& rep)
+    {
+      if constexpr (std::is_integral_v<T>)
+      {
+        using U = std::make_unsigned_t<T>;
+        if (rep.size() != sizeof(U))
+        {
+          throw std::logic_error("Wrong size for deserialising");
+        }
+
+        U u = 0;
+        for (size_t i = 0; i < sizeof(U); ++i)
+        {
+          u = (u << 8) | rep[i];
+        }
+
+        if constexpr (std::is_signed_v<T>)
+        {
+          u ^= U(1) << (sizeof(U) * 8 - 1);
+        }
+        return static_cast<T>(u);
+      }
+      else if constexpr (
+        std::is_same_v<T, std::string> ||
+        std::is_same_v<T, std::vector<uint8_t>> ||
+        nonstd::is_std_array<T>::value)
+      {
+        return T(rep.begin(), rep.end());
+      }
+      else
+      {
+        static_assert(
+          nonstd::dependent_false<T>::value, "Can't deserialise this type");
+      }
+    }
+  };
+}
\ No newline at end of file
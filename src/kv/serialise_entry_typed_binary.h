@@ -0,0 +1,462 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include "ds/json.h"
+#include "ds/nonstd.h"
+#include "serialised_entry.h"
+
+#include <cstring>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define TYPED_BINARY_FIELD_FOR_JSON_NEXT(TYPE, FIELD) &TYPE::FIELD,
+#define TYPED_BINARY_FIELD_FOR_JSON_FINAL(TYPE, FIELD) &TYPE::FIELD
+
+/** Declares the fields of TYPE which kv::serialisers::TypedBinarySerialiser
+ * writes, in order. This is usually the same list of fields as in the
+ * DECLARE_JSON_REQUIRED_FIELDS or MSGPACK_DEFINE of TYPE, and must be used in
+ * the same namespace as TYPE. TYPE must be default-constructible.
+ *
+ * Fields may be of arithmetic or enum types, std::arrays of those, strings,
+ * vectors of arithmetic or enum types, or other types declared with this
+ * macro.
+ *
+ * Example:
+ *  struct Account
+ *  {
+ *    std::string name;
+ *    int64_t balance;
+ *  };
+ *  DECLARE_TYPED_BINARY_FIELDS(Account, name, balance)
+ */
+#define DECLARE_TYPED_BINARY_FIELDS(TYPE, ...) \
+  inline constexpr auto typed_binary_fields(const TYPE*) \
+  { \
+    return std::make_tuple(_FOR_JSON_COUNT_NN(__VA_ARGS__)(POP1)( \
+      TYPED_BINARY_FIELD, TYPE, ##__VA_ARGS__)); \
+  }
+
+namespace kv::serialisers
+{
+  // An entry starts with a fixed-size slot for each field, in declaration
+  // order, so that the offset of each field is known at compile time. Fixed
+  // size fields are stored in their slot. Strings, vectors and nested types
+  // are stored after the last slot, and their slot holds their offset from
+  // the start of the entry and their size, as two uint32_t. Nested types are
+  // laid out in the same way, with offsets from their own start.
+  namespace typed_binary
+  {
+    static constexpr size_t variable_slot_size = 2 * sizeof(uint32_t);
+
+    template <typename T, typename = void>
+    struct has_fields : std::false_type
+    {};
+
+    template <typename T>
+    struct has_fields<
+      T,
+      std::void_t<decltype(typed_binary_fields(std::declval<const T*>()))>>
+      : std::true_type
+    {};
+
+    template <typename T>
+    struct is_vector : std::false_type
+    {};
+
+    template <typename U, typename A>
+    struct is_vector<std::vector<U, A>> : std::true_type
+    {};
+
+    template <typename M>
+    struct member;
+
+    template <typename C, typename F>
+    struct member<F C::*>
+    {
+      using class_type = C;
+      using type = F;
+    };
+
+    template <typename T>
+    using fields_t =
+      decltype(typed_binary_fields(std::declval<const T*>()));
+
+    template <typename T>
+    inline constexpr size_t field_count = std::tuple_size_v<fields_t<T>>;
+
+    template <typename T, size_t I>
+    using field_t =
+      typename member<std::tuple_element_t<I, fields_t<T>>>::type;
+
+    template <typename T>
+    constexpr auto fields()
+    {
+      return typed_binary_fields(static_cast<const T*>(nullptr));
+    }
+
+    template <typename T>
+    constexpr bool is_fixed()
+    {
+      if constexpr (nonstd::is_std_array<T>::value)
+      {
+        return is_fixed<typename T::value_type>();
+      }
+      else
+      {
+        // The padding of long double would make entries non-deterministic
+        return (std::is_arithmetic_v<T> && !std::is_same_v<T, long double>) ||
+          std::is_enum_v<T>;
+      }
+    }
+
+    // Strings and vectors whose contents are copied as they are
+    template <typename T>
+    constexpr bool is_contiguous()
+    {
+      if constexpr (std::is_same_v<T, std::string>)
+      {
+        return true;
+      }
+      else if constexpr (is_vector<T>::value)
+      {
+        using U = typename T::value_type;
+        return is_fixed<U>() && !std::is_same_v<U, bool>;
+      }
+      else
+      {
+        return false;
+      }
+    }
+
+    template <typename F>
+    constexpr size_t slot_size()
+    {
+      if constexpr (is_fixed<F>())
+      {
+        return sizeof(F);
+      }
+      else if constexpr (is_contiguous<F>() || has_fields<F>::value)
+      {
+        return variable_slot_size;
+      }
+      else
+      {
+        static_assert(
+          nonstd::dependent_false<F>::value, "Can't serialise this type");
+      }
+    }
+
+    // Offset of the slot of field I of T, or size of all slots of T if I is
+    // the number of fields of T
+    template <typename T, size_t I>
+    constexpr size_t slot_offset()
+    {
+      if constexpr (I == 0)
+      {
+        return 0;
+      }
+      else
+      {
+        return slot_offset<T, I - 1>() + slot_size<field_t<T, I - 1>>();
+      }
+    }
+
+    template <typename T>
+    constexpr size_t fixed_size()
+    {
+      return slot_offset<T, field_count<T>>();
+    }
+
+    template <typename T, auto Field, size_t I = 0>
+    constexpr size_t field_index()
+    {
+      using M = std::tuple_element_t<I, fields_t<T>>;
+      if constexpr (std::is_same_v<M, decltype(Field)>)
+      {
+        if (std::get<I>(fields<T>()) == Field)
+        {
+          return I;
+        }
+      }
+
+      if constexpr (I + 1 < field_count<T>)
+      {
+        return field_index<T, Field, I + 1>();
+      }
+      else
+      {
+        throw std::logic_error("Not a declared typed binary field");
+      }
+    }
+
+    template <typename T>
+    size_t serialised_size(const T& t);
+
+    template <typename F>
+    size_t variable_size(const F& f)
+    {
+      if constexpr (is_fixed<F>())
+      {
+        return 0;
+      }
+      else if constexpr (is_contiguous<F>())
+      {
+        return f.size() * sizeof(typename F::value_type);
+      }
+      else
+      {
+        return serialised_size(f);
+      }
+    }
+
+    template <typename T>
+    size_t serialised_size(const T& t)
+    {
+      size_t size = fixed_size<T>();
+      std::apply(
+        [&](const auto&... fs) { ((size += variable_size(t.*fs)), ...); },
+        fields<T>());
+      return size;
+    }
+
+    template <typename T>
+    void write(const T& t, uint8_t* data);
+
+    template <typename F>
+    void write_field(const F& f, uint8_t* slot, uint8_t* data, size_t& end)
+    {
+      if constexpr (is_fixed<F>())
+      {
+        std::memcpy(slot, &f, sizeof(F));
+      }
+      else
+      {
+        const auto offset = static_cast<uint32_t>(end);
+        const auto size = static_cast<uint32_t>(variable_size(f));
+        std::memcpy(slot, &offset, sizeof(offset));
+        std::memcpy(slot + sizeof(offset), &size, sizeof(size));
+
+        if constexpr (is_contiguous<F>())
+        {
+          if (size != 0)
+          {
+            std::memcpy(data + end, f.data(), size);
+          }
+        }
+        else
+        {
+          write(f, data + end);
+        }
+        end += size;
+      }
+    }
+
+    template <typename T, size_t... Is>
+    void write_fields(
+      const T& t, uint8_t* data, size_t& end, std::index_sequence<Is...>)
+    {
+      (write_field(
+         t.*std::get<Is>(fields<T>()), data + slot_offset<T, Is>(), data, end),
+       ...);
+    }
+
+    // Writes t at data, which must hold serialised_size(t) bytes
+    template <typename T>
+    void write(const T& t, uint8_t* data)
+    {
+      size_t end = fixed_size<T>();
+      write_fields(t, data, end, std::make_index_sequence<field_count<T>>());
+    }
+
+    template <typename T>
+    void check_size(size_t size)
+    {
+      if (size < fixed_size<T>())
+      {
+        throw std::logic_error("Wrong size for deserialising");
+      }
+    }
+
+    template <typename T>
+    T read(const uint8_t* data, size_t size);
+
+    // Reads the field of type F in the slot at data + offset, of the entry of
+    // type T at data
+    template <typename T, typename F>
+    F read_field(const uint8_t* data, size_t size, size_t offset)
+    {
+      const uint8_t* slot = data + offset;
+      if constexpr (is_fixed<F>())
+      {
+        F f;
+        std::memcpy(&f, slot, sizeof(F));
+        return f;
+      }
+      else
+      {
+        uint32_t field_offset;
+        uint32_t field_size;
+        std::memcpy(&field_offset, slot, sizeof(field_offset));
+        std::memcpy(
+          &field_size, slot + sizeof(field_offset), sizeof(field_size));
+        if (
+          field_offset < fixed_size<T>() || field_offset > size ||
+          field_size > size - field_offset)
+        {
+          throw std::logic_error("Field out of bounds for deserialising");
+        }
+
+        const uint8_t* field_data = data + field_offset;
+        if constexpr (std::is_same_v<F, std::string>)
+        {
+          return F(field_data, field_data + field_size);
+        }
+        else if constexpr (is_contiguous<F>())
+        {
+          using U = typename F::value_type;
+          if (field_size % sizeof(U) != 0)
+          {
+            throw std::logic_error("Wrong size for deserialising");
+          }
+
+          F f(field_size / sizeof(U));
+          if (field_size != 0)
+          {
+            std::memcpy(f.data(), field_data, field_size);
+          }
+          return f;
+        }
+        else
+        {
+          return read<F>(field_data, field_size);
+        }
+      }
+    }
+
+    template <typename T, size_t... Is>
+    void read_fields(
+      T& t, const uint8_t* data, size_t size, std::index_sequence<Is...>)
+    {
+      ((t.*std::get<Is>(fields<T>()) =
+          read_field<T, field_t<T, Is>>(data, size, slot_offset<T, Is>())),
+       ...);
+    }
+
+    template <typename T>
+    T read(const uint8_t* data, size_t size)
+    {
+      check_size<T>(size);
+      T t;
+      read_fields(t, data, size, std::make_index_sequence<field_count<T>>());
+      return t;
+    }
+  }
+
+  /** Serialises types declared with DECLARE_TYPED_BINARY_FIELDS to a fixed
+   * layout, in which each field is at a known offset. Deserialising does not
+   * parse the entry, and single fields can be read with read_field, without
+   * deserialising the other fields.
+   *
+   * Arithmetic and enum types, strings and byte vectors are copied as they
+   * are, so can also be used as keys. Values are written in the byte order of
+   * the host.
+   */
+  template <typename T>
+  struct TypedBinarySerialiser
+  {
+    static SerialisedEntry to_serialised(const T& t)
+    {
+      if constexpr (typed_binary::has_fields<T>::value)
+      {
+        const auto size = typed_binary::serialised_size(t);
+        if (size > std::numeric_limits<uint32_t>::max())
+        {
+          throw std::logic_error("Value too large for serialising");
+        }
+
+        SerialisedEntry s(size);
+        typed_binary::write(t, s.data());
+        return s;
+      }
+      else if constexpr (typed_binary::is_fixed<T>())
+      {
+        SerialisedEntry s(sizeof(T));
+        std::memcpy(s.data(), &t, sizeof(T));
+        return s;
+      }
+      else if constexpr (typed_binary::is_contiguous<T>())
+      {
+        const auto data = reinterpret_cast<const uint8_t*>(t.data());
+        return SerialisedEntry(
+          data, data + t.size() * sizeof(typename T::value_type));
+      }
+      else
+      {
+        static_assert(
+          nonstd::dependent_false<T>::value, "Can't serialise this type");
+      }
+    }
+
+    static T from_serialised(const SerialisedEntry& rep)
+    {
+      if constexpr (typed_binary::has_fields<T>::value)
+      {
+        return typed_binary::read<T>(rep.data(), rep.size());
+      }
+      else if constexpr (typed_binary::is_fixed<T>())
+      {
+        if (rep.size() != sizeof(T))
+        {
+          throw std::logic_error("Wrong size for deserialising");
+        }
+
+        T t;
+        std::memcpy(&t, rep.data(), sizeof(T));
+        return t;
+      }
+      else if constexpr (typed_binary::is_contiguous<T>())
+      {
+        using U = typename T::value_type;
+        if (rep.size() % sizeof(U) != 0)
+        {
+          throw std::logic_error("Wrong size for deserialising");
+        }
+
+        T t(rep.size() / sizeof(U), U{});
+        if (!rep.empty())
+        {
+          std::memcpy(t.data(), rep.data(), rep.size());
+        }
+        return t;
+      }
+      else
+      {
+        static_assert(
+          nonstd::dependent_false<T>::value, "Can't deserialise this type");
+      }
+    }
+
+    /** Reads a single field of a serialised T, given as a pointer to member
+     * of T, such as &T::field. The field must be declared with
+     * DECLARE_TYPED_BINARY_FIELDS.
+     */
+    template <auto Field>
+    static auto read_field(const SerialisedEntry& rep)
+    {
+      using M = typed_binary::member<decltype(Field)>;
+      static_assert(
+        std::is_same_v<typename M::class_type, T>,
+        "Field must be a member of the serialised type");
+
+      constexpr auto i = typed_binary::field_index<T, Field>();
+      typed_binary::check_size<T>(rep.size());
+      return typed_binary::read_field<T, typename M::type>(
+        rep.data(), rep.size(), typed_binary::slot_offset<T, i>());
+    }
+  };
+}
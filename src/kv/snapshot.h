@@ -6,6 +6,11 @@
 
 namespace kv
 {
+  // Maps whose serialised state is at least this large (in bytes) are
+  // serialised and deserialised one at a time, each on all threads. Smaller
+  // maps are each handled on a single thread, concurrently with one another.
+  static constexpr size_t large_map_snapshot_size = 1 << 20;
+
   class StoreSnapshot : public AbstractStore::AbstractSnapshot
   {
   private:
@@ -39,9 +44,29 @@ namespace kv
     }
 
     std::vector<uint8_t> serialise(
-      std::shared_ptr<AbstractTxEncryptor> encryptor)
+      std::shared_ptr<AbstractTxEncryptor> encryptor,
+      const threading::ParallelFor& parallel_for,
+      bool record_map_sizes = false)
     {
-      KvStoreSerialiser serialiser(encryptor, version, true);
+      std::vector<kv::AbstractMap::Snapshot*> small_maps;
+      for (const auto& it : snapshots)
+      {
+        if (it->get_serialised_size() >= large_map_snapshot_size)
+        {
+          it->serialise_state(parallel_for);
+        }
+        else
+        {
+          small_maps.push_back(it.get());
+        }
+      }
+      threading::for_indices(parallel_for, small_maps.size(), [&](size_t i) {
+        small_maps[i]->serialise_state(nullptr);
+      });
+
+      // The serialised states are then written in order, so that the snapshot
+      // does not depend on the order in which they were serialised
+      KvStoreSerialiser serialiser(encryptor, version, true, record_map_sizes);
 
       if (hash_at_snapshot.has_value())
       {
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "ds/ccf_exception.h"
+#include "ds/tracing.h"
 #include "kv_serialiser.h"
 #include "kv_types.h"
 #include "map.h"
@@ -14,6 +15,7 @@
 #include "view_containers.h"
 
 #include <fmt/format.h>
+#include <set>
 
 namespace kv
 {
@@ -28,6 +30,13 @@ namespace kv
     SpinLock maps_lock;
     Maps maps;
 
+    // Names of the maps which have been committed to since they were last
+    // compacted. Only these maps can hold state which is discarded by
+    // compaction or rollback, so other maps are not visited. Ordered by name,
+    // like Maps, so that they are locked in the same order.
+    SpinLock dirty_maps_lock;
+    std::set<std::string> dirty_maps;
+
     SpinLock version_lock;
     Version version = 0;
     Version compacted = 0;
@@ -47,6 +56,11 @@ namespace kv
       maps.clear();
       pending_txs.clear();
 
+      {
+        std::lock_guard<SpinLock> dguard(dirty_maps_lock);
+        dirty_maps.clear();
+      }
+
       version = 0;
       compacted = 0;
       term = 0;
@@ -68,6 +82,9 @@ namespace kv
     std::shared_ptr<TxHistory> history = nullptr;
     std::shared_ptr<ccf::ProgressTracker> progress_tracker = nullptr;
     EncryptorPtr encryptor = nullptr;
+    ValueSpillPtr value_spill = nullptr;
+    threading::ParallelFor parallel_for = nullptr;
+    bool record_map_sizes = false;
 
     kv::ReplicateType replicate_type = kv::ReplicateType::ALL;
     std::unordered_set<std::string> replicated_tables;
@@ -106,6 +123,23 @@ namespace kv
       return false;
     }
 
+    // Returns the entries of the named maps which currently exist, in name
+    // order. Expects maps_lock to be held.
+    std::vector<Maps::iterator> find_maps(const std::set<std::string>& names)
+    {
+      std::vector<Maps::iterator> found;
+      found.reserve(names.size());
+      for (const auto& name : names)
+      {
+        auto search = maps.find(name);
+        if (search != maps.end())
+        {
+          found.push_back(search);
+        }
+      }
+      return found;
+    }
+
   public:
     Store(bool strict_versions_ = true) : strict_versions(strict_versions_) {}
 
@@ -161,6 +195,55 @@ namespace kv
       return encryptor;
     }
 
+    /** Spill large committed values out of enclave memory.
+     *
+     * Values are only spilled once they have been compacted, so that the
+     * values of recent transactions remain in the enclave.
+     *
+     * @param value_spill_ Spill for large values, or nullptr to keep all new
+     * values in the enclave
+     */
+    void set_value_spill(const ValueSpillPtr& value_spill_)
+    {
+      value_spill = value_spill_;
+    }
+
+    ValueSpillPtr get_value_spill() override
+    {
+      return value_spill;
+    }
+
+    /** Record the size of each map in serialised transactions and snapshots,
+     * so that readers can skip the maps they do not select.
+     *
+     * Nodes which predate sized maps cannot read them, so this must only be
+     * enabled once every node of the service can.
+     *
+     * @param record_map_sizes_ Whether map sizes are recorded
+     */
+    void set_record_map_sizes(bool record_map_sizes_)
+    {
+      record_map_sizes = record_map_sizes_;
+    }
+
+    bool get_record_map_sizes() override
+    {
+      return record_map_sizes;
+    }
+
+    /** Serialise and deserialise snapshots on several threads.
+     *
+     * The maps of a snapshot are serialised concurrently, as are the subtrees
+     * of large maps. Serialised snapshots do not depend on parallel_for.
+     *
+     * @param parallel_for_ Runs tasks concurrently, or nullptr to serialise
+     * and deserialise snapshots on the calling thread
+     */
+    void set_parallel_for(const threading::ParallelFor& parallel_for_)
+    {
+      parallel_for = parallel_for_;
+    }
+
     /** Get a map by name, iff it exists at the given version.
      *
      * This means a prior transaction must have created the map, and
@@ -227,6 +310,10 @@ namespace kv
       LOG_DEBUG_FMT("Adding newly created map '{}' at version {}", map_name, v);
       maps[map_name] = std::make_pair(v, map);
 
+      // The creation of the map may be rolled back, so it must be visited by
+      // rollback until it is compacted
+      mark_map_dirty(map_name);
+
       {
         // If we have any hooks for the given map name, set them on this new map
         const auto local_it = local_hooks.find(map_name);
@@ -243,6 +330,12 @@ namespace kv
       }
     }
 
+    void mark_map_dirty(const std::string& map_name) override
+    {
+      std::lock_guard<SpinLock> dguard(dirty_maps_lock);
+      dirty_maps.insert(map_name);
+    }
+
     bool is_map_replicated(const std::string& name) override
     {
       switch (replicate_type)
@@ -294,16 +387,16 @@ namespace kv
       {
         std::lock_guard<SpinLock> mguard(maps_lock);
 
+        // Compaction and rollback are excluded by maps_lock, and any
+        // transaction committed concurrently is at a version later than v, so
+        // is not included in the snapshot. Each map only needs to be locked
+        // while its own state is read, rather than locking all maps at once.
         for (auto& it : maps)
         {
           auto& [_, map] = it.second;
           map->lock();
-        }
-
-        for (auto& it : maps)
-        {
-          auto& [_, map] = it.second;
           snapshot->add_map_snapshot(map->snapshot(v));
+          map->unlock();
         }
 
         auto h = get_history();
@@ -317,12 +410,6 @@ namespace kv
         {
           snapshot->add_view_history(c->get_view_history(v));
         }
-
-        for (auto& it : maps)
-        {
-          auto& [_, map] = it.second;
-          map->unlock();
-        }
       }
 
       return snapshot;
@@ -332,7 +419,7 @@ namespace kv
       std::unique_ptr<AbstractSnapshot> snapshot) override
     {
       auto e = get_encryptor();
-      return snapshot->serialise(e);
+      return snapshot->serialise(e, parallel_for, record_map_sizes);
     }
 
     DeserialiseSuccess deserialise_snapshot(
@@ -378,6 +465,10 @@ namespace kv
       OrderedChanges changes;
       MapCollection new_maps;
 
+      // Maps are read sequentially, and deserialised once all have been read
+      std::vector<std::pair<std::string, kv::untyped::Map::SerialisedSnapshot>>
+        serialised_maps;
+
       for (auto r = d.start_map(); r.has_value(); r = d.start_map())
       {
         const auto map_name = r.value();
@@ -411,12 +502,39 @@ namespace kv
           return DeserialiseSuccess::FAILED;
         }
 
-        auto deserialised_snapshot_changes =
-          map->deserialise_snapshot_changes(d);
+        changes[map_name] = {map, nullptr};
+        serialised_maps.emplace_back(map_name, map->read_snapshot(d));
+      }
 
-        // Take ownership of the produced change set, store it to be committed
-        // later
-        changes[map_name] = {map, std::move(deserialised_snapshot_changes)};
+      std::vector<kv::untyped::ChangeSetPtr> deserialised_maps(
+        serialised_maps.size());
+      std::vector<size_t> small_maps;
+      for (size_t i = 0; i < serialised_maps.size(); ++i)
+      {
+        const auto& serialised = serialised_maps[i].second;
+        if (serialised.state.size() >= large_map_snapshot_size)
+        {
+          deserialised_maps[i] =
+            kv::untyped::Map::deserialise_snapshot_changes(
+              serialised, parallel_for);
+        }
+        else
+        {
+          small_maps.push_back(i);
+        }
+      }
+      threading::for_indices(parallel_for, small_maps.size(), [&](size_t i) {
+        const auto idx = small_maps[i];
+        deserialised_maps[idx] = kv::untyped::Map::deserialise_snapshot_changes(
+          serialised_maps[idx].second);
+      });
+
+      // Take ownership of the produced change sets, store them to be committed
+      // later
+      for (size_t i = 0; i < serialised_maps.size(); ++i)
+      {
+        changes[serialised_maps[i].first].changeset =
+          std::move(deserialised_maps[i]);
       }
 
       for (auto& it : maps)
@@ -477,28 +595,39 @@ namespace kv
         return;
       }
 
-      for (auto& it : maps)
+      // Maps committed to after this point are marked dirty again, and are
+      // compacted next time.
+      std::set<std::string> dirty_names;
       {
-        auto& [_, map] = it.second;
+        std::lock_guard<SpinLock> dguard(dirty_maps_lock);
+        dirty_names.swap(dirty_maps);
+      }
+      const auto dirty = find_maps(dirty_names);
+
+      for (auto& it : dirty)
+      {
+        auto& [_, map] = it->second;
         map->lock();
       }
 
-      for (auto& it : maps)
+      for (auto& it : dirty)
       {
-        auto& [_, map] = it.second;
+        auto& [_, map] = it->second;
         map->compact(v);
+        if (map->refresh_dirty())
+        {
+          mark_map_dirty(it->first);
+        }
       }
 
-      for (auto& it : maps)
+      for (auto& it : dirty)
       {
-        auto& [_, map] = it.second;
+        auto& [_, map] = it->second;
         map->unlock();
       }
 
       {
         std::lock_guard<SpinLock> vguard(version_lock);
-        compacted = v;
-
         auto h = get_history();
         if (h)
         {
@@ -512,11 +641,18 @@ namespace kv
         }
       }
 
-      for (auto& it : maps)
+      for (auto& it : dirty)
       {
-        auto& [_, map] = it.second;
+        auto& [_, map] = it->second;
         map->post_compact();
       }
+
+      // The compacted version is only updated once the global hooks have run,
+      // so that state built by those hooks is complete up to commit_version()
+      {
+        std::lock_guard<SpinLock> vguard(version_lock);
+        compacted = v;
+      }
     }
 
     void rollback(Version v, std::optional<Term> t = std::nullopt) override
@@ -544,38 +680,50 @@ namespace kv
           commit_version()));
       }
 
-      for (auto& it : maps)
+      // Every map with commits after v, including those created after v, has
+      // been committed to since it was last compacted, so is dirty.
+      std::set<std::string> dirty_names;
       {
-        auto& [_, map] = it.second;
+        std::lock_guard<SpinLock> dguard(dirty_maps_lock);
+        dirty_names = dirty_maps;
+      }
+      const auto dirty = find_maps(dirty_names);
+
+      for (auto& it : dirty)
+      {
+        auto& [_, map] = it->second;
         map->lock();
       }
 
-      auto it = maps.begin();
-      while (it != maps.end())
+      for (auto& it : dirty)
       {
-        auto& [map_creation_version, map] = it->second;
         // Rollback this map whether we're forgetting about it or not. Anyone
         // else still holding it should see it has rolled back
+        auto& [_, map] = it->second;
         map->rollback(v);
+      }
+
+      for (auto& it : dirty)
+      {
+        auto& [_, map] = it->second;
+        map->unlock();
+      }
+
+      for (auto& it : dirty)
+      {
+        const auto& [map_creation_version, _] = it->second;
         if (map_creation_version > v)
         {
           // Map was created more recently; its creation is being forgotten.
           // Erase our knowledge of it
-          map->unlock();
-          it = maps.erase(it);
-        }
-        else
-        {
-          ++it;
+          {
+            std::lock_guard<SpinLock> dguard(dirty_maps_lock);
+            dirty_maps.erase(it->first);
+          }
+          maps.erase(it);
         }
       }
 
-      for (auto& it : maps)
-      {
-        auto& [_, map] = it.second;
-        map->unlock();
-      }
-
       std::lock_guard<SpinLock> vguard(version_lock);
       version = v;
       last_replicated = v;
@@ -596,13 +744,17 @@ namespace kv
       term = t;
     }
 
+    // If selected_maps is set, only the changes to those maps are applied.
+    // Changes to other maps are skipped without being parsed, where the
+    // transaction records the size of each map.
     DeserialiseSuccess deserialise_views(
       const std::vector<uint8_t>& data,
       bool public_only = false,
       Term* term_ = nullptr,
       Version* index_ = nullptr,
       AbstractChangeContainer* tx = nullptr,
-      ccf::PrimarySignature* sig = nullptr)
+      ccf::PrimarySignature* sig = nullptr,
+      const std::optional<std::set<std::string>>& selected_maps = std::nullopt)
     {
       // If we pass in a transaction we don't want to commit, just deserialise
       // and put the views into that transaction.
@@ -658,6 +810,14 @@ namespace kv
       {
         const auto map_name = r.value();
 
+        if (
+          selected_maps.has_value() &&
+          selected_maps->find(map_name) == selected_maps->end())
+        {
+          d.skip_map();
+          continue;
+        }
+
         auto map = get_map_internal(v, map_name);
         if (map == nullptr)
         {
@@ -882,6 +1042,14 @@ namespace kv
       return success;
     }
 
+    DeserialiseSuccess deserialise_selected_maps(
+      const std::vector<uint8_t>& data,
+      const std::set<std::string>& selected_maps)
+    {
+      return deserialise_views(
+        data, false, nullptr, nullptr, nullptr, nullptr, selected_maps);
+    }
+
     DeserialiseSuccess deserialise(
       const std::vector<uint8_t>& data,
       bool public_only = false,
@@ -957,6 +1125,9 @@ namespace kv
         return CommitSuccess::OK;
       }
 
+      tracing::ScopedSpan span(tracing::SpanKind::StoreCommit);
+      span.set_seqno(txid.version);
+
       LOG_DEBUG_FMT(
         "Store::commit {}{}",
         txid.version,
@@ -983,6 +1154,13 @@ namespace kv
         if (globally_committable && txid.version > last_committable)
           last_committable = txid.version;
 
+        if (tracing::current_trace != 0)
+        {
+          // Acknowledged and committed by consensus once replicated
+          tracing::PendingTraces::instance().add(
+            txid.version, tracing::current_trace, tracing::config::now_us());
+        }
+
         pending_txs.insert(
           {txid.version,
            std::make_pair(std::move(pending_tx), globally_committable)});
@@ -1031,7 +1209,14 @@ namespace kv
         replication_view = term;
       }
 
-      if (c->replicate(batch, replication_view))
+      bool replicated = false;
+      {
+        tracing::ScopedSpan replicate_span(tracing::SpanKind::Replicate);
+        replicate_span.set_seqno(txid.version);
+        replicated = c->replicate(batch, replication_view);
+      }
+
+      if (replicated)
       {
         std::lock_guard<SpinLock> vguard(version_lock);
         if (
@@ -1174,6 +1359,8 @@ namespace kv
       for (auto& [name, lhs, rhs] : entries)
       {
         lhs->swap(rhs);
+        mark_map_dirty(name);
+        store.mark_map_dirty(name);
       }
 
       for (auto& [name, lhs, rhs] : entries)
@@ -1218,6 +1405,16 @@ namespace kv
       }
     }
 
+    kv::untyped::Map::CommitHook get_global_hook(const std::string& map_name)
+    {
+      const auto it = global_hooks.find(map_name);
+      if (it == global_hooks.end())
+      {
+        return nullptr;
+      }
+      return it->second;
+    }
+
     void unset_global_hook(const std::string& map_name)
     {
       global_hooks.erase(map_name);
@@ -2,14 +2,20 @@
 // Licensed under the Apache 2.0 License.
 #define PICOBENCH_IMPLEMENT_WITH_MAIN
 
+#include "ds/thread_messaging.h"
 #include "kv/store.h"
 #include "kv/test/stub_consensus.h"
 #include "kv/tx.h"
+#include "kv/value_spill.h"
 #include "node/encryptor.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <msgpack/msgpack.hpp>
 #include <picobench/picobench.hpp>
 #include <string>
+#include <thread>
 
 using KeyType = kv::serialisers::SerialisedEntry;
 using ValueType = kv::serialisers::SerialisedEntry;
@@ -38,6 +44,8 @@ ValueType gen_value(size_t i)
   return ValueType(raw, raw + buf.size());
 }
 
+std::atomic<uint16_t> threading::ThreadMessaging::thread_count = 0;
+
 // Helper functions to use a dummy encryption key
 std::shared_ptr<ccf::LedgerSecrets> create_ledger_secrets()
 {
@@ -129,6 +137,50 @@ static void deserialise(picobench::state& s)
   s.stop_timer();
 }
 
+// Deserialises a transaction writing to s.iterations() maps, either into every
+// map or only into the first of them. Skipped maps are not parsed, so
+// selective deserialisation should not grow with the number of maps.
+template <bool SELECTED>
+static void deserialise_many_maps(picobench::state& s)
+{
+  logger::config::level() = logger::INFO;
+
+  auto consensus = std::make_shared<kv::StubConsensus>();
+  kv::Store kv_store(consensus);
+  kv::Store kv_store2;
+
+  auto secrets = create_ledger_secrets();
+  auto encryptor = std::make_shared<ccf::CftTxEncryptor>(secrets);
+  encryptor->set_iv_id(1);
+  kv_store.set_encryptor(encryptor);
+  kv_store2.set_encryptor(encryptor);
+  kv_store.set_record_map_sizes(true);
+
+  constexpr size_t writes_per_map = 10;
+  const auto first_map = build_map_name("map0", kv::SecurityDomain::PUBLIC);
+
+  auto tx = kv_store.create_tx();
+  for (int m = 0; m < s.iterations(); m++)
+  {
+    auto view = tx.get_view<MapType>(
+      build_map_name(fmt::format("map{}", m), kv::SecurityDomain::PUBLIC));
+    for (size_t i = 0; i < writes_per_map; i++)
+    {
+      view->put(gen_key(i), gen_value(i));
+    }
+  }
+  tx.commit();
+  const auto data = consensus->get_latest_data().value();
+
+  s.start_timer();
+  auto rc = SELECTED ? kv_store2.deserialise_selected_maps(data, {first_map}) :
+                       kv_store2.deserialise(data);
+  if (rc != kv::DeserialiseSuccess::PASS)
+    throw std::logic_error(
+      "Transaction deserialisation failed: " + std::to_string(rc));
+  s.stop_timer();
+}
+
 template <size_t S>
 static void commit_latency(picobench::state& s)
 {
@@ -239,6 +291,409 @@ static void des_snap(picobench::state& s)
   s.stop_timer();
 }
 
+// Runs a thread messaging with THREADS - 1 worker threads, alongside the
+// calling thread, and uses it to serialise and load the snapshots of store
+template <uint16_t THREADS>
+class SnapshotThreads
+{
+  threading::ThreadMessaging tm;
+  std::vector<std::thread> workers;
+
+public:
+  SnapshotThreads(kv::Store& store) : tm(THREADS)
+  {
+    threading::ThreadMessaging::thread_count = THREADS;
+    for (uint16_t tid = 1; tid < THREADS; ++tid)
+    {
+      workers.emplace_back([this, tid]() {
+        threading::thread_id = tid;
+        tm.run();
+      });
+    }
+
+    store.set_parallel_for(
+      [this](size_t n, const std::function<void(size_t)>& fn) {
+        tm.parallel_for(n, fn);
+      });
+  }
+
+  ~SnapshotThreads()
+  {
+    tm.set_finished();
+    for (auto& w : workers)
+    {
+      w.join();
+    }
+    tm.drop_tasks();
+    threading::ThreadMessaging::thread_count = 0;
+  }
+};
+
+// Commits one large map of key_count entries, serialised one subtree per
+// thread, and many small maps, serialised one map per thread
+static kv::Version populate_snapshot_store(kv::Store& store, size_t key_count)
+{
+  constexpr size_t small_map_count = 100;
+  constexpr size_t small_map_key_count = 100;
+
+  auto tx = store.create_tx();
+  auto large_view = tx.get_view<MapType>("large_map");
+  for (size_t i = 0; i < key_count; i++)
+  {
+    large_view->put(gen_key(i), gen_value(i));
+  }
+  for (size_t i = 0; i < small_map_count; i++)
+  {
+    auto view = tx.get_view<MapType>(fmt::format("map{}", i));
+    for (size_t j = 0; j < small_map_key_count; j++)
+    {
+      view->put(gen_key(j), gen_value(j));
+    }
+  }
+
+  auto rc = tx.commit();
+  if (rc != kv::CommitSuccess::OK)
+    throw std::logic_error("Transaction commit failed: " + std::to_string(rc));
+  return tx.commit_version();
+}
+
+template <uint16_t THREADS>
+static void par_ser_snap(picobench::state& s)
+{
+  logger::config::level() = logger::INFO;
+
+  kv::Store kv_store;
+  auto secrets = create_ledger_secrets();
+  auto encryptor = std::make_shared<ccf::CftTxEncryptor>(secrets);
+  encryptor->set_iv_id(1);
+  kv_store.set_encryptor(encryptor);
+  SnapshotThreads<THREADS> threads(kv_store);
+
+  const auto version = populate_snapshot_store(kv_store, s.iterations());
+
+  s.start_timer();
+  auto snap = kv_store.snapshot(version);
+  kv_store.serialise_snapshot(std::move(snap));
+  s.stop_timer();
+}
+
+template <uint16_t THREADS>
+static void par_des_snap(picobench::state& s)
+{
+  logger::config::level() = logger::INFO;
+
+  kv::Store kv_store;
+  kv::Store kv_store2;
+  auto secrets = create_ledger_secrets();
+  auto encryptor = std::make_shared<ccf::CftTxEncryptor>(secrets);
+  encryptor->set_iv_id(1);
+  kv_store.set_encryptor(encryptor);
+  kv_store2.set_encryptor(encryptor);
+  SnapshotThreads<THREADS> threads(kv_store2);
+
+  const auto version = populate_snapshot_store(kv_store, s.iterations());
+  auto snap = kv_store.snapshot(version);
+  auto serialised_snap = kv_store.serialise_snapshot(std::move(snap));
+
+  s.start_timer();
+  kv_store2.deserialise_snapshot(serialised_snap);
+  s.stop_timer();
+}
+
+// Commit latency on a store holding MAP_COUNT maps, when each transaction
+// writes to one of a few hot maps and the store is compacted after every
+// transaction. Compaction should only visit the maps written since the last
+// compaction, so the tail latency should not grow with the number of maps.
+template <size_t MAP_COUNT>
+static void dynamic_tables(picobench::state& s)
+{
+  logger::config::level() = logger::INFO;
+
+  kv::Store kv_store;
+  auto secrets = create_ledger_secrets();
+  auto encryptor = std::make_shared<ccf::CftTxEncryptor>(secrets);
+  encryptor->set_iv_id(1);
+  kv_store.set_encryptor(encryptor);
+
+  {
+    auto tx = kv_store.create_tx();
+    for (size_t i = 0; i < MAP_COUNT; i++)
+    {
+      auto view = tx.get_view<MapType>(fmt::format("map{}", i));
+      view->put(gen_key(0), gen_value(0));
+    }
+
+    auto rc = tx.commit();
+    if (rc != kv::CommitSuccess::OK)
+      throw std::logic_error(
+        "Transaction commit failed: " + std::to_string(rc));
+    kv_store.compact(kv_store.current_version());
+  }
+
+  constexpr size_t hot_maps = 10;
+  std::vector<std::chrono::nanoseconds> latencies;
+  latencies.reserve(s.iterations());
+
+  size_t i = 0;
+  s.start_timer();
+  for (auto _ : s)
+  {
+    (void)_;
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view<MapType>(fmt::format("map{}", i % hot_maps));
+    view->put(gen_key(i), gen_value(i));
+    auto rc = tx.commit();
+    if (rc != kv::CommitSuccess::OK)
+      throw std::logic_error(
+        "Transaction commit failed: " + std::to_string(rc));
+    kv_store.compact(kv_store.current_version());
+
+    latencies.push_back(std::chrono::high_resolution_clock::now() - start);
+    ++i;
+  }
+  s.stop_timer();
+
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << fmt::format(
+                 "dynamic_tables maps={} n={} : p50 {}ns, p99 {}ns, max {}ns",
+                 MAP_COUNT,
+                 latencies.size(),
+                 latencies[latencies.size() / 2].count(),
+                 latencies[latencies.size() * 99 / 100].count(),
+                 latencies.back().count())
+            << std::endl;
+}
+
+// Several threads increment a few hot counters, either by reading and writing
+// each counter and retrying on conflict, or by merging an increment into it.
+// Reports the proportion of executions which were wasted on conflicts.
+template <bool MERGE>
+static void increment_counters(picobench::state& s)
+{
+  logger::config::level() = logger::INFO;
+
+  kv::Store kv_store;
+  auto secrets = create_ledger_secrets();
+  auto encryptor = std::make_shared<ccf::CftTxEncryptor>(secrets);
+  encryptor->set_iv_id(1);
+  kv_store.set_encryptor(encryptor);
+
+  using Counters = kv::Map<size_t, int64_t>;
+  Counters counters("counters");
+
+  constexpr size_t thread_count = 4;
+  constexpr size_t hot_counters = 4;
+
+  {
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view(counters);
+    for (size_t k = 0; k < hot_counters; k++)
+    {
+      view->put(k, 0);
+    }
+    auto rc = tx.commit();
+    if (rc != kv::CommitSuccess::OK)
+      throw std::logic_error(
+        "Transaction commit failed: " + std::to_string(rc));
+  }
+
+  const size_t tx_per_thread = s.iterations() / thread_count;
+  std::atomic<size_t> conflicts(0);
+
+  auto increment = [&](size_t thread_id) {
+    for (size_t i = 0; i < tx_per_thread; i++)
+    {
+      const auto k = (thread_id + i) % hot_counters;
+      while (true)
+      {
+        auto tx = kv_store.create_tx();
+        auto view = tx.get_view(counters);
+        if constexpr (MERGE)
+        {
+          view->add(k, 1);
+        }
+        else
+        {
+          view->put(k, view->get(k).value_or(0) + 1);
+        }
+
+        if (tx.commit() == kv::CommitSuccess::OK)
+        {
+          break;
+        }
+        ++conflicts;
+      }
+    }
+  };
+
+  s.start_timer();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < thread_count; t++)
+  {
+    threads.emplace_back(increment, t);
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  s.stop_timer();
+
+  const auto committed = tx_per_thread * thread_count;
+  std::cout << fmt::format(
+                 "increment_counters merge={} n={} : {} conflicts, {:.1f}% of "
+                 "executions wasted",
+                 MERGE,
+                 committed,
+                 conflicts.load(),
+                 100.0 * conflicts.load() / (committed + conflicts.load()))
+            << std::endl;
+}
+
+// Store holding a map of 1M entries, populated once and shared by all samples
+template <typename M>
+static kv::Store& get_range_store()
+{
+  static kv::Store kv_store;
+  static bool populated = false;
+  if (!populated)
+  {
+    auto secrets = create_ledger_secrets();
+    auto encryptor = std::make_shared<ccf::CftTxEncryptor>(secrets);
+    encryptor->set_iv_id(1);
+    kv_store.set_encryptor(encryptor);
+
+    M map("public:range");
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view(map);
+    for (size_t k = 0; k < 1'000'000; k++)
+    {
+      view->put(k, k);
+    }
+    auto rc = tx.commit();
+    if (rc != kv::CommitSuccess::OK)
+      throw std::logic_error(
+        "Transaction commit failed: " + std::to_string(rc));
+    populated = true;
+  }
+  return kv_store;
+}
+
+// Reads RANGE consecutive entries of a map of 1M entries, either by iterating
+// over that range of an ordered map, or by iterating over the whole of an
+// unordered map and filtering its entries
+template <typename M, size_t RANGE>
+static void range_scan(picobench::state& s)
+{
+  logger::config::level() = logger::INFO;
+
+  auto& kv_store = get_range_store<M>();
+  M map("public:range");
+
+  size_t from = 0;
+  size_t sum = 0;
+  s.start_timer();
+  for (auto _ : s)
+  {
+    (void)_;
+    from = (from + 7919) % (1'000'000 - RANGE);
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view(map);
+    auto f = [&sum](const size_t&, const size_t& v) {
+      sum += v;
+      return true;
+    };
+    if constexpr (M::TxView::is_ordered)
+    {
+      view->foreach_range(from, from + RANGE, f);
+    }
+    else
+    {
+      view->foreach([&](const size_t& k, const size_t& v) {
+        if (k >= from && k < from + RANGE)
+        {
+          f(k, v);
+        }
+        return true;
+      });
+    }
+    clobber_memory();
+  }
+  s.stop_timer();
+}
+
+// Reads values from a state of 16MB, of which 90% of reads fall in a working
+// set of 1MB. With a value spill, values are sealed outside the enclave once
+// committed, and faulted back in through a 2MB cache. Reports the hit rate of
+// the cache.
+template <bool SPILL>
+static void tiered_reads(picobench::state& s)
+{
+  logger::config::level() = logger::INFO;
+
+  constexpr size_t total_keys = 4096;
+  constexpr size_t working_set_keys = 256;
+  constexpr size_t value_size = 4096;
+  constexpr size_t cache_capacity = 2 * 1024 * 1024;
+
+  kv::Store kv_store;
+  auto spill = std::make_shared<kv::ValueSpill>(
+    std::vector<uint8_t>(32, 1), value_size / 2, cache_capacity);
+  if constexpr (SPILL)
+  {
+    kv_store.set_value_spill(spill);
+  }
+
+  using Values = kv::Map<size_t, std::vector<uint8_t>>;
+  Values values("public:values");
+  for (size_t k = 0; k < total_keys;)
+  {
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view(values);
+    for (size_t end = k + working_set_keys; k < end; ++k)
+    {
+      view->put(k, std::vector<uint8_t>(value_size, k));
+    }
+    auto rc = tx.commit();
+    if (rc != kv::CommitSuccess::OK)
+      throw std::logic_error(
+        "Transaction commit failed: " + std::to_string(rc));
+    kv_store.compact(kv_store.current_version());
+  }
+
+  const auto before = spill->get_stats();
+  uint64_t rng = 42;
+  size_t sum = 0;
+  s.start_timer();
+  for (auto _ : s)
+  {
+    (void)_;
+    rng = rng * 6364136223846793005ull + 1442695040888963407ull;
+    const auto r = rng >> 33;
+    const auto k = (r % 10 == 0) ? r % total_keys : r % working_set_keys;
+
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view(values);
+    sum += view->get(k)->front();
+    clobber_memory();
+  }
+  s.stop_timer();
+
+  const auto stats = spill->get_stats();
+  const auto hits = stats.hits - before.hits;
+  const auto misses = stats.misses - before.misses;
+  std::cout << fmt::format(
+                 "tiered_reads spill={} n={} : {} spilled values, {:.1f}MB "
+                 "spilled, {:.1f}% cache hits",
+                 SPILL,
+                 s.iterations(),
+                 stats.spilled_values,
+                 stats.spilled_bytes / 1e6,
+                 hits + misses == 0 ? 0. : 100.0 * hits / (hits + misses))
+            << std::endl;
+}
+
 const std::vector<int> tx_count = {10, 100, 1000};
 const uint32_t sample_size = 100;
 
@@ -262,6 +717,17 @@ PICOBENCH(deserialise<SD::PUBLIC>)
   .baseline();
 PICOBENCH(deserialise<SD::PRIVATE>).iterations(tx_count).samples(sample_size);
 
+const std::vector<int> tx_map_count = {10, 100, 1000};
+
+PICOBENCH_SUITE("deserialise_many_maps");
+PICOBENCH(deserialise_many_maps<false>)
+  .iterations(tx_map_count)
+  .samples(sample_size)
+  .baseline();
+PICOBENCH(deserialise_many_maps<true>)
+  .iterations(tx_map_count)
+  .samples(sample_size);
+
 const uint32_t snapshot_sample_size = 10;
 const std::vector<int> map_count = {20, 100};
 
@@ -277,4 +743,101 @@ PICOBENCH(des_snap<100>)
   .iterations(map_count)
   .samples(snapshot_sample_size)
   .baseline();
-PICOBENCH(des_snap<1000>).iterations(map_count).samples(snapshot_sample_size);
\ No newline at end of file
+PICOBENCH(des_snap<1000>).iterations(map_count).samples(snapshot_sample_size);
+
+const std::vector<int> parallel_snapshot_key_count = {100000, 1000000};
+const uint32_t parallel_snapshot_sample_size = 3;
+
+PICOBENCH_SUITE("parallel_serialise_snapshot");
+PICOBENCH(par_ser_snap<1>)
+  .iterations(parallel_snapshot_key_count)
+  .samples(parallel_snapshot_sample_size)
+  .baseline();
+PICOBENCH(par_ser_snap<2>)
+  .iterations(parallel_snapshot_key_count)
+  .samples(parallel_snapshot_sample_size);
+PICOBENCH(par_ser_snap<4>)
+  .iterations(parallel_snapshot_key_count)
+  .samples(parallel_snapshot_sample_size);
+PICOBENCH(par_ser_snap<8>)
+  .iterations(parallel_snapshot_key_count)
+  .samples(parallel_snapshot_sample_size);
+
+PICOBENCH_SUITE("parallel_deserialise_snapshot");
+PICOBENCH(par_des_snap<1>)
+  .iterations(parallel_snapshot_key_count)
+  .samples(parallel_snapshot_sample_size)
+  .baseline();
+PICOBENCH(par_des_snap<2>)
+  .iterations(parallel_snapshot_key_count)
+  .samples(parallel_snapshot_sample_size);
+PICOBENCH(par_des_snap<4>)
+  .iterations(parallel_snapshot_key_count)
+  .samples(parallel_snapshot_sample_size);
+PICOBENCH(par_des_snap<8>)
+  .iterations(parallel_snapshot_key_count)
+  .samples(parallel_snapshot_sample_size);
+
+const std::vector<int> dynamic_tx_count = {1000, 10000};
+
+PICOBENCH_SUITE("dynamic_tables");
+PICOBENCH(dynamic_tables<10>)
+  .iterations(dynamic_tx_count)
+  .samples(snapshot_sample_size)
+  .baseline();
+PICOBENCH(dynamic_tables<1000>)
+  .iterations(dynamic_tx_count)
+  .samples(snapshot_sample_size);
+PICOBENCH(dynamic_tables<100000>)
+  .iterations(dynamic_tx_count)
+  .samples(snapshot_sample_size);
+
+const std::vector<int> contention_tx_count = {10000, 100000};
+
+PICOBENCH_SUITE("contention");
+PICOBENCH(increment_counters<false>)
+  .iterations(contention_tx_count)
+  .samples(snapshot_sample_size)
+  .baseline();
+PICOBENCH(increment_counters<true>)
+  .iterations(contention_tx_count)
+  .samples(snapshot_sample_size);
+
+const std::vector<int> range_scan_count = {1, 10};
+const uint32_t range_sample_size = 3;
+using UnorderedNumNum = kv::Map<size_t, size_t>;
+using OrderedNumNum = kv::OrderedMap<size_t, size_t>;
+
+PICOBENCH_SUITE("range_scan_100");
+auto range_scan_unordered_100 = range_scan<UnorderedNumNum, 100>;
+PICOBENCH(range_scan_unordered_100)
+  .iterations(range_scan_count)
+  .samples(range_sample_size)
+  .baseline();
+auto range_scan_ordered_100 = range_scan<OrderedNumNum, 100>;
+PICOBENCH(range_scan_ordered_100)
+  .iterations(range_scan_count)
+  .samples(range_sample_size);
+
+PICOBENCH_SUITE("range_scan_10k");
+auto range_scan_unordered_10k = range_scan<UnorderedNumNum, 10000>;
+PICOBENCH(range_scan_unordered_10k)
+  .iterations(range_scan_count)
+  .samples(range_sample_size)
+  .baseline();
+auto range_scan_ordered_10k = range_scan<OrderedNumNum, 10000>;
+PICOBENCH(range_scan_ordered_10k)
+  .iterations(range_scan_count)
+  .samples(range_sample_size);
+
+const std::vector<int> tiered_read_count = {1000, 10000};
+const uint32_t tiered_sample_size = 3;
+
+PICOBENCH_SUITE("tiered_reads");
+PICOBENCH(tiered_reads<false>)
+  .iterations(tiered_read_count)
+  .samples(tiered_sample_size)
+  .baseline();
+PICOBENCH(tiered_reads<true>)
+  .iterations(tiered_read_count)
+  .samples(tiered_sample_size);
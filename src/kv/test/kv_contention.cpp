@@ -208,3 +208,65 @@ DOCTEST_TEST_CASE("Concurrent kv access" * doctest::test_suite("concurrency"))
     compact_thread.join();
   }
 }
+
+DOCTEST_TEST_CASE(
+  "Concurrent merges do not conflict" * doctest::test_suite("concurrency"))
+{
+  logger::config::level() = logger::INFO;
+
+  // Multiple threads increment a small set of shared counters. When the
+  // counters are updated by merges rather than read-modify-write, no
+  // transaction should conflict, and no increment should be lost
+  kv::Store kv_store;
+
+  using Counters = kv::Map<size_t, size_t>;
+  Counters counters("public:counters");
+
+  constexpr size_t thread_count = 8;
+  constexpr size_t tx_count = 1000;
+  constexpr size_t counter_count = 4;
+
+  {
+    // Create the map first, as concurrent creations of a map do conflict
+    auto tx = kv_store.create_tx();
+    tx.get_view(counters)->put(0, 0);
+    DOCTEST_REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+  }
+
+  std::atomic<size_t> conflicts(0);
+  std::vector<std::thread> threads;
+  for (size_t i = 0u; i < thread_count; ++i)
+  {
+    threads.emplace_back([&, i]() {
+      for (size_t j = 0u; j < tx_count; ++j)
+      {
+        auto tx = kv_store.create_tx();
+        auto view = tx.get_view(counters);
+        view->add((i + j) % counter_count, 1);
+
+        std::this_thread::yield();
+
+        if (tx.commit() != kv::CommitSuccess::OK)
+        {
+          ++conflicts;
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  DOCTEST_REQUIRE(conflicts.load() == 0);
+
+  auto tx = kv_store.create_tx();
+  auto view = tx.get_view(counters);
+  size_t total = 0;
+  for (size_t k = 0u; k < counter_count; ++k)
+  {
+    total += view->get(k).value_or(0);
+  }
+  DOCTEST_REQUIRE(total == thread_count * tx_count);
+}
@@ -613,3 +613,119 @@ TEST_CASE("Swapping dynamic maps" * doctest::test_suite("dynamic"))
     REQUIRE(val1.value() == "target");
   }
 }
+
+TEST_CASE(
+  "Compaction and rollback of many dynamic maps" *
+  doctest::test_suite("dynamic"))
+{
+  kv::Store kv_store;
+
+  auto encryptor = std::make_shared<kv::NullTxEncryptor>();
+  kv_store.set_encryptor(encryptor);
+
+  constexpr size_t map_count = 100;
+  auto map_name = [](size_t i) { return fmt::format("map_{}", i); };
+
+  std::vector<std::pair<kv::Version, std::string>> global_writes;
+  auto record_global_writes = [&global_writes](size_t i) {
+    return [&global_writes, i](kv::Version v, const kv::untyped::Write& w) {
+      for (const auto& [k, _] : w)
+      {
+        global_writes.emplace_back(
+          v, fmt::format("map_{}:{}", i, std::string(k.begin(), k.end())));
+      }
+    };
+  };
+
+  for (size_t i = 0; i < map_count; ++i)
+  {
+    kv_store.set_global_hook(map_name(i), record_global_writes(i));
+  }
+
+  auto write = [&](size_t i, const std::string& key) {
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view<kv::untyped::Map>(map_name(i));
+    view->put({key.begin(), key.end()}, {});
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+    return kv_store.current_version();
+  };
+
+  auto has_key = [&](size_t i, const std::string& key) {
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view<kv::untyped::Map>(map_name(i));
+    return view->has({key.begin(), key.end()});
+  };
+
+  for (size_t i = 0; i < map_count; ++i)
+  {
+    write(i, "a");
+  }
+  kv_store.compact(kv_store.current_version());
+  REQUIRE(global_writes.size() == map_count);
+
+  {
+    INFO("Only maps committed to since the last compaction are compacted");
+    global_writes.clear();
+    const auto v1 = write(3, "b");
+    const auto v2 = write(7, "b");
+    const auto v3 = write(3, "c");
+
+    kv_store.compact(v2);
+    REQUIRE(
+      global_writes ==
+      decltype(global_writes){{v1, "map_3:b"}, {v2, "map_7:b"}});
+
+    INFO("Maps with state after the compaction point remain dirty");
+    global_writes.clear();
+    kv_store.compact(v3);
+    REQUIRE(global_writes == decltype(global_writes){{v3, "map_3:c"}});
+
+    global_writes.clear();
+    kv_store.compact(v3);
+    REQUIRE(global_writes.empty());
+  }
+
+  {
+    INFO("Rollback reaches maps committed to since the last compaction");
+    const auto before = kv_store.current_version();
+    write(5, "d");
+    write(map_count, "d");
+    const auto v = write(5, "e");
+
+    kv_store.rollback(v - 1);
+    REQUIRE(has_key(5, "d"));
+    REQUIRE_FALSE(has_key(5, "e"));
+    REQUIRE(has_key(map_count, "d"));
+
+    kv_store.rollback(before);
+    REQUIRE_FALSE(has_key(5, "d"));
+    REQUIRE(kv_store.get_map(before, map_name(map_count)) == nullptr);
+
+    global_writes.clear();
+    const auto v_after = write(5, "f");
+    kv_store.compact(v_after);
+    REQUIRE(global_writes == decltype(global_writes){{v_after, "map_5:f"}});
+  }
+
+  {
+    INFO("Snapshots contain every map, dirty or not");
+    write(11, "g");
+    const auto v = kv_store.current_version();
+    auto snapshot = kv_store.snapshot(v);
+    auto serialised = kv_store.serialise_snapshot(std::move(snapshot));
+
+    kv::Store new_store;
+    new_store.set_encryptor(encryptor);
+    REQUIRE(
+      new_store.deserialise_snapshot(serialised) ==
+      kv::DeserialiseSuccess::PASS);
+
+    for (size_t i = 0; i < map_count; ++i)
+    {
+      auto tx = new_store.create_tx();
+      auto view = tx.get_view<kv::untyped::Map>(map_name(i));
+      const std::string key = "a";
+      REQUIRE(view->has({key.begin(), key.end()}));
+    }
+  }
+}
@@ -222,6 +222,9 @@ struct CustomClass
 DECLARE_JSON_TYPE(CustomClass);
 DECLARE_JSON_REQUIRED_FIELDS(CustomClass, s, n);
 
+// This macro allows the typed binary serialiser to be used
+DECLARE_TYPED_BINARY_FIELDS(CustomClass, s, n);
+
 // Not really intended to be extended, but lets us use the BlitSerialiser for
 // this specific type
 namespace kv::serialisers
@@ -376,6 +379,8 @@ struct CustomVerboseDumbSerialiser
 using DefaultSerialisedMap = kv::Map<CustomClass, CustomClass>;
 using JsonSerialisedMap = kv::JsonSerialisedMap<CustomClass, CustomClass>;
 using RawCopySerialisedMap = kv::RawCopySerialisedMap<CustomClass, CustomClass>;
+using TypedBinarySerialisedMap =
+  kv::TypedBinarySerialisedMap<CustomClass, CustomClass>;
 using MixSerialisedMapA = kv::TypedMap<
   CustomClass,
   CustomClass,
@@ -414,6 +419,7 @@ TEST_CASE_TEMPLATE(
   DefaultSerialisedMap,
   JsonSerialisedMap,
   RawCopySerialisedMap,
+  TypedBinarySerialisedMap,
   MixSerialisedMapA,
   MixSerialisedMapB,
   MixSerialisedMapC,
@@ -463,6 +469,110 @@ TEST_CASE_TEMPLATE(
   }
 }
 
+enum class AccountKind : uint8_t
+{
+  CHECKING,
+  SAVINGS
+};
+
+struct Owner
+{
+  std::string name;
+  std::array<uint8_t, 4> id;
+};
+DECLARE_TYPED_BINARY_FIELDS(Owner, name, id);
+
+struct Account
+{
+  uint64_t number;
+  std::string name;
+  AccountKind kind;
+  std::vector<int64_t> history;
+  Owner owner;
+  double rate;
+  std::vector<uint8_t> notes;
+};
+DECLARE_TYPED_BINARY_FIELDS(
+  Account, number, name, kind, history, owner, rate, notes);
+
+TEST_CASE("Typed binary serialisation" * doctest::test_suite("serialisation"))
+{
+  using Serialiser = kv::serialisers::TypedBinarySerialiser<Account>;
+
+  const Account account{
+    42, "alice", AccountKind::SAVINGS, {1, -2, 3}, {"bob", {1, 2, 3, 4}}, 0.5};
+
+  INFO("Round trip");
+  {
+    const auto rep = Serialiser::to_serialised(account);
+    const auto a = Serialiser::from_serialised(rep);
+    REQUIRE(a.number == account.number);
+    REQUIRE(a.name == account.name);
+    REQUIRE(a.kind == account.kind);
+    REQUIRE(a.history == account.history);
+    REQUIRE(a.owner.name == account.owner.name);
+    REQUIRE(a.owner.id == account.owner.id);
+    REQUIRE(a.rate == account.rate);
+    REQUIRE(a.notes.empty());
+
+    INFO("Serialisation is deterministic");
+    REQUIRE(Serialiser::to_serialised(a) == rep);
+  }
+
+  INFO("Single fields are read in place");
+  {
+    const auto rep = Serialiser::to_serialised(account);
+    REQUIRE(Serialiser::read_field<&Account::number>(rep) == 42);
+    REQUIRE(Serialiser::read_field<&Account::name>(rep) == "alice");
+    REQUIRE(
+      Serialiser::read_field<&Account::kind>(rep) == AccountKind::SAVINGS);
+    REQUIRE(Serialiser::read_field<&Account::history>(rep) == account.history);
+    REQUIRE(Serialiser::read_field<&Account::owner>(rep).name == "bob");
+    REQUIRE(Serialiser::read_field<&Account::rate>(rep) == 0.5);
+    REQUIRE(Serialiser::read_field<&Account::notes>(rep).empty());
+  }
+
+  INFO("Truncated or corrupted entries are rejected");
+  {
+    auto rep = Serialiser::to_serialised(account);
+    auto truncated = rep;
+    truncated.resize(truncated.size() - 1);
+    REQUIRE_THROWS_AS(
+      Serialiser::from_serialised(truncated), std::logic_error);
+    REQUIRE_THROWS_AS(
+      Serialiser::read_field<&Account::notes>(truncated), std::logic_error);
+
+    truncated.resize(4);
+    REQUIRE_THROWS_AS(
+      Serialiser::read_field<&Account::number>(truncated), std::logic_error);
+
+    // Point the name out of the entry
+    const uint32_t offset = rep.size();
+    std::memcpy(rep.data() + sizeof(account.number), &offset, sizeof(offset));
+    REQUIRE_THROWS_AS(Serialiser::from_serialised(rep), std::logic_error);
+    REQUIRE(Serialiser::read_field<&Account::number>(rep) == 42);
+  }
+
+  INFO("Fields are read from views");
+  {
+    kv::Store store;
+    kv::TypedBinarySerialisedMap<std::string, Account> accounts(
+      "public:accounts");
+
+    auto tx = store.create_tx();
+    auto view = tx.get_view(accounts);
+    view->put("alice", account);
+    REQUIRE(view->get_field<&Account::history>("alice") == account.history);
+    REQUIRE(!view->get_field<&Account::history>("bob").has_value());
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+
+    auto tx2 = store.create_tx();
+    auto view2 = tx2.get_view(accounts);
+    REQUIRE(view2->get_field<&Account::name>("alice") == "alice");
+    REQUIRE(view2->get("alice")->owner.id == account.owner.id);
+  }
+}
+
 bool corrupt_serialised_tx(
   std::vector<uint8_t>& serialised_tx, std::vector<uint8_t>& value_to_corrupt)
 {
@@ -693,4 +803,101 @@ TEST_CASE("Exceptional serdes" * doctest::test_suite("serialisation"))
     auto bad_view = tx.get_view(bad_map_v);
     REQUIRE_THROWS(bad_view->put(0, {}));
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE(
+  "Deserialise selected maps" * doctest::test_suite("serialisation"))
+{
+  auto encryptor = std::make_shared<kv::NullTxEncryptor>();
+  auto consensus = std::make_shared<kv::StubConsensus>();
+
+  kv::Store store(consensus);
+  store.set_encryptor(encryptor);
+
+  SUBCASE("Without map sizes")
+  {
+    store.set_record_map_sizes(false);
+  }
+  SUBCASE("With map sizes")
+  {
+    store.set_record_map_sizes(true);
+  }
+
+  {
+    auto tx = store.create_tx();
+    auto [pub0, priv, pub1] =
+      tx.get_view<MapTypes::NumString, MapTypes::NumString, MapTypes::NumNum>(
+        "public:pub_map0", "priv_map", "public:pub_map1");
+    for (size_t i = 0; i < 10; ++i)
+    {
+      pub0->put(i, std::to_string(i));
+      priv->put(i, std::to_string(i));
+      pub1->put(i, i);
+    }
+    pub0->remove(0);
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+  }
+
+  const auto latest_data = consensus->get_latest_data();
+  REQUIRE(latest_data.has_value());
+
+  kv::Store target;
+  target.set_encryptor(encryptor);
+  REQUIRE(
+    target.deserialise_selected_maps(
+      latest_data.value(), {"priv_map", "public:pub_map1"}) ==
+    kv::DeserialiseSuccess::PASS);
+
+  auto tx = target.create_tx();
+  auto [pub0, priv, pub1] =
+    tx.get_view<MapTypes::NumString, MapTypes::NumString, MapTypes::NumNum>(
+      "public:pub_map0", "priv_map", "public:pub_map1");
+  REQUIRE_FALSE(pub0->get(1).has_value());
+  REQUIRE(priv->get(9) == "9");
+  REQUIRE(pub1->get(9) == 9);
+}
+
+TEST_CASE(
+  "Deserialise maps written without their size" *
+  doctest::test_suite("serialisation"))
+{
+#ifdef USE_NLJSON_KV_SERIALISER
+  kv::JsonWriter writer;
+#else
+  kv::MsgPackWriter writer;
+#endif
+
+  // Public-only transaction, as written before the size of each map was
+  // recorded
+  constexpr kv::Version version = 1;
+  writer.append(false);
+  writer.append(version);
+  for (const auto& name : {"public:skipped", "public:selected"})
+  {
+    writer.append(kv::KvOperationType::KOT_MAP_START_INDICATOR);
+    writer.append(std::string(name));
+    writer.append(kv::NoVersion);
+    writer.append(uint64_t(0));
+    writer.append(uint64_t(1));
+    writer.append_pre_serialised(
+      MapTypes::NumNum::KeySerialiser::to_serialised(42));
+    writer.append_pre_serialised(
+      MapTypes::NumNum::ValueSerialiser::to_serialised(43));
+    writer.append(uint64_t(1));
+    writer.append_pre_serialised(
+      MapTypes::NumNum::KeySerialiser::to_serialised(44));
+  }
+  const auto data = writer.get_raw_data();
+
+  kv::Store target;
+  REQUIRE(
+    target.deserialise_selected_maps(data, {"public:selected"}) ==
+    kv::DeserialiseSuccess::PASS);
+  REQUIRE(target.current_version() == version);
+
+  auto tx = target.create_tx();
+  auto [skipped, selected] = tx.get_view<MapTypes::NumNum, MapTypes::NumNum>(
+    "public:skipped", "public:selected");
+  REQUIRE_FALSE(skipped->get(42).has_value());
+  REQUIRE(selected->get(42) == 43);
+}
@@ -7,6 +7,7 @@
 #include "kv/tx.h"
 
 #include <doctest/doctest.h>
+#include <thread>
 
 struct MapTypes
 {
@@ -225,4 +226,139 @@ TEST_CASE("Commit hooks with snapshot" * doctest::test_suite("snapshot"))
       REQUIRE_EQ(writes.at("baz"), "baz");
     }
   }
-}
\ No newline at end of file
+}
+TEST_CASE("Ordered map snapshot" * doctest::test_suite("snapshot"))
+{
+  kv::Store store;
+  using Ordered = kv::OrderedMap<size_t, std::string>;
+  Ordered ordered("public:ordered");
+
+  {
+    auto tx1 = store.create_tx();
+    auto view_1 = tx1.get_view(ordered);
+    for (size_t k = 5; k > 0; --k)
+    {
+      view_1->put(k, std::to_string(k));
+    }
+    REQUIRE(tx1.commit() == kv::CommitSuccess::OK);
+
+    auto tx2 = store.create_tx();
+    tx2.get_view(ordered)->remove(3);
+    REQUIRE(tx2.commit() == kv::CommitSuccess::OK);
+  }
+
+  auto snapshot = store.snapshot(store.current_version());
+  auto serialised_snapshot = store.serialise_snapshot(std::move(snapshot));
+
+  auto range_keys = [&](kv::Store& s) {
+    auto tx = s.create_tx();
+    std::vector<size_t> keys;
+    tx.get_view(ordered)->foreach_range(
+      2, std::nullopt, [&keys](const auto& k, const auto&) {
+        keys.push_back(k);
+        return true;
+      });
+    return keys;
+  };
+
+  INFO("Apply snapshot to a store on which the map is already ordered");
+  {
+    kv::Store new_store;
+    REQUIRE(range_keys(new_store).empty());
+
+    REQUIRE_EQ(
+      new_store.deserialise_snapshot(serialised_snapshot),
+      kv::DeserialiseSuccess::PASS);
+    REQUIRE(range_keys(new_store) == std::vector<size_t>{2, 4, 5});
+  }
+
+  INFO("Apply snapshot to a new store");
+  {
+    kv::Store new_store;
+    REQUIRE_EQ(
+      new_store.deserialise_snapshot(serialised_snapshot),
+      kv::DeserialiseSuccess::PASS);
+    REQUIRE(range_keys(new_store) == std::vector<size_t>{2, 4, 5});
+  }
+}
+
+static void thread_per_index(size_t n, const std::function<void(size_t)>& fn)
+{
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < n; ++i)
+  {
+    threads.emplace_back(fn, i);
+  }
+  for (auto& t : threads)
+  {
+    t.join();
+  }
+}
+
+TEST_CASE("Parallel snapshot" * doctest::test_suite("snapshot"))
+{
+  kv::Store store;
+  constexpr size_t small_map_count = 20;
+  // Large enough for the map to be serialised and loaded in parallel
+  constexpr size_t large_map_size = 60000;
+
+  {
+    auto tx = store.create_tx();
+    auto large_view = tx.get_view<MapTypes::NumNum>("public:large_map");
+    for (size_t k = 0; k < large_map_size; ++k)
+    {
+      large_view->put(k, k * 2);
+    }
+    for (size_t i = 0; i < small_map_count; ++i)
+    {
+      auto view =
+        tx.get_view<MapTypes::StringString>(fmt::format("public:map{}", i));
+      view->put("key", std::to_string(i));
+    }
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+  }
+
+  auto serialised_snapshot =
+    store.serialise_snapshot(store.snapshot(store.current_version()));
+
+  INFO("Snapshot serialised in parallel is identical");
+  {
+    store.set_parallel_for(thread_per_index);
+    auto parallel_serialised_snapshot =
+      store.serialise_snapshot(store.snapshot(store.current_version()));
+    REQUIRE(parallel_serialised_snapshot == serialised_snapshot);
+  }
+
+  INFO("Snapshot loaded in parallel has the same contents");
+  {
+    kv::Store new_store;
+    new_store.set_parallel_for(thread_per_index);
+    REQUIRE_EQ(
+      new_store.deserialise_snapshot(serialised_snapshot),
+      kv::DeserialiseSuccess::PASS);
+    REQUIRE_EQ(new_store.current_version(), store.current_version());
+
+    auto tx = new_store.create_tx();
+    auto large_view = tx.get_view<MapTypes::NumNum>("public:large_map");
+    size_t count = 0;
+    large_view->foreach([&count](const auto& k, const auto& v) {
+      REQUIRE(v == k * 2);
+      ++count;
+      return true;
+    });
+    REQUIRE(count == large_map_size);
+
+    for (size_t i = 0; i < small_map_count; ++i)
+    {
+      auto view =
+        tx.get_view<MapTypes::StringString>(fmt::format("public:map{}", i));
+      REQUIRE(view->get("key") == std::to_string(i));
+    }
+
+    INFO("and serialises to the same snapshot");
+    REQUIRE(
+      new_store.serialise_snapshot(
+        new_store.snapshot(new_store.current_version())) ==
+      serialised_snapshot);
+  }
+}
@@ -0,0 +1,200 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#include "kv/store.h"
+#include "kv/test/null_encryptor.h"
+#include "kv/tx.h"
+#include "kv/value_spill.h"
+
+#include <doctest/doctest.h>
+#include <map>
+#include <string>
+
+using StringString = kv::Map<std::string, std::string>;
+
+constexpr size_t spill_threshold = 100;
+
+static const std::string small_value = "small";
+static const std::string large_value(1000, 'x');
+
+// Keeps track of the sealed values it holds, so that they can be tampered with
+class TrackedSpillStorage : public kv::HeapSpillStorage
+{
+public:
+  std::map<uint8_t*, size_t> allocated;
+
+  uint8_t* allocate(size_t size) override
+  {
+    auto data = kv::HeapSpillStorage::allocate(size);
+    allocated.emplace(data, size);
+    return data;
+  }
+
+  void deallocate(uint8_t* data, size_t size) override
+  {
+    allocated.erase(data);
+    kv::HeapSpillStorage::deallocate(data, size);
+  }
+};
+
+std::shared_ptr<kv::ValueSpill> make_spill(
+  size_t cache_capacity,
+  std::shared_ptr<kv::AbstractSpillStorage> storage =
+    std::make_shared<kv::HeapSpillStorage>())
+{
+  return std::make_shared<kv::ValueSpill>(
+    std::vector<uint8_t>(32, 1), spill_threshold, cache_capacity, storage);
+}
+
+void put(kv::Store& store, const std::string& k, const std::string& v)
+{
+  auto tx = store.create_tx();
+  auto view = tx.get_view<StringString>("public:map");
+  view->put(k, v);
+  REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+}
+
+std::optional<std::string> get(kv::Store& store, const std::string& k)
+{
+  auto tx = store.create_tx();
+  auto view = tx.get_view<StringString>("public:map");
+  return view->get(k);
+}
+
+TEST_CASE("Large values are spilled once compacted")
+{
+  kv::Store store;
+  auto spill = make_spill(0);
+  store.set_value_spill(spill);
+
+  put(store, "small", small_value);
+  put(store, "large", large_value);
+  REQUIRE(spill->get_stats().spilled_values == 0);
+
+  auto tx_before = store.create_tx();
+  auto view_before = tx_before.get_view<StringString>("public:map");
+
+  store.compact(store.current_version());
+  auto stats = spill->get_stats();
+  REQUIRE(stats.spilled_values == 1);
+  REQUIRE(stats.spilled_bytes >= large_value.size());
+  REQUIRE(stats.cached_bytes == 0);
+
+  INFO("Values are loaded when they are read");
+  REQUIRE(get(store, "small") == small_value);
+  REQUIRE(get(store, "large") == large_value);
+  REQUIRE(spill->get_stats().misses == 1);
+
+  INFO("Transactions started before compaction still read their state");
+  REQUIRE(view_before->get("large") == large_value);
+
+  INFO("Loaded values remain valid for the lifetime of the transaction");
+  {
+    auto tx = store.create_tx();
+    auto view = tx.get_view<StringString>("public:map");
+    std::map<std::string, std::string> values;
+    view->foreach([&values](const auto& k, const auto& v) {
+      values[k] = v;
+      return true;
+    });
+    REQUIRE(values.size() == 2);
+    REQUIRE(values["large"] == large_value);
+    REQUIRE(view->get("large") == view->get("large"));
+  }
+
+  INFO("Globally committed values are loaded");
+  {
+    auto tx = store.create_tx();
+    auto view = tx.get_view<StringString>("public:map");
+    REQUIRE(view->get_globally_committed("large") == large_value);
+  }
+}
+
+TEST_CASE("Spilled values are cached")
+{
+  kv::Store store;
+  auto spill = make_spill(3 * large_value.size());
+  store.set_value_spill(spill);
+
+  for (size_t i = 0; i < 10; ++i)
+  {
+    put(store, std::to_string(i), large_value + std::to_string(i));
+  }
+  store.compact(store.current_version());
+
+  auto stats = spill->get_stats();
+  REQUIRE(stats.spilled_values == 10);
+  REQUIRE(stats.cached_bytes <= 3 * large_value.size());
+
+  INFO("Reading a small working set only misses once per value");
+  for (size_t round = 0; round < 5; ++round)
+  {
+    for (size_t i = 0; i < 2; ++i)
+    {
+      REQUIRE(get(store, std::to_string(i)) == large_value + std::to_string(i));
+    }
+  }
+  stats = spill->get_stats();
+  REQUIRE(stats.misses == 2);
+  REQUIRE(stats.hits == 8);
+}
+
+TEST_CASE("Spilled values are freed once no state refers to them")
+{
+  kv::Store store;
+  auto storage = std::make_shared<TrackedSpillStorage>();
+  auto spill = make_spill(0, storage);
+  store.set_value_spill(spill);
+
+  put(store, "large", large_value);
+  store.compact(store.current_version());
+  REQUIRE(storage->allocated.size() == 1);
+
+  put(store, "large", large_value + large_value);
+  store.compact(store.current_version());
+  REQUIRE(storage->allocated.size() == 1);
+  REQUIRE(spill->get_stats().spilled_values == 1);
+  REQUIRE(get(store, "large") == large_value + large_value);
+
+  put(store, "large", small_value);
+  store.compact(store.current_version());
+  REQUIRE(storage->allocated.empty());
+  REQUIRE(spill->get_stats().spilled_bytes == 0);
+}
+
+TEST_CASE("Tampered spilled values are not loaded")
+{
+  kv::Store store;
+  auto storage = std::make_shared<TrackedSpillStorage>();
+  store.set_value_spill(make_spill(0, storage));
+
+  put(store, "large", large_value);
+  store.compact(store.current_version());
+  REQUIRE(storage->allocated.size() == 1);
+
+  auto [data, size] = *storage->allocated.begin();
+  data[size / 2] ^= 1;
+  REQUIRE_THROWS_AS(get(store, "large"), std::logic_error);
+}
+
+TEST_CASE("Spilled values are snapshotted and spilled on snapshot install")
+{
+  kv::Store store;
+  store.set_value_spill(make_spill(0));
+
+  put(store, "small", small_value);
+  put(store, "large", large_value);
+  store.compact(store.current_version());
+
+  auto snapshot = store.snapshot(store.current_version());
+  auto serialised = store.serialise_snapshot(std::move(snapshot));
+
+  kv::Store new_store;
+  auto new_spill = make_spill(0);
+  new_store.set_value_spill(new_spill);
+  REQUIRE(
+    new_store.deserialise_snapshot(serialised) == kv::DeserialiseSuccess::PASS);
+  REQUIRE(new_spill->get_stats().spilled_values == 1);
+
+  REQUIRE(get(new_store, "small") == small_value);
+  REQUIRE(get(new_store, "large") == large_value);
+}
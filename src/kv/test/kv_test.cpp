@@ -5,6 +5,7 @@
 #include "kv/kv_serialiser.h"
 #include "kv/store.h"
 #include "kv/test/null_encryptor.h"
+#include "kv/test/stub_consensus.h"
 #include "node/entities.h"
 #include "node/history.h"
 
@@ -1268,11 +1269,22 @@ TEST_CASE("Conflict resolution")
     confirm_state({"baz"}, {"bar"});
   }
 
+  REQUIRE(!tx2.get_conflicting_key().has_value());
+
   // Trying to commit first transaction produces a conflict
   auto res1 = tx1.commit();
   REQUIRE(res1 == kv::CommitSuccess::CONFLICT);
   confirm_state({"baz"}, {"bar"});
 
+  {
+    // The conflict is reported on the key which was read
+    const auto& conflict = tx1.get_conflicting_key();
+    REQUIRE(conflict.has_value());
+    REQUIRE(conflict->map_name == "public:map");
+    using KS = MapTypes::StringString::KeySerialiser;
+    REQUIRE(KS::from_serialised(conflict->key) == "foo");
+  }
+
   // A third transaction just wants to read the value
   auto tx3 = kv_store.create_tx();
   auto view3 = tx3.get_view(map);
@@ -1285,6 +1297,7 @@ TEST_CASE("Conflict resolution")
   res1 = tx1.commit();
   REQUIRE(res1 == kv::CommitSuccess::OK);
   confirm_state({"baz", "buzz"}, {"bar"});
+  REQUIRE(!tx1.get_conflicting_key().has_value());
 
   // Third transaction completes later, has no conflicts but reports the earlier
   // version it read
@@ -1299,6 +1312,360 @@ TEST_CASE("Conflict resolution")
   REQUIRE_THROWS(tx2.commit());
 }
 
+TEST_CASE("Merges")
+{
+  auto consensus = std::make_shared<kv::StubConsensus>();
+  auto encryptor = std::make_shared<kv::NullTxEncryptor>();
+  kv::Store kv_store(consensus);
+  kv_store.set_encryptor(encryptor);
+
+  using Counters = kv::Map<std::string, int64_t>;
+  Counters counters("public:counters");
+
+  auto get_counter = [&](const std::string& k) {
+    auto tx = kv_store.create_tx();
+    return tx.get_view(counters)->get(k);
+  };
+
+  {
+    INFO("Merges into missing keys are applied to nullopt");
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view(counters);
+    REQUIRE(view->add("a", 5));
+    REQUIRE(view->min("b", 10));
+    REQUIRE(view->max("c", -10));
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+
+    REQUIRE(get_counter("a") == 5);
+    REQUIRE(get_counter("b") == 10);
+    REQUIRE(get_counter("c") == -10);
+  }
+
+  {
+    INFO("Concurrent merges into the same key do not conflict");
+    auto tx1 = kv_store.create_tx();
+    auto tx2 = kv_store.create_tx();
+    auto tx3 = kv_store.create_tx();
+
+    tx1.get_view(counters)->add("a", 1);
+    tx2.get_view(counters)->add("a", 10);
+    auto view3 = tx3.get_view(counters);
+    view3->min("b", 3);
+    view3->max("c", 7);
+
+    REQUIRE(tx2.commit() == kv::CommitSuccess::OK);
+    REQUIRE(tx1.commit() == kv::CommitSuccess::OK);
+    REQUIRE(tx3.commit() == kv::CommitSuccess::OK);
+
+    REQUIRE(get_counter("a") == 16);
+    REQUIRE(get_counter("b") == 3);
+    REQUIRE(get_counter("c") == 7);
+  }
+
+  {
+    INFO("A merge does not conflict with a concurrent read-modify-write");
+    auto tx1 = kv_store.create_tx();
+    auto tx2 = kv_store.create_tx();
+
+    auto view1 = tx1.get_view(counters);
+    view1->put("a", view1->get("a").value() * 2);
+    tx2.get_view(counters)->add("a", 1);
+
+    REQUIRE(tx1.commit() == kv::CommitSuccess::OK);
+    REQUIRE(tx2.commit() == kv::CommitSuccess::OK);
+    REQUIRE(get_counter("a") == 33);
+  }
+
+  {
+    INFO("Reading a merged key applies the merges and records a read");
+    auto tx1 = kv_store.create_tx();
+    auto tx2 = kv_store.create_tx();
+
+    auto view1 = tx1.get_view(counters);
+    view1->add("a", 1);
+    view1->add("a", 1);
+    REQUIRE(view1->get("a") == 35);
+    view1->add("a", 1);
+    REQUIRE(view1->get("a") == 36);
+
+    tx2.get_view(counters)->add("a", 100);
+    REQUIRE(tx2.commit() == kv::CommitSuccess::OK);
+    REQUIRE(tx1.commit() == kv::CommitSuccess::CONFLICT);
+    REQUIRE(get_counter("a") == 133);
+  }
+
+  {
+    INFO("Merges compose with writes and removals in the same transaction");
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view(counters);
+    view->put("d", 1);
+    view->add("d", 2);
+    view->add("b", 1);
+    view->put("b", 0);
+    view->add("c", 1);
+    REQUIRE(view->remove("c"));
+    view->add("c", 4);
+
+    size_t count = 0;
+    view->foreach([&count](const auto&, const auto&) {
+      ++count;
+      return true;
+    });
+    REQUIRE(count == 4);
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+
+    REQUIRE(get_counter("b") == 0);
+    REQUIRE(get_counter("c") == 4);
+    REQUIRE(get_counter("d") == 3);
+  }
+
+  {
+    INFO("Merges are replicated as their results");
+    auto tx1 = kv_store.create_tx();
+    auto tx2 = kv_store.create_tx();
+    tx1.get_view(counters)->add("e", 1);
+    tx2.get_view(counters)->add("e", 2);
+    REQUIRE(tx1.commit() == kv::CommitSuccess::OK);
+    REQUIRE(tx2.commit() == kv::CommitSuccess::OK);
+
+    const auto latest = consensus->get_latest_data();
+    REQUIRE(latest.has_value());
+
+    // Only the latest transaction is deserialised, and it contains the result
+    // of both merges
+    kv::Store other(false);
+    other.set_encryptor(encryptor);
+    REQUIRE(other.deserialise(latest.value()) == kv::DeserialiseSuccess::PASS);
+    auto tx = other.create_tx();
+    REQUIRE(tx.get_view(counters)->get("e") == 3);
+  }
+}
+
+TEST_CASE("Value references")
+{
+  kv::Store kv_store;
+
+  const auto map_name = "public:values";
+  const kv::untyped::SerialisedEntry k1 = {1};
+  const kv::untyped::SerialisedEntry k2 = {2};
+  const kv::untyped::SerialisedEntry v1 = {1, 1, 1};
+  const kv::untyped::SerialisedEntry v2 = {2, 2, 2};
+
+  {
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view<kv::untyped::Map>(map_name);
+    view->put(k1, v1);
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+  }
+
+  auto tx = kv_store.create_tx();
+  auto view = tx.get_view<kv::untyped::Map>(map_name);
+
+  bool written = true;
+  REQUIRE(view->get_ref(k2, written) == nullptr);
+  REQUIRE_FALSE(written);
+
+  const auto v1_p = view->get_ref(k1, written);
+  REQUIRE(v1_p != nullptr);
+  REQUIRE_FALSE(written);
+  REQUIRE(*v1_p == v1);
+
+  INFO("Values read from the snapshot outlive concurrent commits");
+  {
+    auto tx2 = kv_store.create_tx();
+    auto view2 = tx2.get_view<kv::untyped::Map>(map_name);
+    view2->put(k1, v2);
+    REQUIRE(tx2.commit() == kv::CommitSuccess::OK);
+  }
+  REQUIRE(*v1_p == v1);
+
+  INFO("Values read from the snapshot outlive writes by the transaction");
+  view->put(k1, v2);
+  REQUIRE(*v1_p == v1);
+
+  INFO("Values written by the transaction are reported as such");
+  const auto v2_p = view->get_ref(k1, written);
+  REQUIRE(v2_p != nullptr);
+  REQUIRE(written);
+  REQUIRE(*v2_p == v2);
+  REQUIRE(view->get_ref(k1) == v2_p);
+
+  view->remove(k1);
+  REQUIRE(view->get_ref(k1, written) == nullptr);
+  REQUIRE(written);
+}
+
+TEST_CASE("Ordered maps")
+{
+  auto encryptor = std::make_shared<kv::NullTxEncryptor>();
+  kv::Store kv_store;
+  kv_store.set_encryptor(encryptor);
+
+  using Ordered = kv::OrderedMap<int64_t, std::string>;
+  Ordered ordered("public:ordered");
+
+  using Entries = std::vector<std::pair<int64_t, std::string>>;
+  auto collect = [](auto view, int64_t from, std::optional<int64_t> to) {
+    Entries entries;
+    view->foreach_range(from, to, [&](const auto& k, const auto& v) {
+      entries.emplace_back(k, v);
+      return true;
+    });
+    return entries;
+  };
+
+  {
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view(ordered);
+    for (int64_t k = -50; k < 50; k += 10)
+    {
+      view->put(k, std::to_string(k));
+    }
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+  }
+
+  {
+    INFO("Ranges are iterated in key order, including negative keys");
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view(ordered);
+    REQUIRE(
+      collect(view, -15, 15) == Entries{{-10, "-10"}, {0, "0"}, {10, "10"}});
+    REQUIRE(collect(view, 35, std::nullopt) == Entries{{40, "40"}});
+    REQUIRE(collect(view, 45, 100).empty());
+  }
+
+  {
+    INFO("Ranges include the transaction's own writes and removals");
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view(ordered);
+    view->put(5, "five");
+    view->put(10, "ten");
+    view->remove(0);
+    view->add(15, "teen");
+    REQUIRE(
+      collect(view, -10, 20) ==
+      Entries{{-10, "-10"}, {5, "five"}, {10, "ten"}, {15, "teen"}});
+  }
+
+  {
+    INFO("Iteration can be stopped early");
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view(ordered);
+    Entries entries;
+    view->foreach_range(-50, std::nullopt, [&](const auto& k, const auto& v) {
+      entries.emplace_back(k, v);
+      return entries.size() < 3;
+    });
+    REQUIRE(entries == Entries{{-50, "-50"}, {-40, "-40"}, {-30, "-30"}});
+  }
+
+  {
+    INFO("Range reads only conflict with writes in the range");
+    auto tx1 = kv_store.create_tx();
+    auto tx2 = kv_store.create_tx();
+    auto tx3 = kv_store.create_tx();
+    auto tx4 = kv_store.create_tx();
+    auto tx5 = kv_store.create_tx();
+
+    auto view1 = tx1.get_view(ordered);
+    REQUIRE(collect(view1, 0, 20).size() == 2);
+    view1->put(100, "a");
+
+    auto view2 = tx2.get_view(ordered);
+    REQUIRE(collect(view2, 20, 40).size() == 2);
+    view2->put(101, "b");
+
+    auto view3 = tx3.get_view(ordered);
+    view3->foreach_range(-50, std::nullopt, [](const auto&, const auto&) {
+      return false;
+    });
+    view3->put(102, "c");
+
+    auto view5 = tx5.get_view(ordered);
+    REQUIRE(collect(view5, -100, -40).size() == 1);
+    view5->put(103, "d");
+
+    // Writes a key in the range read by tx2, and creates a key in the range
+    // read by tx5
+    auto view4 = tx4.get_view(ordered);
+    view4->put(30, "thirty");
+    view4->put(-60, "new");
+    REQUIRE(tx4.commit() == kv::CommitSuccess::OK);
+
+    REQUIRE(tx1.commit() == kv::CommitSuccess::OK);
+    REQUIRE(tx2.commit() == kv::CommitSuccess::CONFLICT);
+    // tx3 stopped at the first key, so only depends on the keys up to it
+    REQUIRE(tx3.commit() == kv::CommitSuccess::OK);
+    REQUIRE(tx5.commit() == kv::CommitSuccess::CONFLICT);
+  }
+
+  {
+    INFO("Prefix iteration");
+    using Names = kv::OrderedMap<std::string, size_t>;
+    Names names("public:names");
+
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view(names);
+    for (const auto& name : {"alice", "alfred", "bob", "al", "a"})
+    {
+      view->put(name, 0);
+    }
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+
+    auto tx2 = kv_store.create_tx();
+    auto view2 = tx2.get_view(names);
+    std::vector<std::string> found;
+    view2->foreach_prefix("al", [&](const auto& k, const auto&) {
+      found.push_back(k);
+      return true;
+    });
+    REQUIRE(found == std::vector<std::string>{"al", "alfred", "alice"});
+  }
+
+  {
+    INFO("Maps are indexed when first accessed through an ordered view");
+    using NumString = kv::TypedMap<
+      size_t,
+      std::string,
+      kv::serialisers::OrderedSerialiser<size_t>,
+      kv::serialisers::MsgPackSerialiser<std::string>>;
+    NumString unordered("public:numbers");
+
+    auto tx = kv_store.create_tx();
+    auto view = tx.get_view(unordered);
+    view->put(1, "one");
+    REQUIRE_THROWS_AS(
+      view->foreach_range(0, 10, [](const auto&, const auto&) { return true; }),
+      std::logic_error);
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+
+    auto tx2 = kv_store.create_tx();
+    tx2.get_view(unordered)->put(2, "two");
+    REQUIRE(tx2.commit() == kv::CommitSuccess::OK);
+
+    using OrderedNumString = kv::TypedOrderedMap<
+      size_t,
+      std::string,
+      kv::serialisers::OrderedSerialiser<size_t>,
+      kv::serialisers::MsgPackSerialiser<std::string>>;
+    OrderedNumString reordered("public:numbers");
+    auto tx3 = kv_store.create_tx();
+    auto view3 = tx3.get_view(reordered);
+    view3->put(3, "three");
+    view3->remove(1);
+    REQUIRE(tx3.commit() == kv::CommitSuccess::OK);
+
+    auto tx4 = kv_store.create_tx();
+    auto view4 = tx4.get_view(reordered);
+    std::vector<size_t> keys;
+    view4->foreach_range(0, std::nullopt, [&](const auto& k, const auto&) {
+      keys.push_back(k);
+      return true;
+    });
+    REQUIRE(keys == std::vector<size_t>{2, 3});
+  }
+}
+
 TEST_CASE("Mid-tx compaction")
 {
   kv::Store kv_store;
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "ds/ccf_assert.h"
+#include "ds/tracing.h"
 #include "kv_serialiser.h"
 #include "kv_types.h"
 #include "map.h"
@@ -26,6 +27,13 @@ namespace kv
     }
   };
 
+  // Map and key on which a transaction conflicted
+  struct ConflictingKey
+  {
+    std::string map_name;
+    serialisers::SerialisedEntry key;
+  };
+
   // Manages a collection of TxViews. Derived implementations call get_tuple to
   // retrieve views over target maps.
   class BaseTx : public AbstractChangeContainer
@@ -53,6 +61,8 @@ namespace kv
 
     std::map<std::string, std::shared_ptr<AbstractMap>> created_maps;
 
+    std::optional<ConflictingKey> conflicting_key = std::nullopt;
+
     template <typename MapView>
     MapView* get_or_insert_view(
       untyped::ChangeSet& change_set, const std::string& name)
@@ -153,6 +163,11 @@ namespace kv
           fmt::format("Map {} has unexpected type", map_name));
       }
 
+      if constexpr (MapView::is_ordered)
+      {
+        untyped_map->enable_ordering();
+      }
+
       auto change_set = untyped_map->create_change_set(read_version);
       return check_and_store_change_set<MapView>(
         std::move(change_set), map_name, abstract_map);
@@ -260,6 +275,9 @@ namespace kv
       if (committed)
         throw std::logic_error("Transaction already committed");
 
+      tracing::ScopedSpan span(tracing::SpanKind::TxCommit);
+      conflicting_key = std::nullopt;
+
       if (all_changes.empty())
       {
         committed = true;
@@ -284,10 +302,22 @@ namespace kv
 
       if (!success)
       {
+        std::optional<ConflictingKey> conflict = std::nullopt;
+        for (const auto& [map_name, mc] : all_changes)
+        {
+          if (mc.changeset->conflicting_key.has_value())
+          {
+            conflict =
+              ConflictingKey{map_name, mc.changeset->conflicting_key.value()};
+            break;
+          }
+        }
+
         // Conflicting views (and contained writes) and all version tracking are
         // discarded. They must be reconstructed at updated, non-conflicting
         // versions
         reset();
+        conflicting_key = std::move(conflict);
 
         LOG_TRACE_FMT("Could not commit transaction due to conflict");
         return CommitSuccess::CONFLICT;
@@ -296,6 +326,7 @@ namespace kv
       {
         committed = true;
         version = c.value();
+        span.set_seqno(version);
 
         // From here, we have received a unique commit version and made
         // modifications to our local kv. If we fail in any way, we cannot
@@ -335,6 +366,16 @@ namespace kv
       }
     }
 
+    /** Map and key on which the last commit of this transaction conflicted
+     *
+     * @return Set after commit() returns CONFLICT because a key read by the
+     * transaction has since been written, nullopt otherwise
+     */
+    const std::optional<ConflictingKey>& get_conflicting_key() const
+    {
+      return conflicting_key;
+    }
+
     /** Commit version if committed
      *
      * @return Commit version
@@ -388,7 +429,8 @@ namespace kv
       auto map = all_changes.begin()->second.map;
       auto e = map->get_store()->get_encryptor();
 
-      KvStoreSerialiser replicated_serialiser(e, version);
+      KvStoreSerialiser replicated_serialiser(
+        e, version, false, map->get_store()->get_record_map_sizes());
 
       // Process in security domain order
       for (auto domain : {SecurityDomain::PUBLIC, SecurityDomain::PRIVATE})
@@ -430,6 +472,7 @@ namespace kv
       read_version = NoVersion;
       version = NoVersion;
       term = 0;
+      conflicting_key = std::nullopt;
     }
   };
 
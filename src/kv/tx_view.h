@@ -32,6 +32,27 @@ namespace kv
       return std::nullopt;
     }
 
+    /** Get a single field of the value at key, given as a pointer to member
+     * of V such as &V::field, without deserialising the rest of the value.
+     * The field is read from the serialised value in place, which is not
+     * copied. Only available on maps whose value serialiser can read single
+     * fields, such as TypedBinarySerialisedMap.
+     */
+    template <auto Field>
+    auto get_field(const K& key)
+    {
+      using F = std::decay_t<decltype(std::declval<const V&>().*Field)>;
+      const auto v_rep = untyped_view.get_ref(KSerialiser::to_serialised(key));
+
+      if (v_rep != nullptr)
+      {
+        return std::optional<F>(
+          VSerialiser::template read_field<Field>(*v_rep));
+      }
+
+      return std::optional<F>(std::nullopt);
+    }
+
     std::optional<V> get_globally_committed(const K& key)
     {
       const auto opt_v_rep =
@@ -62,6 +83,45 @@ namespace kv
       };
       untyped_view.foreach(g);
     }
+
+    /** Iterate in key order over the entries with keys in [from, to), or at
+     * least from if to is nullopt. Only available on ordered maps. See
+     * kv::untyped::TxView::foreach_range.
+     */
+    template <class F>
+    void foreach_range(const K& from, const std::optional<K>& to, F&& f)
+    {
+      auto g = [&](
+                 const kv::serialisers::SerialisedEntry& k_rep,
+                 const kv::serialisers::SerialisedEntry& v_rep) {
+        return f(
+          KSerialiser::from_serialised(k_rep),
+          VSerialiser::from_serialised(v_rep));
+      };
+      std::optional<kv::serialisers::SerialisedEntry> to_rep = std::nullopt;
+      if (to.has_value())
+      {
+        to_rep = KSerialiser::to_serialised(to.value());
+      }
+      untyped_view.foreach_range(KSerialiser::to_serialised(from), to_rep, g);
+    }
+
+    /** Iterate in key order over the entries whose serialised keys start with
+     * the serialised prefix, for instance the string keys starting with a
+     * given string. Only available on ordered maps.
+     */
+    template <class F>
+    void foreach_prefix(const K& prefix, F&& f)
+    {
+      auto g = [&](
+                 const kv::serialisers::SerialisedEntry& k_rep,
+                 const kv::serialisers::SerialisedEntry& v_rep) {
+        return f(
+          KSerialiser::from_serialised(k_rep),
+          VSerialiser::from_serialised(v_rep));
+      };
+      untyped_view.foreach_prefix(KSerialiser::to_serialised(prefix), g);
+    }
   };
 
   template <typename K, typename V, typename KSerialiser, typename VSerialiser>
@@ -83,5 +143,69 @@ namespace kv
     {
       return ReadOnlyBase::untyped_view.remove(KSerialiser::to_serialised(key));
     }
+
+    /** Update the value at key with a merge function, without recording a
+     * read dependency on it. f is called with the value of the key when the
+     * transaction is committed (nullopt if it does not exist) and returns its
+     * new value, so it should commute with concurrent updates to the key.
+     * See kv::untyped::TxView::merge.
+     */
+    template <typename F>
+    bool merge(const K& key, F&& f)
+    {
+      return ReadOnlyBase::untyped_view.merge(
+        KSerialiser::to_serialised(key),
+        [f = std::forward<F>(f)](
+          const std::optional<kv::serialisers::SerialisedEntry>& v_rep) {
+          std::optional<V> v = std::nullopt;
+          if (v_rep.has_value())
+          {
+            v = VSerialiser::from_serialised(*v_rep);
+          }
+          return VSerialiser::to_serialised(f(v));
+        });
+    }
+
+    /** Add delta to the value at key, or set it to delta if the key does not
+     * exist, without recording a read dependency on it.
+     */
+    bool add(const K& key, const V& delta)
+    {
+      return merge(key, [delta](const std::optional<V>& v) {
+        return v.has_value() ? *v + delta : delta;
+      });
+    }
+
+    /** Set the value at key to the lesser of its current value and value,
+     * without recording a read dependency on it.
+     */
+    bool min(const K& key, const V& value)
+    {
+      return merge(key, [value](const std::optional<V>& v) {
+        return v.has_value() && *v < value ? *v : value;
+      });
+    }
+
+    /** Set the value at key to the greater of its current value and value,
+     * without recording a read dependency on it.
+     */
+    bool max(const K& key, const V& value)
+    {
+      return merge(key, [value](const std::optional<V>& v) {
+        return v.has_value() && value < *v ? *v : value;
+      });
+    }
+  };
+
+  /** View over an ordered map. Obtaining one maintains an index of the keys
+   * of the map, which foreach_range and foreach_prefix iterate over.
+   */
+  template <typename K, typename V, typename KSerialiser, typename VSerialiser>
+  class OrderedTxView : public TxView<K, V, KSerialiser, VSerialiser>
+  {
+  public:
+    using TxView<K, V, KSerialiser, VSerialiser>::TxView;
+
+    static constexpr bool is_ordered = true;
   };
 }
\ No newline at end of file
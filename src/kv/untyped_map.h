@@ -7,6 +7,7 @@
 #include "ds/spin_lock.h"
 #include "kv/kv_serialiser.h"
 #include "kv/kv_types.h"
+#include "kv/value_spill.h"
 #include "kv/untyped_tx_view.h"
 
 #include <functional>
@@ -51,15 +52,22 @@ namespace kv::untyped
   struct LocalCommit
   {
     LocalCommit() = default;
-    LocalCommit(Version v, State&& s, const Write& w) :
+    LocalCommit(
+      Version v,
+      State&& s,
+      const Write& w,
+      std::optional<OrderedKeys>&& o = std::nullopt) :
       version(v),
       state(std::move(s)),
-      writes(w)
+      writes(w),
+      ordered(std::move(o))
     {}
 
     Version version;
     State state;
     Write writes;
+    // Only present on maps which are iterated in order
+    std::optional<OrderedKeys> ordered;
     LocalCommit* next = nullptr;
     LocalCommit* prev = nullptr;
   };
@@ -72,10 +80,29 @@ namespace kv::untyped
 
     LocalCommits empty_commits;
 
+    // Set once the map has been accessed through an ordered view, after which
+    // every local commit holds an index of the keys of its state.
+    bool ordered = false;
+
     void reset_commits()
     {
       commits->clear();
-      commits->insert_back(create_new_local_commit(0, State(), Write()));
+      commits->insert_back(create_new_local_commit(
+        0,
+        State(),
+        Write(),
+        ordered ? std::make_optional<OrderedKeys>() : std::nullopt));
+    }
+
+    void discard_commit(LocalCommit* c)
+    {
+      // Discarded commits are kept for reuse, but release their state, so
+      // that values which are no longer referenced (and their spilled copies)
+      // are freed
+      c->state = State();
+      c->writes.clear();
+      c->ordered.reset();
+      empty_commits.insert(c);
     }
 
     template <typename... Args>
@@ -113,6 +140,9 @@ namespace kv::untyped
     CommitHook global_hook = nullptr;
     std::list<std::pair<Version, Write>> commit_deltas;
     SpinLock sl;
+    // Set when a commit adds state which may later be compacted or rolled
+    // back, so that the store only visits maps which have changed.
+    bool dirty = false;
     const SecurityDomain security_domain;
     const bool replicated;
 
@@ -143,7 +173,8 @@ namespace kv::untyped
 
       bool prepare() override
       {
-        if (change_set.writes.empty())
+        // Merges do not record read dependencies, so never conflict
+        if (!change_set.has_writes())
           return true;
 
         auto& roll = map.get_roll();
@@ -164,6 +195,34 @@ namespace kv::untyped
           return false;
         }
 
+        // Check that no key in each range we have iterated over has been
+        // written or created since the state we read.
+        for (const auto& [from, to] : change_set.ranges)
+        {
+          if (!current->ordered.has_value())
+          {
+            return false;
+          }
+
+          const auto unchanged = current->ordered->foreach_range(
+            from, to, [&](const K& k, bool) {
+              const auto search = current->state.getp(k);
+              if (
+                search != nullptr &&
+                std::abs(search->version) > change_set.start_version)
+              {
+                change_set.conflicting_key = k;
+                return false;
+              }
+              return true;
+            });
+          if (!unchanged)
+          {
+            LOG_DEBUG_FMT("Read depends on invalid range of entries");
+            return false;
+          }
+        }
+
         // Check each key in our read set.
         for (auto it = change_set.reads.begin(); it != change_set.reads.end();
              ++it)
@@ -177,6 +236,7 @@ namespace kv::untyped
             if (search.has_value())
             {
               LOG_DEBUG_FMT("Read depends on non-existing entry");
+              change_set.conflicting_key = it->first;
               return false;
             }
           }
@@ -187,6 +247,7 @@ namespace kv::untyped
             if (!search.has_value() || (it->second != search.value().version))
             {
               LOG_DEBUG_FMT("Read depends on invalid version of entry");
+              change_set.conflicting_key = it->first;
               return false;
             }
           }
@@ -197,7 +258,7 @@ namespace kv::untyped
 
       void commit(Version v) override
       {
-        if (change_set.writes.empty())
+        if (!change_set.has_writes())
         {
           commit_version = change_set.start_version;
           return;
@@ -209,6 +270,29 @@ namespace kv::untyped
 
         auto& roll = map.get_roll();
         auto state = roll.commits->get_tail()->state;
+        auto ordered = roll.commits->get_tail()->ordered;
+
+        // Merges are applied to the latest value of each key, under the map's
+        // lock, so they are applied in commit order. Their results are recorded
+        // as writes, so are serialised and passed to hooks like any other write.
+        for (auto& [key, merges] : change_set.merges)
+        {
+          std::optional<V> value = std::nullopt;
+          const auto search = state.getp(key);
+          if (search != nullptr && !is_deleted(search->version))
+          {
+            std::shared_ptr<const V> loaded = nullptr;
+            value = load_value(*search, loaded);
+          }
+
+          for (const auto& f : merges)
+          {
+            value = f(value);
+          }
+
+          change_set.writes[key] = std::move(value);
+        }
+        change_set.merges.clear();
 
         for (auto it = change_set.writes.begin(); it != change_set.writes.end();
              ++it)
@@ -217,6 +301,10 @@ namespace kv::untyped
           {
             // Write the new value with the global version.
             changes = true;
+            if (ordered.has_value() && state.getp(it->first) == nullptr)
+            {
+              ordered = ordered->put(it->first, true);
+            }
             state = state.put(it->first, VersionV{v, it->second.value()});
           }
           else
@@ -235,7 +323,8 @@ namespace kv::untyped
         if (changes)
         {
           map.roll.commits->insert_back(map.roll.create_new_local_commit(
-            v, std::move(state), change_set.writes));
+            v, std::move(state), change_set.writes, std::move(ordered)));
+          map.mark_dirty();
         }
       }
 
@@ -264,6 +353,7 @@ namespace kv::untyped
       const kv::Version version;
 
       StateSnapshot map_snapshot;
+      std::optional<std::vector<uint8_t>> serialised_state = std::nullopt;
 
     public:
       Snapshot(
@@ -277,14 +367,28 @@ namespace kv::untyped
         map_snapshot(std::move(map_snapshot_))
       {}
 
+      void serialise_state(const threading::ParallelFor& parallel_for) override
+      {
+        if (!serialised_state.has_value())
+        {
+          std::vector<uint8_t> ret(map_snapshot.get_serialized_size());
+          map_snapshot.serialize(ret.data(), parallel_for);
+          serialised_state = std::move(ret);
+        }
+      }
+
+      size_t get_serialised_size() override
+      {
+        return map_snapshot.get_serialized_size();
+      }
+
       void serialise(KvStoreSerialiser& s) override
       {
+        serialise_state(nullptr);
+
         s.start_map(name, security_domain);
         s.serialise_entry_version(version);
-
-        std::vector<uint8_t> ret(map_snapshot.get_serialized_size());
-        map_snapshot.serialize(ret.data());
-        s.serialise_raw(ret);
+        s.serialise_raw(serialised_state.value());
       }
 
       SecurityDomain get_security_domain() override
@@ -427,6 +531,11 @@ namespace kv::untyped
 
         r->state = change_set.state;
         r->version = change_set.version;
+        if (r->ordered.has_value())
+        {
+          r->ordered = map.index_keys(r->state);
+        }
+        map.mark_dirty();
 
         // Executing hooks from snapshot requires copying the entire snapshotted
         // state so only do it if there's an hook on the table
@@ -435,11 +544,14 @@ namespace kv::untyped
           r->state.foreach([&r](const K& k, const VersionV& v) {
             if (!is_deleted(v.version))
             {
-              r->writes[k] = v.value;
+              std::shared_ptr<const V> loaded = nullptr;
+              r->writes[k] = load_value(v, loaded);
             }
             return true;
           });
         }
+
+        map.spill_state(r->state);
       }
 
       void post_commit() override
@@ -449,14 +561,32 @@ namespace kv::untyped
       }
     };
 
-    ChangeSetPtr deserialise_snapshot_changes(KvStoreDeserialiser& d)
+    // State of a map read from a snapshot, which has not been deserialised
+    struct SerialisedSnapshot
+    {
+      Version version;
+      std::vector<uint8_t> state;
+    };
+
+    SerialisedSnapshot read_snapshot(KvStoreDeserialiser& d)
     {
-      // Create a new empty view, deserialising d's contents into it.
       auto v = d.deserialise_entry_version();
-      auto map_snapshot = d.deserialise_raw();
+      return {v, d.deserialise_raw()};
+    }
 
+    // Deserialises a map's state from a snapshot. This does not access the
+    // map, so can run concurrently for different maps.
+    static ChangeSetPtr deserialise_snapshot_changes(
+      const SerialisedSnapshot& snapshot,
+      const threading::ParallelFor& parallel_for = nullptr)
+    {
       return std::make_unique<SnapshotChangeSet>(
-        State::deserialize_map(map_snapshot), v);
+        State::deserialize_map(snapshot.state, parallel_for), snapshot.version);
+    }
+
+    ChangeSetPtr deserialise_snapshot_changes(KvStoreDeserialiser& d)
+    {
+      return deserialise_snapshot_changes(read_snapshot(d));
     }
 
     ChangeSetPtr deserialise_changes(KvStoreDeserialiser& d, Version version)
@@ -620,9 +750,15 @@ namespace kv::untyped
             {
               return false;
             }
-            else if (Check::ne(found.value, v.value))
+            else
             {
-              return false;
+              std::shared_ptr<const V> loaded1 = nullptr;
+              std::shared_ptr<const V> loaded2 = nullptr;
+              if (Check::ne(
+                    load_value(found, loaded1), load_value(v, loaded2)))
+              {
+                return false;
+              }
             }
           }
           else
@@ -666,11 +802,80 @@ namespace kv::untyped
         name, security_domain, r->version, StateSnapshot(r->state));
     }
 
+    ValueSpillPtr get_value_spill()
+    {
+      return store != nullptr ? store->get_value_spill() : nullptr;
+    }
+
+    void spill_writes(Version v)
+    {
+      // Large values written at or before version v are spilled, and replaced
+      // by the same cold value in every state of the roll which still holds
+      // them. The Map expects to be locked.
+      auto spill = get_value_spill();
+      if (spill == nullptr)
+        return;
+
+      for (auto c = roll.commits->get_head(); c != nullptr && c->version <= v;
+           c = c->next)
+      {
+        for (const auto& [k, value] : c->writes)
+        {
+          if (!value.has_value() || !spill->should_spill(value.value()))
+            continue;
+
+          std::shared_ptr<const champ::ColdValue> cold = nullptr;
+          for (auto s = c; s != nullptr; s = s->next)
+          {
+            const auto search = s->state.getp(k);
+            if (search == nullptr || search->version != c->version)
+              break;
+
+            // Already spilled by an earlier compaction
+            if (search->cold != nullptr)
+              continue;
+
+            if (cold == nullptr)
+            {
+              cold = spill->spill(value.value());
+            }
+            s->state = s->state.put(k, VersionV{c->version, {}, cold});
+          }
+        }
+      }
+    }
+
+    void spill_state(State& state)
+    {
+      // Every large value of a state installed from a snapshot is spilled.
+      // The Map expects to be locked.
+      auto spill = get_value_spill();
+      if (spill == nullptr)
+        return;
+
+      std::vector<std::pair<K, Version>> large;
+      state.foreach([&](const K& k, const VersionV& v) {
+        if (v.cold == nullptr && spill->should_spill(v.value))
+        {
+          large.emplace_back(k, v.version);
+        }
+        return true;
+      });
+
+      for (const auto& [k, version] : large)
+      {
+        auto cold = spill->spill(state.getp(k)->value);
+        state = state.put(k, VersionV{version, {}, cold});
+      }
+    }
+
     void compact(Version v) override
     {
       // This discards available rollback state before version v, and populates
       // the commit_deltas to be passed to the global commit hook, if there is
       // one, up to version v. The Map expects to be locked during compaction.
+      spill_writes(v);
+
       while (roll.commits->get_head() != roll.commits->get_tail())
       {
         auto r = roll.commits->get_head();
@@ -698,7 +903,7 @@ namespace kv::untyped
           return;
 
         auto c = roll.commits->pop();
-        roll.empty_commits.insert(c);
+        roll.discard_commit(c);
       }
 
       // There is only one roll. We may need to call the commit hook.
@@ -740,13 +945,32 @@ namespace kv::untyped
 
         advance = true;
         auto c = roll.commits->pop_tail();
-        roll.empty_commits.insert(c);
+        roll.discard_commit(c);
       }
 
       if (advance)
         roll.rollback_counter++;
     }
 
+    void mark_dirty()
+    {
+      // The Map expects to be locked while it is marked dirty.
+      if (!dirty)
+      {
+        dirty = true;
+        store->mark_map_dirty(name);
+      }
+    }
+
+    bool refresh_dirty()
+    {
+      // After compaction, a map whose roll holds a single state has nothing
+      // left to compact or roll back, and is clean until its next commit. The
+      // Map expects to be locked.
+      dirty = roll.commits->get_head() != roll.commits->get_tail();
+      return dirty;
+    }
+
     void clear() override
     {
       // This discards all entries in the roll and resets the rollback counter.
@@ -775,6 +999,60 @@ namespace kv::untyped
       std::swap(roll, map->roll);
     }
 
+    static OrderedKeys index_keys(const State& state)
+    {
+      OrderedKeys ordered;
+      state.foreach([&ordered](const K& k, const VersionV&) {
+        ordered = ordered.put(k, true);
+        return true;
+      });
+      return ordered;
+    }
+
+    /** Maintain an index of the keys of each state of this map from now on,
+     * so that transactions can iterate over ranges of keys in order. This is
+     * called when the map is first accessed through an ordered view, so maps
+     * which are never iterated in order do not pay for the index.
+     */
+    void enable_ordering()
+    {
+      lock();
+
+      if (!roll.ordered)
+      {
+        roll.ordered = true;
+
+        // Index the oldest state in full, and each later state from the
+        // writes which produced it.
+        LocalCommit* prev = nullptr;
+        for (auto current = roll.commits->get_head(); current != nullptr;
+             current = current->next)
+        {
+          if (prev == nullptr)
+          {
+            current->ordered = index_keys(current->state);
+          }
+          else
+          {
+            auto ordered = prev->ordered.value();
+            for (const auto& [k, _] : current->writes)
+            {
+              if (
+                current->state.getp(k) != nullptr &&
+                ordered.getp(k) == nullptr)
+              {
+                ordered = ordered.put(k, true);
+              }
+            }
+            current->ordered = std::move(ordered);
+          }
+          prev = current;
+        }
+      }
+
+      unlock();
+    }
+
     ChangeSetPtr create_change_set(Version version)
     {
       lock();
@@ -791,7 +1069,8 @@ namespace kv::untyped
             roll.rollback_counter,
             current->state,
             roll.commits->get_head()->state,
-            current->version);
+            current->version,
+            current->ordered);
           break;
         }
       }
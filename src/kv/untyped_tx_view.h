@@ -14,14 +14,32 @@ namespace kv::untyped
   using VersionV = kv::VersionV<SerialisedEntry>;
   using State =
     kv::State<SerialisedEntry, SerialisedEntry, SerialisedKeyHasher>;
+  using OrderedKeys = kv::OrderedKeys<SerialisedEntry>;
   using Read = kv::Read<SerialisedEntry>;
   using Write = kv::Write<SerialisedEntry, SerialisedEntry>;
+  using Merge = kv::Merge<SerialisedEntry>;
   using ChangeSet =
     kv::ChangeSet<SerialisedEntry, SerialisedEntry, SerialisedKeyHasher>;
   using ChangeSetPtr = std::unique_ptr<ChangeSet>;
   using SnapshotChangeSet = kv::
     SnapshotChangeSet<SerialisedEntry, SerialisedEntry, SerialisedKeyHasher>;
 
+  /** Get the value of an entry of a map's state, loading it first if it is
+   * cold. A loaded value is owned by loaded, which must outlive the returned
+   * reference.
+   */
+  inline const SerialisedEntry& load_value(
+    const VersionV& v, std::shared_ptr<const SerialisedEntry>& loaded)
+  {
+    if (v.cold == nullptr)
+    {
+      return v.value;
+    }
+
+    loaded = v.cold->load();
+    return *loaded;
+  }
+
   class TxView : public kv::AbstractTxView
   {
   public:
@@ -33,6 +51,36 @@ namespace kv::untyped
   protected:
     ChangeSet& tx_changes;
 
+    /** Resolve any pending merges on this key into a write, by applying them
+     * to the current value of the key. This records a read dependency on the
+     * key, so is only done when the transaction needs to observe the result.
+     */
+    void resolve_merges(const KeyType& key)
+    {
+      auto merges = tx_changes.merges.find(key);
+      if (merges == tx_changes.merges.end())
+      {
+        return;
+      }
+
+      const auto pending = std::move(merges->second);
+      tx_changes.merges.erase(merges);
+
+      std::optional<ValueType> value = std::nullopt;
+      const auto value_p = read_key(key);
+      if (value_p != nullptr)
+      {
+        value = *value_p;
+      }
+
+      for (const auto& f : pending)
+      {
+        value = f(value);
+      }
+
+      tx_changes.writes[key] = std::move(value);
+    }
+
     /** Get pointer to current value if this key exists, else nullptr if it does
      * not exist or has been deleted. If non-null, points to something owned by
      * tx_changes - expect this is used/dereferenced immediately, and there is
@@ -42,6 +90,8 @@ namespace kv::untyped
      */
     const ValueType* read_key(const KeyType& key)
     {
+      resolve_merges(key);
+
       // A write followed by a read doesn't introduce a read dependency.
       // If we have written, return the value without updating the read set.
       auto write = tx_changes.writes.find(key);
@@ -75,8 +125,15 @@ namespace kv::untyped
         return nullptr;
       }
 
-      // Return the value.
-      return &search->value;
+      // Return the value, which remains loaded until the transaction ends if
+      // it is cold.
+      std::shared_ptr<const ValueType> loaded = nullptr;
+      const auto& value = load_value(*search, loaded);
+      if (loaded != nullptr)
+      {
+        tx_changes.loaded_values.push_back(std::move(loaded));
+      }
+      return &value;
     }
 
   public:
@@ -103,6 +160,43 @@ namespace kv::untyped
       return *value_p;
     }
 
+    /** Get a pointer to the value for key, without copying it
+     *
+     * Like get(), this records a read dependency on the key. If the key has
+     * not been written by the current transaction, the value is owned by the
+     * transaction's snapshot of the map, which is immutable, so the pointer
+     * remains valid for the lifetime of the transaction. Otherwise the value
+     * is owned by the transaction's write set, and the pointer is invalidated
+     * by further writes to the key.
+     *
+     * @param key Key
+     * @param[out] written Set to true if the key has been written by the
+     * current transaction
+     *
+     * @return Pointer to value, nullptr if the key doesn't exist
+     */
+    const ValueType* get_ref(const KeyType& key, bool& written)
+    {
+      resolve_merges(key);
+      written = tx_changes.writes.find(key) != tx_changes.writes.end();
+      return read_key(key);
+    }
+
+    /** Get a pointer to the value for key, without copying it
+     *
+     * As get_ref(key, written), for callers which do not need to know whether
+     * the key has been written by the current transaction.
+     *
+     * @param key Key
+     *
+     * @return Pointer to value, nullptr if the key doesn't exist
+     */
+    const ValueType* get_ref(const KeyType& key)
+    {
+      bool written;
+      return get_ref(key, written);
+    }
+
     /** Get globally committed value for key
      *
      * This reads a globally replicated value for the specified key.
@@ -133,7 +227,8 @@ namespace kv::untyped
       }
 
       // Return the value.
-      return found.value;
+      std::shared_ptr<const ValueType> loaded = nullptr;
+      return load_value(found, loaded);
     }
 
     /** Test if key is present
@@ -164,11 +259,47 @@ namespace kv::untyped
      */
     bool put(const KeyType& key, const ValueType& value)
     {
+      // A put replaces the result of any earlier merge.
+      tx_changes.merges.erase(key);
+
       // Record in the write set.
       tx_changes.writes[key] = value;
       return true;
     }
 
+    /** Update the value at key with a merge function
+     *
+     * The merge function is called with the value of the key when the
+     * transaction is committed (or nullopt if the key does not exist), and
+     * returns the new value for the key. Unlike a get followed by a put, this
+     * does not record a read dependency on the key, so concurrent transactions
+     * merging into the same key do not conflict with each other. The merge
+     * should therefore commute with other updates to the key, for instance an
+     * increment of a counter.
+     *
+     * If the transaction later reads the key, pending merges are applied to the
+     * value it reads, and the read dependency is recorded at that point.
+     *
+     * @param key Key
+     * @param f Merge function
+     *
+     * @return true if successful, false otherwise
+     */
+    bool merge(const KeyType& key, const Merge& f)
+    {
+      // If this transaction has already written the key, the merge can be
+      // applied to the written value directly.
+      auto write = tx_changes.writes.find(key);
+      if (write != tx_changes.writes.end())
+      {
+        write->second = f(write->second);
+        return true;
+      }
+
+      tx_changes.merges[key].push_back(f);
+      return true;
+    }
+
     /** Remove key
      *
      * This will fail if the key does not exist, or if the transaction
@@ -180,6 +311,8 @@ namespace kv::untyped
      */
     bool remove(const KeyType& key)
     {
+      resolve_merges(key);
+
       auto write = tx_changes.writes.find(key);
       auto search = tx_changes.state.get(key).has_value();
 
@@ -235,6 +368,12 @@ namespace kv::untyped
       // Record a global read dependency.
       tx_changes.read_version = tx_changes.start_version;
 
+      // Merges must be resolved so that their results are iterated over.
+      while (!tx_changes.merges.empty())
+      {
+        resolve_merges(tx_changes.merges.begin()->first);
+      }
+
       // Take a snapshot copy of the writes. This is what we will iterate over,
       // while any additional modifications made by the functor will modify the
       // original tx_changes.writes, and be visible outside of the functor's
@@ -248,7 +387,8 @@ namespace kv::untyped
 
           if ((write == w.end()) && !is_deleted(v.version))
           {
-            should_continue = f(k, v.value);
+            std::shared_ptr<const ValueType> loaded = nullptr;
+            should_continue = f(k, load_value(v, loaded));
           }
 
           return should_continue;
@@ -270,5 +410,152 @@ namespace kv::untyped
         }
       }
     }
+
+    /** Iterate in key order over the entries of an ordered map whose keys are
+     * in [from, to), or at least from if to is nullopt. Keys are ordered by
+     * their serialised representation.
+     *
+     * Unlike foreach, this does not depend on the whole map. The transaction
+     * depends only on the range of keys which was iterated over, up to the
+     * last key passed to the functor if the iteration was stopped early, and
+     * conflicts only with transactions which write a key in that range.
+     *
+     * The entries which are iterated over are determined in the same way as
+     * for foreach, and this throws if the map was not accessed through an
+     * ordered view.
+     *
+     * @param from First key of the range (inclusive)
+     * @param to End of the range (exclusive), or nullopt
+     * @param F functor, taking a key and a value, return value determines
+     * whether the iteration should continue (true) or stop (false)
+     */
+    template <class F>
+    void foreach_range(
+      const KeyType& from, const std::optional<KeyType>& to, F&& f)
+    {
+      if (!tx_changes.ordered.has_value())
+      {
+        throw std::logic_error(
+          "Range iteration is only possible over ordered maps");
+      }
+
+      auto in_range = [&](const KeyType& k) {
+        return !(k < from) && (!to.has_value() || k < to.value());
+      };
+
+      // Merges in the range must be resolved so that their results are
+      // iterated over.
+      for (auto it = tx_changes.merges.lower_bound(from);
+           it != tx_changes.merges.end() && in_range(it->first);
+           it = tx_changes.merges.lower_bound(from))
+      {
+        resolve_merges(it->first);
+      }
+
+      // As in foreach, iterate over a copy of the writes in the range, which
+      // take precedence over the state at the same keys.
+      const Write w(
+        tx_changes.writes.lower_bound(from),
+        to.has_value() ? tx_changes.writes.lower_bound(to.value()) :
+                         tx_changes.writes.end());
+      auto write = w.begin();
+      std::optional<KeyType> last = std::nullopt;
+      bool should_continue = true;
+
+      auto visit = [&](const KeyType& k, const ValueType& v) {
+        should_continue = f(k, v);
+        if (!should_continue)
+        {
+          last = k;
+        }
+      };
+
+      // Visit written entries before k, or all remaining ones if k is null.
+      auto visit_writes_before = [&](const KeyType* k) {
+        for (; should_continue && write != w.end() &&
+             (k == nullptr || write->first < *k);
+             ++write)
+        {
+          if (write->second.has_value())
+          {
+            visit(write->first, write->second.value());
+          }
+        }
+      };
+
+      tx_changes.ordered->foreach_range(from, to, [&](const KeyType& k, bool) {
+        visit_writes_before(&k);
+        if (!should_continue)
+        {
+          return false;
+        }
+
+        if (write != w.end() && write->first == k)
+        {
+          if (write->second.has_value())
+          {
+            visit(k, write->second.value());
+          }
+          ++write;
+        }
+        else
+        {
+          const auto search = tx_changes.state.getp(k);
+          if (search != nullptr && !is_deleted(search->version))
+          {
+            std::shared_ptr<const ValueType> loaded = nullptr;
+            visit(k, load_value(*search, loaded));
+          }
+        }
+
+        return should_continue;
+      });
+
+      visit_writes_before(nullptr);
+
+      // Record a dependency on the keys that were iterated over. If the
+      // iteration stopped early, that is up to and including the last key,
+      // ie up to its successor in byte order.
+      if (last.has_value())
+      {
+        last->push_back(0);
+        tx_changes.ranges.emplace_back(from, std::move(last));
+      }
+      else
+      {
+        tx_changes.ranges.emplace_back(from, to);
+      }
+    }
+
+    /** Iterate in key order over the entries of an ordered map whose
+     * serialised keys start with prefix. See foreach_range.
+     *
+     * @param prefix Serialised key prefix
+     * @param F functor, taking a key and a value, return value determines
+     * whether the iteration should continue (true) or stop (false)
+     */
+    template <class F>
+    void foreach_prefix(const KeyType& prefix, F&& f)
+    {
+      // The keys with this prefix are those before the prefix incremented
+      // as a big-endian number, ignoring trailing 0xff bytes. If the prefix
+      // is all 0xff bytes, they are unbounded.
+      std::optional<KeyType> to = prefix;
+      while (!to->empty() && to->back() == 0xff)
+      {
+        to->pop_back();
+      }
+
+      if (to->empty())
+      {
+        to = std::nullopt;
+      }
+      else
+      {
+        to->back()++;
+      }
+
+      foreach_range(prefix, to, std::forward<F>(f));
+    }
   };
 }
\ No newline at end of file
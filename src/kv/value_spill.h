@@ -0,0 +1,274 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include "crypto/symmetric_key.h"
+#include "ds/champ_map_serializers.h"
+#include "ds/spin_lock.h"
+
+#include <atomic>
+#include <list>
+#include <unordered_map>
+
+namespace kv
+{
+  /** Storage for sealed values outside of the enclave.
+   *
+   * Memory returned by allocate is untrusted. It is only written with
+   * ciphertext, and is copied into the enclave before being decrypted.
+   */
+  class AbstractSpillStorage
+  {
+  public:
+    virtual ~AbstractSpillStorage() = default;
+
+    virtual uint8_t* allocate(size_t size) = 0;
+    virtual void deallocate(uint8_t* data, size_t size) = 0;
+  };
+
+  // Suitable for virtual enclaves and tests, where all memory is host memory
+  class HeapSpillStorage : public AbstractSpillStorage
+  {
+  public:
+    uint8_t* allocate(size_t size) override
+    {
+      return new uint8_t[size];
+    }
+
+    void deallocate(uint8_t* data, size_t) override
+    {
+      delete[] data;
+    }
+  };
+
+  struct ValueSpillStats
+  {
+    size_t spilled_values = 0;
+    size_t spilled_bytes = 0;
+    size_t cached_bytes = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+  };
+
+  /** Moves large values of the KV out of enclave memory.
+   *
+   * Values of at least the threshold size are sealed with AES-GCM and written
+   * to spill storage once they are committed, and replaced in the state of
+   * their map by a cold value (see champ::ColdValue). Each cold value owns its
+   * sealed copy, which is freed when no state refers to it any more.
+   *
+   * Cold values are decrypted when they are read, and recently read values are
+   * kept in an LRU cache, of up to cache_capacity bytes. Each value is sealed
+   * with a unique IV, and its tag is kept in the enclave, so that values which
+   * have been modified or swapped outside the enclave fail to load.
+   */
+  class ValueSpill : public std::enable_shared_from_this<ValueSpill>
+  {
+  private:
+    using SerialisedEntry = champ::serialisers::SerialisedEntry;
+    using CacheEntry =
+      std::pair<uint64_t, std::shared_ptr<const SerialisedEntry>>;
+
+    class SealedValue : public champ::ColdValue
+    {
+    public:
+      std::shared_ptr<ValueSpill> spill;
+      uint64_t id;
+      uint8_t* data;
+      size_t data_size;
+      uint8_t tag[crypto::GCM_SIZE_TAG];
+
+      SealedValue(const std::shared_ptr<ValueSpill>& spill_, uint64_t id_) :
+        spill(spill_),
+        id(id_),
+        data(nullptr),
+        data_size(0)
+      {}
+
+      ~SealedValue()
+      {
+        if (data != nullptr)
+        {
+          spill->release(*this);
+        }
+      }
+
+      size_t size() const override
+      {
+        return data_size;
+      }
+
+      std::shared_ptr<const SerialisedEntry> load() const override
+      {
+        return spill->load(*this);
+      }
+    };
+
+    crypto::KeyAesGcm key;
+    std::shared_ptr<AbstractSpillStorage> storage;
+    const size_t threshold;
+    const size_t cache_capacity;
+
+    std::atomic<uint64_t> next_id = 0;
+
+    SpinLock lock;
+    std::list<CacheEntry> lru;
+    std::unordered_map<uint64_t, std::list<CacheEntry>::iterator> cache;
+    ValueSpillStats stats;
+
+    static crypto::GcmHeader<> make_header(uint64_t id)
+    {
+      crypto::GcmHeader<> hdr;
+      hdr.set_iv_seq(id);
+      return hdr;
+    }
+
+    // Expects lock to be held
+    void cache_value(
+      uint64_t id, const std::shared_ptr<const SerialisedEntry>& value)
+    {
+      if (value->size() > cache_capacity)
+      {
+        return;
+      }
+
+      lru.emplace_front(id, value);
+      cache[id] = lru.begin();
+      stats.cached_bytes += value->size();
+
+      while (stats.cached_bytes > cache_capacity)
+      {
+        evict(std::prev(lru.end()));
+      }
+    }
+
+    // Expects lock to be held
+    void evict(std::list<CacheEntry>::iterator it)
+    {
+      stats.cached_bytes -= it->second->size();
+      cache.erase(it->first);
+      lru.erase(it);
+    }
+
+    std::shared_ptr<const SerialisedEntry> load(const SealedValue& sealed)
+    {
+      {
+        std::lock_guard<SpinLock> guard(lock);
+        auto search = cache.find(sealed.id);
+        if (search != cache.end())
+        {
+          stats.hits++;
+          lru.splice(lru.begin(), lru, search->second);
+          return search->second->second;
+        }
+        stats.misses++;
+      }
+
+      // Copy the ciphertext into the enclave before it is authenticated, so
+      // that it cannot change while it is decrypted
+      SerialisedEntry cipher(sealed.data, sealed.data + sealed.data_size);
+      auto plain = std::make_shared<SerialisedEntry>(sealed.data_size);
+      const auto hdr = make_header(sealed.id);
+      if (!key.decrypt(
+            hdr.get_iv(),
+            sealed.tag,
+            {cipher.data(), cipher.size()},
+            nullb,
+            plain->data()))
+      {
+        throw std::logic_error(fmt::format(
+          "Spilled value {} could not be decrypted: it has been modified "
+          "outside the enclave",
+          sealed.id));
+      }
+
+      std::lock_guard<SpinLock> guard(lock);
+      if (cache.find(sealed.id) == cache.end())
+      {
+        cache_value(sealed.id, plain);
+      }
+      return plain;
+    }
+
+    void release(const SealedValue& sealed)
+    {
+      storage->deallocate(sealed.data, sealed.data_size);
+
+      std::lock_guard<SpinLock> guard(lock);
+      auto search = cache.find(sealed.id);
+      if (search != cache.end())
+      {
+        evict(search->second);
+      }
+      stats.spilled_values--;
+      stats.spilled_bytes -= sealed.data_size;
+    }
+
+  public:
+    /**
+     * @param raw_key Key with which values are sealed. It must not be used to
+     * encrypt anything else.
+     * @param threshold Size from which values are spilled
+     * @param cache_capacity Total size of the values kept in the cache
+     * @param storage Storage for sealed values
+     */
+    ValueSpill(
+      const std::vector<uint8_t>& raw_key,
+      size_t threshold,
+      size_t cache_capacity,
+      std::shared_ptr<AbstractSpillStorage> storage =
+        std::make_shared<HeapSpillStorage>()) :
+      key(raw_key),
+      storage(storage),
+      threshold(std::max<size_t>(threshold, 1)),
+      cache_capacity(cache_capacity)
+    {}
+
+    ValueSpill(const ValueSpill&) = delete;
+
+    bool should_spill(const SerialisedEntry& value) const
+    {
+      return value.size() >= threshold;
+    }
+
+    /** Seal a value and write it to spill storage.
+     *
+     * The value is also cached, as it has been written recently.
+     *
+     * @param value Value to spill
+     *
+     * @return Cold value, from which value can be loaded
+     */
+    std::shared_ptr<const champ::ColdValue> spill(const SerialisedEntry& value)
+    {
+      // Ids are never reused, so each IV is unique for this key
+      auto sealed =
+        std::make_shared<SealedValue>(shared_from_this(), next_id++);
+      const auto hdr = make_header(sealed->id);
+
+      SerialisedEntry cipher(value.size());
+      key.encrypt(
+        hdr.get_iv(),
+        {value.data(), value.size()},
+        nullb,
+        cipher.data(),
+        sealed->tag);
+
+      sealed->data = storage->allocate(cipher.size());
+      sealed->data_size = cipher.size();
+      std::copy(cipher.begin(), cipher.end(), sealed->data);
+
+      std::lock_guard<SpinLock> guard(lock);
+      stats.spilled_values++;
+      stats.spilled_bytes += sealed->data_size;
+      cache_value(sealed->id, std::make_shared<SerialisedEntry>(value));
+      return sealed;
+    }
+
+    ValueSpillStats get_stats()
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      return stats;
+    }
+  };
+}
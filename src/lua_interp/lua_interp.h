@@ -2,6 +2,8 @@
 // Licensed under the Apache 2.0 License.
 #pragma once
 
+#include <exception>
+#include <memory>
 #include <optional>
 #include <ostream>
 #include <sstream>
@@ -68,10 +70,15 @@ namespace ccf
     class Interpreter
     {
     private:
+      static constexpr size_t default_execution_limit = 1 << 22;
+
       lua_State* l;
 
       std::optional<size_t> execution_limit;
 
+      //! Reference to the globals of the freshly created state, see reset()
+      int pristine_globals = LUA_NOREF;
+
       /**
        * @brief Check that the stack has enough space to push an element of the
        * templated type
@@ -104,7 +111,7 @@ namespace ccf
       void _push_table() {}
 
     public:
-      Interpreter() : execution_limit(1 << 22)
+      Interpreter() : execution_limit(default_execution_limit)
       {
         l = luaL_newstate();
         lua_atpanic(l, panic);
@@ -126,6 +133,11 @@ namespace ccf
           lua_pop(l, 1); /* remove lib */
         }
 
+        // scripts never see the pristine globals, only copies of them
+        lua_rawgeti(l, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+        pristine_globals = luaL_ref(l, LUA_REGISTRYINDEX);
+        reset();
+
         // lua's garbage collector is left in its default state. As long as
         // instances of this Interpreter remain reasonably short-lived their
         // memory use is unlikely to be a problem - either they are destroyed
@@ -142,6 +154,60 @@ namespace ccf
         lua_close(l);
       }
 
+      /**
+       * @brief Reset the interpreter so that it can be reused for another
+       * script.
+       *
+       * Scripts are given a new global table, copied from the globals of the
+       * freshly created state, with the library tables (string, table, math)
+       * copied too. Globals set and library functions replaced by previous
+       * scripts are therefore not visible. Metatables registered with
+       * register_metatable() are kept.
+       */
+      void reset()
+      {
+        lua_settop(l, 0);
+        lua_gc(l, LUA_GCRESTART);
+        execution_limit = default_execution_limit;
+
+        // Strings share a metatable, whose __index is the original string
+        // library. Hide it from getmetatable so that it cannot be modified.
+        lua_pushliteral(l, "");
+        lua_getmetatable(l, -1);
+        lua_pushboolean(l, false);
+        lua_setfield(l, -2, "__metatable");
+        lua_pop(l, 2);
+
+        lua_newtable(l);
+        lua_rawgeti(l, LUA_REGISTRYINDEX, pristine_globals);
+        lua_pushnil(l);
+        while (lua_next(l, -2) != 0)
+        {
+          // stack: globals, pristine, key, value
+          if (lua_istable(l, -1) && !lua_rawequal(l, -1, -3))
+          {
+            lua_newtable(l);
+            lua_pushnil(l);
+            while (lua_next(l, -3) != 0)
+            {
+              // stack: ..., lib, copy, lib key, lib value
+              lua_pushvalue(l, -2);
+              lua_insert(l, -2);
+              lua_rawset(l, -4);
+            }
+            lua_remove(l, -2); // replace lib with its copy
+          }
+          lua_pushvalue(l, -2);
+          lua_insert(l, -2);
+          lua_rawset(l, -5);
+        }
+        lua_pop(l, 1); // remove pristine globals
+
+        lua_pushvalue(l, -1);
+        lua_setfield(l, -2, LUA_GNAME); // globals._G = globals
+        lua_rawseti(l, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+      }
+
       /**
        * @brief Push item to stack.
        *
@@ -362,6 +428,11 @@ namespace ccf
         lua_pushvalue(l, metatable); // dup metatable
         lua_setfield(l, field, "__index"); // metatable.__index = metatable
 
+        // hide the metatable from scripts, which could otherwise replace its
+        // methods for later users of this interpreter
+        lua_pushboolean(l, false);
+        lua_setfield(l, field, "__metatable");
+
         lua_pop(l, 1); // remove metatable from stack
       }
 
@@ -407,5 +478,88 @@ namespace ccf
         execution_limit = std::nullopt;
       }
     };
+
+    /**
+     * @brief Per-thread pool of interpreters
+     *
+     * Creating an interpreter (a new lua_State, with its libraries opened) is
+     * expensive relative to running short scripts. Interpreters acquired from
+     * the pool are reset() before use, and returned to the pool when the handle
+     * is destroyed. An interpreter in use when an exception is thrown is
+     * discarded instead, as its state may be inconsistent.
+     */
+    class InterpreterPool
+    {
+    private:
+      static constexpr size_t max_idle = 4;
+
+      static std::vector<std::unique_ptr<Interpreter>>& idle()
+      {
+        static thread_local std::vector<std::unique_ptr<Interpreter>>
+          interpreters;
+        return interpreters;
+      }
+
+    public:
+      class Handle
+      {
+      private:
+        std::unique_ptr<Interpreter> li;
+        const int uncaught_exceptions;
+
+      public:
+        Handle(std::unique_ptr<Interpreter>&& li_) :
+          li(std::move(li_)),
+          uncaught_exceptions(std::uncaught_exceptions())
+        {}
+
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+
+        ~Handle()
+        {
+          auto& interpreters = idle();
+          if (
+            std::uncaught_exceptions() == uncaught_exceptions &&
+            interpreters.size() < max_idle)
+          {
+            interpreters.push_back(std::move(li));
+          }
+        }
+
+        Interpreter& operator*()
+        {
+          return *li;
+        }
+
+        Interpreter* operator->()
+        {
+          return li.get();
+        }
+      };
+
+      static Handle acquire()
+      {
+        auto& interpreters = idle();
+        std::unique_ptr<Interpreter> li;
+        if (interpreters.empty())
+        {
+          li = std::make_unique<Interpreter>();
+        }
+        else
+        {
+          li = std::move(interpreters.back());
+          interpreters.pop_back();
+        }
+        li->reset();
+        return Handle(std::move(li));
+      }
+
+      //! Number of idle interpreters held for the current thread
+      static size_t size()
+      {
+        return idle().size();
+      }
+    };
   } // namespace lua
 } // namespace ccf
\ No newline at end of file
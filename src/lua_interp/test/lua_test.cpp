@@ -423,3 +423,61 @@ TEST_CASE("infinite loop prevention")
     REQUIRE_NOTHROW(interp.invoke(script));
   }
 }
+
+TEST_CASE("reset interpreter")
+{
+  Interpreter interp;
+  interp.invoke(R"xxx(
+    x = 42
+    string.upper = function() return "replaced" end
+    table.insert = nil
+  )xxx");
+  REQUIRE(interp.invoke<int>("return x") == 42);
+
+  interp.reset();
+
+  INFO("Globals set by previous scripts are not visible");
+  REQUIRE(interp.invoke<bool>("return x == nil"));
+  REQUIRE(interp.invoke<bool>("return _G.x == nil and _G == _ENV"));
+
+  INFO("Library tables are restored");
+  REQUIRE(interp.invoke<std::string>("return string.upper('abc')") == "ABC");
+  REQUIRE(interp.invoke<bool>("return table.insert ~= nil"));
+
+  INFO("Chunks loaded by scripts see the same globals");
+  REQUIRE(interp.invoke<int>("y = 5; return load('return y')()") == 5);
+
+  INFO("Shared metatables cannot be modified");
+  REQUIRE(interp.invoke<bool>("return getmetatable('') == false"));
+  interp.reset();
+  REQUIRE(interp.invoke<std::string>("return ('abc'):upper()") == "ABC");
+}
+
+TEST_CASE("interpreter pool")
+{
+  {
+    auto li = InterpreterPool::acquire();
+    li->invoke("x = 1");
+  }
+  REQUIRE(InterpreterPool::size() == 1);
+
+  {
+    INFO("Pooled interpreters are reset");
+    auto li = InterpreterPool::acquire();
+    REQUIRE(InterpreterPool::size() == 0);
+    REQUIRE(li->invoke<bool>("return x == nil"));
+  }
+  REQUIRE(InterpreterPool::size() == 1);
+
+  {
+    INFO("Interpreters are discarded when an exception is thrown");
+    try
+    {
+      auto li = InterpreterPool::acquire();
+      li->invoke("error('failed')");
+    }
+    catch (const lua::ex&)
+    {}
+    REQUIRE(InterpreterPool::size() == 0);
+  }
+}
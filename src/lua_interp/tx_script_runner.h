@@ -250,7 +250,8 @@ namespace ccf
       template <typename T, typename... Args>
       T run(kv::Tx& tx, const TxScript& txs, Args&&... args) const
       {
-        lua::Interpreter li;
+        auto pooled = lua::InterpreterPool::acquire();
+        auto& li = *pooled;
 
         // run an optional environment script
         setup_environment(li, txs.env_script);
@@ -0,0 +1,79 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include "crypto/hash.h"
+#include "entities.h"
+#include "kv/map.h"
+#include "kv/tx.h"
+
+#include <optional>
+
+namespace ccf
+{
+  // Certificates of callers, by digest. BFT requests recorded in the ledger,
+  // and forwarded requests, refer to their caller's certificate by digest once
+  // it has been recorded here, rather than including it.
+  using CallerCerts = kv::Map<crypto::Sha256Hash, Cert>;
+
+  // How the caller certificate is included in a serialised BFT request or
+  // forwarded command. Cert and None share their values with the bool which
+  // preceded this.
+  enum class CallerCertFormat : uint8_t
+  {
+    None = 0,
+    Cert = 1,
+    Digest = 2
+  };
+
+  inline crypto::Sha256Hash get_caller_cert_digest(const Cert& cert)
+  {
+    return crypto::Sha256Hash({cert.data(), cert.size()});
+  }
+
+  /** Record a caller certificate, if it has not been recorded already
+   *
+   * @param tx Transaction in which to record the certificate
+   * @param cert Caller certificate
+   *
+   * @return Digest by which the certificate can be resolved
+   */
+  inline crypto::Sha256Hash intern_caller_cert(kv::Tx& tx, const Cert& cert)
+  {
+    auto digest = get_caller_cert_digest(cert);
+    auto certs_view = tx.get_view<CallerCerts>(Tables::CALLER_CERTS);
+    if (!certs_view->has(digest))
+    {
+      certs_view->put(digest, cert);
+    }
+    return digest;
+  }
+
+  /** Look up a caller certificate whose record has been committed, and so
+   * can be resolved by any later primary
+   *
+   * @param tx Transaction in which to look up the certificate
+   * @param cert Caller certificate
+   *
+   * @return Digest of the certificate if its record has been committed,
+   * nullopt otherwise
+   */
+  inline std::optional<crypto::Sha256Hash> find_committed_caller_cert(
+    kv::Tx& tx, const Cert& cert)
+  {
+    auto digest = get_caller_cert_digest(cert);
+    auto certs_view = tx.get_view<CallerCerts>(Tables::CALLER_CERTS);
+    if (!certs_view->get_globally_committed(digest).has_value())
+    {
+      return std::nullopt;
+    }
+    return digest;
+  }
+
+  inline std::optional<Cert> resolve_caller_cert(
+    kv::Tx& tx, const crypto::Sha256Hash& digest)
+  {
+    auto certs_view = tx.get_view<CallerCerts>(Tables::CALLER_CERTS);
+    return certs_view->get(digest);
+  }
+}
@@ -102,6 +102,7 @@ namespace ccf
     static constexpr auto BACKUP_SIGNATURES =
       "public:ccf.internal.backup_signatures";
     static constexpr auto NONCES = "public:ccf.internal.nonces";
+    static constexpr auto CALLER_CERTS = "public:ccf.internal.caller_certs";
 
     // Consensus specific tables
     static constexpr auto AFT_REQUESTS = "public:ccf.gov.aft.requests";
@@ -3,14 +3,18 @@
 #pragma once
 
 #include "consensus/ledger_enclave_types.h"
+#include "ds/spin_lock.h"
+#include "ds/thread_messaging.h"
 #include "kv/store.h"
 #include "node/historical_queries_interface.h"
 #include "node/history.h"
 #include "node/rpc/node_interface.h"
 
+#include <deque>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 
 namespace ccf::historical
@@ -35,6 +39,10 @@ namespace ccf::historical
       RequestStage current_stage = RequestStage::Fetching;
       crypto::Sha256Hash entry_hash = {};
       StorePtr store = nullptr;
+
+      // Tree of the signature which made this entry trusted, from which
+      // receipts can be produced
+      std::shared_ptr<ccf::MerkleTreeHistory> tree = nullptr;
     };
 
     // These constitute a simple LRU, where only user queries will refresh an
@@ -48,6 +56,52 @@ namespace ccf::historical
     // need to distinguish things-we-asked-for from junk-from-the-host
     std::set<consensus::Index> pending_fetches;
 
+    // Stores are requested by endpoints on worker threads, while entries are
+    // received on the main thread. This protects requests, recent_requests
+    // and pending_fetches.
+    SpinLock requests_lock;
+
+    // Entries are deserialised, and signatures verified, on worker threads if
+    // there are any, so that bursts of historical queries do not delay
+    // consensus on the main thread. Results are applied on the main thread. At
+    // most MAX_CONCURRENT_ENTRIES are processed at once, the rest are queued.
+    // These are only accessed from the main thread.
+    static constexpr size_t MAX_CONCURRENT_ENTRIES = 4;
+    size_t entries_in_progress = 0;
+
+    struct QueuedEntry
+    {
+      consensus::Index idx;
+      LedgerEntry entry;
+      bool signature_only;
+    };
+    std::deque<QueuedEntry> queued_entries;
+
+    struct ProcessedEntry
+    {
+      consensus::Index idx;
+      StorePtr store = nullptr;
+      crypto::Sha256Hash entry_hash = {};
+
+      // Verified tree, if this entry is a signature transaction
+      std::shared_ptr<ccf::MerkleTreeHistory> tree = nullptr;
+
+      // Set if only the signatures table was deserialised into store
+      bool signature_only = false;
+
+      // Set if the entry could not be deserialised or verified
+      std::optional<std::string> error = std::nullopt;
+    };
+
+    struct ProcessEntryMsg
+    {
+      StateCache* self;
+      consensus::Index idx;
+      LedgerEntry entry;
+      bool signature_only;
+      ProcessedEntry processed;
+    };
+
     void request_entry_at(consensus::Index idx)
     {
       // To avoid duplicates, remove index if it was already requested
@@ -110,7 +164,7 @@ namespace ccf::historical
       return nodes_view->get(node_id);
     }
 
-    void handle_signature_transaction(
+    std::shared_ptr<ccf::MerkleTreeHistory> verify_signature_transaction(
       consensus::Index sig_idx, const StorePtr& sig_store)
     {
       const auto sig = get_signature(sig_store);
@@ -121,8 +175,8 @@ namespace ccf::historical
       }
 
       // Build tree from signature
-      ccf::MerkleTreeHistory tree(sig->tree);
-      const auto real_root = tree.get_root();
+      auto tree = std::make_shared<ccf::MerkleTreeHistory>(sig->tree);
+      const auto real_root = tree->get_root();
       if (real_root != sig->root)
       {
         throw std::logic_error("Invalid signature: invalid root");
@@ -150,6 +204,13 @@ namespace ccf::historical
           fmt::format("Signature at {} is invalid", sig_idx));
       }
 
+      return tree;
+    }
+
+    void handle_signature_transaction(
+      consensus::Index sig_idx,
+      const std::shared_ptr<ccf::MerkleTreeHistory>& tree)
+    {
       auto it = requests.begin();
       while (it != requests.end())
       {
@@ -158,12 +219,12 @@ namespace ccf::historical
 
         if (
           request.current_stage == RequestStage::Untrusted &&
-          tree.in_range(untrusted_idx))
+          tree->in_range(untrusted_idx))
         {
           // Compare signed hash, from signature mini-tree, with hash of the
           // entry which was used to populate the store
           const auto& untrusted_hash = request.entry_hash;
-          const auto trusted_hash = tree.get_leaf(untrusted_idx);
+          const auto trusted_hash = tree->get_leaf(untrusted_idx);
           if (trusted_hash != untrusted_hash)
           {
             LOG_FAIL_FMT(
@@ -182,6 +243,7 @@ namespace ccf::historical
           LOG_DEBUG_FMT(
             "Now trusting {} due to signature at {}", untrusted_idx, sig_idx);
           request.current_stage = RequestStage::Trusted;
+          request.tree = tree;
           ++it;
         }
         else
@@ -193,64 +255,157 @@ namespace ccf::historical
       }
     }
 
-    void deserialise_ledger_entry(
-      consensus::Index idx, const LedgerEntry& entry)
+    // Deserialises an entry and, if it is a signature, verifies it. This does
+    // not access the requests, so can run on any thread. Entries which were
+    // not requested are only fetched to find the next signature, so only
+    // their signatures table is deserialised.
+    ProcessedEntry deserialise_ledger_entry(
+      consensus::Index idx, const LedgerEntry& entry, bool signature_only)
     {
-      StorePtr store = std::make_shared<kv::Store>(false);
+      ProcessedEntry processed;
+      processed.idx = idx;
+      processed.signature_only = signature_only;
 
-      store->set_encryptor(source_store.get_encryptor());
+      try
+      {
+        StorePtr store = std::make_shared<kv::Store>(false);
 
-      const auto deserialise_result = store->deserialise_views(entry);
+        store->set_encryptor(source_store.get_encryptor());
 
-      switch (deserialise_result)
-      {
-        case kv::DeserialiseSuccess::FAILED:
-        {
-          throw std::logic_error("Deserialise failed!");
-          break;
-        }
-        case kv::DeserialiseSuccess::PASS:
-        case kv::DeserialiseSuccess::PASS_SIGNATURE:
-        {
-          LOG_DEBUG_FMT("Processed transaction at {}", idx);
+        const auto deserialise_result = signature_only ?
+          store->deserialise_selected_maps(entry, {ccf::Tables::SIGNATURES}) :
+          store->deserialise_views(entry);
 
-          auto request_it = requests.find(idx);
-          if (request_it != requests.end())
+        switch (deserialise_result)
+        {
+          case kv::DeserialiseSuccess::FAILED:
           {
-            auto& request = request_it->second;
-            if (request.current_stage == RequestStage::Fetching)
-            {
-              // We were looking for this entry. Store the produced store
-              request.current_stage = RequestStage::Untrusted;
-              request.entry_hash = crypto::Sha256Hash(entry);
-              request.store = store;
-            }
-            else
-            {
-              LOG_DEBUG_FMT(
-                "Not fetching ledger entry {}: already have it in stage {}",
-                request_it->first,
-                request.current_stage);
-            }
+            throw std::logic_error("Deserialise failed!");
+            break;
           }
-
-          if (deserialise_result == kv::DeserialiseSuccess::PASS_SIGNATURE)
+          case kv::DeserialiseSuccess::PASS:
+          case kv::DeserialiseSuccess::PASS_SIGNATURE:
           {
-            // This looks like a valid signature - try to use this signature to
-            // move some stores from untrusted to trusted
-            handle_signature_transaction(idx, store);
+            LOG_DEBUG_FMT("Processed transaction at {}", idx);
+
+            processed.store = store;
+            processed.entry_hash = crypto::Sha256Hash(entry);
+
+            if (deserialise_result == kv::DeserialiseSuccess::PASS_SIGNATURE)
+            {
+              processed.tree = verify_signature_transaction(idx, store);
+            }
+            break;
           }
-          else
+          default:
           {
-            // This is not a signature - try the next transaction
-            fetch_entry_at(idx + 1);
+            throw std::logic_error("Unexpected deserialise result");
           }
-          break;
         }
-        default:
+      }
+      catch (const std::exception& e)
+      {
+        processed.error = e.what();
+      }
+
+      return processed;
+    }
+
+    bool apply_ledger_entry(const ProcessedEntry& processed)
+    {
+      const auto idx = processed.idx;
+      if (processed.error.has_value())
+      {
+        LOG_FAIL_FMT(
+          "Unable to deserialise entry {}: {}", idx, processed.error.value());
+        return false;
+      }
+
+      std::lock_guard<SpinLock> guard(requests_lock);
+
+      auto request_it = requests.find(idx);
+      if (request_it != requests.end())
+      {
+        auto& request = request_it->second;
+        if (
+          request.current_stage == RequestStage::Fetching &&
+          processed.signature_only)
         {
-          throw std::logic_error("Unexpected deserialise result");
+          // This entry was requested while it was being processed, so was
+          // not fully deserialised. Fetch it again
+          fetch_entry_at(idx);
         }
+        else if (request.current_stage == RequestStage::Fetching)
+        {
+          // We were looking for this entry. Store the produced store
+          request.current_stage = RequestStage::Untrusted;
+          request.entry_hash = processed.entry_hash;
+          request.store = processed.store;
+        }
+        else
+        {
+          LOG_DEBUG_FMT(
+            "Not fetching ledger entry {}: already have it in stage {}",
+            request_it->first,
+            request.current_stage);
+        }
+      }
+
+      if (processed.tree != nullptr)
+      {
+        // This is a valid signature - use it to move some stores from
+        // untrusted to trusted
+        handle_signature_transaction(idx, processed.tree);
+      }
+      else
+      {
+        // This is not a signature - try the next transaction
+        fetch_entry_at(idx + 1);
+      }
+
+      return true;
+    }
+
+    static void deserialise_ledger_entry_cb(
+      std::unique_ptr<threading::Tmsg<ProcessEntryMsg>> msg)
+    {
+      msg->data.processed = msg->data.self->deserialise_ledger_entry(
+        msg->data.idx, msg->data.entry, msg->data.signature_only);
+      msg->data.entry.clear();
+
+      threading::ThreadMessaging::ChangeTmsgCallback(
+        msg, &apply_ledger_entry_cb);
+      threading::ThreadMessaging::thread_messaging.add_task(
+        threading::MAIN_THREAD_ID, std::move(msg));
+    }
+
+    static void apply_ledger_entry_cb(
+      std::unique_ptr<threading::Tmsg<ProcessEntryMsg>> msg)
+    {
+      auto self = msg->data.self;
+      self->apply_ledger_entry(msg->data.processed);
+      --self->entries_in_progress;
+      self->process_queued_entries();
+    }
+
+    void process_queued_entries()
+    {
+      while (!queued_entries.empty() &&
+             entries_in_progress < MAX_CONCURRENT_ENTRIES)
+      {
+        auto& [idx, entry, signature_only] = queued_entries.front();
+        auto msg = std::make_unique<threading::Tmsg<ProcessEntryMsg>>(
+          &deserialise_ledger_entry_cb);
+        msg->data.self = this;
+        msg->data.idx = idx;
+        msg->data.entry = std::move(entry);
+        msg->data.signature_only = signature_only;
+        const auto tid = threading::ThreadMessaging::get_execution_thread(idx);
+        queued_entries.pop_front();
+
+        ++entries_in_progress;
+        threading::ThreadMessaging::thread_messaging.add_task(
+          tid, std::move(msg));
       }
     }
 
@@ -262,6 +417,8 @@ namespace ccf::historical
 
     StorePtr get_store_at(consensus::Index idx) override
     {
+      std::lock_guard<SpinLock> guard(requests_lock);
+
       const auto it = requests.find(idx);
       if (it == requests.end())
       {
@@ -281,33 +438,98 @@ namespace ccf::historical
       return nullptr;
     }
 
-    bool handle_ledger_entry(consensus::Index idx, const LedgerEntry& data)
+    std::vector<std::vector<uint8_t>> get_batch_receipts(
+      const std::vector<consensus::Index>& idxs) override
     {
-      const auto it =
-        std::find(pending_fetches.begin(), pending_fetches.end(), idx);
-      if (it == pending_fetches.end())
+      std::lock_guard<SpinLock> guard(requests_lock);
+
+      // Entries trusted by the same signature share a single receipt. They
+      // are grouped by root rather than by tree, since each time a signature
+      // is processed it produces a distinct but identical tree. The trees are
+      // captured under the same lock as the stages are checked, so that a
+      // request evicted in between cannot be missed.
+      struct TreeIdxs
       {
-        // Unexpected entry - ignore it?
-        return false;
+        std::shared_ptr<ccf::MerkleTreeHistory> tree;
+        std::vector<uint64_t> idxs;
+      };
+      std::map<crypto::Sha256Hash, TreeIdxs> idxs_by_root;
+      bool all_trusted = true;
+      for (const auto idx : idxs)
+      {
+        const auto it = requests.find(idx);
+        if (it == requests.end())
+        {
+          // Keep requesting the remaining entries, so that they are all
+          // fetched at once
+          request_entry_at(idx);
+          all_trusted = false;
+        }
+        else if (it->second.current_stage != RequestStage::Trusted)
+        {
+          all_trusted = false;
+        }
+        else if (all_trusted)
+        {
+          const auto& tree = it->second.tree;
+          auto& entry = idxs_by_root[tree->get_root()];
+          entry.tree = tree;
+          entry.idxs.push_back(idx);
+        }
       }
 
-      pending_fetches.erase(it);
+      if (!all_trusted)
+      {
+        return {};
+      }
 
-      try
+      std::vector<std::vector<uint8_t>> receipts;
+      for (const auto& [root, entry] : idxs_by_root)
       {
-        deserialise_ledger_entry(idx, data);
+        receipts.push_back(entry.tree->get_batch_receipt(entry.idxs).to_v());
       }
-      catch (const std::exception& e)
+      return receipts;
+    }
+
+    /** Handle an entry received from the host, on the main thread
+     *
+     * If there are worker threads, the entry is processed asynchronously and
+     * this returns true if the entry was expected. Otherwise, it is processed
+     * immediately and this returns true if it was expected and valid.
+     */
+    bool handle_ledger_entry(consensus::Index idx, const LedgerEntry& data)
+    {
+      bool signature_only;
       {
-        LOG_FAIL_FMT("Unable to deserialise entry {}: {}", idx, e.what());
-        return false;
+        std::lock_guard<SpinLock> guard(requests_lock);
+
+        const auto it =
+          std::find(pending_fetches.begin(), pending_fetches.end(), idx);
+        if (it == pending_fetches.end())
+        {
+          // Unexpected entry - ignore it?
+          return false;
+        }
+
+        pending_fetches.erase(it);
+        signature_only = requests.find(idx) == requests.end();
+      }
+
+      if (threading::ThreadMessaging::thread_count <= 1)
+      {
+        return apply_ledger_entry(
+          deserialise_ledger_entry(idx, data, signature_only));
       }
 
+      queued_entries.push_back({idx, data, signature_only});
+      process_queued_entries();
       return true;
     }
 
     void handle_no_entry(consensus::Index idx)
     {
+      std::lock_guard<SpinLock> guard(requests_lock);
+
       const auto request_it = requests.find(idx);
       if (request_it != requests.end())
       {
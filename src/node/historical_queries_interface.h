@@ -6,6 +6,7 @@
 #include "kv/store.h"
 #include "node/rpc/endpoint_registry.h"
 
+#include <algorithm>
 #include <memory>
 
 namespace ccf::historical
@@ -18,6 +19,39 @@ namespace ccf::historical
     virtual ~AbstractStateCache() = default;
 
     virtual StorePtr get_store_at(consensus::Index idx) = 0;
+
+    /** Requests the stores at each of the given indices. The returned
+     * collection is empty until all of them are available.
+     */
+    virtual std::vector<StorePtr> get_stores_at(
+      const std::vector<consensus::Index>& idxs)
+    {
+      std::vector<StorePtr> stores;
+      for (const auto idx : idxs)
+      {
+        // Request every index, even after one is found to be missing, so that
+        // they are all fetched concurrently
+        stores.push_back(get_store_at(idx));
+      }
+
+      if (std::find(stores.begin(), stores.end(), nullptr) != stores.end())
+      {
+        return {};
+      }
+
+      return stores;
+    }
+
+    /** Returns receipts for the entries at the given indices, which may have
+     * been flushed from the node's Merkle tree. Entries covered by the same
+     * signature share a single receipt, so there may be several receipts.
+     * The returned collection is empty until all entries are available.
+     */
+    virtual std::vector<std::vector<uint8_t>> get_batch_receipts(
+      const std::vector<consensus::Index>&)
+    {
+      return {};
+    }
   };
 
   class StubStateCache : public AbstractStateCache
@@ -135,5 +169,104 @@ namespace ccf::historical
       f(args, historical_store, target_view, target_seqno);
     };
   }
+
+  // Maximum number of stores passed to a single call of a range query
+  // handler. This matches the number of requests the state cache holds at
+  // once, so that a page of stores is not evicted while it is being fetched.
+  static constexpr size_t max_stores_per_range_query = 10;
+
+  using SeqNoCollection = std::vector<kv::Consensus::SeqNo>;
+
+  enum class GetSeqNosResult
+  {
+    // seqnos contains every transaction needed by the query
+    Ok,
+    // The query is invalid, as described by error_reason
+    Invalid,
+    // The transactions needed by the query are not yet known, for example
+    // because an index has not caught up with the queried range. The query
+    // should be retried.
+    Pending
+  };
+
+  // Returns the seqnos of the transactions needed by a range query, for
+  // example from an index
+  using GetSeqNos = std::function<GetSeqNosResult(
+    ccf::EndpointContext& args,
+    SeqNoCollection& seqnos,
+    std::string& error_reason)>;
+
+  using StoresBySeqNo = std::vector<std::pair<kv::Consensus::SeqNo, StorePtr>>;
+
+  // If next_seqno is set, there were more seqnos than could be handled by a
+  // single call, and the query should be resumed from next_seqno
+  using HandleHistoricalRangeQuery = std::function<void(
+    ccf::EndpointContext& args,
+    const StoresBySeqNo& stores,
+    std::optional<kv::Consensus::SeqNo> next_seqno)>;
+
+  static ccf::EndpointFunction range_adapter(
+    const HandleHistoricalRangeQuery& f,
+    AbstractStateCache& state_cache,
+    const GetSeqNos& get_seqnos)
+  {
+    return [f, &state_cache, get_seqnos](EndpointContext& args) {
+      static constexpr size_t retry_after_seconds = 3;
+
+      SeqNoCollection seqnos;
+      std::string error_reason;
+      switch (get_seqnos(args, seqnos, error_reason))
+      {
+        case GetSeqNosResult::Ok:
+        {
+          break;
+        }
+        case GetSeqNosResult::Invalid:
+        {
+          args.rpc_ctx->set_response_status(HTTP_STATUS_BAD_REQUEST);
+          args.rpc_ctx->set_response_body(std::move(error_reason));
+          return;
+        }
+        case GetSeqNosResult::Pending:
+        {
+          args.rpc_ctx->set_response_status(HTTP_STATUS_ACCEPTED);
+          args.rpc_ctx->set_response_header(
+            http::headers::RETRY_AFTER, retry_after_seconds);
+          args.rpc_ctx->set_response_body(std::move(error_reason));
+          return;
+        }
+      }
+
+      std::optional<kv::Consensus::SeqNo> next_seqno = std::nullopt;
+      if (seqnos.size() > max_stores_per_range_query)
+      {
+        next_seqno = seqnos[max_stores_per_range_query];
+        seqnos.resize(max_stores_per_range_query);
+      }
+
+      // Only the transactions which are needed are fetched, rather than every
+      // transaction in the range
+      const auto stores = state_cache.get_stores_at(
+        std::vector<consensus::Index>(seqnos.begin(), seqnos.end()));
+      if (stores.size() != seqnos.size())
+      {
+        args.rpc_ctx->set_response_status(HTTP_STATUS_ACCEPTED);
+        args.rpc_ctx->set_response_header(
+          http::headers::RETRY_AFTER, retry_after_seconds);
+        args.rpc_ctx->set_response_body(fmt::format(
+          "Historical transactions from seqno {} are not currently available",
+          seqnos.front()));
+        return;
+      }
+
+      StoresBySeqNo stores_by_seqno;
+      for (size_t i = 0; i < seqnos.size(); ++i)
+      {
+        stores_by_seqno.emplace_back(seqnos[i], stores[i]);
+      }
+
+      f(args, stores_by_seqno, next_seqno);
+    };
+  }
 #pragma clang diagnostic pop
 }
\ No newline at end of file
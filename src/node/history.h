@@ -10,6 +10,7 @@
 #include "kv/kv_types.h"
 #include "kv/store.h"
 #include "nodes.h"
+#include "signature_policy.h"
 #include "signatures.h"
 #include "tls/tls.h"
 #include "tls/verifier.h"
@@ -205,6 +206,22 @@ namespace ccf
     {
       return true;
     }
+
+    std::vector<uint8_t> get_batch_receipt(
+      const std::vector<kv::Version>&) override
+    {
+      return {};
+    }
+
+    bool verify_batch_receipt(const std::vector<uint8_t>&) override
+    {
+      return true;
+    }
+
+    kv::Version get_first_receipt_version() override
+    {
+      return 0;
+    }
   };
 
   class Receipt
@@ -268,6 +285,26 @@ namespace ccf
 
     Receipt(const Receipt&) = delete;
 
+    uint32_t get_max_index() const
+    {
+      return max_index;
+    }
+
+    const crypto::Sha256Hash& get_root() const
+    {
+      return root;
+    }
+
+    crypto::Sha256Hash get_step(uint32_t i) const
+    {
+      if (!mt_get_path_step_pre(path->raw, i))
+        throw std::logic_error("Precondition to mt_get_path_step violated");
+      crypto::Sha256Hash step;
+      std::memcpy(
+        step.h.data(), mt_get_path_step(path->raw, i), step.h.size());
+      return step;
+    }
+
     bool verify(merkle_tree* tree) const
     {
       if (!mt_verify_pre(
@@ -301,6 +338,262 @@ namespace ccf
     }
   };
 
+  // A receipt for a set of leaves of the same tree. Rather than one path per
+  // leaf, it contains each hash needed to recompute the root once, in the
+  // order in which they are consumed by verify(). Hashes which can be computed
+  // from the leaves themselves (common ancestors) are omitted entirely.
+  //
+  // The shape of the tree follows mt_get_path: at each level, the last node
+  // is either promoted as is or, if some lower level had an odd number of
+  // nodes, combined with the root of the partial subtree to its right.
+  class BatchReceipt
+  {
+  private:
+    uint64_t offset = 0;
+    uint32_t max_index = 0;
+    crypto::Sha256Hash root;
+    std::vector<std::pair<uint64_t, crypto::Sha256Hash>> leaves;
+    std::vector<crypto::Sha256Hash> proof;
+
+    // Whether the node k at a level with j nodes has no sibling and is
+    // promoted as is. actd is set if any lower level had an odd number of
+    // nodes, in which case there is a partial subtree to the right of node j-1
+    static bool is_promoted(uint32_t k, uint32_t j, bool actd)
+    {
+      return k % 2 == 0 && (k == j || (k + 1 == j && !actd));
+    }
+
+    static crypto::Sha256Hash combine(
+      const crypto::Sha256Hash& left, const crypto::Sha256Hash& right)
+    {
+      crypto::Sha256Hash res;
+      mt_sha256_compress(
+        const_cast<uint8_t*>(left.h.data()),
+        const_cast<uint8_t*>(right.h.data()),
+        res.h.data());
+      return res;
+    }
+
+  public:
+    BatchReceipt() = default;
+
+    BatchReceipt(const std::vector<uint8_t>& v)
+    {
+      const uint8_t* buf = v.data();
+      size_t s = v.size();
+      offset = serialized::read<decltype(offset)>(buf, s);
+      max_index = serialized::read<decltype(max_index)>(buf, s);
+      root.h = serialized::read<decltype(root.h)>(buf, s);
+
+      const auto leaf_count = serialized::read<uint32_t>(buf, s);
+      if (leaf_count > s / (sizeof(uint64_t) + crypto::Sha256Hash::SIZE))
+      {
+        throw std::logic_error("Batch receipt is truncated");
+      }
+      leaves.reserve(leaf_count);
+      for (size_t i = 0; i < leaf_count; ++i)
+      {
+        const auto index = serialized::read<uint64_t>(buf, s);
+        crypto::Sha256Hash leaf;
+        leaf.h = serialized::read<decltype(leaf.h)>(buf, s);
+        leaves.emplace_back(index, leaf);
+      }
+
+      const auto proof_length = serialized::read<uint32_t>(buf, s);
+      if (proof_length > s / crypto::Sha256Hash::SIZE)
+      {
+        throw std::logic_error("Batch receipt is truncated");
+      }
+      proof.resize(proof_length);
+      for (auto& hash : proof)
+      {
+        hash.h = serialized::read<decltype(hash.h)>(buf, s);
+      }
+    }
+
+    /** Produces a receipt for a set of indices, which must all be in the
+     * tree. Duplicate indices are ignored.
+     */
+    BatchReceipt(merkle_tree* tree, std::vector<uint64_t> indices)
+    {
+      std::sort(indices.begin(), indices.end());
+      indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+      offset = tree->offset;
+
+      // Collect the siblings on the path of each leaf, keyed by their level
+      // and position in the tree
+      std::map<std::pair<uint32_t, uint32_t>, crypto::Sha256Hash> siblings;
+      for (const auto index : indices)
+      {
+        Receipt r(tree, index);
+        max_index = r.get_max_index();
+        root = r.get_root();
+        leaves.emplace_back(index, r.get_step(0));
+
+        uint32_t k = index - offset;
+        uint32_t j = max_index;
+        bool actd = false;
+        uint32_t step = 1;
+        for (uint32_t lv = 0; j != 0; ++lv)
+        {
+          if (!is_promoted(k, j, actd))
+          {
+            siblings.emplace(std::make_pair(lv, k ^ 1), r.get_step(step++));
+          }
+          actd = actd || j % 2 == 1;
+          k /= 2;
+          j /= 2;
+        }
+      }
+
+      // Walk up the tree as verify() does, keeping only the siblings which
+      // cannot be computed from the leaves
+      std::vector<uint32_t> known;
+      for (const auto& [index, _] : leaves)
+      {
+        known.push_back(index - offset);
+      }
+
+      uint32_t j = max_index;
+      bool actd = false;
+      for (uint32_t lv = 0; j != 0; ++lv)
+      {
+        std::vector<uint32_t> parents;
+        for (size_t i = 0; i < known.size(); ++i)
+        {
+          const auto k = known[i];
+          if (!is_promoted(k, j, actd))
+          {
+            if (k % 2 == 0 && i + 1 < known.size() && known[i + 1] == k + 1)
+            {
+              // Both children are known
+              ++i;
+            }
+            else
+            {
+              proof.push_back(siblings.at(std::make_pair(lv, k ^ 1)));
+            }
+          }
+          parents.push_back(k / 2);
+        }
+        known.swap(parents);
+        actd = actd || j % 2 == 1;
+        j /= 2;
+      }
+    }
+
+    BatchReceipt(const BatchReceipt&) = delete;
+    BatchReceipt(BatchReceipt&&) = default;
+
+    /** Checks that the leaves and proof hash to the root of the receipt */
+    bool verify() const
+    {
+      std::map<uint32_t, crypto::Sha256Hash> level;
+      for (const auto& [index, leaf] : leaves)
+      {
+        if (index < offset || index - offset >= max_index)
+        {
+          return false;
+        }
+        level.emplace(index - offset, leaf);
+      }
+
+      if (level.empty() || level.size() != leaves.size())
+      {
+        return false;
+      }
+
+      size_t next_proof = 0;
+      uint32_t j = max_index;
+      bool actd = false;
+      while (j != 0)
+      {
+        std::map<uint32_t, crypto::Sha256Hash> parents;
+        for (auto it = level.begin(); it != level.end(); ++it)
+        {
+          const auto k = it->first;
+          const auto& acc = it->second;
+
+          if (is_promoted(k, j, actd))
+          {
+            parents.emplace_hint(parents.end(), k / 2, acc);
+            continue;
+          }
+
+          if (k % 2 == 0)
+          {
+            auto right = std::next(it);
+            if (right != level.end() && right->first == k + 1)
+            {
+              parents.emplace_hint(
+                parents.end(), k / 2, combine(acc, right->second));
+              it = right;
+              continue;
+            }
+          }
+
+          if (next_proof >= proof.size())
+          {
+            return false;
+          }
+          const auto& sibling = proof[next_proof++];
+          parents.emplace_hint(
+            parents.end(),
+            k / 2,
+            k % 2 == 0 ? combine(acc, sibling) : combine(sibling, acc));
+        }
+
+        level.swap(parents);
+        actd = actd || j % 2 == 1;
+        j /= 2;
+      }
+
+      return next_proof == proof.size() && level.size() == 1 &&
+        level.begin()->second == root;
+    }
+
+    std::vector<uint8_t> to_v() const
+    {
+      const auto hash_size = crypto::Sha256Hash::SIZE;
+      size_t vs = sizeof(offset) + sizeof(max_index) + hash_size +
+        sizeof(uint32_t) + leaves.size() * (sizeof(uint64_t) + hash_size) +
+        sizeof(uint32_t) + proof.size() * hash_size;
+      std::vector<uint8_t> v(vs);
+      uint8_t* buf = v.data();
+      serialized::write(buf, vs, offset);
+      serialized::write(buf, vs, max_index);
+      serialized::write(buf, vs, root.h.data(), hash_size);
+      serialized::write(buf, vs, static_cast<uint32_t>(leaves.size()));
+      for (const auto& [index, leaf] : leaves)
+      {
+        serialized::write(buf, vs, index);
+        serialized::write(buf, vs, leaf.h.data(), hash_size);
+      }
+      serialized::write(buf, vs, static_cast<uint32_t>(proof.size()));
+      for (const auto& hash : proof)
+      {
+        serialized::write(buf, vs, hash.h.data(), hash_size);
+      }
+      return v;
+    }
+
+    const crypto::Sha256Hash& get_root() const
+    {
+      return root;
+    }
+
+    size_t get_leaf_count() const
+    {
+      return leaves.size();
+    }
+
+    size_t get_proof_length() const
+    {
+      return proof.size();
+    }
+  };
+
   class MerkleTreeHistory
   {
     merkle_tree* tree;
@@ -400,6 +693,32 @@ namespace ccf
       return r.verify(tree);
     }
 
+    BatchReceipt get_batch_receipt(const std::vector<uint64_t>& indices)
+    {
+      if (indices.empty())
+      {
+        throw std::logic_error("Cannot produce receipt for no indices");
+      }
+
+      for (const auto index : indices)
+      {
+        if (index < begin_index())
+        {
+          throw std::logic_error(fmt::format(
+            "Cannot produce receipt for {}: index is too old and has been "
+            "flushed from memory",
+            index));
+        }
+        if (index > end_index())
+        {
+          throw std::logic_error(fmt::format(
+            "Cannot produce receipt for {}: index is not yet known", index));
+        }
+      }
+
+      return BatchReceipt(tree, indices);
+    }
+
     std::vector<uint8_t> serialise()
     {
       LOG_TRACE_FMT("mt_serialize_size {}", mt_serialize_size(tree));
@@ -467,8 +786,7 @@ namespace ccf
     std::optional<ResponseCallbackHandler> on_response;
 
     threading::Task::TimerEntry emit_signature_timer_entry;
-    size_t sig_tx_interval;
-    size_t sig_ms_interval;
+    SignaturePolicy signature_policy;
 
     void discard_pending(kv::Version v)
     {
@@ -492,12 +810,13 @@ namespace ccf
       NodeId id_,
       tls::KeyPair& kp_,
       size_t sig_tx_interval_ = 0,
-      size_t sig_ms_interval_ = 0) :
+      size_t sig_ms_interval_ = 0,
+      size_t sig_latency_target_ms_ = 0) :
       store(store_),
       id(id_),
       kp(kp_),
-      sig_tx_interval(sig_tx_interval_),
-      sig_ms_interval(sig_ms_interval_)
+      signature_policy(
+        sig_tx_interval_, sig_ms_interval_, sig_latency_target_ms_)
     {
       start_signature_emit_timer();
     }
@@ -517,43 +836,33 @@ namespace ccf
           std::unique_lock<SpinLock> mguard(
             self->signature_lock, std::defer_lock);
 
-          const int64_t sig_ms_interval = self->sig_ms_interval;
-          int64_t delta_time_to_next_sig = sig_ms_interval;
+          auto& policy = self->signature_policy;
+          auto delta_time_to_next_sig = policy.get_check_interval();
 
           if (mguard.try_lock())
           {
             // NOTE: time is set on every thread via a thread message
-            //       time_of_last_signature is a atomic that can be set by any
-            //       thread
             auto time = threading::ThreadMessaging::thread_messaging
-                          .get_current_time_offset()
-                          .count();
-            auto time_of_last_signature = self->time_of_last_signature.count();
+                          .get_current_time_offset();
 
             auto consensus = self->store.get_consensus();
-            if (
-              (consensus != nullptr) && consensus->is_primary() &&
-              self->store.commit_gap() > 0 && time > time_of_last_signature &&
-              (time - time_of_last_signature) > sig_ms_interval)
+            if ((consensus != nullptr) && consensus->is_primary())
             {
-              msg->data.self->emit_signature();
+              if (policy.should_emit_on_tick(
+                    time,
+                    self->store.current_version(),
+                    self->store.commit_gap()))
+              {
+                msg->data.self->emit_signature();
+              }
             }
 
-            delta_time_to_next_sig =
-              sig_ms_interval - (time - self->time_of_last_signature.count());
-
-            if (
-              delta_time_to_next_sig <= 0 ||
-              delta_time_to_next_sig > sig_ms_interval)
-            {
-              delta_time_to_next_sig = sig_ms_interval;
-            }
+            delta_time_to_next_sig = policy.next_check_delay(time);
           }
 
           self->emit_signature_timer_entry =
             threading::ThreadMessaging::thread_messaging.add_task_after(
-              std::move(msg),
-              std::chrono::milliseconds(delta_time_to_next_sig));
+              std::move(msg), delta_time_to_next_sig);
         },
         this);
 
@@ -635,6 +944,11 @@ namespace ccf
       return replicated_state_tree.get_root();
     }
 
+    SignatureStatistics get_signature_statistics() override
+    {
+      return signature_policy.get_statistics();
+    }
+
     void append(const std::vector<uint8_t>& replicated) override
     {
       append(replicated.data(), replicated.size());
@@ -723,12 +1037,17 @@ namespace ccf
     void rollback(kv::Version v) override
     {
       discard_pending(v);
+      signature_policy.on_rollback(v);
       replicated_state_tree.retract(v);
       log_hash(replicated_state_tree.get_root(), ROLLBACK);
     }
 
     void compact(kv::Version v) override
     {
+      signature_policy.on_commit(
+        threading::ThreadMessaging::thread_messaging.get_current_time_offset(),
+        v);
+
       flush_pending();
       // Receipts can only be retrieved to the flushed index. Keep a range of
       // history so that a range of receipts are available.
@@ -740,20 +1059,22 @@ namespace ccf
     }
 
     kv::Version last_signed_tx = 0;
-    std::chrono::milliseconds time_of_last_signature =
-      std::chrono::milliseconds(0);
 
     SpinLock signature_lock;
 
     void try_emit_signature() override
     {
       std::unique_lock<SpinLock> mguard(signature_lock, std::defer_lock);
-      if (store.commit_gap() < sig_tx_interval || !mguard.try_lock())
+      const auto time =
+        threading::ThreadMessaging::thread_messaging.get_current_time_offset();
+      if (
+        !signature_policy.should_emit_on_commit(time, store.commit_gap()) ||
+        !mguard.try_lock())
       {
         return;
       }
 
-      if (store.commit_gap() >= sig_tx_interval)
+      if (store.commit_gap() >= signature_policy.get_tx_interval())
       {
         emit_signature();
       }
@@ -780,8 +1101,9 @@ namespace ccf
       auto txid = store.next_txid();
 
       last_signed_tx = commit_txid.second;
-      time_of_last_signature =
-        threading::ThreadMessaging::thread_messaging.get_current_time_offset();
+      signature_policy.on_signature(
+        threading::ThreadMessaging::thread_messaging.get_current_time_offset(),
+        txid.version);
 
       LOG_DEBUG_FMT(
         "Signed at {} in view: {} commit was: {}.{}",
@@ -864,6 +1186,25 @@ namespace ccf
       return replicated_state_tree.verify(r);
     }
 
+    std::vector<uint8_t> get_batch_receipt(
+      const std::vector<kv::Version>& indices) override
+    {
+      return replicated_state_tree
+        .get_batch_receipt({indices.begin(), indices.end()})
+        .to_v();
+    }
+
+    bool verify_batch_receipt(const std::vector<uint8_t>& v) override
+    {
+      BatchReceipt r(v);
+      return r.verify();
+    }
+
+    kv::Version get_first_receipt_version() override
+    {
+      return replicated_state_tree.begin_index();
+    }
+
     std::vector<uint8_t> get_raw_leaf(uint64_t index) override
     {
       auto leaf = replicated_state_tree.get_leaf(index);
@@ -0,0 +1,43 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include "kv/value_spill.h"
+
+#if defined(INSIDE_ENCLAVE) && !defined(VIRTUAL_ENCLAVE)
+#  include <openenclave/enclave.h>
+#endif
+
+#include <new>
+
+namespace ccf
+{
+  // Holds sealed KV values in host memory, outside of the enclave heap.
+  // Virtual enclaves have no separate host memory, so use their own heap.
+  class HostSpillStorage : public kv::AbstractSpillStorage
+  {
+  public:
+    uint8_t* allocate(size_t size) override
+    {
+#if defined(INSIDE_ENCLAVE) && !defined(VIRTUAL_ENCLAVE)
+      auto data = static_cast<uint8_t*>(oe_host_malloc(size));
+      if (data == nullptr)
+      {
+        throw std::bad_alloc();
+      }
+      return data;
+#else
+      return new uint8_t[size];
+#endif
+    }
+
+    void deallocate(uint8_t* data, size_t) override
+    {
+#if defined(INSIDE_ENCLAVE) && !defined(VIRTUAL_ENCLAVE)
+      oe_host_free(data);
+#else
+      delete[] data;
+#endif
+    }
+  };
+}
@@ -0,0 +1,178 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include "ds/spin_lock.h"
+#include "kv/store.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace ccf::indexing
+{
+  using SeqNo = kv::Consensus::SeqNo;
+  using SeqNoCollection = std::vector<SeqNo>;
+
+  // An indexing strategy is fed the writes of each globally committed
+  // transaction to the map it is installed on, in commit order, and builds
+  // whatever summary of them it needs to answer queries that would otherwise
+  // require a scan of the ledger.
+  class Strategy
+  {
+  public:
+    virtual ~Strategy() = default;
+
+    virtual void handle_committed_writes(
+      kv::Version version, const kv::untyped::Write& writes) = 0;
+  };
+
+  // Records, for each key of a map, the seqnos of the transactions which wrote
+  // (or removed) that key. These can then be fetched individually from the
+  // historical state cache, rather than fetching every transaction in a range.
+  class SeqNosByKey : public Strategy
+  {
+  protected:
+    SpinLock lock;
+    std::unordered_map<kv::serialisers::SerialisedEntry, SeqNoCollection>
+      seqnos_by_key;
+    SeqNo last_seqno = 0;
+
+  public:
+    void handle_committed_writes(
+      kv::Version version, const kv::untyped::Write& writes) override
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      if (version <= last_seqno)
+      {
+        // Already indexed
+        return;
+      }
+
+      for (const auto& [key, _] : writes)
+      {
+        seqnos_by_key[key].push_back(version);
+      }
+      last_seqno = version;
+    }
+
+    /** Returns the seqnos, in increasing order, at which a key was written
+     *
+     * @param key Serialised key
+     * @param from First seqno of the range (inclusive)
+     * @param to Last seqno of the range (inclusive)
+     * @param max_seqnos Maximum number of seqnos to return
+     */
+    SeqNoCollection get_seqnos_for_key(
+      const kv::serialisers::SerialisedEntry& key,
+      SeqNo from,
+      SeqNo to,
+      size_t max_seqnos = SIZE_MAX)
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      const auto it = seqnos_by_key.find(key);
+      if (it == seqnos_by_key.end() || from > to)
+      {
+        return {};
+      }
+
+      const auto& seqnos = it->second;
+      const auto begin = std::lower_bound(seqnos.begin(), seqnos.end(), from);
+      const auto end = std::upper_bound(begin, seqnos.end(), to);
+      const auto count =
+        std::min<size_t>(std::distance(begin, end), max_seqnos);
+      return SeqNoCollection(begin, begin + count);
+    }
+
+    /** Last seqno for which writes have been indexed. Queries for later seqnos
+     * may return incomplete results.
+     */
+    SeqNo get_indexed_seqno()
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      return last_seqno;
+    }
+
+    size_t get_key_count()
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      return seqnos_by_key.size();
+    }
+  };
+
+  template <typename M>
+  class TypedSeqNosByKey : public SeqNosByKey
+  {
+  public:
+    template <typename K>
+    SeqNoCollection get_seqnos_for_key(
+      const K& key, SeqNo from, SeqNo to, size_t max_seqnos = SIZE_MAX)
+    {
+      return SeqNosByKey::get_seqnos_for_key(
+        M::KeySerialiser::to_serialised(key), from, to, max_seqnos);
+    }
+  };
+
+  // Feeds committed transactions to the strategies installed on each map, via
+  // the store's global commit hooks. A global hook already installed on a map
+  // when its first strategy is installed is still called, before the
+  // strategies.
+  //
+  // Only transactions committed while the node is running are indexed. On a
+  // node started from a snapshot, the transactions before the snapshot are not
+  // indexed.
+  class Indexer
+  {
+  protected:
+    struct MapStrategies
+    {
+      kv::untyped::Map::CommitHook previous_hook;
+      std::vector<std::shared_ptr<Strategy>> strategies;
+    };
+
+    kv::Store& store;
+    std::map<std::string, MapStrategies> strategies;
+
+  public:
+    Indexer(kv::Store& store_) : store(store_) {}
+
+    void install_strategy(
+      const std::string& map_name, const std::shared_ptr<Strategy>& strategy)
+    {
+      auto& map_strategies = strategies[map_name];
+      if (map_strategies.strategies.empty())
+      {
+        map_strategies.previous_hook = store.get_global_hook(map_name);
+      }
+      map_strategies.strategies.push_back(strategy);
+
+      store.set_global_hook(
+        map_name,
+        [previous_hook = map_strategies.previous_hook,
+         strategies = map_strategies.strategies](
+          kv::Version version, const kv::untyped::Write& w) {
+          if (previous_hook)
+          {
+            previous_hook(version, w);
+          }
+
+          for (const auto& s : strategies)
+          {
+            s->handle_committed_writes(version, w);
+          }
+        });
+    }
+
+    /** Last seqno up to which every committed transaction has been fed to the
+     * installed strategies. Queries for later seqnos may return incomplete
+     * results, and should be retried once this has caught up.
+     */
+    SeqNo get_indexed_seqno()
+    {
+      return store.commit_version();
+    }
+  };
+}
@@ -3,6 +3,7 @@
 #pragma once
 #include "backup_signatures.h"
 #include "call_types.h"
+#include "caller_certs.h"
 #include "certs.h"
 #include "client_signatures.h"
 #include "code_id.h"
@@ -103,6 +104,7 @@ namespace ccf
     BackupSignaturesMap backup_signatures_map;
     aft::RevealedNoncesMap revealed_nonces_map;
     NewViewsMap new_views_map;
+    CallerCerts caller_certs;
 
     NetworkTables(const ConsensusType& consensus_type = ConsensusType::CFT) :
       tables(
@@ -144,7 +146,8 @@ namespace ccf
       bft_requests_map(Tables::AFT_REQUESTS),
       backup_signatures_map(Tables::BACKUP_SIGNATURES),
       revealed_nonces_map(Tables::NONCES),
-      new_views_map(Tables::NEW_VIEWS)
+      new_views_map(Tables::NEW_VIEWS),
+      caller_certs(Tables::CALLER_CERTS)
     {}
 
     /** Returns a tuple of all tables that are possibly accessible from scripts
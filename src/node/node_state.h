@@ -11,6 +11,7 @@
 #include "entities.h"
 #include "genesis_gen.h"
 #include "history.h"
+#include "host_spill_storage.h"
 #include "network_state.h"
 #include "node/jwt_key_auto_refresh.h"
 #include "node/progress_tracker.h"
@@ -145,6 +146,7 @@ namespace ccf
     consensus::Config consensus_config;
     size_t sig_tx_interval;
     size_t sig_ms_interval;
+    size_t sig_latency_target_ms;
 
     NetworkState& network;
 
@@ -152,6 +154,8 @@ namespace ccf
     std::shared_ptr<enclave::RPCMap> rpc_map;
     std::shared_ptr<NodeToNode> n2n_channels;
     std::shared_ptr<Forwarder<NodeToNode>> cmd_forwarder;
+    std::shared_ptr<CommitNotifier> commit_notifier;
+    std::shared_ptr<PendingReads> pending_reads;
     std::shared_ptr<enclave::RPCSessions> rpcsessions;
 
     std::shared_ptr<kv::TxHistory> history;
@@ -217,8 +221,11 @@ namespace ccf
       std::shared_ptr<NodeToNode> n2n_channels_,
       std::shared_ptr<enclave::RPCMap> rpc_map_,
       std::shared_ptr<Forwarder<NodeToNode>> cmd_forwarder_,
+      std::shared_ptr<CommitNotifier> commit_notifier_,
+      std::shared_ptr<PendingReads> pending_reads_,
       size_t sig_tx_interval_,
-      size_t sig_ms_interval_)
+      size_t sig_ms_interval_,
+      size_t sig_latency_target_ms_)
     {
       std::lock_guard<SpinLock> guard(lock);
       sm.expect(State::uninitialized);
@@ -227,8 +234,12 @@ namespace ccf
       n2n_channels = n2n_channels_;
       rpc_map = rpc_map_;
       cmd_forwarder = cmd_forwarder_;
+      commit_notifier = commit_notifier_;
+      pending_reads = pending_reads_;
       sig_tx_interval = sig_tx_interval_;
       sig_ms_interval = sig_ms_interval_;
+      sig_latency_target_ms = sig_latency_target_ms_;
+      setup_parallel_for(*network.tables);
       sm.advance(State::initialized);
     }
 
@@ -242,6 +253,8 @@ namespace ccf
 
       create_node_cert(args.config);
       open_node_frontend();
+      setup_value_spill(args.config);
+      network.tables->set_record_map_sizes(args.config.kv_record_map_sizes);
 
 #ifdef GET_QUOTE
       if (network.consensus_type != ConsensusType::BFT)
@@ -922,7 +935,8 @@ namespace ccf
         self,
         *node_sign_kp,
         sig_tx_interval,
-        sig_ms_interval);
+        sig_ms_interval,
+        sig_latency_target_ms);
 
 #ifdef USE_NULL_ENCRYPTOR
       recovery_encryptor = std::make_shared<kv::NullTxEncryptor>();
@@ -947,6 +961,7 @@ namespace ccf
 
       recovery_store->set_history(recovery_history);
       recovery_store->set_encryptor(recovery_encryptor);
+      setup_parallel_for(*recovery_store);
 
       // Record real store version and root
       recovery_v = network.tables->current_version();
@@ -1689,6 +1704,8 @@ namespace ccf
         std::chrono::milliseconds(consensus_config.bft_view_change_timeout),
         sig_tx_interval,
         public_only);
+      raft->set_commit_notifier(commit_notifier);
+      raft->set_pending_reads(pending_reads);
 
       consensus = std::make_shared<RaftConsensusType>(
         std::move(raft), network.consensus_type);
@@ -1758,7 +1775,8 @@ namespace ccf
         self,
         *node_sign_kp,
         sig_tx_interval,
-        sig_ms_interval);
+        sig_ms_interval,
+        sig_latency_target_ms);
 
       network.tables->set_history(history);
     }
@@ -1790,6 +1808,33 @@ namespace ccf
       network.tables->set_encryptor(encryptor);
     }
 
+    void setup_value_spill(const CCFConfig& config)
+    {
+      if (config.kv_spill_threshold == 0)
+      {
+        return;
+      }
+
+      // Sealed values never leave this node, and do not outlive it, so they
+      // are sealed with a fresh key rather than with a key derived from the
+      // ledger secrets, which are shared with every node
+      network.tables->set_value_spill(std::make_shared<kv::ValueSpill>(
+        tls::create_entropy()->random(crypto::GCM_SIZE_KEY),
+        config.kv_spill_threshold,
+        config.kv_spill_cache_size,
+        std::make_shared<HostSpillStorage>()));
+    }
+
+    // Snapshots of large stores are serialised and loaded on all the enclave
+    // threads, rather than on the calling thread only
+    void setup_parallel_for(kv::Store& store)
+    {
+      store.set_parallel_for(
+        [](size_t n, const std::function<void(size_t)>& fn) {
+          threading::ThreadMessaging::thread_messaging.parallel_for(n, fn);
+        });
+    }
+
     void setup_consensus(bool public_only = false)
     {
       setup_raft(public_only);
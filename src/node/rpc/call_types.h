@@ -29,6 +29,11 @@ namespace ccf
     {
       kv::Consensus::View view;
       kv::Consensus::SeqNo seqno;
+
+      bool operator==(const In& other) const
+      {
+        return view == other.view && seqno == other.seqno;
+      }
     };
 
     struct Out
@@ -37,6 +42,18 @@ namespace ccf
     };
   };
 
+  struct SubscribeTxStatus
+  {
+    struct In
+    {
+      std::vector<GetTxStatus::In> txs = {};
+      bool own_txs = false;
+      size_t ack = 0;
+    };
+
+    using Out = TxStatusNotification;
+  };
+
   struct GetMetrics
   {
     struct HistogramResults
@@ -48,10 +65,24 @@ namespace ccf
       nlohmann::json buckets = {};
     };
 
+    struct SignatureResults
+    {
+      bool adaptive = {};
+      size_t tx_interval = {};
+      size_t ms_interval = {};
+      size_t latency_target_ms = {};
+      size_t commit_latency_samples = {};
+      size_t commit_latency_p50_ms = {};
+      size_t commit_latency_p90_ms = {};
+      size_t commit_latency_p99_ms = {};
+      size_t commit_latency_max_ms = {};
+    };
+
     struct Out
     {
       HistogramResults histogram;
       nlohmann::json tx_rates;
+      SignatureResults signatures;
     };
   };
 
@@ -144,6 +175,8 @@ namespace ccf
       size_t calls = 0;
       size_t errors = 0;
       size_t failures = 0;
+      size_t conflicts = 0;
+      std::vector<size_t> retries = {};
     };
 
     struct Out
@@ -165,11 +198,32 @@ namespace ccf
     };
   };
 
+  struct GetBatchReceipt
+  {
+    static constexpr size_t max_commits = 10'000;
+
+    struct In
+    {
+      int64_t from_commit = 0;
+      int64_t to_commit = 0;
+    };
+
+    struct Out
+    {
+      // One receipt for the commits covered by each signature. There is a
+      // single receipt unless the commits have been flushed from the node's
+      // Merkle tree and span several signatures.
+      std::vector<std::vector<std::uint8_t>> receipts = {};
+    };
+  };
+
   struct VerifyReceipt
   {
     struct In
     {
       std::vector<std::uint8_t> receipt = {};
+      // Set if the receipt was produced by receipt/batch
+      bool batch = false;
     };
 
     struct Out
@@ -0,0 +1,356 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include "ds/logger.h"
+#include "ds/spin_lock.h"
+#include "enclave/forwarder_types.h"
+#include "http/ws_builder.h"
+#include "node/rpc/serdes.h"
+#include "tx_status.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace ccf
+{
+  // Pushes the final status (COMMITTED or INVALID) of transactions to
+  // websocket sessions which have subscribed to them, as the local commit
+  // point advances. This replaces polling of the tx endpoint.
+  //
+  // A session subscribes to explicit transaction IDs, and/or to all write
+  // transactions it executes on this node. Each advance of the commit point
+  // results in at most one notification per session, containing all of the
+  // status updates for that session.
+  //
+  // Slow subscribers are handled with a credit scheme: a session has at most
+  // max_in_flight unacknowledged notifications. Beyond that, updates are held
+  // back and coalesced into a single notification once the subscriber
+  // acknowledges. The number of transactions tracked for each session is
+  // bounded, transactions which cannot be tracked are reported as dropped.
+  class CommitNotifier
+  {
+  public:
+    using View = int64_t;
+    using SeqNo = int64_t;
+    using ViewAt = std::function<View(SeqNo)>;
+
+    static constexpr size_t default_max_subscribers = 1000;
+    static constexpr size_t default_max_watched = 1 << 16;
+    static constexpr size_t default_max_in_flight = 64;
+
+    enum class WatchResult
+    {
+      OK,
+      NOT_SUBSCRIBED,
+      TOO_MANY_TXS
+    };
+
+  private:
+    struct Subscriber
+    {
+      serdes::Pack pack = serdes::Pack::Text;
+      bool own_txs = false;
+
+      // Transactions whose final status is not yet known. There may be
+      // several views for a single seqno.
+      std::multimap<SeqNo, View> watched;
+
+      // Final statuses not yet pushed to the subscriber
+      std::vector<TxStatusUpdate> pending;
+      size_t dropped = 0;
+
+      size_t in_flight = 0;
+    };
+
+    struct Push
+    {
+      size_t session_id;
+      std::vector<uint8_t> frame;
+    };
+
+    std::shared_ptr<enclave::AbstractRPCResponder> responder;
+    const size_t max_subscribers;
+    const size_t max_watched;
+    const size_t max_in_flight;
+
+    SpinLock lock;
+    std::unordered_map<size_t, Subscriber> subscribers;
+    View committed_view = 0;
+    SeqNo committed_seqno = 0;
+
+    size_t tracked(const Subscriber& s) const
+    {
+      return s.watched.size() + s.pending.size();
+    }
+
+    static std::vector<uint8_t> make_frame(
+      const TxStatusNotification& n, serdes::Pack pack)
+    {
+      return ws::make_out_frame(
+        HTTP_STATUS_OK,
+        n.seqno,
+        n.view,
+        n.seqno,
+        serdes::pack(nlohmann::json(n), pack));
+    }
+
+    std::optional<Push> take_push(size_t session_id, Subscriber& s)
+    {
+      if (
+        (s.pending.empty() && s.dropped == 0) || s.in_flight >= max_in_flight)
+      {
+        return std::nullopt;
+      }
+
+      TxStatusNotification n;
+      n.view = committed_view;
+      n.seqno = committed_seqno;
+      n.updates.swap(s.pending);
+      n.dropped = s.dropped;
+      s.dropped = 0;
+      ++s.in_flight;
+
+      return Push{session_id, make_frame(n, s.pack)};
+    }
+
+    void send(std::vector<Push>&& pushes)
+    {
+      for (auto& push : pushes)
+      {
+        if (!responder->reply_async(push.session_id, std::move(push.frame)))
+        {
+          LOG_DEBUG_FMT(
+            "Removing commit subscription for closed session {}",
+            push.session_id);
+          unsubscribe(push.session_id);
+        }
+      }
+    }
+
+  public:
+    CommitNotifier(
+      std::shared_ptr<enclave::AbstractRPCResponder> responder_,
+      size_t max_subscribers_ = default_max_subscribers,
+      size_t max_watched_ = default_max_watched,
+      size_t max_in_flight_ = default_max_in_flight) :
+      responder(responder_),
+      max_subscribers(max_subscribers_),
+      max_watched(max_watched_),
+      max_in_flight(max_in_flight_)
+    {}
+
+    /** Creates or updates the subscription of a session
+     *
+     * @param session_id Client session to which notifications are pushed
+     * @param pack Encoding of the notifications
+     * @param own_txs If true, all write transactions executed on this node
+     *  for this session are tracked
+     *
+     * @return false if the maximum number of subscribers is reached
+     */
+    bool subscribe(size_t session_id, serdes::Pack pack, bool own_txs)
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      auto it = subscribers.find(session_id);
+      if (it == subscribers.end())
+      {
+        if (subscribers.size() >= max_subscribers)
+        {
+          return false;
+        }
+        it = subscribers.emplace(session_id, Subscriber()).first;
+      }
+      it->second.pack = pack;
+      it->second.own_txs = it->second.own_txs || own_txs;
+      return true;
+    }
+
+    void unsubscribe(size_t session_id)
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      subscribers.erase(session_id);
+    }
+
+    bool is_subscribed(size_t session_id)
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      return subscribers.find(session_id) != subscribers.end();
+    }
+
+    size_t subscriber_count()
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      return subscribers.size();
+    }
+
+    /** Tracks a transaction explicitly requested by a subscriber. The caller
+     * should check the current status of the transaction after this returns,
+     * since the commit point may have passed it already.
+     */
+    WatchResult watch(size_t session_id, View view, SeqNo seqno)
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      auto it = subscribers.find(session_id);
+      if (it == subscribers.end())
+      {
+        return WatchResult::NOT_SUBSCRIBED;
+      }
+
+      auto& s = it->second;
+      if (tracked(s) >= max_watched)
+      {
+        return WatchResult::TOO_MANY_TXS;
+      }
+
+      s.watched.emplace(seqno, view);
+      return WatchResult::OK;
+    }
+
+    /** Stops tracking a transaction whose final status has already been
+     * returned to the subscriber
+     */
+    void unwatch(size_t session_id, View view, SeqNo seqno)
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      auto it = subscribers.find(session_id);
+      if (it == subscribers.end())
+      {
+        return;
+      }
+
+      auto& watched = it->second.watched;
+      auto [begin, end] = watched.equal_range(seqno);
+      for (auto w = begin; w != end; ++w)
+      {
+        if (w->second == view)
+        {
+          watched.erase(w);
+          return;
+        }
+      }
+    }
+
+    /** Called by the frontend for each write transaction executed on this
+     * node. Only tracked if the session subscribed to its own transactions.
+     */
+    void watch_own_tx(size_t session_id, View view, SeqNo seqno)
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      auto it = subscribers.find(session_id);
+      if (it == subscribers.end() || !it->second.own_txs)
+      {
+        return;
+      }
+
+      auto& s = it->second;
+      if (tracked(s) >= max_watched)
+      {
+        ++s.dropped;
+        return;
+      }
+
+      s.watched.emplace(seqno, view);
+    }
+
+    /** Returns credits to a subscriber, and pushes any updates that were held
+     * back while it had none left
+     *
+     * @param session_id Subscriber session
+     * @param count Number of notifications processed by the subscriber
+     */
+    void acknowledge(size_t session_id, size_t count)
+    {
+      std::vector<Push> pushes;
+      {
+        std::lock_guard<SpinLock> guard(lock);
+        auto it = subscribers.find(session_id);
+        if (it == subscribers.end())
+        {
+          return;
+        }
+
+        auto& s = it->second;
+        s.in_flight -= std::min(count, s.in_flight);
+        auto push = take_push(session_id, s);
+        if (push.has_value())
+        {
+          pushes.push_back(std::move(push.value()));
+        }
+      }
+      send(std::move(pushes));
+    }
+
+    /** Called by consensus when the local commit point advances
+     *
+     * @param seqno New commit point
+     * @param view_at Returns the view in which a (committed) seqno was
+     *  replicated
+     */
+    void on_commit(SeqNo seqno, const ViewAt& view_at)
+    {
+      std::vector<Push> pushes;
+      {
+        std::lock_guard<SpinLock> guard(lock);
+        if (seqno <= committed_seqno)
+        {
+          return;
+        }
+
+        const auto previous_view = committed_view;
+        committed_seqno = seqno;
+        committed_view = view_at(seqno);
+        const bool view_changed = committed_view > previous_view;
+
+        for (auto& [session_id, s] : subscribers)
+        {
+          // Committed seqnos have a final status
+          auto end = s.watched.upper_bound(committed_seqno);
+          for (auto w = s.watched.begin(); w != end; ++w)
+          {
+            const auto& [tx_seqno, tx_view] = *w;
+            const auto status = view_at(tx_seqno) == tx_view ?
+              TxStatus::Committed :
+              TxStatus::Invalid;
+            s.pending.push_back({tx_view, tx_seqno, status});
+          }
+          s.watched.erase(s.watched.begin(), end);
+
+          // Uncommitted seqnos from an earlier view than the commit point can
+          // never be committed
+          if (view_changed)
+          {
+            for (auto w = s.watched.begin(); w != s.watched.end();)
+            {
+              if (w->second < committed_view)
+              {
+                s.pending.push_back({w->second, w->first, TxStatus::Invalid});
+                w = s.watched.erase(w);
+              }
+              else
+              {
+                ++w;
+              }
+            }
+          }
+
+          auto push = take_push(session_id, s);
+          if (push.has_value())
+          {
+            pushes.push_back(std::move(push.value()));
+          }
+        }
+      }
+      send(std::move(pushes));
+    }
+
+    std::pair<View, SeqNo> get_committed_txid()
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      return {committed_view, committed_seqno};
+    }
+  };
+}
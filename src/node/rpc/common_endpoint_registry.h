@@ -8,6 +8,9 @@
 #include "json_handler.h"
 #include "metrics.h"
 #include "node/code_id.h"
+#include "node/historical_queries_interface.h"
+
+#include <numeric>
 
 namespace ccf
 {
@@ -83,8 +86,96 @@ namespace ccf
         .set_execute_locally(true)
         .install();
 
+      auto subscribe_tx_status = [this](auto& args, nlohmann::json&& params) {
+        if (args.rpc_ctx->frame_format() != enclave::FrameFormat::ws)
+        {
+          return make_error(
+            HTTP_STATUS_BAD_REQUEST,
+            "Transaction status subscriptions require a websocket session");
+        }
+
+        if (consensus == nullptr || commit_notifier == nullptr)
+        {
+          return make_error(
+            HTTP_STATUS_INTERNAL_SERVER_ERROR,
+            "Consensus is not yet configured");
+        }
+
+        const auto in = params.is_null() ? SubscribeTxStatus::In() :
+                                           params.get<SubscribeTxStatus::In>();
+        const auto session_id = args.rpc_ctx->session->client_session_id;
+
+        if (!commit_notifier->subscribe(
+              session_id,
+              jsonhandler::detect_json_pack(args.rpc_ctx),
+              in.own_txs))
+        {
+          return make_error(
+            HTTP_STATUS_SERVICE_UNAVAILABLE,
+            "Too many sessions are subscribed to transaction statuses");
+        }
+
+        // Transactions are watched before their current status is checked, so
+        // that a concurrent commit cannot be missed
+        for (auto it = in.txs.begin(); it != in.txs.end(); ++it)
+        {
+          if (
+            commit_notifier->watch(session_id, it->view, it->seqno) !=
+            CommitNotifier::WatchResult::OK)
+          {
+            for (auto w = in.txs.begin(); w != it; ++w)
+            {
+              commit_notifier->unwatch(session_id, w->view, w->seqno);
+            }
+            return make_error(
+              HTTP_STATUS_TOO_MANY_REQUESTS,
+              "Too many transactions are watched by this session");
+          }
+        }
+
+        SubscribeTxStatus::Out out;
+        out.seqno = consensus->get_committed_seqno();
+        out.view = consensus->get_view(out.seqno);
+        for (const auto& tx : in.txs)
+        {
+          const auto status = ccf::get_tx_status(
+            tx.view,
+            tx.seqno,
+            consensus->get_view(tx.seqno),
+            out.view,
+            out.seqno);
+          if (status == TxStatus::Committed || status == TxStatus::Invalid)
+          {
+            commit_notifier->unwatch(session_id, tx.view, tx.seqno);
+            out.updates.push_back({tx.view, tx.seqno, status});
+          }
+        }
+
+        commit_notifier->acknowledge(session_id, in.ack);
+        return make_success(out);
+      };
+      make_command_endpoint(
+        "tx/subscribe",
+        ws::Verb::WEBSOCKET,
+        json_command_adapter(subscribe_tx_status))
+        .set_execute_locally(true)
+        .install();
+
       auto get_metrics = [this](auto&, nlohmann::json&&) {
         auto result = metrics.get_metrics();
+        if (history != nullptr)
+        {
+          const auto s = history->get_signature_statistics();
+          result.signatures = {s.adaptive,
+                               s.tx_interval,
+                               s.ms_interval,
+                               s.latency_target_ms,
+                               s.commit_latency_samples,
+                               s.commit_latency_p50_ms,
+                               s.commit_latency_p90_ms,
+                               s.commit_latency_p99_ms,
+                               s.commit_latency_max_ms};
+        }
         return make_success(result);
       };
       make_command_endpoint(
@@ -281,6 +372,96 @@ namespace ccf
         .set_auto_schema<GetReceipt>()
         .install();
 
+      auto get_batch_receipt = [this](auto& args, nlohmann::json&& params) {
+        const auto in = params.get<GetBatchReceipt::In>();
+
+        if (in.from_commit < 1)
+        {
+          return make_error(
+            HTTP_STATUS_BAD_REQUEST,
+            fmt::format(
+              "Invalid range: from_commit {} must be positive",
+              in.from_commit));
+        }
+
+        if (in.from_commit > in.to_commit)
+        {
+          return make_error(
+            HTTP_STATUS_BAD_REQUEST,
+            fmt::format(
+              "Invalid range: from_commit {} is past to_commit {}",
+              in.from_commit,
+              in.to_commit));
+        }
+
+        const size_t count = in.to_commit - in.from_commit + 1;
+        if (count > GetBatchReceipt::max_commits)
+        {
+          return make_error(
+            HTTP_STATUS_BAD_REQUEST,
+            fmt::format(
+              "Cannot produce a receipt for more than {} commits",
+              GetBatchReceipt::max_commits));
+        }
+
+        std::vector<kv::Version> commits(count);
+        std::iota(commits.begin(), commits.end(), in.from_commit);
+
+        if (
+          history != nullptr && historical_state != nullptr &&
+          in.from_commit < history->get_first_receipt_version())
+        {
+          // These commits have been flushed from the node's Merkle tree, so
+          // their receipts are built from the trees of the signatures which
+          // cover them, fetched from the ledger
+          auto receipts = historical_state->get_batch_receipts(
+            {commits.begin(), commits.end()});
+          if (receipts.empty())
+          {
+            static constexpr size_t retry_after_seconds = 3;
+            args.rpc_ctx->set_response_header(
+              http::headers::RETRY_AFTER, retry_after_seconds);
+            return make_error(
+              HTTP_STATUS_ACCEPTED,
+              fmt::format(
+                "Historical commits {} to {} are not yet available, fetching "
+                "now",
+                in.from_commit,
+                in.to_commit));
+          }
+
+          return make_success(GetBatchReceipt::Out{std::move(receipts)});
+        }
+
+        if (history != nullptr)
+        {
+          try
+          {
+            auto p = history->get_batch_receipt(commits);
+            const GetBatchReceipt::Out out{{p}};
+
+            return make_success(out);
+          }
+          catch (const std::exception& e)
+          {
+            return make_error(
+              HTTP_STATUS_INTERNAL_SERVER_ERROR,
+              fmt::format(
+                "Unable to produce receipt for commits {} to {} : {}",
+                in.from_commit,
+                in.to_commit,
+                e.what()));
+          }
+        }
+
+        return make_error(
+          HTTP_STATUS_INTERNAL_SERVER_ERROR, "Unable to produce receipt");
+      };
+      make_command_endpoint(
+        "receipt/batch", HTTP_GET, json_command_adapter(get_batch_receipt))
+        .set_auto_schema<GetBatchReceipt>()
+        .install();
+
       auto verify_receipt = [this](auto&, nlohmann::json&& params) {
         const auto in = params.get<VerifyReceipt::In>();
 
@@ -288,7 +469,8 @@ namespace ccf
         {
           try
           {
-            bool v = history->verify_receipt(in.receipt);
+            bool v = in.batch ? history->verify_batch_receipt(in.receipt) :
+                                history->verify_receipt(in.receipt);
             const VerifyReceipt::Out out{v};
 
             return make_success(out);
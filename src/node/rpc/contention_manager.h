@@ -0,0 +1,165 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include "ds/hash.h"
+#include "ds/spin_lock.h"
+#include "ds/thread_messaging.h"
+#include "kv/tx.h"
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace ccf
+{
+  // Learns which keys are contended from the keys on which transactions
+  // conflict, and serialises the re-execution of transactions which conflicted
+  // on a contended key, so that they do not repeatedly conflict with each
+  // other. Keys are hashed into a fixed number of partitions, each with a
+  // queue of re-executions and a count of recent conflicts which decays on
+  // every tick. Re-executions are queued rather than waited for, and the
+  // re-executions of a partition are run one at a time, each as a task on the
+  // thread it was queued for (the thread of its session, which owns the
+  // session's state). Transactions which have not conflicted, or whose
+  // conflicts are on keys which are rarely contended, are executed
+  // optimistically without being queued.
+  class ContentionManager
+  {
+  public:
+    static constexpr size_t partition_count = 64;
+
+    // A partition is contended once this many conflicts on its keys have been
+    // recorded since the counts last decayed
+    static constexpr uint32_t contended_threshold = 4;
+
+    using Job = std::function<void()>;
+
+  private:
+    struct QueuedJob
+    {
+      uint16_t thread;
+      Job job;
+    };
+
+    struct Partition
+    {
+      SpinLock lock;
+      // Whether one of this partition's jobs is posted or running. Only then
+      // are further jobs held in the queue.
+      bool active = false;
+      std::deque<QueuedJob> queue;
+      std::atomic<uint32_t> recent_conflicts = 0;
+    };
+
+    std::array<Partition, partition_count> partitions;
+
+    struct JobMsg
+    {
+      JobMsg(ContentionManager& manager_, size_t partition_, Job&& job_) :
+        manager(manager_),
+        partition(partition_),
+        job(std::move(job_))
+      {}
+
+      ContentionManager& manager;
+      size_t partition;
+      Job job;
+    };
+
+    static void run_job(std::unique_ptr<threading::Tmsg<JobMsg>> msg)
+    {
+      msg->data.job();
+      msg->data.manager.next(msg->data.partition);
+    }
+
+    void post(size_t partition, QueuedJob&& queued)
+    {
+      threading::ThreadMessaging::thread_messaging.add_task(
+        queued.thread,
+        std::make_unique<threading::Tmsg<JobMsg>>(
+          &run_job, *this, partition, std::move(queued.job)));
+    }
+
+    void next(size_t partition)
+    {
+      auto& p = partitions[partition];
+      QueuedJob queued;
+      {
+        std::lock_guard<SpinLock> guard(p.lock);
+        if (p.queue.empty())
+        {
+          p.active = false;
+          return;
+        }
+        queued = std::move(p.queue.front());
+        p.queue.pop_front();
+      }
+      post(partition, std::move(queued));
+    }
+
+  public:
+    static size_t get_partition(const kv::ConflictingKey& conflict)
+    {
+      size_t n = std::hash<std::string>()(conflict.map_name);
+      std::hash<kv::serialisers::SerialisedEntry> h;
+      ds::hashutils::hash_combine(n, conflict.key, h);
+      return n % partition_count;
+    }
+
+    /** Record a conflict on a key
+     *
+     * @return true if the key's partition is contended, in which case the
+     * transaction should be re-executed from the partition's queue
+     */
+    bool record_conflict(size_t partition)
+    {
+      return ++partitions[partition].recent_conflicts >= contended_threshold;
+    }
+
+    /** Queue the re-execution of a transaction which conflicted on one of a
+     * partition's keys. It runs after the re-executions already queued for
+     * that partition, and not concurrently with any of them.
+     *
+     * @param partition Partition of the key the transaction conflicted on
+     * @param thread Thread on which the re-execution runs
+     * @param job Re-execution
+     */
+    void serialise(size_t partition, uint16_t thread, Job&& job)
+    {
+      auto& p = partitions[partition];
+      {
+        std::lock_guard<SpinLock> guard(p.lock);
+        if (p.active)
+        {
+          p.queue.push_back({thread, std::move(job)});
+          return;
+        }
+        p.active = true;
+      }
+      post(partition, {thread, std::move(job)});
+    }
+
+    size_t queued(size_t partition)
+    {
+      auto& p = partitions[partition];
+      std::lock_guard<SpinLock> guard(p.lock);
+      return p.queue.size();
+    }
+
+    bool is_contended(size_t partition) const
+    {
+      return partitions[partition].recent_conflicts >= contended_threshold;
+    }
+
+    void tick()
+    {
+      for (auto& p : partitions)
+      {
+        p.recent_conflicts = p.recent_conflicts / 2;
+      }
+    }
+  };
+}
@@ -2,6 +2,7 @@
 // Licensed under the Apache 2.0 License.
 #pragma once
 
+#include "commit_notifier.h"
 #include "ds/json_schema.h"
 #include "ds/openapi.h"
 #include "enclave/rpc_context.h"
@@ -13,12 +14,19 @@
 #include "node/certs.h"
 #include "serialization.h"
 
+#include <algorithm>
+#include <array>
 #include <functional>
 #include <llhttp/llhttp.h>
 #include <nlohmann/json.hpp>
 #include <regex>
 #include <set>
 
+namespace ccf::historical
+{
+  class AbstractStateCache;
+}
+
 namespace ccf
 {
   using namespace endpoints;
@@ -81,9 +89,15 @@ namespace ccf
 
     struct Metrics
     {
+      // Number of times a transaction is executed before giving up on it
+      static constexpr size_t max_attempts = 30;
+
       size_t calls = 0;
       size_t errors = 0;
       size_t failures = 0;
+      size_t conflicts = 0;
+      // retries[i] is the number of calls which committed after i retries
+      std::array<size_t, max_attempts> retries = {};
     };
 
     struct Endpoint;
@@ -454,6 +468,8 @@ namespace ccf
 
     kv::Consensus* consensus = nullptr;
     kv::TxHistory* history = nullptr;
+    std::shared_ptr<CommitNotifier> commit_notifier = nullptr;
+    historical::AbstractStateCache* historical_state = nullptr;
 
     std::string certs_table_name;
     std::string digests_table_name;
@@ -676,7 +692,17 @@ namespace ccf
         for (const auto& [verb, metric] : verb_metrics)
         {
           std::string v(verb.c_str());
-          out.metrics[path][v] = {metric.calls, metric.errors, metric.failures};
+          auto& m = out.metrics[path][v];
+          m.calls = metric.calls;
+          m.errors = metric.errors;
+          m.failures = metric.failures;
+          m.conflicts = metric.conflicts;
+
+          auto last = std::find_if(
+            metric.retries.rbegin(), metric.retries.rend(), [](size_t n) {
+              return n != 0;
+            });
+          m.retries.assign(metric.retries.begin(), last.base());
         }
       }
     }
@@ -889,5 +915,15 @@ namespace ccf
     {
       history = h;
     }
+
+    void set_commit_notifier(std::shared_ptr<CommitNotifier> n)
+    {
+      commit_notifier = n;
+    }
+
+    void set_historical_state(historical::AbstractStateCache* h)
+    {
+      historical_state = h;
+    }
   };
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "enclave/rpc_map.h"
 #include "http/http_rpc_context.h"
 #include "kv/kv_types.h"
+#include "node/caller_certs.h"
 #include "node/node_to_node.h"
 #include "node/request_tracker.h"
 
@@ -31,8 +32,6 @@ namespace ccf
     ConsensusType consensus_type;
     NodeId self;
 
-    using IsCallerCertForwarded = bool;
-
   public:
     Forwarder(
       std::shared_ptr<enclave::AbstractRPCResponder> rpcresponder,
@@ -61,18 +60,24 @@ namespace ccf
       NodeId to,
       std::set<NodeId> nodes,
       CallerId caller_id,
-      const std::vector<uint8_t>& caller_cert)
+      const std::vector<uint8_t>& caller_cert,
+      const std::optional<crypto::Sha256Hash>& caller_cert_digest)
     {
-      IsCallerCertForwarded include_caller = false;
+      auto caller_format = CallerCertFormat::None;
       const auto method = rpc_ctx->get_method();
       const auto& raw_request = rpc_ctx->get_serialised_request();
       size_t size = sizeof(caller_id) +
-        sizeof(rpc_ctx->session->client_session_id) +
-        sizeof(IsCallerCertForwarded) + raw_request.size();
-      if (!caller_cert.empty())
+        sizeof(rpc_ctx->session->client_session_id) + sizeof(caller_format) +
+        raw_request.size();
+      if (caller_cert_digest.has_value())
+      {
+        size += crypto::Sha256Hash::SIZE;
+        caller_format = CallerCertFormat::Digest;
+      }
+      else if (!caller_cert.empty())
       {
         size += sizeof(size_t) + caller_cert.size();
-        include_caller = true;
+        caller_format = CallerCertFormat::Cert;
       }
 
       std::vector<uint8_t> plain(size);
@@ -80,8 +85,12 @@ namespace ccf
       auto size_ = plain.size();
       serialized::write(data_, size_, caller_id);
       serialized::write(data_, size_, rpc_ctx->session->client_session_id);
-      serialized::write(data_, size_, include_caller);
-      if (include_caller)
+      serialized::write(data_, size_, caller_format);
+      if (caller_format == CallerCertFormat::Digest)
+      {
+        serialized::write(data_, size_, caller_cert_digest->h);
+      }
+      else if (caller_format == CallerCertFormat::Cert)
       {
         serialized::write(data_, size_, caller_cert.size());
         serialized::write(data_, size_, caller_cert.data(), caller_cert.size());
@@ -146,9 +155,15 @@ namespace ccf
       auto size_ = plain_.size();
       auto caller_id = serialized::read<CallerId>(data_, size_);
       auto client_session_id = serialized::read<size_t>(data_, size_);
-      auto includes_caller =
-        serialized::read<IsCallerCertForwarded>(data_, size_);
-      if (includes_caller)
+      std::optional<crypto::Sha256Hash> caller_cert_digest = std::nullopt;
+      auto caller_format = serialized::read<CallerCertFormat>(data_, size_);
+      if (caller_format == CallerCertFormat::Digest)
+      {
+        crypto::Sha256Hash digest;
+        digest.h = serialized::read<decltype(digest.h)>(data_, size_);
+        caller_cert_digest = digest;
+      }
+      else if (caller_format == CallerCertFormat::Cert)
       {
         auto caller_size = serialized::read<size_t>(data_, size_);
         caller_cert = serialized::read(data_, size_, caller_size);
@@ -157,6 +172,7 @@ namespace ccf
 
       auto session = std::make_shared<enclave::SessionContext>(
         client_session_id, caller_id, caller_cert);
+      session->caller_cert_digest = caller_cert_digest;
 
       try
       {
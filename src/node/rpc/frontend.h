@@ -1,20 +1,26 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the Apache 2.0 License.
 #pragma once
+#include "commit_notifier.h"
 #include "common_endpoint_registry.h"
 #include "consensus/aft/request.h"
+#include "contention_manager.h"
 #include "ds/buffer.h"
 #include "ds/spin_lock.h"
+#include "ds/tracing.h"
 #include "enclave/rpc_handler.h"
 #include "forwarder.h"
 #include "http/http_jwt.h"
+#include "node/caller_certs.h"
 #include "node/client_signatures.h"
 #include "node/jwt.h"
 #include "node/nodes.h"
+#include "pending_reads.h"
 #include "rpc_exception.h"
 #include "tls/verifier.h"
 
 #define FMT_HEADER_ONLY
+#include <charconv>
 #include <fmt/format.h>
 #include <mutex>
 #include <utility>
@@ -39,6 +45,8 @@ namespace ccf
     }
 
   private:
+    ContentionManager contention;
+
     SpinLock verifiers_lock;
     std::map<CallerId, tls::VerifierPtr> verifiers;
 
@@ -48,6 +56,9 @@ namespace ccf
     std::string client_signatures_name;
     kv::Consensus* consensus;
     std::shared_ptr<enclave::AbstractForwarder> cmd_forwarder;
+    std::shared_ptr<CommitNotifier> commit_notifier;
+    std::shared_ptr<PendingReads> pending_reads;
+    std::shared_ptr<enclave::AbstractRPCResponder> responder;
     kv::TxHistory* history;
 
     size_t sig_tx_interval = 5000;
@@ -111,7 +122,8 @@ namespace ccf
     std::optional<std::vector<uint8_t>> forward_or_redirect_json(
       std::shared_ptr<enclave::RpcContext> ctx,
       const EndpointDefinitionPtr& endpoint,
-      CallerId caller_id)
+      CallerId caller_id,
+      kv::Tx& tx)
     {
       auto& metrics = endpoints.get_metrics(endpoint);
 
@@ -121,6 +133,16 @@ namespace ccf
         {
           auto primary_id = consensus->primary();
 
+          // Certificates whose record has been committed are forwarded by
+          // digest only. A more recent record may not have reached the
+          // primary yet, so the full certificate is forwarded instead.
+          auto cert = get_cert_to_forward(ctx, endpoint);
+          std::optional<crypto::Sha256Hash> cert_digest = std::nullopt;
+          if (!cert.empty())
+          {
+            cert_digest = find_committed_caller_cert(tx, cert);
+          }
+
           if (
             primary_id != NoNode &&
             cmd_forwarder->forward_command(
@@ -128,7 +150,8 @@ namespace ccf
               primary_id,
               consensus->active_nodes(),
               caller_id,
-              get_cert_to_forward(ctx, endpoint)))
+              cert_digest.has_value() ? std::vector<uint8_t>() : cert,
+              cert_digest))
           {
             // Indicate that the RPC has been forwarded to primary
             LOG_TRACE_FMT("RPC forwarded to primary {}", primary_id);
@@ -166,6 +189,128 @@ namespace ccf
       }
     }
 
+    // Returns the seqno which a read must observe, if the request has an
+    // x-ccf-min-seqno header. Throws if the header is not a valid seqno.
+    std::optional<kv::Version> get_min_seqno(
+      const std::shared_ptr<enclave::RpcContext>& ctx)
+    {
+      const auto& headers = ctx->get_request_headers();
+      const auto it = headers.find(http::headers::CCF_MIN_SEQNO);
+      if (it == headers.end())
+      {
+        return std::nullopt;
+      }
+
+      const auto& value = it->second;
+      kv::Version seqno;
+      const auto [p, ec] =
+        std::from_chars(value.data(), value.data() + value.size(), seqno);
+      if (ec != std::errc() || p != value.data() + value.size())
+      {
+        throw RpcException(
+          fmt::format(
+            "Invalid {} header: {}", http::headers::CCF_MIN_SEQNO, value),
+          HTTP_STATUS_BAD_REQUEST);
+      }
+      return seqno;
+    }
+
+    void reply(
+      const std::shared_ptr<enclave::RpcContext>& ctx,
+      std::vector<uint8_t>&& response)
+    {
+      if (!responder->reply_async(
+            ctx->session->client_session_id, std::move(response)))
+      {
+        LOG_DEBUG_FMT(
+          "Could not reply on closed session {}",
+          ctx->session->client_session_id);
+      }
+    }
+
+    // Completes a request whose session is awaiting its response, on the
+    // session's thread. Once it has been answered, the requests held behind
+    // it are processed in order, until one of them is answered
+    // asynchronously in turn.
+    void complete_async(
+      const std::shared_ptr<enclave::RpcContext>& ctx,
+      const std::function<std::optional<std::vector<uint8_t>>()>& complete)
+    {
+      auto& session = ctx->session;
+      session->awaiting_response = false;
+
+      auto response = complete();
+      if (response.has_value())
+      {
+        reply(ctx, std::move(response.value()));
+      }
+
+      while (!session->awaiting_response && !session->held_requests.empty())
+      {
+        auto held = std::move(session->held_requests.front());
+        session->held_requests.pop_front();
+        held();
+      }
+    }
+
+    // Executes a read held by pending_reads once the seqno it must observe
+    // has been applied, or forwards it to the primary if it timed out. The
+    // response is sent here rather than by pending_reads, so that it is sent
+    // before those of the requests held behind it.
+    PendingReads::Resume resume_read(
+      std::shared_ptr<enclave::RpcContext> ctx,
+      const EndpointDefinitionPtr& endpoint,
+      CallerId caller_id)
+    {
+      return [this, ctx, endpoint, caller_id](bool timed_out) {
+        complete_async(ctx, [&]() {
+          auto tx = tables.create_tx();
+          if (timed_out)
+          {
+            // Later requests of the session are forwarded too, so that their
+            // responses come back after this one
+            ctx->session->is_forwarding = true;
+            return forward_or_redirect_json(ctx, endpoint, caller_id, tx);
+          }
+          return process_command(ctx, tx, caller_id, {}, true);
+        });
+        return std::optional<std::vector<uint8_t>>();
+      };
+    }
+
+    // A transaction which conflicted on a contended key, and is re-executed
+    // from the queue of that key's partition
+    struct Reexecution
+    {
+      size_t partition;
+      size_t attempts;
+    };
+
+    // Re-executions are queued, and their responses sent later, only for
+    // calls from this node's clients. Forwarded and BFT calls must return
+    // their response.
+    bool can_queue_reexecution(
+      const std::shared_ptr<enclave::RpcContext>& ctx, const PreExec& pre_exec)
+    {
+      return responder != nullptr && consensus != nullptr &&
+        consensus->type() == ConsensusType::CFT && !pre_exec &&
+        !ctx->session->original_caller.has_value();
+    }
+
+    // Re-executions run on the thread of their session, which owns its state
+    ContentionManager::Job reexecute(
+      std::shared_ptr<enclave::RpcContext> ctx,
+      CallerId caller_id,
+      Reexecution reexecution)
+    {
+      return [this, ctx, caller_id, reexecution]() {
+        complete_async(ctx, [&]() {
+          auto tx = tables.create_tx();
+          return process_command(ctx, tx, caller_id, {}, false, reexecution);
+        });
+      };
+    }
+
     void record_client_signature(
       kv::Tx& tx, CallerId caller_id, const SignedReq& signed_request)
     {
@@ -242,9 +387,32 @@ namespace ccf
       std::shared_ptr<enclave::RpcContext> ctx,
       kv::Tx& tx,
       CallerId caller_id,
-      const PreExec& pre_exec = {})
+      const PreExec& pre_exec = {},
+      bool resumed_read = false,
+      std::optional<Reexecution> reexecution = std::nullopt)
     {
-      const auto endpoint = endpoints.find_endpoint(tx, *ctx);
+      if (
+        ctx->session->caller_cert.empty() &&
+        ctx->session->caller_cert_digest.has_value())
+      {
+        auto cert =
+          resolve_caller_cert(tx, ctx->session->caller_cert_digest.value());
+        if (!cert.has_value())
+        {
+          ctx->set_response_status(HTTP_STATUS_INTERNAL_SERVER_ERROR);
+          ctx->set_response_body(fmt::format(
+            "Could not resolve caller certificate digest {}",
+            ctx->session->caller_cert_digest.value()));
+          return ctx->serialise_response();
+        }
+        ctx->session->caller_cert = std::move(cert.value());
+      }
+
+      EndpointDefinitionPtr endpoint = nullptr;
+      {
+        tracing::ScopedSpan span(tracing::SpanKind::FindEndpoint);
+        endpoint = endpoints.find_endpoint(tx, *ctx);
+      }
       if (endpoint == nullptr)
       {
         const auto allowed_verbs = endpoints.get_allowed_verbs(*ctx);
@@ -282,7 +450,10 @@ namespace ccf
       // Note: calls that could not be dispatched (cases handled above)
       // are not counted against any particular endpoint.
       auto& metrics = endpoints.get_metrics(endpoint);
-      metrics.calls++;
+      if (!resumed_read && !reexecution.has_value())
+      {
+        metrics.calls++;
+      }
 
       const auto signed_request = ctx->get_signed_request();
       // On signed requests, the effective caller id is the key id that
@@ -422,6 +593,57 @@ namespace ccf
 
           case ForwardingRequired::Sometimes:
           {
+            std::optional<kv::Version> min_seqno;
+            try
+            {
+              min_seqno = get_min_seqno(ctx);
+            }
+            catch (const RpcException& e)
+            {
+              ctx->set_response_status(e.status);
+              ctx->set_response_body(e.what());
+              update_metrics(ctx, metrics);
+              return ctx->serialise_response();
+            }
+
+            // Reads which must observe a given seqno are executed on this
+            // backup once it has applied that seqno, rather than forwarded
+            if (
+              min_seqno.has_value() &&
+              consensus->type() == ConsensusType::CFT &&
+              !ctx->session->original_caller.has_value())
+            {
+              // A resumed read is only released once its seqno is applied.
+              // The read version of its fresh transaction is not yet known.
+              if (
+                resumed_read || min_seqno.value() <= tx.get_read_version())
+              {
+                break;
+              }
+
+              if (pending_reads != nullptr && responder != nullptr)
+              {
+                const auto result = pending_reads->defer(
+                  ctx->session->client_session_id,
+                  min_seqno.value(),
+                  resume_read(ctx, endpoint, caller_id));
+                if (result == PendingReads::DeferResult::DEFERRED)
+                {
+                  ctx->session->awaiting_response = true;
+                  return std::nullopt;
+                }
+                if (result == PendingReads::DeferResult::APPLIED)
+                {
+                  // The seqno was applied after this transaction started, so
+                  // read from a later version
+                  tx.reset();
+                  break;
+                }
+              }
+
+              return forward_or_redirect_json(ctx, endpoint, caller_id, tx);
+            }
+
             if (
               (ctx->session->is_forwarding &&
                consensus->type() == ConsensusType::CFT) ||
@@ -432,7 +654,7 @@ namespace ccf
                  !endpoint->properties.execute_locally))))
             {
               ctx->session->is_forwarding = true;
-              return forward_or_redirect_json(ctx, endpoint, caller_id);
+              return forward_or_redirect_json(ctx, endpoint, caller_id, tx);
             }
             break;
           }
@@ -440,17 +662,20 @@ namespace ccf
           case ForwardingRequired::Always:
           {
             ctx->session->is_forwarding = true;
-            return forward_or_redirect_json(ctx, endpoint, caller_id);
+            return forward_or_redirect_json(ctx, endpoint, caller_id, tx);
           }
         }
       }
 
       auto args = EndpointContext{ctx, tx, caller_id};
 
-      tx_count++;
+      if (!reexecution.has_value())
+      {
+        tx_count++;
+      }
 
-      size_t attempts = 0;
-      constexpr auto max_attempts = 30;
+      size_t attempts = reexecution.has_value() ? reexecution->attempts : 0;
+      constexpr auto max_attempts = EndpointRegistry::Metrics::max_attempts;
 
       while (attempts < max_attempts)
       {
@@ -468,7 +693,10 @@ namespace ccf
             record_client_signature(tx, caller_id, signed_request.value());
           }
 
-          endpoints.execute_endpoint(endpoint, args);
+          {
+            tracing::ScopedSpan span(tracing::SpanKind::ExecuteEndpoint);
+            endpoints.execute_endpoint(endpoint, args);
+          }
 
           if (!ctx->should_apply_writes())
           {
@@ -490,6 +718,17 @@ namespace ccf
                   ctx->set_seqno(cv);
                   ctx->set_view(tx.commit_term());
                 }
+
+                if (
+                  commit_notifier != nullptr &&
+                  tx.commit_version() > 0 &&
+                  !ctx->session->original_caller.has_value())
+                {
+                  commit_notifier->watch_own_tx(
+                    ctx->session->client_session_id,
+                    tx.commit_term(),
+                    tx.commit_version());
+                }
                 // Deprecated, this will be removed in future releases
                 ctx->set_global_commit(consensus->get_committed_seqno());
 
@@ -499,12 +738,40 @@ namespace ccf
                 }
               }
 
+              metrics.retries[attempts - 1]++;
               update_metrics(ctx, metrics);
               return ctx->serialise_response();
             }
 
             case kv::CommitSuccess::CONFLICT:
             {
+              metrics.conflicts++;
+
+              const auto& conflicting_key = tx.get_conflicting_key();
+              if (conflicting_key.has_value())
+              {
+                const auto partition =
+                  ContentionManager::get_partition(conflicting_key.value());
+                // Re-executions which conflict again on the partition they
+                // are queued on retry straight away, as they already have
+                // its turn. Otherwise, this call is moved to the queue of
+                // the partition it conflicted on, and replied to from there.
+                if (
+                  contention.record_conflict(partition) &&
+                  (!reexecution.has_value() ||
+                   reexecution->partition != partition) &&
+                  attempts < max_attempts &&
+                  can_queue_reexecution(ctx, pre_exec))
+                {
+                  ctx->session->awaiting_response = true;
+                  contention.serialise(
+                    partition,
+                    threading::ThreadMessaging::get_execution_thread(
+                      ctx->session->client_session_id),
+                    reexecute(ctx, caller_id, {partition, attempts}));
+                  return std::nullopt;
+                }
+              }
               break;
             }
 
@@ -591,6 +858,31 @@ namespace ccf
       cmd_forwarder = cmd_forwarder_;
     }
 
+    void set_commit_notifier(
+      std::shared_ptr<CommitNotifier> commit_notifier_) override
+    {
+      commit_notifier = commit_notifier_;
+      endpoints.set_commit_notifier(commit_notifier);
+    }
+
+    void set_pending_reads(
+      std::shared_ptr<PendingReads> pending_reads_) override
+    {
+      pending_reads = pending_reads_;
+    }
+
+    void set_historical_state(
+      historical::AbstractStateCache* historical_state_) override
+    {
+      endpoints.set_historical_state(historical_state_);
+    }
+
+    void set_responder(
+      std::shared_ptr<enclave::AbstractRPCResponder> responder_) override
+    {
+      responder = responder_;
+    }
+
     void open() override
     {
       std::lock_guard<SpinLock> mguard(open_lock);
@@ -619,6 +911,21 @@ namespace ccf
     std::optional<std::vector<uint8_t>> process(
       std::shared_ptr<enclave::RpcContext> ctx) override
     {
+      // Responses are sent in the order of the requests of a session, so a
+      // request received while an earlier one is awaiting its response is
+      // held behind it
+      if (ctx->session->awaiting_response)
+      {
+        ctx->session->held_requests.push_back([this, ctx]() {
+          auto response = process(ctx);
+          if (response.has_value())
+          {
+            reply(ctx, std::move(response.value()));
+          }
+        });
+        return std::nullopt;
+      }
+
       update_consensus();
 
       auto tx = tables.create_tx();
@@ -694,14 +1001,21 @@ namespace ccf
       update_consensus();
 
       PreExec fn = [](kv::Tx& tx, enclave::RpcContext& ctx) {
+        // The caller certificate is recorded once, in the replicated
+        // CallerCerts table, and requests in the ledger refer to it by digest
+        aft::Request request = {ctx.session->original_caller.value().caller_id,
+                                tx.get_req_id(),
+                                {},
+                                ctx.get_serialised_request()};
+        if (!ctx.session->caller_cert.empty())
+        {
+          request.caller_cert_digest =
+            intern_caller_cert(tx, ctx.session->caller_cert);
+        }
+
         auto req_view =
           tx.get_view<aft::RequestsMap>(ccf::Tables::AFT_REQUESTS);
-        req_view->put(
-          0,
-          {ctx.session->original_caller.value().caller_id,
-           tx.get_req_id(),
-           ctx.session->caller_cert,
-           ctx.get_serialised_request()});
+        req_view->put(0, request);
       };
 
       auto rep =
@@ -741,9 +1055,17 @@ namespace ccf
 
       if (consensus->type() == ConsensusType::CFT)
       {
+        // The backup forwards the full certificate of a caller when it has no
+        // committed record of it. Processing may replace it with the
+        // certificate recorded for the caller id, so keep a copy.
+        const auto caller_id = ctx->session->original_caller->caller_id;
+        const auto forwarded_cert =
+          ctx->session->caller_cert_digest.has_value() ?
+          Cert() :
+          ctx->session->caller_cert;
+
         auto tx = tables.create_tx();
-        auto rep =
-          process_command(ctx, tx, ctx->session->original_caller->caller_id);
+        auto rep = process_command(ctx, tx, caller_id);
         if (!rep.has_value())
         {
           // This should never be called when process_command is called with a
@@ -751,6 +1073,19 @@ namespace ccf
           throw std::logic_error("Forwarded RPC cannot be forwarded");
         }
 
+        // Record the certificate of a known caller, so that its later
+        // requests can be forwarded by digest
+        if (!forwarded_cert.empty())
+        {
+          auto cert_tx = tables.create_tx();
+          if (resolve_caller_id(caller_id, cert_tx).has_value())
+          {
+            intern_caller_cert(cert_tx, forwarded_cert);
+            // If this fails, the certificate is recorded on a later request
+            cert_tx.commit();
+          }
+        }
+
         return rep.value();
       }
       else
@@ -774,6 +1109,8 @@ namespace ccf
 
       endpoints.tick(elapsed, stats);
 
+      contention.tick();
+
       // reset tx_counter for next tick interval
       tx_count = 0;
     }
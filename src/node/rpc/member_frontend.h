@@ -24,6 +24,7 @@
 #include <openenclave/attestation/verifier.h>
 #include <set>
 #include <sstream>
+#include <tuple>
 #if defined(INSIDE_ENCLAVE) && !defined(VIRTUAL_ENCLAVE)
 #  include <openenclave/enclave.h>
 #else
@@ -1009,6 +1010,16 @@ namespace ccf
         // vvv arguments to script vvv
         proposal.parameter);
 
+      // Ballots are all evaluated against the same proposed calls, in the same
+      // transaction, so each distinct ballot (typically most members submit
+      // the same one) only needs to be run once. Results cannot be kept across
+      // transactions, as ballots may read from the store.
+      const auto script_less = [](const Script* a, const Script* b) {
+        return std::tie(a->bytecode, a->text) < std::tie(b->bytecode, b->text);
+      };
+      std::map<const Script*, bool, decltype(script_less)> ballot_results(
+        script_less);
+
       nlohmann::json votes = nlohmann::json::object();
       // Collect all member votes
       for (const auto& vote : proposal.votes)
@@ -1020,13 +1031,19 @@ namespace ccf
         }
 
         // does the voter agree?
-        votes[std::to_string(vote.first)] = tsr.run<bool>(
-          tx,
-          {vote.second,
-           {}, // can't write
-           WlIds::MEMBER_CAN_READ,
-           {}},
-          proposed_calls);
+        auto it = ballot_results.find(&vote.second);
+        if (it == ballot_results.end())
+        {
+          const auto result = tsr.run<bool>(
+            tx,
+            {vote.second,
+             {}, // can't write
+             WlIds::MEMBER_CAN_READ,
+             {}},
+            proposed_calls);
+          it = ballot_results.emplace(&vote.second, result).first;
+        }
+        votes[std::to_string(vote.first)] = it->second;
       }
 
       const auto pass = tsr.run<int>(
@@ -137,4 +137,18 @@ namespace ccf
       size_t peak_allocated_heap_size = 0;
     };
   };
+
+  struct SetTracing
+  {
+    struct In
+    {
+      // 1 in sample_rate requests is traced. 0 disables tracing
+      uint32_t sample_rate = 0;
+    };
+
+    struct Out
+    {
+      uint32_t sample_rate = 0;
+    };
+  };
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "crypto/hash.h"
+#include "ds/tracing.h"
 #include "frontend.h"
 #include "node/entities.h"
 #include "node/network_state.h"
@@ -408,6 +409,18 @@ namespace ccf
         .set_forwarding_required(ForwardingRequired::Never)
         .set_auto_schema<MemoryUsage>()
         .install();
+
+      auto set_tracing = [](auto&, nlohmann::json&& params) {
+        const auto in = params.get<SetTracing::In>();
+        tracing::set_sample_rate(in.sample_rate);
+        return make_success(SetTracing::Out{in.sample_rate});
+      };
+
+      make_command_endpoint(
+        "tracing", HTTP_POST, json_command_adapter(set_tracing))
+        .set_forwarding_required(ForwardingRequired::Never)
+        .set_auto_schema<SetTracing>()
+        .install();
     }
   };
 
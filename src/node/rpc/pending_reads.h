@@ -0,0 +1,224 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include "ds/logger.h"
+#include "ds/spin_lock.h"
+#include "ds/thread_messaging.h"
+#include "enclave/forwarder_types.h"
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace ccf
+{
+  // Holds read-only requests which must observe a minimum seqno (see the
+  // x-ccf-min-seqno header) on a backup, until that seqno has been applied
+  // locally. This lets clients read their own writes from any node, rather
+  // than sending every such read to the primary.
+  //
+  // Requests which wait for longer than the timeout are resumed anyway, and
+  // are then forwarded to the primary. The number of pending requests is
+  // bounded, requests beyond that are forwarded immediately.
+  //
+  // Requests are resumed by tasks on the worker thread of their session,
+  // rather than on the thread which applied the seqno or ticked.
+  class PendingReads
+  {
+  public:
+    using SeqNo = int64_t;
+
+    // Called once the request can be executed, or once it has timed out.
+    // Returns the response to send to the session, or nullopt if the
+    // response will be sent later (for instance, if it was forwarded).
+    using Resume =
+      std::function<std::optional<std::vector<uint8_t>>(bool timed_out)>;
+
+    static constexpr std::chrono::milliseconds default_timeout{1000};
+    static constexpr size_t default_max_pending = 10000;
+
+    enum class DeferResult
+    {
+      DEFERRED,
+      APPLIED,
+      TOO_MANY
+    };
+
+    struct Stats
+    {
+      size_t deferred = 0;
+      size_t resumed = 0;
+      size_t timed_out = 0;
+      size_t rejected = 0;
+    };
+
+  private:
+    struct Pending
+    {
+      size_t session_id;
+      std::chrono::milliseconds deadline;
+      Resume resume;
+    };
+
+    struct Ready
+    {
+      Pending pending;
+      bool timed_out;
+    };
+
+    struct ResumeMsg
+    {
+      ResumeMsg(
+        std::shared_ptr<enclave::AbstractRPCResponder> responder_,
+        Ready&& ready_) :
+        responder(responder_),
+        ready(std::move(ready_))
+      {}
+
+      std::shared_ptr<enclave::AbstractRPCResponder> responder;
+      Ready ready;
+    };
+
+    static void resume_cb(std::unique_ptr<threading::Tmsg<ResumeMsg>> msg)
+    {
+      auto& r = msg->data.ready;
+      auto response = r.pending.resume(r.timed_out);
+      if (
+        response.has_value() &&
+        !msg->data.responder->reply_async(
+          r.pending.session_id, std::move(response.value())))
+      {
+        LOG_DEBUG_FMT(
+          "Could not reply to pending read on closed session {}",
+          r.pending.session_id);
+      }
+    }
+
+    std::shared_ptr<enclave::AbstractRPCResponder> responder;
+    const std::chrono::milliseconds timeout;
+    const size_t max_pending;
+
+    SpinLock lock;
+    SeqNo applied = 0;
+    std::chrono::milliseconds now{0};
+    std::multimap<SeqNo, Pending> pending;
+    Stats stats;
+
+    void resume(std::vector<Ready>&& ready)
+    {
+      for (auto& r : ready)
+      {
+        const auto tid = threading::ThreadMessaging::get_execution_thread(
+          r.pending.session_id);
+        threading::ThreadMessaging::thread_messaging.add_task(
+          tid,
+          std::make_unique<threading::Tmsg<ResumeMsg>>(
+            &resume_cb, responder, std::move(r)));
+      }
+    }
+
+  public:
+    PendingReads(
+      std::shared_ptr<enclave::AbstractRPCResponder> responder_,
+      std::chrono::milliseconds timeout_ = default_timeout,
+      size_t max_pending_ = default_max_pending) :
+      responder(responder_),
+      timeout(timeout_),
+      max_pending(max_pending_)
+    {}
+
+    /** Holds a request until min_seqno has been applied
+     *
+     * @param session_id Client session to which the response is sent
+     * @param min_seqno Seqno which must be applied before the request is
+     *  executed
+     * @param resume Executes or forwards the request
+     *
+     * @return DEFERRED if resume will be called later, APPLIED if min_seqno
+     *  has already been applied, and TOO_MANY if the request could not be
+     *  held. resume is not called in the latter two cases.
+     */
+    DeferResult defer(size_t session_id, SeqNo min_seqno, Resume resume)
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      if (min_seqno <= applied)
+      {
+        return DeferResult::APPLIED;
+      }
+
+      if (pending.size() >= max_pending)
+      {
+        ++stats.rejected;
+        return DeferResult::TOO_MANY;
+      }
+
+      pending.emplace(
+        min_seqno, Pending{session_id, now + timeout, std::move(resume)});
+      ++stats.deferred;
+      return DeferResult::DEFERRED;
+    }
+
+    /** Called by consensus once entries up to seqno have been applied to the
+     * store, to execute the requests that were waiting for them. These are
+     * posted to the threads of their sessions, so this does not wait for
+     * them.
+     */
+    void on_applied(SeqNo seqno)
+    {
+      std::vector<Ready> ready;
+      {
+        std::lock_guard<SpinLock> guard(lock);
+        applied = seqno;
+
+        auto end = pending.upper_bound(seqno);
+        for (auto it = pending.begin(); it != end; ++it)
+        {
+          ready.push_back({std::move(it->second), false});
+        }
+        pending.erase(pending.begin(), end);
+        stats.resumed += ready.size();
+      }
+      resume(std::move(ready));
+    }
+
+    void tick(std::chrono::milliseconds elapsed)
+    {
+      std::vector<Ready> ready;
+      {
+        std::lock_guard<SpinLock> guard(lock);
+        now += elapsed;
+
+        for (auto it = pending.begin(); it != pending.end();)
+        {
+          if (it->second.deadline <= now)
+          {
+            ready.push_back({std::move(it->second), true});
+            it = pending.erase(it);
+          }
+          else
+          {
+            ++it;
+          }
+        }
+        stats.timed_out += ready.size();
+      }
+      resume(std::move(ready));
+    }
+
+    size_t pending_count()
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      return pending.size();
+    }
+
+    Stats get_stats()
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      return stats;
+    }
+  };
+}
@@ -81,11 +81,28 @@ namespace ccf
   DECLARE_JSON_TYPE(GetTxStatus::Out)
   DECLARE_JSON_REQUIRED_FIELDS(GetTxStatus::Out, status)
 
+  DECLARE_JSON_TYPE_WITH_OPTIONAL_FIELDS(SubscribeTxStatus::In)
+  DECLARE_JSON_REQUIRED_FIELDS(SubscribeTxStatus::In)
+  DECLARE_JSON_OPTIONAL_FIELDS(SubscribeTxStatus::In, txs, own_txs, ack)
+
   DECLARE_JSON_TYPE(GetMetrics::HistogramResults)
   DECLARE_JSON_REQUIRED_FIELDS(
     GetMetrics::HistogramResults, low, high, overflow, underflow, buckets)
+  DECLARE_JSON_TYPE(GetMetrics::SignatureResults)
+  DECLARE_JSON_REQUIRED_FIELDS(
+    GetMetrics::SignatureResults,
+    adaptive,
+    tx_interval,
+    ms_interval,
+    latency_target_ms,
+    commit_latency_samples,
+    commit_latency_p50_ms,
+    commit_latency_p90_ms,
+    commit_latency_p99_ms,
+    commit_latency_max_ms)
   DECLARE_JSON_TYPE(GetMetrics::Out)
-  DECLARE_JSON_REQUIRED_FIELDS(GetMetrics::Out, histogram, tx_rates)
+  DECLARE_JSON_REQUIRED_FIELDS(
+    GetMetrics::Out, histogram, tx_rates, signatures)
 
   DECLARE_JSON_TYPE(GetPrimaryInfo::Out)
   DECLARE_JSON_REQUIRED_FIELDS(
@@ -110,7 +127,8 @@ namespace ccf
   DECLARE_JSON_REQUIRED_FIELDS(GetUserId::In, cert)
 
   DECLARE_JSON_TYPE(EndpointMetrics::Metric)
-  DECLARE_JSON_REQUIRED_FIELDS(EndpointMetrics::Metric, calls, errors, failures)
+  DECLARE_JSON_REQUIRED_FIELDS(
+    EndpointMetrics::Metric, calls, errors, failures, conflicts, retries)
   DECLARE_JSON_TYPE(EndpointMetrics::Out)
   DECLARE_JSON_REQUIRED_FIELDS(EndpointMetrics::Out, metrics)
 
@@ -119,8 +137,14 @@ namespace ccf
   DECLARE_JSON_TYPE(GetReceipt::Out)
   DECLARE_JSON_REQUIRED_FIELDS(GetReceipt::Out, receipt)
 
-  DECLARE_JSON_TYPE(VerifyReceipt::In)
+  DECLARE_JSON_TYPE(GetBatchReceipt::In)
+  DECLARE_JSON_REQUIRED_FIELDS(GetBatchReceipt::In, from_commit, to_commit)
+  DECLARE_JSON_TYPE(GetBatchReceipt::Out)
+  DECLARE_JSON_REQUIRED_FIELDS(GetBatchReceipt::Out, receipts)
+
+  DECLARE_JSON_TYPE_WITH_OPTIONAL_FIELDS(VerifyReceipt::In)
   DECLARE_JSON_REQUIRED_FIELDS(VerifyReceipt::In, receipt)
+  DECLARE_JSON_OPTIONAL_FIELDS(VerifyReceipt::In, batch)
   DECLARE_JSON_TYPE(VerifyReceipt::Out)
   DECLARE_JSON_REQUIRED_FIELDS(VerifyReceipt::Out, valid)
 
@@ -135,4 +159,9 @@ namespace ccf
     max_total_heap_size,
     current_allocated_heap_size,
     peak_allocated_heap_size)
+
+  DECLARE_JSON_TYPE(SetTracing::In)
+  DECLARE_JSON_REQUIRED_FIELDS(SetTracing::In, sample_rate)
+  DECLARE_JSON_TYPE(SetTracing::Out)
+  DECLARE_JSON_REQUIRED_FIELDS(SetTracing::Out, sample_rate)
 }
\ No newline at end of file
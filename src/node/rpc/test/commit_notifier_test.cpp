@@ -0,0 +1,175 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+
+#include "node/rpc/commit_notifier.h"
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+#include <set>
+
+using namespace ccf;
+
+class StubResponder : public enclave::AbstractRPCResponder
+{
+public:
+  std::map<size_t, std::vector<std::vector<uint8_t>>> frames;
+  std::set<size_t> closed;
+
+  bool reply_async(size_t id, std::vector<uint8_t>&& data) override
+  {
+    if (closed.find(id) != closed.end())
+    {
+      return false;
+    }
+    frames[id].push_back(std::move(data));
+    return true;
+  }
+
+  std::vector<TxStatusNotification> take(size_t id)
+  {
+    std::vector<TxStatusNotification> notifications;
+    for (const auto& frame : frames[id])
+    {
+      // Skip websocket and CCF response headers
+      const size_t ws_header_size = frame[1] == 0x7e ? 4 : 2;
+      std::vector<uint8_t> body(
+        frame.begin() + ws_header_size + ws::OUT_CCF_HEADER_SIZE, frame.end());
+      notifications.push_back(
+        serdes::unpack(body, serdes::Pack::Text).get<TxStatusNotification>());
+    }
+    frames[id].clear();
+    return notifications;
+  }
+};
+
+// Views of the ledger used in these tests: seqnos 1-9 in view 2, then 10+ in
+// view 3
+static int64_t view_at(int64_t seqno)
+{
+  return seqno < 10 ? 2 : 3;
+}
+
+TEST_CASE("Explicitly watched transactions")
+{
+  auto responder = std::make_shared<StubResponder>();
+  CommitNotifier notifier(responder);
+  constexpr size_t session = 1;
+
+  REQUIRE(
+    notifier.watch(session, 2, 5) ==
+    CommitNotifier::WatchResult::NOT_SUBSCRIBED);
+
+  REQUIRE(notifier.subscribe(session, serdes::Pack::Text, false));
+  REQUIRE(notifier.watch(session, 2, 5) == CommitNotifier::WatchResult::OK);
+  REQUIRE(notifier.watch(session, 2, 7) == CommitNotifier::WatchResult::OK);
+  // Never committed: seqno 11 is in view 3
+  REQUIRE(notifier.watch(session, 2, 11) == CommitNotifier::WatchResult::OK);
+
+  INFO("Nothing is pushed until a watched transaction is committed");
+  notifier.on_commit(3, view_at);
+  REQUIRE(responder->take(session).empty());
+
+  INFO("Updates for a single commit are coalesced into one notification");
+  notifier.on_commit(8, view_at);
+  auto n = responder->take(session);
+  REQUIRE(n.size() == 1);
+  REQUIRE(n[0].seqno == 8);
+  REQUIRE(n[0].view == 2);
+  REQUIRE(n[0].updates.size() == 2);
+  REQUIRE(n[0].updates[0].seqno == 5);
+  REQUIRE(n[0].updates[0].status == TxStatus::Committed);
+  REQUIRE(n[0].updates[1].seqno == 7);
+  REQUIRE(n[0].updates[1].status == TxStatus::Committed);
+
+  INFO("A transaction from an earlier view is invalidated by a later commit");
+  notifier.on_commit(10, view_at);
+  n = responder->take(session);
+  REQUIRE(n.size() == 1);
+  REQUIRE(n[0].updates.size() == 1);
+  REQUIRE(n[0].updates[0].view == 2);
+  REQUIRE(n[0].updates[0].seqno == 11);
+  REQUIRE(n[0].updates[0].status == TxStatus::Invalid);
+
+  INFO("Unwatched transactions are not reported");
+  REQUIRE(notifier.watch(session, 3, 12) == CommitNotifier::WatchResult::OK);
+  notifier.unwatch(session, 3, 12);
+  notifier.on_commit(12, view_at);
+  REQUIRE(responder->take(session).empty());
+}
+
+TEST_CASE("Own transactions")
+{
+  auto responder = std::make_shared<StubResponder>();
+  CommitNotifier notifier(responder);
+
+  REQUIRE(notifier.subscribe(1, serdes::Pack::Text, true));
+  REQUIRE(notifier.subscribe(2, serdes::Pack::Text, false));
+
+  for (int64_t i = 1; i < 5; ++i)
+  {
+    notifier.watch_own_tx(1, 2, i);
+    notifier.watch_own_tx(2, 2, i);
+    notifier.watch_own_tx(3, 2, i);
+  }
+
+  notifier.on_commit(4, view_at);
+  auto n = responder->take(1);
+  REQUIRE(n.size() == 1);
+  REQUIRE(n[0].updates.size() == 4);
+  REQUIRE(responder->take(2).empty());
+  REQUIRE(responder->take(3).empty());
+}
+
+TEST_CASE("Slow subscribers")
+{
+  auto responder = std::make_shared<StubResponder>();
+  constexpr size_t max_watched = 8;
+  constexpr size_t max_in_flight = 2;
+  CommitNotifier notifier(responder, 2, max_watched, max_in_flight);
+
+  REQUIRE(notifier.subscribe(1, serdes::Pack::Text, true));
+  REQUIRE(notifier.subscribe(2, serdes::Pack::Text, false));
+  REQUIRE_FALSE(notifier.subscribe(3, serdes::Pack::Text, false));
+
+  INFO("Explicit watches beyond the limit are refused");
+  for (size_t i = 0; i < max_watched; ++i)
+  {
+    REQUIRE(notifier.watch(2, 2, 1) == CommitNotifier::WatchResult::OK);
+  }
+  REQUIRE(
+    notifier.watch(2, 2, 1) == CommitNotifier::WatchResult::TOO_MANY_TXS);
+
+  INFO("Own transactions beyond the limit are reported as dropped");
+  for (int64_t i = 1; i <= max_watched + 3; ++i)
+  {
+    notifier.watch_own_tx(1, 2, i);
+  }
+  notifier.on_commit(1, view_at);
+  auto n = responder->take(1);
+  REQUIRE(n.size() == 1);
+  REQUIRE(n[0].updates.size() == 1);
+  REQUIRE(n[0].dropped == 3);
+
+  INFO("Once out of credit, updates are held back and coalesced");
+  notifier.on_commit(2, view_at);
+  REQUIRE(responder->take(1).size() == 1);
+  notifier.on_commit(3, view_at);
+  notifier.on_commit(4, view_at);
+  notifier.on_commit(5, view_at);
+  REQUIRE(responder->take(1).empty());
+
+  notifier.acknowledge(1, 1);
+  n = responder->take(1);
+  REQUIRE(n.size() == 1);
+  REQUIRE(n[0].seqno == 5);
+  REQUIRE(n[0].updates.size() == 3);
+  REQUIRE(n[0].dropped == 0);
+
+  INFO("Subscribers whose session is closed are removed");
+  REQUIRE(notifier.watch(2, 2, 6) == CommitNotifier::WatchResult::OK);
+  responder->closed.insert(2);
+  notifier.on_commit(6, view_at);
+  REQUIRE_FALSE(notifier.is_subscribed(2));
+  REQUIRE(notifier.subscriber_count() == 1);
+  REQUIRE(notifier.subscribe(3, serdes::Pack::Text, false));
+}
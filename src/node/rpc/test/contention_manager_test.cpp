@@ -0,0 +1,75 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+
+#include "node/rpc/contention_manager.h"
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+#include <vector>
+
+threading::ThreadMessaging threading::ThreadMessaging::thread_messaging;
+std::atomic<uint16_t> threading::ThreadMessaging::thread_count = 1;
+
+using namespace ccf;
+
+// Runs the tasks posted so far to the current thread, and returns how many
+// were run
+static size_t run_tasks()
+{
+  size_t n = 0;
+  while (threading::ThreadMessaging::thread_messaging.run_one())
+  {
+    ++n;
+  }
+  return n;
+}
+
+TEST_CASE("Re-executions of a partition run one at a time, in order")
+{
+  ContentionManager contention;
+  std::vector<size_t> ran;
+
+  constexpr size_t partition = 3;
+  constexpr size_t other_partition = 4;
+  const auto thread = threading::get_current_thread_id();
+
+  contention.serialise(partition, thread, [&]() {
+    ran.push_back(0);
+
+    INFO("Jobs queued while one is running run after it");
+    contention.serialise(partition, thread, [&]() { ran.push_back(2); });
+    REQUIRE(contention.queued(partition) == 2);
+  });
+  contention.serialise(partition, thread, [&]() { ran.push_back(1); });
+  REQUIRE(contention.queued(partition) == 1);
+
+  INFO("Other partitions are not held up");
+  contention.serialise(other_partition, thread, [&]() { ran.push_back(10); });
+  REQUIRE(contention.queued(other_partition) == 0);
+
+  REQUIRE(run_tasks() == 4);
+  REQUIRE(ran == std::vector<size_t>{0, 10, 1, 2});
+  REQUIRE(contention.queued(partition) == 0);
+
+  INFO("Once the queue is drained, the next job is posted straight away");
+  contention.serialise(partition, thread, [&]() { ran.push_back(3); });
+  REQUIRE(contention.queued(partition) == 0);
+  REQUIRE(run_tasks() == 1);
+  REQUIRE(ran.back() == 3);
+}
+
+TEST_CASE("Partitions become contended after repeated conflicts")
+{
+  ContentionManager contention;
+  constexpr size_t partition = 7;
+
+  for (size_t i = 1; i < ContentionManager::contended_threshold; ++i)
+  {
+    REQUIRE_FALSE(contention.record_conflict(partition));
+  }
+  REQUIRE(contention.record_conflict(partition));
+  REQUIRE(contention.is_contended(partition));
+
+  contention.tick();
+  REQUIRE_FALSE(contention.is_contended(partition));
+}
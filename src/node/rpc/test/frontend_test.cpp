@@ -512,9 +512,37 @@ TEST_CASE("process_bft")
   aft::Request deserialised_req = request_value.value();
 
   REQUIRE(deserialised_req.caller_id == user_id);
-  REQUIRE(deserialised_req.caller_cert == user_caller.raw());
+  REQUIRE(deserialised_req.caller_cert.empty());
+  REQUIRE(deserialised_req.caller_cert_digest.has_value());
   REQUIRE(deserialised_req.raw == serialized_call);
   REQUIRE(deserialised_req.frame_format == enclave::FrameFormat::http);
+
+  INFO("Caller certificate is recorded once, by digest");
+  {
+    REQUIRE(
+      ccf::resolve_caller_cert(
+        tx, deserialised_req.caller_cert_digest.value()) == user_caller.raw());
+
+    frontend.process_bft(ctx);
+
+    auto tx2 = bft_network.tables->create_tx();
+    auto second_req = tx2.get_view<aft::RequestsMap>(ccf::Tables::AFT_REQUESTS)
+                        ->get(0)
+                        .value();
+    REQUIRE(
+      second_req.caller_cert_digest == deserialised_req.caller_cert_digest);
+  }
+
+  INFO("Request referring to caller certificate by digest round-trips");
+  {
+    const auto serialised = deserialised_req.serialise();
+    aft::Request roundtrip;
+    roundtrip.deserialise(serialised.data(), serialised.size());
+    REQUIRE(roundtrip.caller_cert.empty());
+    REQUIRE(
+      roundtrip.caller_cert_digest == deserialised_req.caller_cert_digest);
+    REQUIRE(roundtrip.raw == serialized_call);
+  }
 }
 
 TEST_CASE("SignedReq to and from json")
@@ -1170,6 +1198,166 @@ TEST_CASE("Signed read requests can be executed on backup")
   CHECK(response.status == HTTP_STATUS_OK);
 }
 
+class StubResponder : public enclave::AbstractRPCResponder
+{
+public:
+  std::vector<std::vector<uint8_t>> responses;
+
+  bool reply_async(size_t, std::vector<uint8_t>&& data) override
+  {
+    responses.push_back(std::move(data));
+    return true;
+  }
+};
+
+TEST_CASE("Reads with a minimum seqno are held on backup")
+{
+  NetworkState network;
+  prepare_callers(network);
+  TestUserFrontend frontend(*network.tables);
+
+  auto channel_stub = std::make_shared<ChannelStubProxy>();
+  frontend.set_cmd_forwarder(std::make_shared<Forwarder<ChannelStubProxy>>(
+    nullptr, channel_stub, nullptr, ConsensusType::CFT));
+  auto responder = std::make_shared<StubResponder>();
+  auto pending_reads =
+    std::make_shared<PendingReads>(responder, std::chrono::milliseconds(100));
+  frontend.set_pending_reads(pending_reads);
+  frontend.set_responder(responder);
+
+  auto backup_consensus = std::make_shared<kv::BackupStubConsensus>();
+  network.tables->set_consensus(backup_consensus);
+
+  auto process_with_min_seqno = [&](const std::string& min_seqno) {
+    auto call = create_simple_request();
+    call.set_header(http::headers::CCF_MIN_SEQNO, min_seqno);
+    auto ctx = enclave::make_rpc_context(
+      make_shared<enclave::SessionContext>(
+        enclave::InvalidSessionId, user_caller_der),
+      call.build_request());
+    return frontend.process(ctx);
+  };
+
+  const auto applied = network.tables->current_version();
+  pending_reads->on_applied(applied);
+
+  {
+    INFO("Reads of applied seqnos are executed immediately");
+    const auto r = process_with_min_seqno(std::to_string(applied));
+    REQUIRE(r.has_value());
+    CHECK(parse_response(r.value()).status == HTTP_STATUS_OK);
+  }
+
+  {
+    INFO("Invalid seqnos are rejected");
+    const auto r = process_with_min_seqno("latest");
+    REQUIRE(r.has_value());
+    CHECK(parse_response(r.value()).status == HTTP_STATUS_BAD_REQUEST);
+  }
+
+  {
+    INFO("Reads of later seqnos are executed once they are applied");
+    const auto r = process_with_min_seqno(std::to_string(applied + 1));
+    REQUIRE(!r.has_value());
+    REQUIRE(pending_reads->pending_count() == 1);
+
+    // Apply a transaction, as if it had been replicated from the primary
+    network.tables->set_consensus(std::make_shared<kv::PrimaryStubConsensus>());
+    {
+      auto tx = network.tables->create_tx();
+      auto view = tx.get_view(network.values);
+      view->put(0, 0);
+      REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+    }
+    network.tables->set_consensus(backup_consensus);
+
+    pending_reads->on_applied(network.tables->current_version());
+    REQUIRE(pending_reads->pending_count() == 0);
+    REQUIRE(responder->responses.empty());
+    while (threading::ThreadMessaging::thread_messaging.run_one())
+    {
+    }
+    REQUIRE(responder->responses.size() == 1);
+    CHECK(parse_response(responder->responses[0]).status == HTTP_STATUS_OK);
+    CHECK(channel_stub->is_empty());
+  }
+
+  {
+    INFO("Reads which time out are forwarded to the primary");
+    const auto r = process_with_min_seqno(
+      std::to_string(network.tables->current_version() + 1));
+    REQUIRE(!r.has_value());
+    REQUIRE(pending_reads->pending_count() == 1);
+
+    pending_reads->tick(std::chrono::milliseconds(100));
+    REQUIRE(pending_reads->pending_count() == 0);
+    while (threading::ThreadMessaging::thread_messaging.run_one())
+    {
+    }
+    REQUIRE(responder->responses.size() == 1);
+    CHECK(channel_stub->size() == 1);
+  }
+}
+
+TEST_CASE("Pipelined requests are answered in order after a held read")
+{
+  NetworkState network;
+  prepare_callers(network);
+  TestUserFrontend frontend(*network.tables);
+
+  auto responder = std::make_shared<StubResponder>();
+  auto pending_reads = std::make_shared<PendingReads>(responder);
+  frontend.set_pending_reads(pending_reads);
+  frontend.set_responder(responder);
+
+  auto backup_consensus = std::make_shared<kv::BackupStubConsensus>();
+  network.tables->set_consensus(backup_consensus);
+
+  const auto applied = network.tables->current_version();
+  pending_reads->on_applied(applied);
+
+  auto session = make_shared<enclave::SessionContext>(0, user_caller_der);
+
+  // The read is held until a later seqno is applied, and the request after it
+  // is held behind it, rather than answered first
+  auto held_read = create_simple_request();
+  held_read.set_header(
+    http::headers::CCF_MIN_SEQNO, std::to_string(applied + 1));
+  auto first = enclave::make_rpc_context(session, held_read.build_request());
+  REQUIRE(!frontend.process(first).has_value());
+  REQUIRE(pending_reads->pending_count() == 1);
+
+  auto second = enclave::make_rpc_context(
+    session, create_simple_request("unknown_function").build_request());
+  REQUIRE(!frontend.process(second).has_value());
+  REQUIRE(responder->responses.empty());
+
+  network.tables->set_consensus(std::make_shared<kv::PrimaryStubConsensus>());
+  {
+    auto tx = network.tables->create_tx();
+    auto view = tx.get_view(network.values);
+    view->put(0, 0);
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+  }
+  network.tables->set_consensus(backup_consensus);
+
+  pending_reads->on_applied(network.tables->current_version());
+  while (threading::ThreadMessaging::thread_messaging.run_one())
+  {
+  }
+  REQUIRE(responder->responses.size() == 2);
+  CHECK(parse_response(responder->responses[0]).status == HTTP_STATUS_OK);
+  CHECK(
+    parse_response(responder->responses[1]).status == HTTP_STATUS_NOT_FOUND);
+
+  INFO("Once the session is no longer waiting, requests are answered at once");
+  auto third = enclave::make_rpc_context(
+    session, create_simple_request().build_request());
+  const auto response = frontend.process(third);
+  REQUIRE(response.has_value());
+  CHECK(parse_response(response.value()).status == HTTP_STATUS_OK);
+}
+
 TEST_CASE("Forwarding" * doctest::test_suite("forwarding"))
 {
   NetworkState network_primary;
@@ -1283,6 +1471,12 @@ TEST_CASE("Forwarding" * doctest::test_suite("forwarding"))
 
       CHECK(user_frontend_primary.last_caller_cert == user_caller);
       CHECK(user_frontend_primary.last_caller_id == 0);
+
+      INFO("Primary records the certificate of a known forwarded caller");
+      auto tx = network_primary.tables->create_tx();
+      CHECK(ccf::resolve_caller_cert(
+              tx, ccf::get_caller_cert_digest(user_caller_der))
+              .has_value());
     }
 
     {
@@ -1306,6 +1500,54 @@ TEST_CASE("Forwarding" * doctest::test_suite("forwarding"))
 
       CHECK(user_frontend_primary.last_caller_cert == invalid_caller);
       CHECK(user_frontend_primary.last_caller_id == INVALID_ID);
+
+      INFO("Certificates of unknown callers are not recorded");
+      auto tx = network_primary.tables->create_tx();
+      CHECK(!ccf::resolve_caller_cert(
+               tx, ccf::get_caller_cert_digest(invalid_caller_der))
+               .has_value());
+    }
+
+    {
+      INFO("Recorded caller certificate is forwarded by digest once committed");
+      // The primary recorded the certificate when it executed the forwarded
+      // request. Record it on the backup too, as if it had been replicated
+      network_backup.tables->set_consensus(primary_consensus);
+      {
+        auto tx = network_backup.tables->create_tx();
+        ccf::intern_caller_cert(tx, user_caller_der);
+        REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+      }
+      network_backup.tables->set_consensus(backup_consensus);
+
+      auto forward = [&]() {
+        auto ctx =
+          enclave::make_rpc_context(user_session, serialized_call_no_auth);
+        const auto r = user_frontend_backup.process(ctx);
+        REQUIRE(!r.has_value());
+        REQUIRE(channel_stub->size() == 1);
+        auto forwarded_msg = channel_stub->get_pop_back();
+        auto [fwd_ctx, node_id] =
+          backup_forwarder
+            ->recv_forwarded_command(forwarded_msg.data(), forwarded_msg.size())
+            .value();
+        return fwd_ctx;
+      };
+
+      auto fwd_ctx = forward();
+      CHECK(fwd_ctx->session->caller_cert == user_caller_der);
+      CHECK(!fwd_ctx->session->caller_cert_digest.has_value());
+
+      network_backup.tables->compact(network_backup.tables->current_version());
+
+      fwd_ctx = forward();
+      CHECK(fwd_ctx->session->caller_cert.empty());
+      CHECK(fwd_ctx->session->caller_cert_digest.has_value());
+
+      auto response =
+        parse_response(user_frontend_primary.process_forwarded(fwd_ctx));
+      CHECK(response.status == HTTP_STATUS_OK);
+      CHECK(user_frontend_primary.last_caller_cert == user_caller);
     }
   }
 
@@ -1593,6 +1835,104 @@ TEST_CASE("Signature is stored even after conflicts")
   }
 }
 
+class TestContendedFrontend : public SimpleUserRpcFrontend
+{
+public:
+  using Values = kv::Map<size_t, size_t>;
+
+  // Number of times the next calls to "contended" conflict
+  size_t conflicts = 0;
+
+  TestContendedFrontend(kv::Store& tables) : SimpleUserRpcFrontend(tables)
+  {
+    open();
+
+    auto contended = [this](auto& args) {
+      auto view = args.tx.template get_view<Values>("test_values_contended");
+      view->get(0); // Record a read dependency
+
+      if (conflicts > 0)
+      {
+        // Commit a write to the key read by this transaction
+        auto tx = this->tables.create_tx();
+        auto other_view =
+          tx.template get_view<Values>("test_values_contended");
+        other_view->put(0, 42);
+        REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+        --conflicts;
+      }
+
+      view->put(0, 0);
+
+      args.rpc_ctx->set_response_status(HTTP_STATUS_OK);
+      args.rpc_ctx->set_response_body("contended");
+    };
+    make_endpoint("contended", HTTP_POST, contended).install();
+
+    auto uncontended = [](auto& args) {
+      args.rpc_ctx->set_response_status(HTTP_STATUS_OK);
+      args.rpc_ctx->set_response_body("uncontended");
+    };
+    make_endpoint("uncontended", HTTP_POST, uncontended).install();
+  }
+};
+
+TEST_CASE("Pipelined requests are answered in order after a re-execution")
+{
+  NetworkState network;
+  prepare_callers(network);
+  network.tables->set_consensus(std::make_shared<kv::PrimaryStubConsensus>());
+
+  TestContendedFrontend frontend(*network.tables);
+  auto responder = std::make_shared<StubResponder>();
+  frontend.set_responder(responder);
+
+  {
+    auto tx = network.tables->create_tx();
+    auto view =
+      tx.get_view<TestContendedFrontend::Values>("test_values_contended");
+    view->put(0, 0);
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+  }
+
+  // The first call conflicts often enough for its key to become contended,
+  // and is queued for re-execution
+  frontend.conflicts = ContentionManager::contended_threshold;
+
+  auto session = std::make_shared<enclave::SessionContext>(0, user_caller_der);
+  auto first = enclave::make_rpc_context(
+    session, create_simple_request("contended").build_request());
+  auto second = enclave::make_rpc_context(
+    session, create_simple_request("uncontended").build_request());
+
+  REQUIRE_FALSE(frontend.process(first).has_value());
+
+  INFO("A later request of the session is held behind the re-execution");
+  REQUIRE_FALSE(frontend.process(second).has_value());
+  REQUIRE(responder->responses.empty());
+
+  while (threading::ThreadMessaging::thread_messaging.run_one())
+  {
+  }
+
+  REQUIRE(responder->responses.size() == 2);
+  const auto first_response = parse_response(responder->responses[0]);
+  CHECK(first_response.status == HTTP_STATUS_OK);
+  CHECK(
+    std::string(first_response.body.begin(), first_response.body.end()) ==
+    "contended");
+  const auto second_response = parse_response(responder->responses[1]);
+  CHECK(second_response.status == HTTP_STATUS_OK);
+  CHECK(
+    std::string(second_response.body.begin(), second_response.body.end()) ==
+    "uncontended");
+
+  INFO("Once answered, requests of the session are processed immediately");
+  auto third = enclave::make_rpc_context(
+    session, create_simple_request("uncontended").build_request());
+  REQUIRE(frontend.process(third).has_value());
+}
+
 // We need an explicit main to initialize kremlib and EverCrypt
 int main(int argc, char** argv)
 {
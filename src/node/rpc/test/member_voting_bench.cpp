@@ -0,0 +1,146 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#include "ds/files.h"
+#include "ds/logger.h"
+#include "kv/test/null_encryptor.h"
+#include "node/genesis_gen.h"
+#include "node/rpc/member_frontend.h"
+#include "node_stub.h"
+#include "runtime_config/default_whitelists.h"
+
+#define PICOBENCH_IMPLEMENT
+#include <picobench/picobench.hpp>
+
+extern "C"
+{
+#include <evercrypt/EverCrypt_AutoConfig2.h>
+}
+
+using namespace ccf;
+
+auto kp = tls::make_key_pair();
+auto encryptor = std::make_shared<kv::NullTxEncryptor>();
+
+std::string get_script_path(std::string name)
+{
+  auto default_dir = "../src/runtime_config";
+  auto dir = getenv("RUNTIME_CONFIG_DIR");
+  return fmt::format("{}/{}", dir ? dir : default_dir, name);
+}
+const auto gov_script_file = files::slurp_string(get_script_path("gov.lua"));
+
+template <class A>
+inline void do_not_optimize(A const& value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Ballots read the proposed calls but reject them, so that the proposal
+// remains open and each completion evaluates every ballot
+static Script make_ballot(MemberId member_id, bool distinct)
+{
+  std::string ballot = R"xxx(
+    tables, calls = ...
+    return #calls == 0
+  )xxx";
+  if (distinct)
+  {
+    ballot += fmt::format("-- ballot of member {}\n", member_id);
+  }
+  return Script(ballot);
+}
+
+// Completes a proposal on which s.iterations() members have voted. Ballots are
+// either all identical, as is typical, or all distinct.
+template <bool DistinctBallots>
+static void complete_proposal(picobench::state& s)
+{
+  const size_t n_members = s.iterations();
+
+  NetworkState network;
+  network.tables->set_encryptor(encryptor);
+  auto gen_tx = network.tables->create_tx();
+  GenesisGenerator gen(network, gen_tx);
+  gen.init_values();
+  gen.create_service({});
+
+  std::vector<MemberId> member_ids;
+  tls::Pem first_member_cert;
+  for (size_t i = 0; i < n_members; ++i)
+  {
+    auto cert = kp->self_sign(fmt::format("CN=member{}", i));
+    const auto member_id = gen.add_member(cert);
+    gen.activate_member(member_id);
+    member_ids.push_back(member_id);
+    if (i == 0)
+    {
+      first_member_cert = cert;
+    }
+  }
+
+  for (const auto& wl : default_whitelists)
+  {
+    gen.set_whitelist(wl.first, wl.second);
+  }
+  gen.set_gov_scripts(
+    lua::Interpreter().invoke<nlohmann::json>(gov_script_file));
+  gen.finalize();
+
+  ShareManager share_manager(network);
+  StubNodeState node(share_manager);
+  MemberRpcFrontend frontend(network, node, share_manager);
+  frontend.open();
+
+  constexpr ObjectId proposal_id = 0;
+  {
+    Proposal proposal(
+      std::string(R"xxx(
+        return Calls:call("raw_puts", Puts:put("public:ccf.gov.values", 999, 999))
+      )xxx"),
+      nullptr,
+      member_ids[0]);
+    for (const auto member_id : member_ids)
+    {
+      proposal.votes[member_id] = make_ballot(member_id, DistinctBallots);
+    }
+
+    auto tx = network.tables->create_tx();
+    tx.get_view(network.proposals)->put(proposal_id, proposal);
+    if (tx.commit() != kv::CommitSuccess::OK)
+    {
+      throw std::logic_error("Could not record proposal");
+    }
+  }
+
+  http::Request r(fmt::format("proposals/{}/complete", proposal_id), HTTP_POST);
+  http::sign_request(r, kp);
+  const auto request = r.build_request();
+
+  auto session = std::make_shared<enclave::SessionContext>(
+    0, tls::make_verifier(first_member_cert)->der_cert_data());
+  auto rpc_ctx = enclave::make_rpc_context(session, request);
+
+  s.start_timer();
+  do_not_optimize(frontend.process(rpc_ctx));
+  s.stop_timer();
+}
+
+const std::vector<int> member_counts = {10, 100, 500};
+
+PICOBENCH_SUITE("complete_proposal");
+PICOBENCH(complete_proposal<false>)
+  .iterations(member_counts)
+  .samples(10)
+  .baseline();
+PICOBENCH(complete_proposal<true>).iterations(member_counts).samples(10);
+
+// We need an explicit main to initialize kremlib and EverCrypt
+int main(int argc, char* argv[])
+{
+  ::EverCrypt_AutoConfig2_init();
+  logger::config::level() = logger::FATAL;
+
+  picobench::runner runner;
+  runner.parse_cmd_line(argc, argv);
+  return runner.run();
+}
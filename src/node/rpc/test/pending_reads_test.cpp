@@ -0,0 +1,164 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+
+#include "node/rpc/pending_reads.h"
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+#include <set>
+
+threading::ThreadMessaging threading::ThreadMessaging::thread_messaging;
+std::atomic<uint16_t> threading::ThreadMessaging::thread_count = 1;
+
+using namespace ccf;
+using namespace std::chrono_literals;
+
+// Resumed reads are posted as tasks to the threads of their sessions, which
+// are all the current thread here
+static void run_tasks()
+{
+  while (threading::ThreadMessaging::thread_messaging.run_one())
+  {
+  }
+}
+
+class StubResponder : public enclave::AbstractRPCResponder
+{
+public:
+  std::map<size_t, std::vector<std::vector<uint8_t>>> frames;
+  std::set<size_t> closed;
+
+  bool reply_async(size_t id, std::vector<uint8_t>&& data) override
+  {
+    if (closed.find(id) != closed.end())
+    {
+      return false;
+    }
+    frames[id].push_back(std::move(data));
+    return true;
+  }
+};
+
+// Records how the read was resumed, and replies with its seqno, or with
+// nothing if it was forwarded
+static PendingReads::Resume make_read(
+  std::vector<std::pair<int64_t, bool>>& resumed, int64_t seqno)
+{
+  return [&resumed, seqno](bool timed_out) {
+    resumed.emplace_back(seqno, timed_out);
+    std::optional<std::vector<uint8_t>> response = std::nullopt;
+    if (!timed_out)
+    {
+      response = std::vector<uint8_t>{static_cast<uint8_t>(seqno)};
+    }
+    return response;
+  };
+}
+
+TEST_CASE("Reads are resumed once their seqno is applied")
+{
+  auto responder = std::make_shared<StubResponder>();
+  PendingReads pending(responder);
+  std::vector<std::pair<int64_t, bool>> resumed;
+
+  pending.on_applied(3);
+  REQUIRE(
+    pending.defer(1, 3, make_read(resumed, 3)) ==
+    PendingReads::DeferResult::APPLIED);
+  REQUIRE(pending.pending_count() == 0);
+
+  REQUIRE(
+    pending.defer(1, 5, make_read(resumed, 5)) ==
+    PendingReads::DeferResult::DEFERRED);
+  REQUIRE(
+    pending.defer(2, 7, make_read(resumed, 7)) ==
+    PendingReads::DeferResult::DEFERRED);
+  REQUIRE(
+    pending.defer(2, 5, make_read(resumed, 5)) ==
+    PendingReads::DeferResult::DEFERRED);
+  REQUIRE(pending.pending_count() == 3);
+  REQUIRE(resumed.empty());
+
+  INFO("Only reads for applied seqnos are resumed, by their session's thread");
+  pending.on_applied(6);
+  REQUIRE(resumed.empty());
+  run_tasks();
+  REQUIRE(resumed.size() == 2);
+  REQUIRE(resumed[0] == std::make_pair<int64_t, bool>(5, false));
+  REQUIRE(resumed[1] == std::make_pair<int64_t, bool>(5, false));
+  REQUIRE(responder->frames[1].size() == 1);
+  REQUIRE(responder->frames[2].size() == 1);
+  REQUIRE(pending.pending_count() == 1);
+
+  INFO("Responses to closed sessions are dropped");
+  responder->closed.insert(2);
+  pending.on_applied(10);
+  run_tasks();
+  REQUIRE(resumed.size() == 3);
+  REQUIRE(resumed[2] == std::make_pair<int64_t, bool>(7, false));
+  REQUIRE(responder->frames[2].size() == 1);
+
+  const auto stats = pending.get_stats();
+  REQUIRE(stats.deferred == 3);
+  REQUIRE(stats.resumed == 3);
+  REQUIRE(stats.timed_out == 0);
+}
+
+TEST_CASE("Reads time out")
+{
+  auto responder = std::make_shared<StubResponder>();
+  PendingReads pending(responder, 100ms);
+  std::vector<std::pair<int64_t, bool>> resumed;
+
+  REQUIRE(
+    pending.defer(1, 5, make_read(resumed, 5)) ==
+    PendingReads::DeferResult::DEFERRED);
+  pending.tick(60ms);
+  run_tasks();
+  REQUIRE(
+    pending.defer(1, 2, make_read(resumed, 2)) ==
+    PendingReads::DeferResult::DEFERRED);
+  REQUIRE(resumed.empty());
+
+  INFO("Reads are timed out in the order of their deadlines");
+  pending.tick(60ms);
+  run_tasks();
+  REQUIRE(resumed.size() == 1);
+  REQUIRE(resumed[0] == std::make_pair<int64_t, bool>(5, true));
+  REQUIRE(responder->frames[1].empty());
+
+  pending.tick(60ms);
+  run_tasks();
+  REQUIRE(resumed.size() == 2);
+  REQUIRE(resumed[1] == std::make_pair<int64_t, bool>(2, true));
+  REQUIRE(pending.pending_count() == 0);
+
+  INFO("Timed out reads are not resumed again");
+  pending.on_applied(10);
+  run_tasks();
+  REQUIRE(resumed.size() == 2);
+  REQUIRE(pending.get_stats().timed_out == 2);
+}
+
+TEST_CASE("Number of pending reads is bounded")
+{
+  auto responder = std::make_shared<StubResponder>();
+  PendingReads pending(responder, 100ms, 2);
+  std::vector<std::pair<int64_t, bool>> resumed;
+
+  REQUIRE(
+    pending.defer(1, 5, make_read(resumed, 5)) ==
+    PendingReads::DeferResult::DEFERRED);
+  REQUIRE(
+    pending.defer(1, 6, make_read(resumed, 6)) ==
+    PendingReads::DeferResult::DEFERRED);
+  REQUIRE(
+    pending.defer(1, 7, make_read(resumed, 7)) ==
+    PendingReads::DeferResult::TOO_MANY);
+  REQUIRE(pending.get_stats().rejected == 1);
+
+  pending.on_applied(5);
+  REQUIRE(
+    pending.defer(1, 7, make_read(resumed, 7)) ==
+    PendingReads::DeferResult::DEFERRED);
+}
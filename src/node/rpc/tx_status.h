@@ -106,4 +106,29 @@ namespace ccf
       return TxStatus::Unknown;
     }
   }
+
+  // Final status of a transaction, as pushed to subscribers by the
+  // CommitNotifier
+  struct TxStatusUpdate
+  {
+    int64_t view;
+    int64_t seqno;
+    TxStatus status;
+  };
+  DECLARE_JSON_TYPE(TxStatusUpdate)
+  DECLARE_JSON_REQUIRED_FIELDS(TxStatusUpdate, view, seqno, status)
+
+  struct TxStatusNotification
+  {
+    // Commit point at which the updates were observed
+    int64_t view;
+    int64_t seqno;
+    std::vector<TxStatusUpdate> updates = {};
+    // Number of transactions which could not be tracked for this subscriber
+    // since the previous notification. Their status must be polled.
+    size_t dropped = 0;
+  };
+  DECLARE_JSON_TYPE(TxStatusNotification)
+  DECLARE_JSON_REQUIRED_FIELDS(
+    TxStatusNotification, view, seqno, updates, dropped)
 }
\ No newline at end of file
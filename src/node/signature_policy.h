@@ -0,0 +1,305 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#pragma once
+
+#include "ds/spin_lock.h"
+#include "kv/kv_types.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <vector>
+
+namespace ccf
+{
+  // Decides when the primary should emit a signature transaction, and records
+  // the commit latency that results from that decision.
+  //
+  // With no latency target (the default), a signature is emitted every
+  // max_tx_interval transactions or, if there are unsigned transactions, every
+  // max_ms_interval milliseconds.
+  //
+  // With a latency target, the policy is adaptive. On top of the above bounds,
+  // a signature is emitted:
+  // - as soon as the pipeline is idle, i.e. no transaction was committed since
+  //   the previous periodic check,
+  // - when the oldest unsigned transaction would otherwise exceed the latency
+  //   target before the next periodic check,
+  // - every tx_interval transactions, where tx_interval follows the observed
+  //   transaction rate (rate * latency target). Under saturation, tx_interval
+  //   grows towards max_tx_interval so that signatures remain a small fraction
+  //   of the work.
+  class SignaturePolicy
+  {
+  public:
+    using Ms = std::chrono::milliseconds;
+
+    // Below this, the idle and latency checks take over from the tx interval
+    static constexpr size_t min_tx_interval = 10;
+    static constexpr size_t max_latency_samples = 4096;
+
+  private:
+    const size_t max_tx_interval;
+    const Ms max_ms_interval;
+    const Ms latency_target;
+
+    std::atomic<size_t> tx_interval;
+
+    // Time at which the oldest unsigned transaction was observed, if any
+    std::atomic<int64_t> unsigned_since = no_time;
+    static constexpr int64_t no_time = -1;
+
+    std::atomic<Ms> time_of_last_signature = Ms(0);
+
+    // Only accessed from the periodic check
+    Ms time_of_last_check = Ms(0);
+    kv::Version version_at_last_check = 0;
+    double tx_per_ms = 0.0;
+
+    struct PendingSignature
+    {
+      kv::Version version;
+      Ms oldest_tx_time;
+    };
+
+    // Protects pending signatures and latency samples, since signatures may be
+    // emitted outside of the periodic check
+    SpinLock lock;
+    std::deque<PendingSignature> pending_signatures;
+    std::array<uint32_t, max_latency_samples> latency_samples = {};
+    size_t next_sample = 0;
+    size_t sample_count = 0;
+
+    void record_latency(Ms latency)
+    {
+      latency_samples[next_sample] = latency.count();
+      next_sample = (next_sample + 1) % max_latency_samples;
+      sample_count = std::min(sample_count + 1, max_latency_samples);
+    }
+
+    void update_tx_interval(Ms now, kv::Version current_version)
+    {
+      const auto elapsed = now - time_of_last_check;
+      if (elapsed.count() <= 0)
+      {
+        return;
+      }
+
+      const auto new_txs = current_version > version_at_last_check ?
+        current_version - version_at_last_check :
+        0;
+      const auto instant_rate =
+        static_cast<double>(new_txs) / static_cast<double>(elapsed.count());
+
+      // Exponentially-weighted moving average, to smooth out bursts
+      constexpr auto alpha = 0.25;
+      tx_per_ms = alpha * instant_rate + (1 - alpha) * tx_per_ms;
+
+      const auto target = static_cast<size_t>(
+        tx_per_ms * static_cast<double>(latency_target.count()));
+      tx_interval = std::clamp(
+        target, std::min(min_tx_interval, max_tx_interval), max_tx_interval);
+    }
+
+  public:
+    SignaturePolicy(
+      size_t max_tx_interval_,
+      size_t max_ms_interval_,
+      size_t latency_target_ms_ = 0) :
+      max_tx_interval(max_tx_interval_),
+      max_ms_interval(max_ms_interval_),
+      latency_target(latency_target_ms_),
+      tx_interval(max_tx_interval_)
+    {}
+
+    bool is_adaptive() const
+    {
+      return latency_target.count() > 0;
+    }
+
+    size_t get_tx_interval() const
+    {
+      return tx_interval;
+    }
+
+    /** Called on the commit path of each transaction executed by the primary
+     *
+     * @param now Current time
+     * @param commit_gap Number of transactions since the last signature
+     *
+     * @return true if a signature should be emitted now
+     */
+    bool should_emit_on_commit(Ms now, size_t commit_gap)
+    {
+      if (commit_gap > 0)
+      {
+        int64_t expected = no_time;
+        unsigned_since.compare_exchange_strong(expected, now.count());
+      }
+
+      return commit_gap >= tx_interval;
+    }
+
+    /** Called periodically on the primary
+     *
+     * @param now Current time
+     * @param current_version Latest version in the store
+     * @param commit_gap Number of transactions since the last signature
+     *
+     * @return true if a signature should be emitted now
+     */
+    bool should_emit_on_tick(
+      Ms now, kv::Version current_version, size_t commit_gap)
+    {
+      const bool idle = current_version == version_at_last_check;
+      const Ms last_signature = time_of_last_signature;
+
+      if (is_adaptive())
+      {
+        update_tx_interval(now, current_version);
+      }
+      time_of_last_check = now;
+      version_at_last_check = current_version;
+
+      if (commit_gap == 0)
+      {
+        return false;
+      }
+
+      // Transactions which did not go through the commit path (e.g. local
+      // node transactions) are only observed here
+      int64_t since = no_time;
+      if (unsigned_since.compare_exchange_strong(since, now.count()))
+      {
+        since = now.count();
+      }
+
+      if (now > last_signature && (now - last_signature) > max_ms_interval)
+      {
+        return true;
+      }
+
+      if (!is_adaptive())
+      {
+        return false;
+      }
+
+      if (idle)
+      {
+        return true;
+      }
+
+      return Ms(since) + latency_target <= now + get_check_interval();
+    }
+
+    /** Called when a signature is emitted
+     *
+     * @param now Current time
+     * @param version Version of the signature transaction
+     */
+    void on_signature(Ms now, kv::Version version)
+    {
+      const auto since = unsigned_since.exchange(no_time);
+      const auto oldest_tx_time = since == no_time ? now : Ms(since);
+
+      std::lock_guard<SpinLock> guard(lock);
+      if (
+        pending_signatures.empty() ||
+        pending_signatures.back().version < version)
+      {
+        pending_signatures.push_back({version, oldest_tx_time});
+      }
+      time_of_last_signature = now;
+    }
+
+    /** Called when the commit point advances. Records the commit latency of
+     * the oldest transaction covered by each newly committed signature.
+     */
+    void on_commit(Ms now, kv::Version committed_version)
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      while (!pending_signatures.empty() &&
+             pending_signatures.front().version <= committed_version)
+      {
+        const auto oldest = pending_signatures.front().oldest_tx_time;
+        record_latency(now > oldest ? now - oldest : Ms(0));
+        pending_signatures.pop_front();
+      }
+    }
+
+    /** Discards signatures which have been rolled back */
+    void on_rollback(kv::Version v)
+    {
+      std::lock_guard<SpinLock> guard(lock);
+      while (!pending_signatures.empty() &&
+             pending_signatures.back().version > v)
+      {
+        pending_signatures.pop_back();
+      }
+    }
+
+    Ms get_check_interval() const
+    {
+      if (is_adaptive())
+      {
+        return std::max(Ms(1), std::min(latency_target / 4, max_ms_interval));
+      }
+      return max_ms_interval;
+    }
+
+    /** Delay until the next periodic check
+     *
+     * @param now Current time
+     */
+    Ms next_check_delay(Ms now) const
+    {
+      if (is_adaptive())
+      {
+        return get_check_interval();
+      }
+
+      auto delay = max_ms_interval - (now - time_of_last_signature.load());
+      if (delay.count() <= 0 || delay > max_ms_interval)
+      {
+        delay = max_ms_interval;
+      }
+      return delay;
+    }
+
+    kv::TxHistory::SignatureStatistics get_statistics()
+    {
+      kv::TxHistory::SignatureStatistics stats;
+      stats.adaptive = is_adaptive();
+      stats.tx_interval = tx_interval;
+      stats.ms_interval = max_ms_interval.count();
+      stats.latency_target_ms = latency_target.count();
+
+      std::vector<uint32_t> samples;
+      {
+        std::lock_guard<SpinLock> guard(lock);
+        samples.assign(
+          latency_samples.begin(), latency_samples.begin() + sample_count);
+      }
+
+      stats.commit_latency_samples = samples.size();
+      if (samples.empty())
+      {
+        return stats;
+      }
+
+      auto percentile = [&samples](size_t p) {
+        auto n = std::min(samples.size() - 1, (samples.size() * p) / 100);
+        std::nth_element(samples.begin(), samples.begin() + n, samples.end());
+        return samples[n];
+      };
+      stats.commit_latency_p50_ms = percentile(50);
+      stats.commit_latency_p90_ms = percentile(90);
+      stats.commit_latency_p99_ms = percentile(99);
+      stats.commit_latency_max_ms =
+        *std::max_element(samples.begin(), samples.end());
+      return stats;
+    }
+  };
+}
@@ -10,6 +10,10 @@
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
 
 threading::ThreadMessaging threading::ThreadMessaging::thread_messaging;
 std::atomic<uint16_t> threading::ThreadMessaging::thread_count = 0;
@@ -63,6 +67,12 @@ public:
     write.contents.insert(write.contents.end(), bytes, bytes + size);
     return marker;
   }
+
+  void abandon(const WriteMarker& marker) override
+  {
+    REQUIRE(!get_write(marker).finished);
+    writes.erase(writes.begin() + marker.value());
+  }
 };
 
 TEST_CASE("StateCache")
@@ -277,6 +287,30 @@ TEST_CASE("StateCache")
     }
   }
 
+  {
+    INFO("Receipts can be produced for trusted entries");
+    const auto receipts = cache.get_batch_receipts({high_index});
+    REQUIRE(receipts.size() == 1);
+    REQUIRE(ccf::BatchReceipt(receipts[0]).verify());
+
+    INFO("Receipts are only produced once all entries are trusted");
+    const auto next_index = high_index + 1;
+    REQUIRE(cache.get_batch_receipts({high_index, next_index}).empty());
+    for (size_t i = next_index; i <= high_signature_transaction; ++i)
+    {
+      REQUIRE(provide_ledger_entry(i));
+    }
+
+    INFO("Entries trusted by the same signature share a receipt");
+    const auto shared = cache.get_batch_receipts({high_index, next_index});
+    REQUIRE(shared.size() == 1);
+    const ccf::BatchReceipt receipt(shared[0]);
+    REQUIRE(receipt.get_leaf_count() == 2);
+    REQUIRE(receipt.verify());
+    REQUIRE(
+      receipt.get_root() == ccf::BatchReceipt(receipts[0]).get_root());
+  }
+
   {
     INFO("Cache doesn't throw when given junk");
     REQUIRE(cache.get_store_at(unsigned_index) == nullptr);
@@ -294,4 +328,164 @@ TEST_CASE("StateCache")
         unsigned_index, ledger[high_signature_transaction]));
     REQUIRE(!result);
   }
-}
\ No newline at end of file
+}
+
+// Records the threads on which entries are decrypted
+class RecordingEncryptor : public kv::NullTxEncryptor
+{
+public:
+  std::mutex lock;
+  std::set<uint16_t> decrypt_threads;
+  size_t decrypt_count = 0;
+
+  bool decrypt(
+    const std::vector<uint8_t>& cipher,
+    const std::vector<uint8_t>& additional_data,
+    const std::vector<uint8_t>& serialised_header,
+    std::vector<uint8_t>& plain,
+    kv::Version version) override
+  {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      decrypt_threads.insert(threading::get_current_thread_id());
+      ++decrypt_count;
+    }
+    return NullTxEncryptor::decrypt(
+      cipher, additional_data, serialised_header, plain, version);
+  }
+};
+
+TEST_CASE("Historical entries are processed off the main thread")
+{
+  auto encryptor = std::make_shared<RecordingEncryptor>();
+  auto consensus = std::make_shared<kv::StubConsensus>();
+
+  kv::Store store(consensus);
+  store.set_encryptor(encryptor);
+
+  const auto node_id = 0;
+  auto kp = tls::make_key_pair();
+  auto history = std::make_shared<ccf::MerkleTxHistory>(store, node_id, *kp);
+  store.set_history(history);
+
+  using NumToString = kv::Map<size_t, std::string>;
+
+  constexpr size_t signature_interval = 20;
+  constexpr size_t last_index = 200;
+
+  {
+    auto tx = store.create_tx();
+    auto view = tx.get_view<ccf::Nodes>(ccf::Tables::NODES);
+    ccf::NodeInfo ni;
+    ni.cert = kp->self_sign("CN=Test node");
+    ni.status = ccf::NodeStatus::TRUSTED;
+    view->put(node_id, ni);
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+  }
+
+  for (size_t i = 2; i <= last_index; ++i)
+  {
+    if (i % signature_interval == 0)
+    {
+      history->emit_signature();
+      store.compact(store.current_version());
+    }
+    else
+    {
+      auto tx = store.create_tx();
+      auto [public_view, private_view] =
+        tx.get_view<NumToString, NumToString>("public:data", "data");
+      const auto s = std::string(1024, 'a' + i % 26);
+      public_view->put(i, s);
+      private_view->put(i, s);
+      REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+    }
+  }
+  REQUIRE(store.current_version() == last_index);
+
+  std::map<consensus::Index, std::vector<uint8_t>> ledger;
+  auto next_ledger_entry = consensus->pop_oldest_entry();
+  while (next_ledger_entry.has_value())
+  {
+    ledger.emplace(
+      std::get<0>(next_ledger_entry.value()),
+      *std::get<1>(next_ledger_entry.value()));
+    next_ledger_entry = consensus->pop_oldest_entry();
+  }
+
+  std::vector<consensus::Index> requested_ledger_entries = {};
+  messaging::BufferProcessor bp("historical_queries");
+  DISPATCHER_SET_MESSAGE_HANDLER(
+    bp,
+    consensus::ledger_get,
+    [&requested_ledger_entries](const uint8_t* data, size_t size) {
+      auto [idx, purpose] =
+        ringbuffer::read_message<consensus::ledger_get>(data, size);
+      requested_ledger_entries.push_back(idx);
+    });
+
+  constexpr size_t buffer_size = 1 << 16;
+  auto buffer = std::make_unique<ringbuffer::TestBuffer>(buffer_size);
+  ringbuffer::Reader rr(buffer->bd);
+  auto rw = std::make_shared<ringbuffer::Writer>(rr);
+
+  constexpr uint16_t worker_tid = 1;
+  const auto prev_thread_count =
+    threading::ThreadMessaging::thread_count.load();
+  threading::ThreadMessaging::thread_count = 2;
+  encryptor->decrypt_threads.clear();
+
+  ccf::historical::StateCache cache(store, rw);
+
+  // Request the first entry after every signature, so that each request
+  // needs a full signature interval of entries to be trusted
+  std::vector<consensus::Index> idxs;
+  for (size_t i = 1; i < last_index; i += signature_interval)
+  {
+    idxs.push_back(i);
+  }
+
+  // Each round answers the outstanding fetches on the main thread, as the
+  // host would, then runs the worker thread's tasks, and then the main
+  // thread's
+  size_t rounds = 0;
+  while (cache.get_stores_at(idxs).empty() && rounds++ < last_index)
+  {
+    const auto decrypts_before = encryptor->decrypt_count;
+
+    bp.read_n(100, rr);
+    for (const auto idx : requested_ledger_entries)
+    {
+      REQUIRE(cache.handle_ledger_entry(idx, ledger.at(idx)));
+    }
+    requested_ledger_entries.clear();
+
+    {
+      INFO("Handling entries returns before they are deserialised");
+      std::lock_guard<std::mutex> guard(encryptor->lock);
+      REQUIRE(encryptor->decrypt_count == decrypts_before);
+    }
+
+    std::thread worker([]() {
+      threading::thread_id = worker_tid;
+      while (threading::ThreadMessaging::thread_messaging.run_one())
+      {
+      }
+    });
+    worker.join();
+
+    while (threading::ThreadMessaging::thread_messaging.run_one())
+    {
+    }
+  }
+
+  REQUIRE(!cache.get_stores_at(idxs).empty());
+
+  {
+    INFO("Entries are deserialised on the worker thread only");
+    std::lock_guard<std::mutex> guard(encryptor->lock);
+    REQUIRE(encryptor->decrypt_threads == std::set<uint16_t>{worker_tid});
+  }
+
+  threading::ThreadMessaging::thread_count = prev_thread_count;
+}
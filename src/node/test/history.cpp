@@ -426,6 +426,117 @@ TEST_CASE(
   }
 }
 
+TEST_CASE("Fixed signature policy")
+{
+  using namespace std::chrono_literals;
+  ccf::SignaturePolicy policy(100, 1000);
+  REQUIRE_FALSE(policy.is_adaptive());
+  REQUIRE(policy.get_tx_interval() == 100);
+
+  INFO("Signatures are emitted on the tx interval");
+  {
+    REQUIRE_FALSE(policy.should_emit_on_commit(10ms, 99));
+    REQUIRE(policy.should_emit_on_commit(10ms, 100));
+  }
+
+  INFO("Idle pipelines wait for the ms interval");
+  {
+    REQUIRE_FALSE(policy.should_emit_on_tick(500ms, 10, 10));
+    REQUIRE_FALSE(policy.should_emit_on_tick(1000ms, 10, 10));
+    REQUIRE(policy.should_emit_on_tick(1001ms, 10, 10));
+    policy.on_signature(1001ms, 11);
+    REQUIRE_FALSE(policy.should_emit_on_tick(1500ms, 11, 0));
+    REQUIRE(policy.next_check_delay(1500ms) == 501ms);
+  }
+}
+
+TEST_CASE("Adaptive signature policy")
+{
+  using namespace std::chrono_literals;
+  constexpr size_t max_tx_interval = 5000;
+  ccf::SignaturePolicy policy(max_tx_interval, 1000, 20);
+  REQUIRE(policy.is_adaptive());
+  REQUIRE(policy.get_check_interval() == 5ms);
+
+  INFO("Signatures are emitted as soon as the pipeline is idle");
+  {
+    REQUIRE_FALSE(policy.should_emit_on_tick(5ms, 1, 1));
+    REQUIRE(policy.should_emit_on_tick(10ms, 1, 1));
+    policy.on_signature(10ms, 2);
+  }
+
+  INFO("Under sustained load, the tx interval follows the rate");
+  {
+    kv::Version v = 2;
+    auto t = 10ms;
+    for (size_t i = 0; i < 50; ++i)
+    {
+      t += 5ms;
+      v += 500;
+      policy.should_emit_on_tick(t, v, 0);
+    }
+    // 100 tx/ms with a 20ms target
+    REQUIRE(policy.get_tx_interval() > 1990);
+    REQUIRE(policy.get_tx_interval() <= 2000);
+
+    for (size_t i = 0; i < 50; ++i)
+    {
+      t += 5ms;
+      v += 5000;
+      policy.should_emit_on_tick(t, v, 0);
+    }
+    REQUIRE(policy.get_tx_interval() == max_tx_interval);
+
+    for (size_t i = 0; i < 50; ++i)
+    {
+      t += 5ms;
+      v += 1;
+      policy.should_emit_on_tick(t, v, 0);
+    }
+    REQUIRE(policy.get_tx_interval() == ccf::SignaturePolicy::min_tx_interval);
+  }
+
+  INFO("Signatures are emitted before the latency target is exceeded");
+  {
+    ccf::SignaturePolicy policy(max_tx_interval, 1000, 20);
+    REQUIRE_FALSE(policy.should_emit_on_commit(100ms, 1));
+    REQUIRE_FALSE(policy.should_emit_on_tick(105ms, 2, 2));
+    REQUIRE_FALSE(policy.should_emit_on_tick(110ms, 3, 3));
+    REQUIRE(policy.should_emit_on_tick(115ms, 4, 4));
+  }
+}
+
+TEST_CASE("Signature policy records commit latency")
+{
+  using namespace std::chrono_literals;
+  ccf::SignaturePolicy policy(100, 1000);
+
+  for (size_t i = 1; i <= 100; ++i)
+  {
+    const auto start = std::chrono::milliseconds(i * 1000);
+    policy.should_emit_on_commit(start, 1);
+    policy.on_signature(start + 1ms, i * 2);
+    policy.on_commit(start + std::chrono::milliseconds(i), i * 2);
+  }
+
+  INFO("Rolled back signatures are not recorded");
+  {
+    policy.on_signature(200s, 1000);
+    policy.on_rollback(999);
+    policy.on_commit(300s, 1000);
+  }
+
+  const auto stats = policy.get_statistics();
+  REQUIRE_FALSE(stats.adaptive);
+  REQUIRE(stats.tx_interval == 100);
+  REQUIRE(stats.ms_interval == 1000);
+  REQUIRE(stats.commit_latency_samples == 100);
+  REQUIRE(stats.commit_latency_p50_ms == 51);
+  REQUIRE(stats.commit_latency_p90_ms == 91);
+  REQUIRE(stats.commit_latency_p99_ms == 100);
+  REQUIRE(stats.commit_latency_max_ms == 100);
+}
+
 // We need an explicit main to initialize kremlib and EverCrypt
 int main(int argc, char** argv)
 {
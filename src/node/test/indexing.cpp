@@ -0,0 +1,146 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+
+#include "node/indexing.h"
+
+#include "kv/test/null_encryptor.h"
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+using NumToString = kv::Map<size_t, std::string>;
+using SeqNos = ccf::indexing::SeqNoCollection;
+
+TEST_CASE("Seqnos by key")
+{
+  kv::Store store;
+  store.set_encryptor(std::make_shared<kv::NullTxEncryptor>());
+
+  NumToString records("records");
+  NumToString others("others");
+
+  auto index = std::make_shared<ccf::indexing::TypedSeqNosByKey<NumToString>>();
+  ccf::indexing::Indexer indexer(store);
+  indexer.install_strategy(records.get_name(), index);
+
+  auto write = [&](size_t key, std::optional<std::string> value) {
+    auto tx = store.create_tx();
+    auto [view, other_view] = tx.get_view(records, others);
+    if (value.has_value())
+    {
+      view->put(key, value.value());
+    }
+    else
+    {
+      view->remove(key);
+    }
+    other_view->put(key, "other");
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+    return store.current_version();
+  };
+
+  const auto a1 = write(1, "a");
+  const auto b1 = write(2, "b");
+  const auto a2 = write(1, "aa");
+  const auto a3 = write(1, std::nullopt);
+
+  {
+    INFO("Uncommitted transactions are not indexed");
+    REQUIRE(index->get_seqnos_for_key(1, 0, a3).empty());
+    REQUIRE(index->get_indexed_seqno() == 0);
+  }
+
+  store.compact(a2);
+
+  {
+    INFO("Committed transactions are indexed");
+    REQUIRE(index->get_seqnos_for_key(1, 0, a3) == SeqNos{a1, a2});
+    REQUIRE(index->get_seqnos_for_key(2, 0, a3) == SeqNos{b1});
+    REQUIRE(index->get_seqnos_for_key(3, 0, a3).empty());
+    REQUIRE(index->get_indexed_seqno() == a2);
+  }
+
+  store.compact(a3);
+
+  {
+    INFO("Removals are indexed");
+    REQUIRE(index->get_seqnos_for_key(1, 0, a3) == SeqNos{a1, a2, a3});
+    REQUIRE(index->get_key_count() == 2);
+  }
+
+  {
+    INFO("Queries are restricted to the requested range");
+    REQUIRE(index->get_seqnos_for_key(1, a1 + 1, a3) == SeqNos{a2, a3});
+    REQUIRE(index->get_seqnos_for_key(1, a1, a2) == SeqNos{a1, a2});
+    REQUIRE(index->get_seqnos_for_key(1, a2, a2) == SeqNos{a2});
+    REQUIRE(index->get_seqnos_for_key(1, a3 + 1, a3 + 10).empty());
+    REQUIRE(index->get_seqnos_for_key(1, a3, a1).empty());
+    REQUIRE(index->get_seqnos_for_key(1, 0, a3, 2) == SeqNos{a1, a2});
+  }
+
+  {
+    INFO("Several strategies can be installed on a single map");
+    auto late_index =
+      std::make_shared<ccf::indexing::TypedSeqNosByKey<NumToString>>();
+    indexer.install_strategy(records.get_name(), late_index);
+
+    const auto b2 = write(2, "bb");
+    store.compact(b2);
+
+    REQUIRE(index->get_seqnos_for_key(2, 0, b2) == SeqNos{b1, b2});
+    REQUIRE(late_index->get_seqnos_for_key(2, 0, b2) == SeqNos{b2});
+  }
+}
+
+TEST_CASE("Indexer")
+{
+  kv::Store store;
+  store.set_encryptor(std::make_shared<kv::NullTxEncryptor>());
+
+  NumToString records("records");
+  NumToString others("others");
+
+  std::vector<kv::Version> hooked_versions;
+  store.set_global_hook(
+    records.get_name(),
+    [&hooked_versions](kv::Version version, const kv::untyped::Write&) {
+      hooked_versions.push_back(version);
+    });
+
+  auto index = std::make_shared<ccf::indexing::TypedSeqNosByKey<NumToString>>();
+  ccf::indexing::Indexer indexer(store);
+  indexer.install_strategy(records.get_name(), index);
+  indexer.install_strategy(
+    records.get_name(),
+    std::make_shared<ccf::indexing::TypedSeqNosByKey<NumToString>>());
+
+  auto write = [&store](NumToString& map, size_t key) {
+    auto tx = store.create_tx();
+    auto view = tx.get_view(map);
+    view->put(key, "value");
+    REQUIRE(tx.commit() == kv::CommitSuccess::OK);
+    return store.current_version();
+  };
+
+  const auto a = write(records, 1);
+  const auto b = write(others, 1);
+
+  {
+    INFO("Only committed transactions are indexed");
+    REQUIRE(indexer.get_indexed_seqno() == 0);
+  }
+
+  store.compact(b);
+
+  {
+    INFO("Existing global hooks are still called, once per commit");
+    REQUIRE(hooked_versions == std::vector<kv::Version>{a});
+    REQUIRE(index->get_seqnos_for_key(1, 0, b) == SeqNos{a});
+  }
+
+  {
+    INFO("Transactions which do not write the map are also indexed");
+    REQUIRE(index->get_indexed_seqno() == a);
+    REQUIRE(indexer.get_indexed_seqno() == b);
+  }
+}
@@ -0,0 +1,139 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the Apache 2.0 License.
+#define PICOBENCH_IMPLEMENT_WITH_MAIN
+
+#include "node/indexing.h"
+
+#include <picobench/picobench.hpp>
+#include <random>
+
+using Records = kv::Map<size_t, std::string>;
+
+// Synthetic ledger, where each transaction writes a single key. Keys are
+// drawn from a skewed distribution, so that some keys have many versions.
+static constexpr size_t ledger_size = 10'000'000;
+static constexpr size_t key_count = 100'000;
+
+struct SyntheticLedger
+{
+  std::vector<uint32_t> key_at;
+  ccf::indexing::TypedSeqNosByKey<Records> index;
+
+  SyntheticLedger()
+  {
+    std::mt19937 gen(42);
+    std::geometric_distribution<uint32_t> dist(10.0 / key_count);
+
+    key_at.resize(ledger_size + 1);
+    for (size_t seqno = 1; seqno <= ledger_size; ++seqno)
+    {
+      const auto key = dist(gen) % key_count;
+      key_at[seqno] = key;
+
+      kv::untyped::Write w;
+      w[Records::KeySerialiser::to_serialised(key)] =
+        Records::ValueSerialiser::to_serialised("value");
+      index.handle_committed_writes(seqno, w);
+    }
+  }
+};
+
+static SyntheticLedger& get_ledger()
+{
+  static SyntheticLedger ledger;
+  return ledger;
+}
+
+inline void clobber_memory()
+{
+  asm volatile("" : : : "memory");
+}
+
+// Cost of indexing each committed transaction
+static void index_tx(picobench::state& s)
+{
+  ccf::indexing::SeqNosByKey index;
+
+  std::vector<kv::untyped::Write> writes(s.iterations());
+  for (size_t i = 0; i < writes.size(); ++i)
+  {
+    writes[i][Records::KeySerialiser::to_serialised(i % key_count)] =
+      Records::ValueSerialiser::to_serialised("value");
+  }
+
+  s.start_timer();
+  for (size_t i = 0; i < writes.size(); ++i)
+  {
+    index.handle_committed_writes(i + 1, writes[i]);
+  }
+  clobber_memory();
+  s.stop_timer();
+}
+
+// Finding the versions of a key by reading every transaction in a range. This
+// is a lower bound, as it ignores the cost of fetching and deserialising each
+// transaction.
+template <size_t RANGE>
+static void scan_range(picobench::state& s)
+{
+  auto& ledger = get_ledger();
+  std::mt19937 gen(s.iterations());
+
+  s.start_timer();
+  for (auto _ : s)
+  {
+    (void)_;
+    const size_t key = gen() % 100;
+    const size_t from = 1 + gen() % (ledger_size - RANGE + 1);
+    ccf::indexing::SeqNoCollection seqnos;
+    for (size_t seqno = from; seqno < from + RANGE; ++seqno)
+    {
+      if (ledger.key_at[seqno] == key)
+      {
+        seqnos.push_back(seqno);
+      }
+    }
+    clobber_memory();
+  }
+  s.stop_timer();
+}
+
+template <size_t RANGE>
+static void index_range(picobench::state& s)
+{
+  auto& ledger = get_ledger();
+  std::mt19937 gen(s.iterations());
+
+  s.start_timer();
+  for (auto _ : s)
+  {
+    (void)_;
+    const size_t key = gen() % 100;
+    const size_t from = 1 + gen() % (ledger_size - RANGE + 1);
+    auto seqnos =
+      ledger.index.get_seqnos_for_key(key, from, from + RANGE - 1);
+    clobber_memory();
+  }
+  s.stop_timer();
+}
+
+const std::vector<int> tx_counts = {100'000, 1'000'000};
+const std::vector<int> query_counts = {10, 100};
+
+PICOBENCH_SUITE("index_tx");
+PICOBENCH(index_tx).iterations(tx_counts).samples(5);
+
+PICOBENCH_SUITE("query_1k");
+PICOBENCH(scan_range<1'000>).iterations(query_counts).samples(5).baseline();
+PICOBENCH(index_range<1'000>).iterations(query_counts).samples(5);
+
+PICOBENCH_SUITE("query_100k");
+PICOBENCH(scan_range<100'000>).iterations(query_counts).samples(5).baseline();
+PICOBENCH(index_range<100'000>).iterations(query_counts).samples(5);
+
+PICOBENCH_SUITE("query_10m");
+PICOBENCH(scan_range<ledger_size>)
+  .iterations(query_counts)
+  .samples(5)
+  .baseline();
+PICOBENCH(index_range<ledger_size>).iterations(query_counts).samples(5);
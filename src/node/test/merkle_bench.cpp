@@ -201,7 +201,66 @@ static void serialised_size(picobench::state& s)
             << std::endl;
 }
 
+// Receipts for BATCH leaves spread across a tree of size s.iterations(),
+// either as individual receipts or as a single batch receipt sharing the
+// interior nodes of their paths
+template <size_t BATCH>
+static void individual_receipts(picobench::state& s)
+{
+  ccf::MerkleTreeHistory t;
+  std::mt19937 gen(s.iterations());
+  for (size_t i = 0; i < s.iterations(); ++i)
+  {
+    crypto::Sha256Hash h;
+    for (size_t j = 0; j < crypto::Sha256Hash::SIZE; j++)
+      h.h[j] = gen();
+    t.append(h);
+  }
+
+  std::vector<uint64_t> indices(BATCH);
+  for (auto& idx : indices)
+    idx = gen() % s.iterations();
+
+  s.start_timer();
+  for (const auto idx : indices)
+  {
+    auto v = t.get_receipt(idx).to_v();
+    ccf::Receipt r(v);
+    if (!t.verify(r))
+      throw std::runtime_error("Bad path");
+    clobber_memory();
+  }
+  s.stop_timer();
+}
+
+template <size_t BATCH>
+static void batch_receipt(picobench::state& s)
+{
+  ccf::MerkleTreeHistory t;
+  std::mt19937 gen(s.iterations());
+  for (size_t i = 0; i < s.iterations(); ++i)
+  {
+    crypto::Sha256Hash h;
+    for (size_t j = 0; j < crypto::Sha256Hash::SIZE; j++)
+      h.h[j] = gen();
+    t.append(h);
+  }
+
+  std::vector<uint64_t> indices(BATCH);
+  for (auto& idx : indices)
+    idx = gen() % s.iterations();
+
+  s.start_timer();
+  auto v = t.get_batch_receipt(indices).to_v();
+  ccf::BatchReceipt r(v);
+  if (!r.verify())
+    throw std::runtime_error("Bad batch");
+  clobber_memory();
+  s.stop_timer();
+}
+
 const std::vector<int> sizes = {1000, 10000};
+const std::vector<int> tree_sizes = {100000};
 
 PICOBENCH_SUITE("append_retract");
 PICOBENCH(append_retract).iterations(sizes).samples(10).baseline();
@@ -211,6 +270,24 @@ PICOBENCH_SUITE("append_get_receipt_verify");
 PICOBENCH(append_get_receipt_verify).iterations(sizes).samples(10).baseline();
 PICOBENCH_SUITE("append_get_receipt_verify_v");
 PICOBENCH(append_get_receipt_verify_v).iterations(sizes).samples(10).baseline();
+PICOBENCH_SUITE("receipts_10");
+PICOBENCH(individual_receipts<10>)
+  .iterations(tree_sizes)
+  .samples(10)
+  .baseline();
+PICOBENCH(batch_receipt<10>).iterations(tree_sizes).samples(10);
+PICOBENCH_SUITE("receipts_1000");
+PICOBENCH(individual_receipts<1000>)
+  .iterations(tree_sizes)
+  .samples(10)
+  .baseline();
+PICOBENCH(batch_receipt<1000>).iterations(tree_sizes).samples(10);
+PICOBENCH_SUITE("receipts_10000");
+PICOBENCH(individual_receipts<10000>)
+  .iterations(tree_sizes)
+  .samples(10)
+  .baseline();
+PICOBENCH(batch_receipt<10000>).iterations(tree_sizes).samples(10);
 PICOBENCH_SUITE("serialise_deserialise");
 PICOBENCH(serialise_deserialise).iterations(sizes).samples(10).baseline();
 // Checks the size of serialised tree, timing results are irrelevant here
@@ -5,6 +5,7 @@
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include <doctest/doctest.h>
+#include <numeric>
 
 crypto::Sha256Hash rand_hash()
 {
@@ -177,3 +178,134 @@ TEST_CASE("First root")
     REQUIRE(tree.get_leaf(0) == single_root);
   }
 }
+
+TEST_CASE("Batch receipts")
+{
+  auto check_batch = [](
+                       ccf::MerkleTreeHistory& tree,
+                       const std::vector<uint64_t>& indices) {
+    const auto receipt = tree.get_batch_receipt(indices);
+    REQUIRE(receipt.verify());
+    REQUIRE(receipt.get_root() == tree.get_root());
+
+    const auto v = receipt.to_v();
+    const ccf::BatchReceipt deserialised(v);
+    REQUIRE(deserialised.verify());
+    REQUIRE(deserialised.to_v() == v);
+
+    {
+      INFO("Tampered receipts are rejected");
+      // Last byte of the root
+      const auto root_end =
+        sizeof(uint64_t) + sizeof(uint32_t) + crypto::Sha256Hash::SIZE;
+      auto tampered = v;
+      tampered[root_end - 1] ^= 1;
+      REQUIRE_FALSE(ccf::BatchReceipt(tampered).verify());
+
+      // Last byte of the proof, or of the last leaf if there is no proof
+      tampered = v;
+      tampered[v.size() - 1 - (receipt.get_proof_length() == 0 ? 4 : 0)] ^= 1;
+      REQUIRE_FALSE(ccf::BatchReceipt(tampered).verify());
+
+      tampered = v;
+      tampered.pop_back();
+      REQUIRE_THROWS(ccf::BatchReceipt(tampered));
+    }
+
+    return receipt.get_proof_length();
+  };
+
+  for (size_t hash_count = 1; hash_count < 70; ++hash_count)
+  {
+    ccf::MerkleTreeHistory tree;
+    for (size_t i = 1; i < hash_count; ++i)
+    {
+      auto h = rand_hash();
+      tree.append(h);
+    }
+
+    INFO("Tree with " << hash_count << " leaves");
+    for (uint64_t i = 0; i < hash_count; ++i)
+    {
+      INFO("Single leaf " << i);
+      const auto proof_length = check_batch(tree, {i});
+
+      // Matches the path of an individual receipt, without the leaf
+      const auto single = tree.get_receipt(i).to_v();
+      const auto header_size =
+        sizeof(uint64_t) + sizeof(uint32_t) + crypto::Sha256Hash::SIZE;
+      REQUIRE(
+        (single.size() - header_size) / crypto::Sha256Hash::SIZE ==
+        proof_length + 1);
+    }
+
+    for (uint64_t from = 0; from < hash_count; from += 3)
+    {
+      for (uint64_t to = from; to < hash_count; to += 5)
+      {
+        std::vector<uint64_t> range;
+        for (auto i = from; i <= to; ++i)
+        {
+          range.push_back(i);
+        }
+        check_batch(tree, range);
+      }
+    }
+  }
+
+  {
+    INFO("Common path nodes are only included once");
+    ccf::MerkleTreeHistory tree;
+    constexpr size_t hash_count = 10'000;
+    for (size_t i = 1; i < hash_count; ++i)
+    {
+      auto h = rand_hash();
+      tree.append(h);
+    }
+
+    std::vector<uint64_t> indices;
+    size_t individual_proofs_length = 0;
+    for (size_t i = 0; i < 100; ++i)
+    {
+      const uint64_t index = rand() % hash_count;
+      indices.push_back(index);
+      individual_proofs_length += check_batch(tree, {index});
+    }
+    REQUIRE(check_batch(tree, indices) < individual_proofs_length);
+
+    std::vector<uint64_t> all(hash_count);
+    std::iota(all.begin(), all.end(), 0);
+    INFO("A receipt for every leaf needs no other hashes");
+    REQUIRE(check_batch(tree, all) == 0);
+
+    INFO("Indices must be in the tree");
+    REQUIRE_THROWS(tree.get_batch_receipt({}));
+    REQUIRE_THROWS(tree.get_batch_receipt({hash_count}));
+    tree.flush(hash_count / 2);
+    REQUIRE_THROWS(tree.get_batch_receipt({0, hash_count - 1}));
+    check_batch(tree, {hash_count / 2, hash_count - 1});
+  }
+
+  {
+    INFO("Receipts can be produced from a tree deserialised from a signature");
+    ccf::MerkleTreeHistory tree;
+    constexpr size_t hash_count = 1'000;
+    for (size_t i = 1; i < hash_count; ++i)
+    {
+      auto h = rand_hash();
+      tree.append(h);
+    }
+    tree.flush(hash_count / 3);
+
+    ccf::MerkleTreeHistory signed_tree(tree.serialise());
+    std::vector<uint64_t> indices;
+    for (auto i = signed_tree.begin_index(); i <= signed_tree.end_index();
+         i += 7)
+    {
+      indices.push_back(i);
+    }
+    const auto receipt = signed_tree.get_batch_receipt(indices);
+    REQUIRE(receipt.verify());
+    REQUIRE(receipt.get_root() == tree.get_root());
+  }
+}
@@ -0,0 +1,129 @@
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# Licensed under the Apache 2.0 License.
+import infra.e2e_args
+import infra.network
+import infra.proc
+import time
+import http
+import concurrent.futures
+import cimetrics.upload
+from ccf.clients import CCF_MIN_SEQNO_HEADER
+
+from loguru import logger as LOG
+
+
+def read_your_writes(primary, node, writes):
+    """
+    Write to the primary, then immediately read each write back from node,
+    passing the seqno of the write as the minimum seqno of the read. Every
+    read must observe its write, wherever it is executed.
+    """
+    with primary.client("user0") as pc, node.client("user0") as nc:
+        for i in range(writes):
+            msg = f"Read your writes on node {node.node_id}: {i}"
+            r = pc.post("/app/log/private", {"id": i, "msg": msg})
+            assert r.status_code == http.HTTPStatus.OK, r
+            r = nc.get(
+                f"/app/log/private?id={i}",
+                headers={CCF_MIN_SEQNO_HEADER: str(r.seqno)},
+            )
+            assert r.status_code == http.HTTPStatus.OK, r
+            assert r.body.json() == {"msg": msg}, r
+
+
+def read_load(node, min_seqno, duration_s):
+    """
+    Send reads which must observe min_seqno to node for duration_s, and return
+    the number of reads completed.
+    """
+    log_capture = []
+    reads = 0
+    with node.client("user0") as c:
+        end_time = time.time() + duration_s
+        while time.time() < end_time:
+            r = c.get(
+                "/app/log/private?id=0",
+                headers={CCF_MIN_SEQNO_HEADER: str(min_seqno)},
+                log_capture=log_capture,
+            )
+            assert r.status_code == http.HTTPStatus.OK, r
+            reads += 1
+    return reads
+
+
+def measure_read_throughput(nodes, min_seqno, duration_s, clients_per_node):
+    """
+    Spread reads evenly over nodes, with clients_per_node concurrent clients on
+    each, and return the aggregate throughput (reads/s).
+    """
+    clients = [node for node in nodes for _ in range(clients_per_node)]
+    with concurrent.futures.ThreadPoolExecutor(len(clients)) as pool:
+        futures = [
+            pool.submit(read_load, node, min_seqno, duration_s) for node in clients
+        ]
+        reads = sum(f.result() for f in futures)
+    return reads / duration_s
+
+
+def run(args):
+    hosts = ["local://localhost"] * args.nodes
+
+    with infra.network.network(
+        hosts, args.binary_dir, args.debug_nodes, args.perf_nodes, pdb=args.pdb
+    ) as network:
+        network.start_and_join(args)
+        primary, backups = network.find_nodes()
+
+        for node in [primary] + backups:
+            read_your_writes(primary, node, args.writes)
+
+        with primary.client("user0") as c:
+            r = c.post("/app/log/private", {"id": 0, "msg": "Backup reads"})
+            assert r.status_code == http.HTTPStatus.OK, r
+            min_seqno = r.seqno
+
+        with cimetrics.upload.metrics(complete=False) as metrics:
+            primary_only = measure_read_throughput(
+                [primary] * args.nodes, min_seqno, args.duration, args.clients
+            )
+            all_nodes = measure_read_throughput(
+                [primary] + backups, min_seqno, args.duration, args.clients
+            )
+            LOG.success(
+                f"Reads with a minimum seqno: {primary_only:.0f} reads/s on the primary, {all_nodes:.0f} reads/s spread over {args.nodes} nodes"
+            )
+            metrics.put(f"{args.label}_primary_reads_per_sec", primary_only)
+            metrics.put(f"{args.label}_all_nodes_reads_per_sec", all_nodes)
+
+
+if __name__ == "__main__":
+
+    def add(parser):
+        parser.add_argument(
+            "--nodes",
+            help="Number of nodes",
+            type=int,
+            default=3,
+        )
+        parser.add_argument(
+            "--writes",
+            help="Number of writes read back from each node",
+            type=int,
+            default=100,
+        )
+        parser.add_argument(
+            "--duration",
+            help="Duration of each read load, in seconds",
+            type=int,
+            default=10,
+        )
+        parser.add_argument(
+            "--clients",
+            help="Number of concurrent clients per node",
+            type=int,
+            default=4,
+        )
+
+    args = infra.e2e_args.cli_args(add)
+    args.package = "liblogging"
+    run(args)
@@ -0,0 +1,155 @@
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# Licensed under the Apache 2.0 License.
+import infra.e2e_args
+import infra.network
+import infra.proc
+import time
+import http
+import heapq
+import queue
+import threading
+import concurrent.futures
+import cimetrics.upload
+
+from loguru import logger as LOG
+
+
+def percentile(samples, p):
+    ordered = sorted(samples)
+    return ordered[min(len(ordered) - 1, (len(ordered) * p) // 100)]
+
+
+def measure_commit_latency(primary, rate, duration_s, senders=16, timeout=30):
+    """
+    Send write transactions to the primary at a fixed offered load (tx/s),
+    and return the observed latency (ms) between each write and its global
+    commit.
+
+    The load is open-loop: each write is scheduled at a fixed time, and is
+    sent from a pool of senders without waiting for earlier writes to
+    complete. Latencies are measured from the scheduled time, so that a slow
+    service is charged for the writes it delays, rather than sending fewer.
+    """
+    period = 1.0 / rate
+    scheduled = queue.Queue()
+    pending = []
+    pending_lock = threading.Lock()
+    latencies = []
+    sending = threading.Event()
+    sending.set()
+
+    def send():
+        log_capture = []
+        with primary.client("user0") as c:
+            while True:
+                item = scheduled.get()
+                if item is None:
+                    return
+                i, send_time = item
+                r = c.post(
+                    "/app/log/private",
+                    {"id": i, "msg": f"Commit latency at {rate} tx/s"},
+                    log_capture=log_capture,
+                )
+                assert r.status_code == http.HTTPStatus.OK, r
+                with pending_lock:
+                    heapq.heappush(pending, (r.seqno, send_time))
+
+    def poll_commit():
+        log_capture = []
+        with primary.client() as nc:
+            end_time = None
+            while True:
+                r = nc.get("/node/commit", log_capture=log_capture)
+                assert r.status_code == http.HTTPStatus.OK, r
+                committed = r.body.json()["seqno"]
+                now = time.time()
+                with pending_lock:
+                    while pending and pending[0][0] <= committed:
+                        latencies.append((now - heapq.heappop(pending)[1]) * 1000)
+                    remaining = len(pending)
+                if not sending.is_set():
+                    if remaining == 0:
+                        return
+                    if end_time is None:
+                        end_time = now + timeout
+                    elif now > end_time:
+                        raise TimeoutError(
+                            f"{remaining} transactions were not committed"
+                        )
+                time.sleep(0.001)
+
+    with concurrent.futures.ThreadPoolExecutor(senders + 1) as pool:
+        poller = pool.submit(poll_commit)
+        workers = [pool.submit(send) for _ in range(senders)]
+        start = time.time()
+        i = 0
+        while start + i * period < start + duration_s:
+            send_time = start + i * period
+            delay = send_time - time.time()
+            if delay > 0:
+                time.sleep(delay)
+            scheduled.put((i, send_time))
+            i += 1
+        for _ in workers:
+            scheduled.put(None)
+        try:
+            for w in workers:
+                w.result()
+        finally:
+            sending.clear()
+        poller.result()
+
+    return latencies
+
+
+def run(args):
+    hosts = ["local://localhost"] * 2
+
+    with infra.network.network(
+        hosts, args.binary_dir, args.debug_nodes, args.perf_nodes, pdb=args.pdb
+    ) as network:
+        network.start_and_join(args)
+        primary, _ = network.find_primary()
+
+        with cimetrics.upload.metrics(complete=False) as metrics:
+            for rate in args.offered_loads:
+                latencies = measure_commit_latency(primary, rate, args.duration)
+                p50 = percentile(latencies, 50)
+                p99 = percentile(latencies, 99)
+                LOG.success(
+                    f"{rate} tx/s: {len(latencies)} txs, commit latency p50={p50:.1f}ms p90={percentile(latencies, 90):.1f}ms p99={p99:.1f}ms max={max(latencies):.1f}ms"
+                )
+                metrics.put(f"{args.label}_{rate}tps_p50_ms", p50)
+                metrics.put(f"{args.label}_{rate}tps_p99_ms", p99)
+
+            with primary.client() as nc:
+                r = nc.get("/node/metrics")
+                assert r.status_code == http.HTTPStatus.OK, r
+                signatures = r.body.json()["signatures"]
+                LOG.info(f"Signature metrics from primary: {signatures}")
+                assert signatures["commit_latency_samples"] > 0, signatures
+                if args.sig_latency_target_ms:
+                    assert signatures["adaptive"], signatures
+
+
+if __name__ == "__main__":
+
+    def add(parser):
+        parser.add_argument(
+            "--offered-loads",
+            help="Offered loads, in transactions per second",
+            type=int,
+            nargs="+",
+            default=[10, 100, 1000],
+        )
+        parser.add_argument(
+            "--duration",
+            help="Duration of each load step, in seconds",
+            type=int,
+            default=10,
+        )
+
+    args = infra.e2e_args.cli_args(add)
+    args.package = "liblogging"
+    run(args)
@@ -0,0 +1,109 @@
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# Licensed under the Apache 2.0 License.
+import infra.network
+import infra.proc
+import infra.e2e_args
+import suite.test_requirements as reqs
+import http
+import time
+
+from loguru import logger as LOG
+
+
+def is_notification(response):
+    body = response.body.json()
+    return isinstance(body, dict) and "updates" in body
+
+
+def collect_updates(response, pending, expected_status="COMMITTED"):
+    assert response.status_code == http.HTTPStatus.OK, response
+    for update in response.body.json()["updates"]:
+        assert update["status"] == expected_status, update
+        pending.discard((update["view"], update["seqno"]))
+
+
+def wait_for_updates(client, pending, timeout=10):
+    end_time = time.time() + timeout
+    while pending:
+        if time.time() > end_time:
+            raise TimeoutError(f"No notification received for {pending}")
+        collect_updates(client.receive(timeout), pending)
+
+
+@reqs.description("Subscribe to the status of known transactions on a backup")
+@reqs.supports_methods("log/private")
+@reqs.at_least_n_nodes(2)
+def test_explicit_txs(network, args):
+    primary, backup = network.find_primary_and_any_backup()
+
+    txs = []
+    with primary.client("user0") as c:
+        for i in range(args.txs):
+            r = c.post("/app/log/private", {"id": i, "msg": f"Notified {i}"})
+            assert r.status_code == http.HTTPStatus.OK, r
+            txs.append((r.view, r.seqno))
+
+    pending = set(txs)
+    with backup.client("user0", ws=True) as c:
+        r = c.post(
+            "/app/tx/subscribe",
+            {"txs": [{"view": view, "seqno": seqno} for view, seqno in txs]},
+        )
+        # Transactions which are already committed are reported immediately
+        collect_updates(r, pending)
+        LOG.info(f"{len(txs) - len(pending)} transactions committed on subscription")
+        wait_for_updates(c, pending)
+
+    return network
+
+
+@reqs.description("Subscribe to the status of all transactions of a session")
+@reqs.supports_methods("log/private")
+def test_own_txs(network, args):
+    primary, _ = network.find_primary()
+
+    pending = set()
+    notifications = []
+    with primary.client("user0", ws=True) as c:
+        r = c.post("/app/tx/subscribe", {"own_txs": True})
+        collect_updates(r, pending)
+
+        for i in range(args.txs):
+            r = c.post("/app/log/private", {"id": i, "msg": f"Own {i}"})
+            # A notification for an earlier write may arrive before the response
+            while is_notification(r):
+                notifications.append(r)
+                r = c.receive()
+            assert r.status_code == http.HTTPStatus.OK, r
+            pending.add((r.view, r.seqno))
+
+        for n in notifications:
+            collect_updates(n, pending)
+        wait_for_updates(c, pending)
+
+    return network
+
+
+def run(args):
+    with infra.network.network(
+        args.nodes, args.binary_dir, args.debug_nodes, args.perf_nodes, pdb=args.pdb
+    ) as network:
+        network.start_and_join(args)
+        network = test_explicit_txs(network, args)
+        network = test_own_txs(network, args)
+
+
+if __name__ == "__main__":
+
+    def add(parser):
+        parser.add_argument(
+            "--txs",
+            help="Number of transactions to track in each test",
+            type=int,
+            default=100,
+        )
+
+    args = infra.e2e_args.cli_args(add)
+    args.package = "liblogging"
+    args.nodes = infra.e2e_args.max_nodes(args, f=0)
+    run(args)
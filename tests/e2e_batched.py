@@ -58,6 +58,54 @@ def test(network, args, batch_size=100, write_key_divisor=1, write_size_multipli
     return network
 
 
+@reqs.description("Fetching large batches, with and without copying values")
+@reqs.supports_methods("batch/submit", "batch/fetch", "batch/fetch_str")
+def test_fetch(
+    network, args, batch_size=1000, write_size_multiplier=20, iterations=10
+):
+    primary, _ = network.find_primary()
+
+    with primary.client("user0") as c:
+        check = infra.checker.Checker()
+
+        message_ids = [next(id_gen) for _ in range(batch_size)]
+        messages = [
+            {"id": i, "msg": f"A unique message: {md5(bytes(i)).hexdigest()}"}
+            for i in message_ids
+        ]
+        check(
+            c.post(
+                "/app/batch/submit",
+                {
+                    "entries": messages,
+                    "write_key_divisor": 1,
+                    "write_size_multiplier": write_size_multiplier,
+                },
+                timeout=30,
+            ),
+            result=len(messages),
+        )
+
+        expected = [
+            {"id": m["id"], "msg": m["msg"] * write_size_multiplier} for m in messages
+        ]
+        value_size = len(expected[0]["msg"])
+
+        for endpoint in ("fetch", "fetch_str"):
+            start = time.time()
+            for _ in range(iterations):
+                check(
+                    c.post(f"/app/batch/{endpoint}", message_ids, timeout=30),
+                    result=expected,
+                )
+            duration = (time.time() - start) / iterations
+            LOG.warning(
+                f"Fetching {batch_size} values of {value_size} bytes with {endpoint} took {duration}s"
+            )
+
+    return network
+
+
 def run(args):
     with infra.network.network(
         args.nodes, args.binary_dir, args.debug_nodes, args.perf_nodes, pdb=args.pdb
@@ -79,6 +127,8 @@ def run(args):
             write_size_multiplier=10,
         )
 
+        network = test_fetch(network, args)
+
         # CI already takes ~25s for batch of 10k, so avoid large batches for now
         # bs = 10000
         # step_size = 10000
@@ -235,6 +235,8 @@ def test_metrics(network, args):
         m = r.body.json()["metrics"]["endpoint_metrics"]["GET"]
         calls = m["calls"]
         errors = m["errors"]
+        # Every committed call is counted once, by the number of retries it took
+        assert sum(m["retries"]) <= calls
 
     with primary.client("user0") as c:
         r = c.get("/app/endpoint_metrics")
@@ -274,6 +276,59 @@ def test_historical_query(network, args):
     return network
 
 
+@reqs.description("Read all versions of a record in a range of seqnos")
+@reqs.supports_methods("log/private", "log/private/historical/range")
+def test_historical_range_query(network, args):
+    if args.consensus == "bft":
+        LOG.warning("Skipping historical queries in BFT")
+        return network
+
+    if args.package != "liblogging":
+        LOG.warning(
+            f"Skipping {inspect.currentframe().f_code.co_name} as application is not C++"
+        )
+        return network
+
+    primary, _ = network.find_primary()
+    idx = 4242
+    # More versions than are returned by a single response
+    n_versions = 25
+
+    with primary.client("user0") as c:
+        versions = []
+        for i in range(n_versions):
+            msg = f"Version {i} of record {idx}"
+            r = c.post("/app/log/private", {"id": idx, "msg": msg})
+            assert r.status_code == http.HTTPStatus.OK, r
+            versions.append({"seqno": r.seqno, "msg": msg})
+            # Unrelated writes, which are not fetched by the range query
+            c.post("/app/log/private", {"id": idx + 1, "msg": msg})
+        r = c.delete(f"/app/log/private?id={idx}")
+        assert r.status_code == http.HTTPStatus.OK, r
+        versions.append({"seqno": r.seqno})
+        c.wait_for_commit(r)
+
+        entries = []
+        from_seqno = versions[0]["seqno"]
+        end_time = time.time() + 30
+        while from_seqno is not None:
+            if time.time() > end_time:
+                raise TimeoutError(f"Range query from {from_seqno} did not complete")
+            r = c.get(
+                f"/app/log/private/historical/range?id={idx}&from_seqno={from_seqno}"
+            )
+            if r.status_code == http.HTTPStatus.ACCEPTED:
+                time.sleep(int(r.headers["retry-after"]))
+                continue
+            assert r.status_code == http.HTTPStatus.OK, r
+            entries += r.body.json()["entries"]
+            from_seqno = r.body.json().get("next_from_seqno")
+
+        assert entries == versions, entries
+
+    return network
+
+
 @reqs.description("Testing forwarding on member and user frontends")
 @reqs.supports_methods("log/private")
 @reqs.at_least_n_nodes(2)
@@ -564,6 +619,7 @@ def run(args):
         network = test_anonymous_caller(network, args)
         network = test_raw_text(network, args)
         network = test_historical_query(network, args)
+        network = test_historical_range_query(network, args)
         network = test_view_history(network, args)
         network = test_primary(network, args)
         network = test_metrics(network, args)
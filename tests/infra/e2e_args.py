@@ -134,6 +134,12 @@ def cli_args(add=lambda x: None, parser=None, accept_unknown=False):
         type=int,
         default=1000,
     )
+    parser.add_argument(
+        "--sig-latency-target-ms",
+        help="Target commit latency in milliseconds. If non-zero, signatures are emitted adaptively",
+        type=int,
+        default=0,
+    )
     parser.add_argument(
         "--memory-reserve-startup",
         help="Reserve this many bytes of memory on startup, to simulate memory restrictions",
@@ -253,6 +259,24 @@ def cli_args(add=lambda x: None, parser=None, accept_unknown=False):
         help="JWT key refresh interval in seconds",
         default=None,
     )
+    parser.add_argument(
+        "--kv-spill-threshold",
+        help="Size in bytes from which committed KV values are moved out of the enclave. If 0, all values are kept in the enclave",
+        type=int,
+        default=0,
+    )
+    parser.add_argument(
+        "--kv-record-map-sizes",
+        help="Record the size of each map in serialised transactions and snapshots. Only for services whose nodes all support it",
+        action="store_true",
+        default=False,
+    )
+    parser.add_argument(
+        "--log-site-rate-limit",
+        help="Maximum number of enclave log messages below fail written per second by each logging statement. If 0, messages are not rate limited",
+        type=int,
+        default=None,
+    )
 
     add(parser)
 
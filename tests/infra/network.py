@@ -67,6 +67,7 @@ class Network:
         "host_log_level",
         "sig_tx_interval",
         "sig_ms_interval",
+        "sig_latency_target_ms",
         "raft_election_timeout",
         "bft_view_change_timeout",
         "consensus",
@@ -79,6 +80,9 @@ class Network:
         "domain",
         "snapshot_tx_interval",
         "jwt_key_refresh_interval_s",
+        "kv_spill_threshold",
+        "kv_record_map_sizes",
+        "log_site_rate_limit",
     ]
 
     # Maximum delay (seconds) for updates to propagate from the primary to backups
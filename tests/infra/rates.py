@@ -12,6 +12,7 @@ class TxRates:
         self.primary = primary
         self.same_commit_count = 0
         self.histogram_data = {}
+        self.signatures_data = {}
         self.tx_rates_data = []
         self.all_metrics = {}
         self.commit = 0
@@ -45,6 +46,11 @@ class TxRates:
                 )
             )
 
+        if self.signatures_data:
+            format_title("Signatures")
+            for k, v in self.signatures_data.items():
+                out_list.append(f"--- {k:>24}: {str(v):>8} ---")
+
         return "\n".join(out_list)
 
     def save_results(self, output_file):
@@ -82,5 +88,9 @@ class TxRates:
             else:
                 self.histogram_data = histogram
 
+            signatures = self.all_metrics.get("signatures")
+            if signatures is not None:
+                self.signatures_data = signatures
+
     def insert_metrics(self, **kwargs):
         self.all_metrics.update(**kwargs)
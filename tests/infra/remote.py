@@ -577,6 +577,7 @@ class CCFRemote(object):
         host_log_level="info",
         sig_tx_interval=5000,
         sig_ms_interval=1000,
+        sig_latency_target_ms=0,
         raft_election_timeout=1000,
         bft_view_change_timeout=5000,
         consensus="cft",
@@ -591,6 +592,9 @@ class CCFRemote(object):
         domain=None,
         snapshot_tx_interval=None,
         jwt_key_refresh_interval_s=None,
+        kv_spill_threshold=0,
+        kv_record_map_sizes=False,
+        log_site_rate_limit=None,
     ):
         """
         Run a ccf binary on a remote host.
@@ -659,6 +663,9 @@ class CCFRemote(object):
         if sig_ms_interval:
             cmd += [f"--sig-ms-interval={sig_ms_interval}"]
 
+        if sig_latency_target_ms:
+            cmd += [f"--sig-latency-target-ms={sig_latency_target_ms}"]
+
         if memory_reserve_startup:
             cmd += [f"--memory-reserve-startup={memory_reserve_startup}"]
 
@@ -674,6 +681,15 @@ class CCFRemote(object):
         if jwt_key_refresh_interval_s:
             cmd += [f"--jwt-key-refresh-interval-s={jwt_key_refresh_interval_s}"]
 
+        if kv_spill_threshold:
+            cmd += [f"--kv-spill-threshold={kv_spill_threshold}"]
+
+        if kv_record_map_sizes:
+            cmd += ["--kv-record-map-sizes"]
+
+        if log_site_rate_limit is not None:
+            cmd += [f"--log-site-rate-limit={log_site_rate_limit}"]
+
         for read_only_ledger_dir in self.read_only_ledger_dirs:
             cmd += [f"--read-only-ledger-dir={os.path.basename(read_only_ledger_dir)}"]
             data_files += [os.path.join(self.common_dir, read_only_ledger_dir)]
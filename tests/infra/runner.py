@@ -1,6 +1,7 @@
 # Copyright (c) Microsoft Corporation. All rights reserved.
 # Licensed under the Apache 2.0 License.
 import getpass
+import os
 import time
 import http
 import logging
@@ -179,6 +180,25 @@ def run(get_command, args):
                         peak_value = results["peak_allocated_heap_size"]
                         metrics.put(heap_peak_metric, peak_value)
 
+                        # Ledger growth, in bytes per transaction
+                        r = nc.get("/node/commit")
+                        assert r.status_code == http.HTTPStatus.OK.value
+                        seqno = r.body.json()["seqno"]
+                        ledger_dir = primary.get_ledger()[0]
+                        ledger_size = sum(
+                            os.path.getsize(os.path.join(ledger_dir, f))
+                            for f in os.listdir(ledger_dir)
+                        )
+                        ledger_metric = f"Ledger_{args.label}"
+                        if ledger_metric.endswith("^"):
+                            ledger_metric = ledger_metric[:-1]
+                        if seqno > 0:
+                            bytes_per_tx = ledger_size / seqno
+                            LOG.info(
+                                f"Ledger: {ledger_size} bytes for {seqno} transactions ({bytes_per_tx:.1f} bytes/tx)"
+                            )
+                            metrics.put(ledger_metric, bytes_per_tx)
+
                     LOG.info(f"Rates:\n{tx_rates}")
                     tx_rates.save_results(args.metrics_file)
 
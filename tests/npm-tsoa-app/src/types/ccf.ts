@@ -38,6 +38,10 @@ export type EndpointFn<
 export interface KVMap {
   has: (key: ArrayBuffer) => boolean;
   get: (key: ArrayBuffer) => ArrayBuffer | undefined;
+  getStr: (key: ArrayBuffer) => string | undefined;
+  getJsonCompatible: <T extends JsonCompatible<T>>(
+    key: ArrayBuffer
+  ) => T | undefined;
   set: (key: ArrayBuffer, value: ArrayBuffer) => KVMap;
   delete: (key: ArrayBuffer) => boolean;
   forEach: (
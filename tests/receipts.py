@@ -11,7 +11,7 @@ from loguru import logger as LOG
 
 
 @reqs.description("Running transactions against logging app")
-@reqs.supports_methods("receipt", "receipt/verify", "log/private")
+@reqs.supports_methods("receipt", "receipt/batch", "receipt/verify", "log/private")
 @reqs.at_least_n_nodes(2)
 def test(network, args):
     primary, _ = network.find_primary_and_any_backup()
@@ -27,6 +27,7 @@ def test(network, args):
             r = c.post("/app/log/private", {"id": 42, "msg": msg})
             check_commit(r, result=True)
             check(c.get("/app/log/private?id=42"), result={"msg": msg})
+            first_seqno = r.seqno
             for _ in range(10):
                 c.post(
                     "/app/log/private",
@@ -48,6 +49,25 @@ def test(network, args):
                 result={"valid": False},
             )
 
+            LOG.info("Batch receipt for all transactions since the first write")
+            last_seqno = first_seqno + 11
+            r = c.get(
+                f"/app/receipt/batch?from_commit={first_seqno}&to_commit={last_seqno}"
+            )
+            receipts = r.body.json()["receipts"]
+            assert len(receipts) == 1, receipts
+            batch = receipts[0]
+            check(
+                c.post("/app/receipt/verify", {"receipt": batch, "batch": True}),
+                result={"valid": True},
+            )
+            # Flip a byte of the root, which follows the offset and max index
+            batch[12] ^= 1
+            check(
+                c.post("/app/receipt/verify", {"receipt": batch, "batch": True}),
+                result={"valid": False},
+            )
+
     return network
 
 